@@ -16,6 +16,11 @@ if(ENABLE_FEATURE_GCOVER)
     add_link_options(--coverage)
 endif()
 
+# tracing points of the media paths, see libshm_trace_internal.h.
+if(ENABLE_FEATURE_TRACE)
+    add_compile_definitions(LIBSHM_ENABLE_TRACE)
+endif()
+
 string(TOUPPER "${CMAKE_BUILD_TYPE}" CMAKE_BUILD_TYPE_UPPER)
 
 if("${CMAKE_BUILD_TYPE_UPPER}" STREQUAL "DEBUG")
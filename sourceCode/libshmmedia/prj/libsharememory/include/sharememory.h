@@ -40,8 +40,38 @@
 #endif
 
 #define MAX_SHARE_MEMROY_NAME   256
+
+/* page backing of the mapped shm region. */
+#define SHM_PAGE_BACKING_NORMAL     0
+#define SHM_PAGE_BACKING_HUGETLBFS  1
 #define USE_POSIX_SHM 1
 
+typedef struct {
+    uint32_t    pid;
+    uint32_t    read_index;//next item index the reader would read.
+    uint64_t    heartbeat;//ms, last time the reader polled.
+    uint64_t    sync_time;//ms, last time the reader polled and found nothing unread.
+} shm_reader_info_t;
+
+/* bucket i counts the items read less than 2^i ms after creating, the last one the later ones. */
+#define SHM_STATS_LATENCY_BUCKETS   12
+
+typedef struct {
+    uint64_t    frames_written;
+    uint64_t    bytes_written;
+    uint64_t    max_item_size;
+    uint64_t    write_blocked;//lossless writes refused for the slowest reader.
+} shm_stats_info_t;
+
+typedef struct {
+    uint32_t    pid;
+    uint32_t    reserved;
+    uint64_t    frames_read;
+    uint64_t    frames_dropped;//items skipped when the writer lapped the reader.
+    uint64_t    overruns;//times the writer lapped the reader.
+    uint64_t    latency_ms[SHM_STATS_LATENCY_BUCKETS];
+} shm_reader_stats_info_t;
+
 class CTvuBaseShareMemory
 {
 public:
@@ -62,6 +92,12 @@ public:
 #if defined (TVU_LINUX)
     int     GetShmId(){return m_iShmId;}
     static int RemoveShmFromKernal(const char *shmname);
+
+    /**
+     *  ProbeShm reads the head of the named shm without mapping it,
+     *  return 1 when it is a ring of this class, 0 not, -errno failed.
+     */
+    static int ProbeShm(const char *shmname);
 #endif
     uint32_t    GetHeadLen() { return m_uHeadLen; }
     uint32_t    GetWriteIndex();
@@ -72,9 +108,111 @@ public:
     void        FinishRead();
     bool        HasReaders(unsigned int timeout = 100 /* default 100ms */);
 
+    /**
+     *  futex wakeup word of the shm head, only linux creators publish it.
+     *  reader should sample GetWakeupSeq() before checking Readable(), then
+     *  WaitForWrite() sleeps until the writer moves the sequence or timeout(ms).
+     *  it falls back to 1ms sleep when the creator does not support the word.
+     *  WaitForWriteAny sleeps on the words of @n shms at once, seqs[i] sampled
+     *  from shms[i], until any of them moves or timeout(ms).
+     */
+    bool        IsWakeupSupported();
+    uint32_t    GetWakeupSeq();
+    void        WaitForWrite(uint32_t seq, unsigned int timeout);
+    void        WakeupReaders();
+    static void WaitForWriteAny(CTvuBaseShareMemory * const *shms, const uint32_t *seqs, int n, unsigned int timeout);
+
+    /**
+     *  reader registration table of the shm head, only creators with enough head
+     *  length publish it. RegisterReader claims one slot for this reader until
+     *  CloseMapFile, false when the table is not supported or full.
+     *  GetReaders fills at most @max registered readers, return the filled count.
+     */
+    bool        IsReaderTableSupported();
+    bool        RegisterReader();
+    int         GetReaders(shm_reader_info_t *readers, int max);
+    static uint32_t     GetReaderTableLen();
+
+    /**
+     *  lossless mode, only for the creator and it requires the reader table.
+     *  the writer keeps one slot for the item the slowest registered reader is
+     *  still using, IsWriteBlocked() tells the next write would overwrite it.
+     *  WaitForRelease() sleeps while blocked, until a reader releases an item or
+     *  timeout(ms), it falls back to 1ms sleep when the head has no release word.
+     *  SetLossless return 0 success, -1 when the reader table is not supported.
+     *  the slot of a reader silent over 3s is taken back by the writer or another
+     *  reader, the items after its read index may be overwritten unread then.
+     *  its next Readable() returns -EPIPE once in lossless mode and registers
+     *  it again.
+     */
+    int         SetLossless(bool bLossless);
+    bool        IsLossless() { return m_bLossless; }
+    bool        IsWriteBlocked();
+    void        WaitForRelease(unsigned int timeout);
+
+    /**
+     *  statistics block of the shm head, only creators with enough head length
+     *  publish it, after the reader table. the writer counts its items by CountWrite
+     *  and its lossless refusals by CountWriteBlocked. a registered reader counts
+     *  its read steps, the items it was lapped over, and by CountReadLatency the ms
+     *  from creating an item to reading it.
+     *  GetStats fills the writer counters and at most @max registered readers,
+     *  return the filled readers count, -1 when the block is not supported.
+     */
+    bool        IsStatsSupported() { return _statsBlock() ? true : false; }
+    void        CountWrite(uint32_t bytes);
+    void        CountWriteBlocked();
+    void        CountRead(uint32_t frames);
+    void        CountReadLatency(int64_t ms);
+    int         GetStats(shm_stats_info_t *pstats, shm_reader_stats_info_t *readers, int max);
+    static uint32_t     GetStatsBlockLen();
+
+    /**
+     *  hugepage backing, SetHugePage must be called before CreateOrOpen.
+     *  the creator maps the region from the hugetlbfs mount, and falls back to
+     *  normal pages silently when it could not. readers find both by the name.
+     *  GetPageBacking return SHM_PAGE_BACKING_xxx of the mapped region.
+     */
+    void        SetHugePage(bool bHugePage) { m_bHugePage = bHugePage; }
+    int         GetPageBacking() { return m_iPageBacking; }
+
+    /**
+     *  warm up, SetPrefault must be called before CreateOrOpen/Open.
+     *  bPrefault faults in every page of the mapping, bLock mlocks it, so the
+     *  first lap of the ring does not take page faults.
+     *  GetPrefaultTime return how many micro-seconds the warm up took.
+     */
+    void        SetPrefault(bool bPrefault, bool bLock) { m_bPrefault = bPrefault; m_bLock = bLock; }
+    int64_t     GetPrefaultTime() { return m_iPrefaultUs; }
+
+    /**
+     *  monitor, SetMonitor must be called before Open. the monitor maps the shm
+     *  read-only, it takes no reader slot, does not stamp the read time and polls
+     *  instead of sleeping on the wakeup word.
+     */
+    void        SetMonitor(bool bMonitor) { m_bMonitor = bMonitor; }
+    bool        IsMonitor() const { return m_bMonitor; }
+
+    /**
+     *  NUMA placement, SetNumaNode must be called before CreateOrOpen, -1 for none.
+     *  the creator binds the mapping to the node and records it in the shm head,
+     *  GetNumaNode return the recorded node, -1 when none or the bind failed.
+     */
+    void        SetNumaNode(int node) { m_iNumaNode = node; }
+    int         GetNumaNode();
+
+    /**
+     *  log level of this shm, LIBSHM_LOG_LEVEL_DEFAULT follows the global one.
+     *  the logs in the methods find the member _libshmLogLevelOverride before
+     *  the global one of libshm_log_internal.h.
+     */
+    void        SetLogLevel(int level) { m_iLogLevel = level; }
+    int         GetLogLevel() const { return m_iLogLevel; }
+    int         _libshmLogLevelOverride() const { return m_iLogLevel; }
+
     /**
      *  > 0 : ready
-     *  0   : waiting
+     *  0   : waiting, lossless writer blocked by the slowest reader
      *  < 0 : EPERM, no privilege
      */
     int     Sendable();
@@ -88,6 +226,11 @@ public:
     int         GetShmFlag();
     uint32_t    GetReadIndex();
     void        SetReadIndex(uint32_t index);
+    /**
+     *  publish @index instead of the read index to the reader table until the next
+     *  read step, batch readers use it to keep every item of a batch referenced.
+     */
+    void        HoldReadIndex(uint32_t index);
     uint32_t    GetExtBuffLen();
 
     static uint32_t     GetShmVerBeforeCreate();
@@ -113,14 +256,40 @@ private:
     uint32_t    m_uReadIndex;
     int     m_iFlags;
     int64_t    m_tmRemoveCheck;
+    bool        m_bWakeup;
+    bool        m_bReaderTable;
+    bool        m_bLossless;
+    bool        m_bStats;
+    bool        m_bHugePage;
+    int         m_iPageBacking;
+    bool        m_bPrefault;
+    bool        m_bLock;
+    bool        m_bMonitor;
+    int64_t     m_iPrefaultUs;
+    int         m_iNumaNode;
+    void        *m_pReaderSlot;
+    uint64_t    m_uReaderToken;
+    bool        m_bReaderEvicted;
+    int         m_iLogLevel;
 
 #if defined (TVU_LINUX)
     uint8_t *_open(const char * pMemoryName, bool bForWriting = false);
+    uint8_t *_createHugePage(const char * pMemoryName, size_t isize, mode_t mode);
+    void    _warmup(bool bForWriting);
+    void    _bindNuma();
     bool _isShmRemovedFromKernal();
 #endif
     int     _readable(bool bClosed);
     inline
-    void    _setReadTime();
+    void    _setReadTime(int readable);
+    uint32_t *_wakeupWord();
+    uint32_t *_releaseWord();
+    uint8_t *_readerTable();
+    uint8_t *_statsBlock();
+    void    *_readerStats();
+    void    _releaseReaderSlot();
+    bool    _ownReaderSlot();
+    void    _publishReadIndex();
 };
 
 #endif
@@ -14,6 +14,7 @@
 #define SHAREMEMORY_INTERNAL_H
 #include "sharememory.h"
 #include "libshm_time_internal.h"
+#include "libshm_log_internal.h"
 
 #if defined (TVU_WINDOWS) || defined (TVU_MINGW)
 #   include <Winsock2.h>
@@ -36,44 +37,38 @@
         libsharememory_set_log_print_internal(level, fmt, ##__VA_ARGS__);\
     } while (0)
 
-#define _LIBSHMMEDIA_TAGGED_HEARTBEAT_MULTIPLE_LOG(tagName,seconds,maxIntervalCount,level,fmt, ...) \
+/**
+ *  prints the first @maxIntervalCount logs of the site in each @seconds,
+ *  filtered by @handleLevel, see libshm_log_internal.h.
+ */
+#define _LIBSHMMEDIA_TAGGED_HEARTBEAT_MULTIPLE_LOG_H(handleLevel,tagName,seconds,maxIntervalCount,level,fmt, ...) \
     do \
     {\
-        uint64_t _tvu_now = _libshm_get_sys_ms64();; \
-        bool boutLog = false; \
-        static uint64_t _tvu_lastTime_##__LINE__ = 0;\
-        static uint32_t _tvu_counts_##__LINE__ = 0;\
-        static uint64_t _tvu_lastLastTime##__LINE__ = 0; \
-        if (!_tvu_lastLastTime##__LINE__) {\
-            _tvu_lastLastTime##__LINE__ = _tvu_now; \
-        } \
-        _tvu_counts_##__LINE__++;\
-        bool b_internal_time_out = _tvu_now>=_tvu_lastTime_##__LINE__+(seconds*(int64_t)1000) || _tvu_now<_tvu_lastTime_##__LINE__; \
-        uint32_t _tvu_count_copy = _tvu_counts_##__LINE__; \
-        if (b_internal_time_out) { \
-            if (_tvu_lastTime_##__LINE__ != 0) { \
-                _tvu_lastLastTime##__LINE__ = _tvu_lastTime_##__LINE__;\
-            } \
-            _tvu_lastTime_##__LINE__=_tvu_now; \
-            _tvu_counts_##__LINE__ = 0;\
-            boutLog = true; \
-        }  else if (_tvu_counts_##__LINE__ < maxIntervalCount) {\
-           boutLog = true;\
+        if (_libshm_log_level_of(level) < LIBSHM_LOG_COMPILE_LEVEL \
+            || !_libshm_log_level_enabled(_libshm_log_level_of(level), (handleLevel))) { \
+            break; \
         } \
-        if (boutLog) {\
+        static libshm_log_site_t _tvu_site; \
+        uint64_t _tvu_now = _libshm_get_sys_ms64_coarse(); \
+        uint32_t _tvu_count_copy = 0; \
+        uint64_t _tvu_interval = 0; \
+        bool b_internal_time_out = false; \
+        if (_libshm_log_site_hit(&_tvu_site, _tvu_now, seconds, maxIntervalCount \
+            , &_tvu_count_copy, &_tvu_interval, &b_internal_time_out)) {\
             char stime[50] = {0};\
             DEBUG_COMMON_LOG(level, "T[%s][%s,%ld][%" PRIu64 ",%u%s%s] %c-" fmt \
             , tagName, __FUNCTION__, __LINE__\
             , _tvu_now, _tvu_count_copy, b_internal_time_out?"/":"@" \
-            , _libshmmediaInternalMilliSec2Str(_tvu_now-_tvu_lastLastTime##__LINE__, stime, sizeof(stime))\
+            , _libshmmediaInternalMilliSec2Str(_tvu_interval, stime, sizeof(stime))\
             , toupper(char(level)) \
             , ##__VA_ARGS__);\
-            if (b_internal_time_out) {\
-                _tvu_lastLastTime##__LINE__ = _tvu_lastTime_##__LINE__;\
-            } \
         } \
     } while (0)
 
+/* the level of the handle in scope, its _libshmLogLevelOverride() member, or the global one. */
+#define _LIBSHMMEDIA_TAGGED_HEARTBEAT_MULTIPLE_LOG(tagName,seconds,maxIntervalCount,level,fmt, ...) \
+    _LIBSHMMEDIA_TAGGED_HEARTBEAT_MULTIPLE_LOG_H(_libshmLogLevelOverride(),tagName,seconds,maxIntervalCount,level,fmt, ##__VA_ARGS__)
+
 #define DEBUG_INFO(fmt, ...)        do {\
                                         _LIBSHMMEDIA_TAGGED_HEARTBEAT_MULTIPLE_LOG("shmm", 1, 1, 'i', fmt, ##__VA_ARGS__);\
                                     } while (0)
@@ -86,6 +81,11 @@
                                         _LIBSHMMEDIA_TAGGED_HEARTBEAT_MULTIPLE_LOG("shmm", 10, 10, 'e', fmt, ##__VA_ARGS__);\
                                     } while (0)
 
+/* as the ones above, at @handleLevel, for the static functions with no handle in scope. */
+#define DEBUG_INFO_H(handleLevel, fmt, ...)     _LIBSHMMEDIA_TAGGED_HEARTBEAT_MULTIPLE_LOG_H(handleLevel, "shmm", 1, 1, 'i', fmt, ##__VA_ARGS__)
+#define DEBUG_WARN_H(handleLevel, fmt, ...)     _LIBSHMMEDIA_TAGGED_HEARTBEAT_MULTIPLE_LOG_H(handleLevel, "shmm", 10, 10, 'w', fmt, ##__VA_ARGS__)
+#define DEBUG_ERROR_H(handleLevel, fmt, ...)    _LIBSHMMEDIA_TAGGED_HEARTBEAT_MULTIPLE_LOG_H(handleLevel, "shmm", 10, 10, 'e', fmt, ##__VA_ARGS__)
+
 #define DEBUG_ERROR_CR(fmt, ...)    DEBUG_ERROR(fmt "\n", ##__VA_ARGS__)
 #define DEBUG_WARN_CR(fmt, ...)     DEBUG_WARN(fmt "\n", ##__VA_ARGS__)
 #define DEBUG_INFO_CR(fmt, ...)     DEBUG_INFO(fmt "\n", ##__VA_ARGS__)
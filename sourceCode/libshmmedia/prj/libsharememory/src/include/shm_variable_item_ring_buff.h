@@ -53,6 +53,14 @@
 //#include "TvuShmSharedCompactRingBuffer.h"
 
 typedef int (*tvu_variableitem_base_shm_item_valid_determine_fn_t)(void *ctx, const void *, size_t, uint64_t pos);
+/**
+ *  compare the keys of one item index entry with the wanted ones,
+ *  <0 : the item is before the wanted one
+ *  0  : the wanted one
+ *  >0 : the item is after the wanted one
+ *  kItemIndexCmpNoKey : the item has not the key, stop searching.
+**/
+typedef int (*tvu_variableitem_base_shm_item_index_cmp_fn_t)(void *ctx, const shm_item_index_entry_t *);
 
 class CTvuVariableItemBaseShm
 {
@@ -69,11 +77,28 @@ private:
     bool        _bForCreate;
     void        *m_pRingShm;
     int64_t     m_tmRemoveCheck;
+    bool        m_bHugePage;
+    bool        m_bPrefault;
+    bool        m_bLock;
+    int64_t     m_iPrefaultUs;
+    int         m_iNumaNode;
+    size_t      m_uPayloadAlignment;
+    bool        m_bLossless;
+    bool        m_bItemIndex;
+    bool        m_bMonitor;
+    int         m_iLogLevel;
+    uint32_t    m_uItemIndexSlots;
+    shm_item_index_entry_t  *m_pItemIndex;
 
     uint8_t *_open(const char * pMemoryName, bool bForWriting = false);
     int     _readable();
     void    _setReadTime();
     bool    _isShmRemovedFromKernal();
+    void    _warmup(bool bForWriting);
+    void    _bindNuma();
+    void    _loadItemIndex();
+    bool    _readItemIndex(uint64_t pos, shm_item_index_entry_t *pentry);
+    uint64_t _itemIndexWindow();
 
 public:
     CTvuVariableItemBaseShm(void);
@@ -95,11 +120,111 @@ public:
     uint8_t *GetHeader() { return m_pHeader; }
     const char *GetName() { return m_memoryName; }
     static int RemoveShmFromKernal(const char *shmname);
+    /* return 1 when the named shm is a variable item ring with a valid head, 0 not, -errno failed. */
+    static int ProbeShm(const char *shmname);
 
     bool HasReaders(unsigned int timeout);
+
+    /**
+     *  monitor, SetMonitor must be called before Open. the monitor maps the ring read-only
+     *  and claims no lossless cursor nor lease, it only peeks, PeekLatestItemAddr return the newest item, NULL when none.
+     *  GetWrittenSince counts the items written after the write index *pwindex, sums
+     *  their sizes into *pbytes, and moves *pwindex to the current write index. it
+     *  counts at most GetItemCounts() items, the ones overwritten before are lost to the sum.
+     */
+    void    SetMonitor(bool bMonitor) { m_bMonitor = bMonitor; }
+    bool    IsMonitor() const { return m_bMonitor; }
+    uint8_t *PeekLatestItemAddr(size_t *ps);
+    uint64_t GetWrittenSince(uint64_t *pwindex, uint64_t *pbytes);
+
+    /* log level of this ring, as CTvuBaseShareMemory::SetLogLevel. */
+    void    SetLogLevel(int level) { m_iLogLevel = level; }
+    int     GetLogLevel() const { return m_iLogLevel; }
+    int     _libshmLogLevelOverride() const { return m_iLogLevel; }
+
+    /**
+     *  lossless mode, SetLossless must be called before CreateOrOpen, the ring is
+     *  created lossless, CreateOrOpen fails when an existing ring can not support it.
+     *  readers opened later claim a cursor, the writer never overwrites the items
+     *  they hold, IsWriteBlocked(s, counts) tells counts items of total size s could
+     *  not be written now. WaitForRelease sleeps while Sendable() is 0, until a reader
+     *  releases items or timeout(ms), it falls back to 1ms sleep where it can not wait.
+     */
+    void    SetLossless(bool bLossless) { m_bLossless = bLossless; }
+    bool    IsLossless();
+    bool    IsWriteBlocked(size_t s, size_t counts = 1);
+    void    WaitForRelease(unsigned int timeout);
+
+    /**
+     *  leases, pin the item at @pos in a slot of the shm after reading it.
+     *  a lossless writer waits on a leased item, a lossy one marks the lease broken.
+     *  AcquireLease return the lease >= 0, -ENOSPC no free slot, -ENOTSUP the ring was
+     *  created without leases, -EAGAIN the item is overwritten already, -EPERM for a monitor.
+     *  CheckLease/ReleaseLease return 0 intact, -EPIPE broken, -EINVAL not held.
+     *  HasLeases tells whether the ring was created with the lease slots.
+     */
+    bool    HasLeases();
+    int     AcquireLease(uint64_t pos);
+    int     CheckLease(int lease);
+    int     ReleaseLease(int lease);
+
+    /**
+     *  hugepage backing, SetHugePage must be called before CreateOrOpen, the ring
+     *  falls back to normal pages when it could not map huge pages.
+     *  GetPageBacking return SHM_PAGE_BACKING_xxx of the mapped ring.
+     */
+    void    SetHugePage(bool bHugePage) { m_bHugePage = bHugePage; }
+    int     GetPageBacking();
+
+    /**
+     *  warm up, SetPrefault must be called before CreateOrOpen/Open.
+     *  bPrefault faults in every page of the ring, bLock mlocks it.
+     *  GetPrefaultTime return how many micro-seconds the warm up took.
+     */
+    void    SetPrefault(bool bPrefault, bool bLock) { m_bPrefault = bPrefault; m_bLock = bLock; }
+    int64_t GetPrefaultTime() { return m_iPrefaultUs; }
+
+    /**
+     *  NUMA placement, SetNumaNode must be called before CreateOrOpen, -1 for none.
+     *  GetNumaNode return the node recorded in the shm head, -1 when none.
+     */
+    void    SetNumaNode(int node) { m_iNumaNode = node; }
+    int     GetNumaNode();
+
+    /**
+     *  item start alignment, SetPayloadAlignment must be called before CreateOrOpen,
+     *  0 for the default sizeof(uint64). it only applies to a new ring.
+     *  GetPayloadAlignment return the one the ring was created with.
+     */
+    void    SetPayloadAlignment(size_t alignment) { m_uPayloadAlignment = alignment; }
+    size_t  GetPayloadAlignment();
+
+    /**
+     *  item index, SetItemIndex must be called before CreateOrOpen, one slot for
+     *  every item. the writer calls UpdateItemIndex before committing the items,
+     *  nth 0 is the next item to commit, 1 the one after it in a batch.
+     *  SearchItemIndex binary searches the items still in the ring for the first one
+     *  fn does not put before the wanted, return its position by @ppos, its index entry by @pentry.
+     *  HasItemIndex tells whether the ring was created with the index.
+     *  GetItemIndexWindow return the counts of the items SearchItemIndex covers,
+     *  the oldest one by @poldest. ReadItemIndex reads the entry of the item at @pos,
+     *  false when its slot does not hold it. NextIndexStep return the position after @pos,
+     *  IndexStepsBetween the positions stepped from @from to @to.
+     */
+    enum { kItemIndexCmpNoKey = -0x7FFFFFFF };
+    void    SetItemIndex(bool bItemIndex) { m_bItemIndex = bItemIndex; }
+    bool    HasItemIndex() { return m_pItemIndex != NULL; }
+    void    UpdateItemIndex(size_t nth, uint64_t tvutimestamp, uint64_t pts);
+    bool    SearchItemIndex(void *ctx, tvu_variableitem_base_shm_item_index_cmp_fn_t fn, uint64_t *ppos, shm_item_index_entry_t *pentry);
+    uint64_t GetItemIndexWindow(uint64_t *poldest);
+    bool    ReadItemIndex(uint64_t pos, shm_item_index_entry_t *pentry) { return m_pItemIndex && _readItemIndex(pos, pentry); }
+    uint64_t NextIndexStep(uint64_t pos);
+    uint64_t IndexStepsBetween(uint64_t from, uint64_t to);
+    uint8_t *GetItemAddrByPos(uint64_t pos, size_t *ps);
+
     /**
     *  > 0 : ready
-    *  0   : waiting
+    *  0   : waiting, lossless writer blocked by the slowest reader
     *  < 0 : EPERM, no privilege
     */
     int     Sendable();
@@ -145,8 +270,14 @@ public:
     uint8_t *GetWriteItemAddr(size_t s);
 
     bool FinishWrite(const void *buff, size_t s);
+    /* batch writing, items lay back to back, each one starts at GetBatchItemSpan of the one before. */
+    uint8_t *GetWriteItemsAddr(size_t s, size_t counts);
+    bool FinishWriteBatch(const void *buff, const size_t *sizes, size_t counts);
+    static size_t GetBatchItemSpan(size_t s);
     uint8_t *GetReadItemAddr(size_t *ps);
     uint8_t *GetReadItemAddrWithNoStep(size_t *ps);
+    /* read at most @max consecutive items, return the counts read out. */
+    int GetReadItemAddrBatch(uint8_t **ppItems, size_t *psizes, int max);
     bool FinishRead();
 
     bool SearchWholeItems(void *, tvu_variableitem_base_shm_item_valid_determine_fn_t fn);
@@ -25,6 +25,7 @@
 #define SHMHEAD_H__
 
 #include <stdint.h>
+#include <stddef.h>
 
 #define _SHM_HEAD_FEATURE_EXT_EABLE  1
 
@@ -71,16 +72,112 @@ enum {
 };
 #define SHM_CONSTRUCT_EXT_VER   kShmConstructExtVer1
 
+/**
+ *  bits of shm_construct_ext_t::ext_flags, zero for old creators.
+ *  kShmConstructExtFlagWakeup: the writer bumps wakeup_word on every FinishWrite
+ *  and wakes the readers sleeping on it by futex.
+**/
+#define kShmConstructExtFlagWakeup          0x01
+
+/**
+ *  kShmConstructExtFlagReaderTable: a reader registration table follows the ext block
+ *  at SHM_MEDIA_HEAD_INFO_V4_OFFSET + ext_len, every opened reader claims one slot of it.
+**/
+#define kShmConstructExtFlagReaderTable     0x02
+
+/**
+ *  kShmConstructExtFlagLossless: the writer never overwrites an item the slowest
+ *  registered reader has not released, it requires the reader table.
+**/
+#define kShmConstructExtFlagLossless        0x04
+
+/**
+ *  kShmConstructExtFlagStats: a statistics block follows the reader table,
+ *  see shm_stats_block_t, it requires the reader table.
+**/
+#define kShmConstructExtFlagStats           0x08
+
+/**
+ *  wakeup_word and release_word are wait words, see libshm_wait_word_internal.h.
+ *  the writer moves wakeup_word, lossless readers release_word after they release items.
+**/
+
 typedef struct {
     //shm_construct_t item;
     uint8_t ext_ver;
-    uint8_t reserve;
+    uint8_t ext_flags;
     uint16_t ext_len;
-    uint8_t  a_reserve_[4];
+    uint32_t wakeup_word;//write sequence for futex wakeup, valid only when kShmConstructExtFlagWakeup set.
     uint64_t item_current_64;//item_current 64bit,
     uint64_t last_read_time_stamp;
+    int32_t  numa_node;//node the creator placed the shm on, -1 none. only when ext_len covers it.
+    uint32_t item_index_slots;//variable item ring only, slots of the item index, 0 none. only when ext_len covers it.
+    uint32_t release_word;//lossless readers wake the blocked writer by it, on linux. only when ext_len covers it.
 } shm_construct_ext_t;
 
+/* ext_len of the creators which record numa_node. */
+#define SHM_CONSTRUCT_EXT_NUMA_LEN  (offsetof(shm_construct_ext_t, numa_node) + sizeof(int32_t))
+/* ext_len of the creators which record item_index_slots. */
+#define SHM_CONSTRUCT_EXT_ITEM_INDEX_LEN    (offsetof(shm_construct_ext_t, item_index_slots) + sizeof(uint32_t))
+/* ext_len of the creators which record release_word. */
+#define SHM_CONSTRUCT_EXT_RELEASE_LEN       (offsetof(shm_construct_ext_t, release_word) + sizeof(uint32_t))
+
+/**
+ *  item index of the variable item ring, the writer keeps the keys of every item
+ *  it commits, readers binary search them instead of parsing the items.
+ *  it lies in the ring's fixed data right after the head, 8 bytes aligned,
+ *  the item at position pos takes slot pos % item_index_slots.
+ *  tag is pos + 1 of the item the slot holds, 0 while the writer updates it.
+ *  the keys are (uint64_t)-1 when the item has none.
+**/
+typedef struct {
+    uint64_t tag;
+    uint64_t tvutimestamp;
+    uint64_t pts;
+} shm_item_index_entry_t;
+
+#define SHM_ITEM_INDEX_OFFSET(head_len)     (((head_len) + 7) & ~7U)
+#define SHM_ITEM_INDEX_KEY_NONE             ((uint64_t)-1)
+
+#define SHM_READER_TABLE_SLOTS      16
+#define SHM_READER_TABLE_LEN        (SHM_READER_TABLE_SLOTS * sizeof(shm_reader_slot_t))
+
+typedef struct {
+    uint64_t owner;//0 free, or (pid << 32 | sequence in that process).
+    uint32_t read_index;//next item index the reader would read.
+    uint32_t reserved;
+    uint64_t heartbeat;//ms, last time the reader polled.
+    uint64_t sync_time;//ms, last time the reader polled and found nothing unread.
+} shm_reader_slot_t;
+
+/**
+ *  statistics block, counters only, the writer and every registered reader update
+ *  their own ones by relaxed stores, anyone may read them without touching the ring.
+ *  readers[i] belongs to slot i of the reader table, cleared when a reader claims it.
+ *  latency_ms[i] counts the items read less than 2^i ms after creating, the last
+ *  bucket the later ones.
+**/
+#define SHM_STATS_BLOCK_LATENCY_BUCKETS     12
+
+typedef struct {
+    uint64_t frames_read;
+    uint64_t frames_dropped;//items skipped when the writer lapped the reader.
+    uint64_t overruns;//times the writer lapped the reader.
+    uint64_t latency_ms[SHM_STATS_BLOCK_LATENCY_BUCKETS];
+} shm_reader_stats_block_t;
+
+typedef struct {
+    uint32_t stats_len;//sizeof(shm_stats_block_t) of the creator.
+    uint32_t reserved;
+    uint64_t frames_written;
+    uint64_t bytes_written;
+    uint64_t max_item_size;
+    uint64_t write_blocked;//lossless writes refused for the slowest reader.
+    shm_reader_stats_block_t readers[SHM_READER_TABLE_SLOTS];
+} shm_stats_block_t;
+
+#define SHM_STATS_BLOCK_LEN         sizeof(shm_stats_block_t)
+
 #pragma pack(pop)
 
 #ifdef __cplusplus
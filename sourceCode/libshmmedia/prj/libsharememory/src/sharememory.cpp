@@ -27,8 +27,15 @@
 #endif
 #include <string.h>
 #include <stdio.h>
+#include <stddef.h>
 #include "shmhead.h"
 #include "sharememory_internal.h"
+#include "libshm_atomic_internal.h"
+#include "libshm_hugepage_internal.h"
+#include "libshm_prefault_internal.h"
+#include "libshm_numa_internal.h"
+#include "libshm_wait_word_internal.h"
+#include "libshm_liveness_internal.h"
 #include "buildversion.h"
 
 #define WAIT_MS_NUM                 1000
@@ -37,6 +44,11 @@
 #include <unistd.h>
 #include <stdarg.h>
 #include <errno.h>
+#if defined(TVU_LINUX)
+#include <signal.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
 #elif defined(TVU_WINDOWS)
 #if (_MSC_VER == 1500)
     #define snprintf(p, count, fmt, ...)    _snprintf(p, (count)-1, fmt, ##__VA_ARGS__)
@@ -69,6 +81,25 @@ unsigned int libshmhead_construct_get_version(const shm_construct_t *pshm)
     return LIBSHMMEDIA_READ_SHM_U32(pshm->version);
 }
 
+#if defined(TVU_LINUX)
+/* futex_waitv of linux 5.16, the headers before it do not know it. */
+#ifndef SYS_futex_waitv
+#define SYS_futex_waitv         449
+#endif
+#define SHM_FUTEX2_SIZE_U32     0x02
+#define SHM_FUTEX_WAITV_MAX     128
+
+struct shm_futex_waitv
+{
+    uint64_t    val;
+    uint64_t    uaddr;
+    uint32_t    flags;
+    uint32_t    reserved;
+};
+#endif
+
+#define kShmWakeupWaitMaxMs     100 /* still re-check close flag & removed status in time */
+
 static int default_cb(int level, const char *fmt, ...)
 {
     va_list ap;
@@ -178,12 +209,31 @@ int CTvuBaseShareMemory::InitCreateShm(uint32_t header_len, uint32_t item_count,
 #if _SHM_HEAD_FEATURE_EXT_EABLE
     shm_construct_ext_t *pext = (shm_construct_ext_t *)(m_pHeader + SHM_MEDIA_HEAD_INFO_V4_OFFSET);
     pext->ext_ver   = SHM_CONSTRUCT_EXT_VER;
-    pext->reserve   = 0;
+    pext->ext_flags = 0;
     m_uExtBufLen    =
     pext->ext_len   = sizeof(shm_construct_ext_t);
-    memset(pext->a_reserve_, 0, sizeof(pext->a_reserve_));
+    pext->wakeup_word = 0;
     pext->item_current_64 = 0;
     pext->last_read_time_stamp = 0;
+    pext->numa_node = LIBSHM_NUMA_NODE_NONE;
+    pext->item_index_slots = 0;
+    pext->release_word = 0;
+#if defined(TVU_LINUX)
+    pext->ext_flags |= kShmConstructExtFlagWakeup;
+    m_bWakeup       = true;
+#endif
+    if (header_len >= SHM_MEDIA_HEAD_INFO_V4_OFFSET + sizeof(shm_construct_ext_t) + SHM_READER_TABLE_LEN)
+    {
+        pext->ext_flags |= kShmConstructExtFlagReaderTable;
+        m_bReaderTable  = true;
+    }
+    if (m_bReaderTable
+        && header_len >= SHM_MEDIA_HEAD_INFO_V4_OFFSET + sizeof(shm_construct_ext_t) + SHM_READER_TABLE_LEN + SHM_STATS_BLOCK_LEN)
+    {
+        pext->ext_flags |= kShmConstructExtFlagStats;
+        m_bStats        = true;
+        ((shm_stats_block_t *)_statsBlock())->stats_len = SHM_STATS_BLOCK_LEN;
+    }
 #endif
 
     m_uVersion      = MEMHEADER_CURRENT_VERSION;
@@ -214,7 +264,7 @@ int CTvuBaseShareMemory::InitOpenShm()
         m_uVersion      = LIBSHMMEDIA_READ_SHM_U32(p1->version);
         m_uItemLen      = LIBSHMMEDIA_READ_SHM_U32(p1->item_length);
         m_uItemCounts   = LIBSHMMEDIA_READ_SHM_U32(p1->item_count);
-        m_uReadIndex    = LIBSHMMEDIA_READ_SHM_U32(p1->item_current);
+        m_uReadIndex    = LIBSHMMEDIA_READ_SHM_U32(_libshm_atomic_load_acquire_u32(&p1->item_current));
         m_uHeadLen      = LIBSHMMEDIA_READ_SHM_U32(p1->item_offset);
 
     #if _SHM_HEAD_FEATURE_EXT_EABLE
@@ -225,6 +275,14 @@ int CTvuBaseShareMemory::InitOpenShm()
             case kShmConstructExtVer1:
             {
                 m_uExtBufLen = pext->ext_len;
+            #if defined(TVU_LINUX)
+                m_bWakeup = (pext->ext_flags & kShmConstructExtFlagWakeup) ? true : false;
+            #endif
+                m_bReaderTable = (pext->ext_flags & kShmConstructExtFlagReaderTable)
+                    && m_uHeadLen >= SHM_MEDIA_HEAD_INFO_V4_OFFSET + m_uExtBufLen + SHM_READER_TABLE_LEN;
+                m_bLossless = m_bReaderTable && (pext->ext_flags & kShmConstructExtFlagLossless);
+                m_bStats = m_bReaderTable && (pext->ext_flags & kShmConstructExtFlagStats)
+                    && m_uHeadLen >= SHM_MEDIA_HEAD_INFO_V4_OFFSET + m_uExtBufLen + SHM_READER_TABLE_LEN + SHM_STATS_BLOCK_LEN;
             }
             break;
             default:
@@ -243,6 +301,21 @@ int CTvuBaseShareMemory::InitOpenShm()
 CTvuBaseShareMemory::CTvuBaseShareMemory(void)
 :m_hMapFile(NULL)
 ,m_pHeader(NULL)
+,m_bWakeup(false)
+,m_bReaderTable(false)
+,m_bLossless(false)
+,m_bStats(false)
+,m_bHugePage(false)
+,m_iPageBacking(SHM_PAGE_BACKING_NORMAL)
+,m_bPrefault(false)
+,m_bLock(false)
+,m_bMonitor(false)
+,m_iPrefaultUs(0)
+,m_iNumaNode(LIBSHM_NUMA_NODE_NONE)
+,m_pReaderSlot(NULL)
+,m_uReaderToken(0)
+,m_bReaderEvicted(false)
+,m_iLogLevel(-1)
 {
     memset(m_memoryName, '\0', MAX_SHARE_MEMROY_NAME);
     DEBUG_INFO("%s this(0X%x)\n", __FUNCTION__, this);
@@ -324,14 +397,14 @@ uint8_t* CTvuBaseShareMemory::Open(const char * pMemoryName)
     if (NULL == m_pHeader) {
         strncpy(m_memoryName, pMemoryName, MAX_SHARE_MEMROY_NAME-1);
         DEBUG_INFO("%s %s this(0X%x)\n", __FUNCTION__, m_memoryName, this);
-        m_hMapFile = OpenFileMapping(FILE_MAP_ALL_ACCESS, TRUE, pMemoryName);
+        m_hMapFile = OpenFileMapping(m_bMonitor ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS, TRUE, pMemoryName);
         if (m_hMapFile == NULL)
         {
             DEBUG_ERROR("Could not open file mapping object %s (%d).\n", pMemoryName, GetLastError());
             return NULL;
         }
 
-        m_pHeader = (uint8_t *)MapViewOfFile(m_hMapFile,FILE_MAP_READ|FILE_MAP_WRITE,0,0,0);
+        m_pHeader = (uint8_t *)MapViewOfFile(m_hMapFile,m_bMonitor ? FILE_MAP_READ : FILE_MAP_READ|FILE_MAP_WRITE,0,0,0);
 
         if (m_pHeader == NULL){
             DEBUG_ERROR("Could not map view of file %s (%d).\n", pMemoryName, GetLastError());
@@ -357,6 +430,7 @@ uint8_t* CTvuBaseShareMemory::Open(const char * pMemoryName)
 int CTvuBaseShareMemory::CloseMapFileAndSleep()
 {
     DEBUG_INFO("%s %s this(0X%x)\n", __FUNCTION__, m_memoryName, this);
+    _releaseReaderSlot();
     if(m_hMapFile) {
         int ret = ::CloseHandle(m_hMapFile);
         if(!ret)
@@ -382,6 +456,7 @@ int CTvuBaseShareMemory::CloseMapFileAndSleep()
 int CTvuBaseShareMemory::CloseMapFile()
 {
     DEBUG_INFO("%s %s this(0X%x)\n", __FUNCTION__, m_memoryName, this);
+    _releaseReaderSlot();
     if(m_hMapFile) {
         int ret = ::CloseHandle(m_hMapFile);
         if(!ret)
@@ -417,7 +492,7 @@ static inline bool  _is_shm_removed(const char *__name)
     snprintf(skeyfile, sizeof(skeyfile), "%s/%s", PREFIX_KEY_FILE, __name);
     int ret = stat(skeyfile, &os);
 
-    return ( ret == 0 ) ? false : true;
+    return ( ret == 0 || _libshm_hugetlbfs_exists(__name) ) ? false : true;
 }
 
 CTvuBaseShareMemory::CTvuBaseShareMemory(void)
@@ -434,6 +509,21 @@ CTvuBaseShareMemory::CTvuBaseShareMemory(void)
     m_iFlags    = 0;
     m_iShmId=-1;
     m_tmRemoveCheck = 0;
+    m_bWakeup   = false;
+    m_bReaderTable  = false;
+    m_bLossless     = false;
+    m_bStats        = false;
+    m_bHugePage     = false;
+    m_iPageBacking  = SHM_PAGE_BACKING_NORMAL;
+    m_bPrefault     = false;
+    m_bLock         = false;
+    m_bMonitor      = false;
+    m_iPrefaultUs   = 0;
+    m_iNumaNode     = LIBSHM_NUMA_NODE_NONE;
+    m_pReaderSlot   = NULL;
+    m_uReaderToken  = 0;
+    m_bReaderEvicted = false;
+    m_iLogLevel     = -1;
 }
 
 CTvuBaseShareMemory::~CTvuBaseShareMemory(void)
@@ -484,40 +574,49 @@ uint8_t *CTvuBaseShareMemory::CreateOrOpen(const char *pMemoryName, uint32_t hea
             }
         }
 
-        int shm_id=shm_open(pMemoryName, O_CREAT | O_RDWR, mode);
-
-        if (shm_id == -1)
+        if (m_bHugePage)
         {
-            DEBUG_ERROR("SHM Create %s failed %d.\n",pMemoryName,errno);
-            return NULL;
+            m_pHeader = _createHugePage(pMemoryName, isize, mode);
         }
 
-        if (ftruncate(shm_id, (size_t)isize) == -1)
+        if (!m_pHeader)
         {
-            int errorCode=errno;
-            DEBUG_ERROR("failed to ftruncate share memeory size. expected size: %llu, error: %d"
-                , isize
-                , errorCode
-            );
-            shm_unlink(pMemoryName);
-            return NULL;
-        }
+            int shm_id=shm_open(pMemoryName, O_CREAT | O_RDWR, mode);
 
+            if (shm_id == -1)
+            {
+                DEBUG_ERROR("SHM Create %s failed %d.\n",pMemoryName,errno);
+                return NULL;
+            }
 
-        m_iFlags = SHM_FLAG_WRITE; /* if shmat failed, make sure closing action go through removing share memory action */
-        m_iShmId    = shm_id;
-        m_iShmSize  = isize;
+            if (ftruncate(shm_id, (size_t)isize) == -1)
+            {
+                int errorCode=errno;
+                DEBUG_ERROR("failed to ftruncate share memeory size. expected size: %llu, error: %d"
+                    , isize
+                    , errorCode
+                );
+                shm_unlink(pMemoryName);
+                return NULL;
+            }
 
-        m_pHeader = (uint8_t *)mmap(NULL, (size_t)isize, PROT_READ | PROT_WRITE, MAP_SHARED, shm_id, 0);
-        if (m_pHeader == MAP_FAILED || m_pHeader == NULL)
-        {
-            int errorCode=errno;
-            DEBUG_ERROR("failed to mmap share memeory size. expected size: %llu, error: %d"
-                , isize
-                , errorCode
-            );
-            shm_unlink(pMemoryName);
-            return NULL;
+
+            m_iFlags = SHM_FLAG_WRITE; /* if shmat failed, make sure closing action go through removing share memory action */
+            m_iShmId    = shm_id;
+            m_iShmSize  = isize;
+            m_iPageBacking  = SHM_PAGE_BACKING_NORMAL;
+
+            m_pHeader = (uint8_t *)mmap(NULL, (size_t)isize, PROT_READ | PROT_WRITE, MAP_SHARED, shm_id, 0);
+            if (m_pHeader == MAP_FAILED || m_pHeader == NULL)
+            {
+                int errorCode=errno;
+                DEBUG_ERROR("failed to mmap share memeory size. expected size: %llu, error: %d"
+                    , isize
+                    , errorCode
+                );
+                shm_unlink(pMemoryName);
+                return NULL;
+            }
         }
 
         {
@@ -528,19 +627,133 @@ uint8_t *CTvuBaseShareMemory::CreateOrOpen(const char *pMemoryName, uint32_t hea
             }
 
             DEBUG_INFO("create const shm success."\
-                "nm:%s, id:%d, ver %d, head len : %d, counts : %d, item len : %d, mem address %p, build version{%s}, build version number %d\n"
+                "nm:%s, id:%d, ver %d, head len : %d, counts : %d, item len : %d, mem address %p, page backing %d, build version{%s}, build version number %d\n"
                 , m_memoryName, m_iShmId, \
                 m_uVersion, m_uHeadLen, m_uItemCounts, \
-                m_uItemLen, m_pHeader, BUILD_VERSION, BUILD_VERSION_NUM
+                m_uItemLen, m_pHeader, m_iPageBacking, BUILD_VERSION, BUILD_VERSION_NUM
             );
         }
     }
 
 EXIT:
     m_iFlags    = SHM_FLAG_WRITE;
+    if (m_pHeader)
+    {
+        _bindNuma();
+        _warmup(true);
+    }
     return m_pHeader;
 }
 
+/**
+ *  place the mapping on the node SetNumaNode asked and record it in the ext head,
+ *  it runs before the warm up, so the prefaulted pages land on the node.
+ */
+void CTvuBaseShareMemory::_bindNuma()
+{
+    if (m_iNumaNode == LIBSHM_NUMA_NODE_NONE || m_uExtBufLen < SHM_CONSTRUCT_EXT_NUMA_LEN)
+    {
+        return;
+    }
+
+    shm_construct_ext_t *pext = (shm_construct_ext_t *)(m_pHeader + SHM_MEDIA_HEAD_INFO_V4_OFFSET);
+    int ret = _libshm_numa_bind(m_pHeader, m_iShmSize, m_iNumaNode);
+
+    if (ret)
+    {
+        DEBUG_WARN("shm[%s] bind to numa node %d failed %d, placed by the default policy\n"
+            , m_memoryName, m_iNumaNode, ret);
+        pext->numa_node = LIBSHM_NUMA_NODE_NONE;
+        return;
+    }
+
+    pext->numa_node = m_iNumaNode;
+    DEBUG_INFO("shm[%s] bound to numa node %d\n", m_memoryName, m_iNumaNode);
+}
+
+/**
+ *  fault in and lock the whole mapping as SetPrefault asked, failures only warn,
+ *  the region works as well, but the first lap of the ring pays the faults.
+ */
+void CTvuBaseShareMemory::_warmup(bool bForWriting)
+{
+    if (!m_bPrefault && !m_bLock)
+    {
+        return;
+    }
+
+    int64_t tmStart = _libshm_get_sys_us64();
+    int ret = 0;
+
+    if (m_bPrefault)
+    {
+        ret = _libshm_prefault(m_pHeader, m_iShmSize, bForWriting);
+        if (ret)
+        {
+            DEBUG_WARN("shm[%s] prefault %zu bytes failed %d\n", m_memoryName, m_iShmSize, ret);
+        }
+    }
+
+    if (m_bLock)
+    {
+        ret = _libshm_mlock(m_pHeader, m_iShmSize);
+        if (ret)
+        {
+            DEBUG_WARN("shm[%s] mlock %zu bytes failed %d, check RLIMIT_MEMLOCK\n", m_memoryName, m_iShmSize, ret);
+        }
+    }
+
+    m_iPrefaultUs   = _libshm_get_sys_us64() - tmStart;
+    DEBUG_INFO("shm[%s] warmed up, size %zu, prefault %d, lock %d, took %" PRId64 " us\n"
+        , m_memoryName, m_iShmSize, m_bPrefault, m_bLock, m_iPrefaultUs);
+}
+
+/**
+ *  Return:
+ *      NULL : hugepage not available, the caller falls back to normal pages.
+ */
+uint8_t *CTvuBaseShareMemory::_createHugePage(const char *pMemoryName, size_t isize, mode_t mode)
+{
+    size_t pagesize = _libshm_hugetlbfs_page_size();
+
+    if (!pagesize)
+    {
+        DEBUG_WARN("no hugetlbfs mount at %s, shm[%s] uses normal pages\n", _libshm_hugetlbfs_dir(), pMemoryName);
+        return NULL;
+    }
+
+    int shm_id = _libshm_hugetlbfs_open(pMemoryName, O_CREAT | O_RDWR, mode);
+
+    if (shm_id == -1)
+    {
+        DEBUG_WARN("hugetlbfs create %s failed %d, uses normal pages\n", pMemoryName, errno);
+        return NULL;
+    }
+
+    /* hugetlbfs only maps whole huge pages, mmap fails when the pool is too small. */
+    size_t msize = _libshm_hugepage_align(isize, pagesize);
+    uint8_t *paddr = NULL;
+
+    if (ftruncate(shm_id, (off_t)msize) == 0)
+    {
+        paddr = (uint8_t *)mmap(NULL, msize, PROT_READ | PROT_WRITE, MAP_SHARED, shm_id, 0);
+    }
+
+    if (paddr == MAP_FAILED || paddr == NULL)
+    {
+        DEBUG_WARN("hugetlbfs map %s failed %d, size:%zu, uses normal pages\n", pMemoryName, errno, msize);
+        close(shm_id);
+        _libshm_hugetlbfs_unlink(pMemoryName);
+        return NULL;
+    }
+
+    m_iFlags        = SHM_FLAG_WRITE;
+    m_iShmId        = shm_id;
+    m_iShmSize      = msize;
+    m_iPageBacking  = SHM_PAGE_BACKING_HUGETLBFS;
+    return paddr;
+}
+
 bool CTvuBaseShareMemory::_isShmRemovedFromKernal()
 {
     bool  bret = false;
@@ -563,8 +776,25 @@ uint8_t *CTvuBaseShareMemory::_open(const char *pMemoryName, bool bForWriting)
     {
         snprintf(m_memoryName, MAX_SHARE_MEMROY_NAME-1, "%s", pMemoryName);
         int shm_id = -1;
+        /* a monitor only peeks, read permission is enough for it. */
+        bool bReadOnly = m_bMonitor && !bForWriting;
+        int oflag = bReadOnly ? O_RDONLY : O_RDWR;
+
+        shm_id  = shm_open(pMemoryName, oflag, S_IRUSR | S_IWUSR);
+        m_iPageBacking  = SHM_PAGE_BACKING_NORMAL;
 
-        shm_id  = shm_open(pMemoryName, O_RDWR, S_IRUSR | S_IWUSR);
+        if (shm_id == -1 && errno == ENOENT)
+        {
+            shm_id  = _libshm_hugetlbfs_open(pMemoryName, oflag, S_IRUSR | S_IWUSR);
+            if (shm_id != -1)
+            {
+                m_iPageBacking  = SHM_PAGE_BACKING_HUGETLBFS;
+            }
+            else
+            {
+                errno   = ENOENT;
+            }
+        }
 
         if (shm_id == -1)
         {
@@ -598,7 +828,7 @@ uint8_t *CTvuBaseShareMemory::_open(const char *pMemoryName, bool bForWriting)
 
         size_t existingSize= shmStat.st_size;
 
-        m_pHeader = (uint8_t *)mmap(NULL, existingSize, PROT_READ | PROT_WRITE, MAP_SHARED, shm_id, 0);
+        m_pHeader = (uint8_t *)mmap(NULL, existingSize, bReadOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, shm_id, 0);
 
         if (m_pHeader == MAP_FAILED || m_pHeader == NULL)
         {
@@ -626,13 +856,22 @@ uint8_t *CTvuBaseShareMemory::_open(const char *pMemoryName, bool bForWriting)
 
 uint8_t *CTvuBaseShareMemory::Open(const char *pMemoryName)
 {
-    return _open(pMemoryName, false);
+    uint8_t *p = _open(pMemoryName, false);
+    if (p)
+    {
+        _warmup(false);
+    }
+    return p;
 }
 
 static int _remove_shm_from_kernal(const char *__name)
 {
     int retval = 0;
     retval = shm_unlink(__name);
+    if (retval != 0 && _libshm_hugetlbfs_unlink(__name) == 0)
+    {
+        retval  = 0;
+    }
     return retval;
 }
 
@@ -643,6 +882,7 @@ int CTvuBaseShareMemory::CloseMapFile()
 
     shm_id  = m_iShmId;
 
+    _releaseReaderSlot();
     if (m_pHeader)
     {
         DEBUG_INFO(
@@ -692,12 +932,60 @@ int CTvuBaseShareMemory::RemoveShmFromKernal(const char *shmname)
 
     if (ret != 0)
     {
-        DEBUG_ERROR("@[%s, %d]remove shm [%s]failed, ret %d\n"
+        DEBUG_ERROR_H(LIBSHM_LOG_LEVEL_DEFAULT, "@[%s, %d]remove shm [%s]failed, ret %d\n"
             , __FUNCTION__, __LINE__, shmname, ret);
     }
     return ret;
 }
 
+int CTvuBaseShareMemory::ProbeShm(const char *shmname)
+{
+    shm_construct_t head;
+    struct stat     os;
+    int             ret     = 0;
+
+    if (!shmname)
+    {
+        return -EINVAL;
+    }
+
+    int shm_id = shm_open(shmname, O_RDONLY, 0);
+    if (shm_id == -1 && errno == ENOENT)
+    {
+        shm_id = _libshm_hugetlbfs_open(shmname, O_RDONLY, 0);
+        if (shm_id == -1)
+        {
+            errno = ENOENT;
+        }
+    }
+
+    if (shm_id == -1)
+    {
+        return -errno;
+    }
+
+    if (fstat(shm_id, &os) != 0)
+    {
+        ret = -errno;
+    }
+    else if (pread(shm_id, &head, sizeof(head), 0) == (ssize_t)sizeof(head))
+    {
+        uint32_t ver     = libshmhead_construct_get_version(&head);
+        uint64_t counts  = LIBSHMMEDIA_READ_SHM_U32(head.item_count);
+        uint64_t length  = LIBSHMMEDIA_READ_SHM_U32(head.item_length);
+        uint64_t offset  = LIBSHMMEDIA_READ_SHM_U32(head.item_offset);
+
+        /* the compact ring starts with its magic code, no version of ours reads like it. */
+        if (ver >= MEMHEADER_V1 && ver <= MEMHEADER_V5 && counts && length
+            && offset >= sizeof(head) && offset + counts * length <= (uint64_t)os.st_size)
+        {
+            ret = 1;
+        }
+    }
+    close(shm_id);
+    return ret;
+}
+
 #else
 
 
@@ -733,6 +1021,21 @@ CTvuBaseShareMemory::CTvuBaseShareMemory(void)
     m_iFlags    = 0;
     m_iKey = -1;
     m_iShmId=-1;
+    m_bWakeup   = false;
+    m_bReaderTable  = false;
+    m_bLossless     = false;
+    m_bStats        = false;
+    m_bHugePage     = false;
+    m_iPageBacking  = SHM_PAGE_BACKING_NORMAL;
+    m_bPrefault     = false;
+    m_bLock         = false;
+    m_bMonitor      = false;
+    m_iPrefaultUs   = 0;
+    m_iNumaNode     = LIBSHM_NUMA_NODE_NONE;
+    m_pReaderSlot   = NULL;
+    m_uReaderToken  = 0;
+    m_bReaderEvicted = false;
+    m_iLogLevel     = -1;
 }
 
 CTvuBaseShareMemory::~CTvuBaseShareMemory(void)
@@ -897,7 +1200,7 @@ uint8_t *CTvuBaseShareMemory::_open(const char *pMemoryName, bool bForWriting)
             m_iFlags    = SHM_FLAG_READ;
         }
 
-        m_pHeader = (uint8_t *)shmat(shm_id, NULL, 0);
+        m_pHeader = (uint8_t *)shmat(shm_id, NULL, (m_bMonitor && !bForWriting) ? SHM_RDONLY : 0);
 
         if (m_pHeader == (void *) -1)
         {
@@ -951,6 +1254,7 @@ int CTvuBaseShareMemory::CloseMapFile()
     m_iKey  = -1;
     shm_id  = m_iShmId;
 
+    _releaseReaderSlot();
     if (m_pHeader)
     {
         DEBUG_INFO("deattached memory from process\n");
@@ -991,7 +1295,7 @@ int CTvuBaseShareMemory::RemoveShmFromKernal(const char *shmname)
 
     if (-1 == key)
     {
-        DEBUG_INFO("could not get the key fronm shm[%s]\n", shmname);
+        DEBUG_INFO_H(LIBSHM_LOG_LEVEL_DEFAULT, "could not get the key fronm shm[%s]\n", shmname);
         return 0;
     }
 
@@ -999,13 +1303,19 @@ int CTvuBaseShareMemory::RemoveShmFromKernal(const char *shmname)
 
     if (shmid == -1)
     {
-        DEBUG_INFO("could not get the shmid from shm[%s]\n", shmname);
+        DEBUG_INFO_H(LIBSHM_LOG_LEVEL_DEFAULT, "could not get the shmid from shm[%s]\n", shmname);
         return 0;
     }
 
     return _remove_shm_from_kernal(shmid);
 }
 
+int CTvuBaseShareMemory::ProbeShm(const char *shmname)
+{
+    (void)shmname;
+    return -ENOTSUP;
+}
+
 #endif
 
 #endif
@@ -1044,6 +1354,17 @@ uint32_t  CTvuBaseShareMemory::GetReadIndex()
 void CTvuBaseShareMemory::SetReadIndex(uint32_t index)
 {
     m_uReadIndex = index;
+    _publishReadIndex();
+}
+
+void CTvuBaseShareMemory::HoldReadIndex(uint32_t index)
+{
+    if (_ownReaderSlot())
+    {
+        shm_reader_slot_t *pslot = (shm_reader_slot_t *)m_pReaderSlot;
+        _libshm_atomic_store_release_u32(&pslot->read_index, index);
+        _libshm_atomic_store_relaxed_u64(&pslot->heartbeat, _libshm_get_sys_ms64());
+    }
 }
 
 uint32_t    CTvuBaseShareMemory::GetShmVerBeforeCreate()
@@ -1052,13 +1373,26 @@ uint32_t    CTvuBaseShareMemory::GetShmVerBeforeCreate()
 }
 
 uint32_t    CTvuBaseShareMemory::GetExtBuffLen() { return m_uExtBufLen; }
+
+int CTvuBaseShareMemory::GetNumaNode()
+{
+#if _SHM_HEAD_FEATURE_EXT_EABLE
+    if (m_pHeader && m_uExtBufLen >= SHM_CONSTRUCT_EXT_NUMA_LEN)
+    {
+        shm_construct_ext_t *pext = (shm_construct_ext_t *)(m_pHeader + SHM_MEDIA_HEAD_INFO_V4_OFFSET);
+        return pext->numa_node;
+    }
+#endif
+    return LIBSHM_NUMA_NODE_NONE;
+}
+
 uint32_t    CTvuBaseShareMemory::GetPreExtBuffSize() { return sizeof(shm_construct_ext_t); }
 
 uint32_t    CTvuBaseShareMemory::GetWriteIndex()
 {
     uint32_t        index           = 0;
     shm_construct_t   *p1           = (shm_construct_t*)m_pHeader;
-    index    = LIBSHMMEDIA_READ_SHM_U32(p1->item_current);
+    index    = LIBSHMMEDIA_READ_SHM_U32(_libshm_atomic_load_acquire_u32(&p1->item_current));
     return  index;
 }
 
@@ -1090,23 +1424,581 @@ void CTvuBaseShareMemory::FinishWrite()
     shm_construct_t *p1         = (shm_construct_t*)m_pHeader;
 
     if (m_iFlags & SHM_FLAG_WRITE) {
-#if SHM_ENDIAN_CONVERT
+        /* only the creator moves the write index, the item was filled before, publish it by release. */
         uint32_t windx = LIBSHMMEDIA_READ_SHM_U32(p1->item_current);
-        p1->item_current = LIBSHMMEDIA_WRITE_SHM_U32(windx+1);
-#else
-        p1->item_current++;
+#if _SHM_HEAD_FEATURE_EXT_EABLE
+        if (m_uExtBufLen >= offsetof(shm_construct_ext_t, last_read_time_stamp))
+        {
+            shm_construct_ext_t *pext = (shm_construct_ext_t *)(m_pHeader + SHM_MEDIA_HEAD_INFO_V4_OFFSET);
+            uint64_t windx64 = LIBSHMMEDIA_READ_SHM_U64(pext->item_current_64);
+            _libshm_atomic_store_release_u64(&pext->item_current_64, LIBSHMMEDIA_WRITE_SHM_U64(windx64+1));
+        }
 #endif
+        _libshm_atomic_store_release_u32(&p1->item_current, LIBSHMMEDIA_WRITE_SHM_U32(windx+1));
+        WakeupReaders();
     }
     return;
 }
 
+uint32_t *CTvuBaseShareMemory::_wakeupWord()
+{
+#if defined(TVU_LINUX) && _SHM_HEAD_FEATURE_EXT_EABLE
+    /* arming the word writes it, a read-only monitor polls. */
+    if (m_bWakeup && m_pHeader && !m_bMonitor)
+    {
+        return (uint32_t *)(m_pHeader + SHM_MEDIA_HEAD_INFO_V4_OFFSET + offsetof(shm_construct_ext_t, wakeup_word));
+    }
+#endif
+    return NULL;
+}
+
+bool CTvuBaseShareMemory::IsWakeupSupported()
+{
+    return _wakeupWord() ? true : false;
+}
+
+uint32_t CTvuBaseShareMemory::GetWakeupSeq()
+{
+    uint32_t *pword = _wakeupWord();
+    if (!pword)
+    {
+        return 0;
+    }
+    return __atomic_load_n(pword, __ATOMIC_ACQUIRE);
+}
+
+void CTvuBaseShareMemory::WakeupReaders()
+{
+    uint32_t *pword = _wakeupWord();
+    if (pword)
+    {
+        /* publishes item_current before the new sequence. */
+        _libshm_wait_word_wake(pword);
+    }
+    return;
+}
+
+void CTvuBaseShareMemory::WaitForWrite(uint32_t seq, unsigned int timeout)
+{
+    uint32_t *pword = _wakeupWord();
+
+    if (!pword)
+    {
+        _libshm_common_msleep(1);
+        return;
+    }
+
+#if defined(TVU_LINUX)
+    if (timeout > kShmWakeupWaitMaxMs)
+    {
+        timeout = kShmWakeupWaitMaxMs;
+    }
+
+    uint32_t sleepval = 0;
+    if (!_libshm_wait_word_arm(pword, seq, &sleepval))
+    {
+        return;
+    }
+
+    _libshm_wait_word_sleep(pword, sleepval, timeout);
+#endif
+    return;
+}
+
+void CTvuBaseShareMemory::WaitForWriteAny(CTvuBaseShareMemory * const *shms, const uint32_t *seqs, int n, unsigned int timeout)
+{
+    if (n == 1)
+    {
+        shms[0]->WaitForWrite(seqs[0], timeout);
+        return;
+    }
+
+#if defined(TVU_LINUX)
+    struct shm_futex_waitv waiters[SHM_FUTEX_WAITV_MAX];
+
+    if (n <= 0 || n > SHM_FUTEX_WAITV_MAX)
+    {
+        _libshm_common_msleep(1);
+        return;
+    }
+
+    if (timeout > kShmWakeupWaitMaxMs)
+    {
+        timeout = kShmWakeupWaitMaxMs;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        uint32_t *pword = shms[i]->_wakeupWord();
+        uint32_t sleepval = 0;
+
+        if (!pword)
+        {
+            /* one of them could only be polled. */
+            _libshm_common_msleep(1);
+            return;
+        }
+
+        if (!_libshm_wait_word_arm(pword, seqs[i], &sleepval))
+        {
+            return;
+        }
+
+        waiters[i].val      = sleepval;
+        waiters[i].uaddr    = (uint64_t)(uintptr_t)pword;
+        waiters[i].flags    = SHM_FUTEX2_SIZE_U32;
+        waiters[i].reserved = 0;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec   += timeout / 1000;
+    ts.tv_nsec  += (timeout % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    if (syscall(SYS_futex_waitv, waiters, n, 0, &ts, CLOCK_MONOTONIC) < 0 && errno == ENOSYS)
+    {
+        /* kernels before 5.16, sleep on the first word for a short while. */
+        struct timespec rel;
+        rel.tv_sec  = 0;
+        rel.tv_nsec = 1000000L;
+        _libshm_futex((uint32_t *)(uintptr_t)waiters[0].uaddr, FUTEX_WAIT, (uint32_t)waiters[0].val, &rel);
+    }
+#else
+    _libshm_common_msleep(1);
+#endif
+    return;
+}
+
 void CTvuBaseShareMemory::FinishRead()
 {
     if (m_iFlags & SHM_FLAG_READ) {
         m_uReadIndex++;
+        _publishReadIndex();
+        CountRead(1);
     }
 }
 
+static inline uint32_t _shm_reader_owner_pid(uint64_t owner)
+{
+    return (uint32_t)(owner >> 32);
+}
+
+static inline uint32_t _shm_current_pid()
+{
+#if defined(TVU_WINDOWS)
+    return (uint32_t)GetCurrentProcessId();
+#else
+    return (uint32_t)getpid();
+#endif
+}
+
+/* the heartbeat of the slot decides, the pid is only a hint, see libshm_liveness_internal.h. */
+static bool _shm_reader_slot_expired(const shm_reader_slot_t *pslot, uint64_t owner, uint64_t now)
+{
+    return !owner || _libshm_slot_expired(_shm_reader_owner_pid(owner), &pslot->heartbeat, now);
+}
+
+uint8_t *CTvuBaseShareMemory::_readerTable()
+{
+#if _SHM_HEAD_FEATURE_EXT_EABLE
+    if (m_bReaderTable && m_pHeader)
+    {
+        return m_pHeader + SHM_MEDIA_HEAD_INFO_V4_OFFSET + m_uExtBufLen;
+    }
+#endif
+    return NULL;
+}
+
+bool CTvuBaseShareMemory::IsReaderTableSupported()
+{
+    return _readerTable() ? true : false;
+}
+
+uint32_t CTvuBaseShareMemory::GetReaderTableLen()
+{
+    return SHM_READER_TABLE_LEN;
+}
+
+bool CTvuBaseShareMemory::RegisterReader()
+{
+    static uint32_t s_uReaderSeq = 0;
+    shm_reader_slot_t *ptable = (shm_reader_slot_t *)_readerTable();
+
+    if (!ptable || !(m_iFlags & SHM_FLAG_READ))
+    {
+        return false;
+    }
+
+    if (m_pReaderSlot)
+    {
+        return true;
+    }
+
+    uint32_t seq = _libshm_atomic_inc_u32(&s_uReaderSeq);
+    uint64_t token = ((uint64_t)_shm_current_pid() << 32) | (seq ? seq : 1);
+    uint64_t now = _libshm_get_sys_ms64();
+
+    for (int i = 0; i < SHM_READER_TABLE_SLOTS; i++)
+    {
+        shm_reader_slot_t *pslot = ptable + i;
+        uint64_t owner = _libshm_atomic_load_acquire_u64(&pslot->owner);
+
+        if (!_shm_reader_slot_expired(pslot, owner, now)
+            || !_libshm_atomic_cas_u64(&pslot->owner, owner, token))
+        {
+            continue;
+        }
+
+        _libshm_atomic_store_relaxed_u32(&pslot->read_index, m_uReadIndex);
+        _libshm_atomic_store_relaxed_u64(&pslot->heartbeat, now);
+        _libshm_atomic_store_relaxed_u64(&pslot->sync_time, now);
+        m_pReaderSlot   = pslot;
+        m_uReaderToken  = token;
+
+        shm_reader_stats_block_t *pstats = (shm_reader_stats_block_t *)_readerStats();
+        if (pstats)
+        {
+            memset((void *)pstats, 0, sizeof(*pstats));
+        }
+        return true;
+    }
+
+    DEBUG_WARN("reader table of shm %s was full, %d slots\n", m_memoryName, SHM_READER_TABLE_SLOTS);
+    return false;
+}
+
+void CTvuBaseShareMemory::_releaseReaderSlot()
+{
+    if (m_pReaderSlot && m_pHeader)
+    {
+        shm_reader_slot_t *pslot = (shm_reader_slot_t *)m_pReaderSlot;
+        _libshm_atomic_cas_u64(&pslot->owner, m_uReaderToken, 0);
+
+        uint32_t *pword = _releaseWord();
+        if (pword)
+        {
+            _libshm_wait_word_wake_armed(pword);
+        }
+    }
+    m_pReaderSlot   = NULL;
+    m_uReaderToken  = 0;
+    m_bReaderEvicted = false;
+}
+
+/**
+ *  the slot is only written while this reader still owns it, a slot silent too long
+ *  could have been taken back and given to another reader. it is dropped then, and
+ *  the reader is flagged evicted for the next Readable().
+ */
+bool CTvuBaseShareMemory::_ownReaderSlot()
+{
+    if (!m_pReaderSlot)
+    {
+        return false;
+    }
+
+    shm_reader_slot_t *pslot = (shm_reader_slot_t *)m_pReaderSlot;
+    if (_libshm_atomic_load_acquire_u64(&pslot->owner) == m_uReaderToken)
+    {
+        return true;
+    }
+
+    DEBUG_WARN("reader slot %d of shm %s was taken back, read index %u\n"
+        , (int)(pslot - (shm_reader_slot_t *)_readerTable()), m_memoryName, m_uReadIndex);
+    m_pReaderSlot   = NULL;
+    m_uReaderToken  = 0;
+    m_bReaderEvicted = true;
+    return false;
+}
+
+void CTvuBaseShareMemory::_publishReadIndex()
+{
+    if (_ownReaderSlot())
+    {
+        shm_reader_slot_t *pslot = (shm_reader_slot_t *)m_pReaderSlot;
+        /* release, a lossless writer may reuse the items before it at once. */
+        _libshm_atomic_store_release_u32(&pslot->read_index, m_uReadIndex);
+        _libshm_atomic_store_relaxed_u64(&pslot->heartbeat, _libshm_get_sys_ms64());
+
+        uint32_t *pword = _releaseWord();
+        if (pword)
+        {
+            _libshm_wait_word_wake_armed(pword);
+        }
+    }
+}
+
+uint32_t *CTvuBaseShareMemory::_releaseWord()
+{
+#if defined(TVU_LINUX) && _SHM_HEAD_FEATURE_EXT_EABLE
+    if (m_bLossless && m_pHeader && m_uExtBufLen >= SHM_CONSTRUCT_EXT_RELEASE_LEN)
+    {
+        return (uint32_t *)(m_pHeader + SHM_MEDIA_HEAD_INFO_V4_OFFSET + offsetof(shm_construct_ext_t, release_word));
+    }
+#endif
+    return NULL;
+}
+
+int CTvuBaseShareMemory::GetReaders(shm_reader_info_t *readers, int max)
+{
+    const shm_reader_slot_t *ptable = (const shm_reader_slot_t *)_readerTable();
+    int n = 0;
+
+    if (!ptable || !readers)
+    {
+        return 0;
+    }
+
+    uint64_t now = _libshm_get_sys_ms64();
+    for (int i = 0; i < SHM_READER_TABLE_SLOTS && n < max; i++)
+    {
+        const shm_reader_slot_t *pslot = ptable + i;
+        uint64_t owner = _libshm_atomic_load_acquire_u64(&pslot->owner);
+
+        if (_shm_reader_slot_expired(pslot, owner, now))
+        {
+            continue;
+        }
+
+        readers[n].pid          = _shm_reader_owner_pid(owner);
+        readers[n].read_index   = _libshm_atomic_load_relaxed_u32(&pslot->read_index);
+        readers[n].heartbeat    = _libshm_atomic_load_relaxed_u64(&pslot->heartbeat);
+        readers[n].sync_time    = _libshm_atomic_load_relaxed_u64(&pslot->sync_time);
+        n++;
+    }
+    return n;
+}
+
+int CTvuBaseShareMemory::SetLossless(bool bLossless)
+{
+    if (!(m_iFlags & SHM_FLAG_WRITE))
+    {
+        return -1;
+    }
+
+    if (bLossless && !IsReaderTableSupported())
+    {
+        DEBUG_ERROR("shm %s can not be lossless, no reader table in head len %u\n", m_memoryName, m_uHeadLen);
+        return -1;
+    }
+
+#if _SHM_HEAD_FEATURE_EXT_EABLE
+    if (m_pHeader && m_uExtBufLen)
+    {
+        shm_construct_ext_t *pext = (shm_construct_ext_t *)(m_pHeader + SHM_MEDIA_HEAD_INFO_V4_OFFSET);
+        if (bLossless)
+            pext->ext_flags |= kShmConstructExtFlagLossless;
+        else
+            pext->ext_flags &= ~kShmConstructExtFlagLossless;
+    }
+#endif
+    m_bLossless = bLossless;
+    return 0;
+}
+
+typedef char _shm_stats_latency_buckets_check[(SHM_STATS_LATENCY_BUCKETS == SHM_STATS_BLOCK_LATENCY_BUCKETS) ? 1 : -1];
+
+uint8_t *CTvuBaseShareMemory::_statsBlock()
+{
+    uint8_t *ptable = _readerTable();
+    return (m_bStats && ptable) ? ptable + SHM_READER_TABLE_LEN : NULL;
+}
+
+void *CTvuBaseShareMemory::_readerStats()
+{
+    shm_stats_block_t *pblock = (shm_stats_block_t *)_statsBlock();
+
+    if (!pblock || !m_pReaderSlot)
+    {
+        return NULL;
+    }
+    return pblock->readers + ((shm_reader_slot_t *)m_pReaderSlot - (shm_reader_slot_t *)_readerTable());
+}
+
+uint32_t CTvuBaseShareMemory::GetStatsBlockLen()
+{
+    return SHM_STATS_BLOCK_LEN;
+}
+
+/* only the owner updates a counter, a load and a store keep it from tearing for the other readers. */
+static inline void _shm_stats_add(uint64_t *pcounter, uint64_t n)
+{
+    _libshm_atomic_store_relaxed_u64(pcounter, _libshm_atomic_load_relaxed_u64(pcounter) + n);
+}
+
+void CTvuBaseShareMemory::CountWrite(uint32_t bytes)
+{
+    shm_stats_block_t *pblock = (shm_stats_block_t *)_statsBlock();
+
+    if (!pblock || !(m_iFlags & SHM_FLAG_WRITE))
+    {
+        return;
+    }
+
+    _shm_stats_add(&pblock->frames_written, 1);
+    _shm_stats_add(&pblock->bytes_written, bytes);
+    if (bytes > _libshm_atomic_load_relaxed_u64(&pblock->max_item_size))
+    {
+        _libshm_atomic_store_relaxed_u64(&pblock->max_item_size, bytes);
+    }
+}
+
+void CTvuBaseShareMemory::CountWriteBlocked()
+{
+    shm_stats_block_t *pblock = (shm_stats_block_t *)_statsBlock();
+
+    if (pblock && (m_iFlags & SHM_FLAG_WRITE))
+    {
+        _shm_stats_add(&pblock->write_blocked, 1);
+    }
+}
+
+void CTvuBaseShareMemory::CountRead(uint32_t frames)
+{
+    shm_reader_stats_block_t *pstats = (shm_reader_stats_block_t *)_readerStats();
+
+    if (pstats)
+    {
+        _shm_stats_add(&pstats->frames_read, frames);
+    }
+}
+
+void CTvuBaseShareMemory::CountReadLatency(int64_t ms)
+{
+    shm_reader_stats_block_t *pstats = (shm_reader_stats_block_t *)_readerStats();
+
+    if (!pstats)
+    {
+        return;
+    }
+
+    int bucket = 0;
+    while (bucket < SHM_STATS_BLOCK_LATENCY_BUCKETS - 1 && ms >= ((int64_t)1 << bucket))
+    {
+        bucket++;
+    }
+    _shm_stats_add(&pstats->latency_ms[bucket], 1);
+}
+
+int CTvuBaseShareMemory::GetStats(shm_stats_info_t *pstats, shm_reader_stats_info_t *readers, int max)
+{
+    const shm_stats_block_t *pblock = (const shm_stats_block_t *)_statsBlock();
+    const shm_reader_slot_t *ptable = (const shm_reader_slot_t *)_readerTable();
+    int n = 0;
+
+    if (!pblock || !pstats)
+    {
+        return -1;
+    }
+
+    pstats->frames_written  = _libshm_atomic_load_relaxed_u64(&pblock->frames_written);
+    pstats->bytes_written   = _libshm_atomic_load_relaxed_u64(&pblock->bytes_written);
+    pstats->max_item_size   = _libshm_atomic_load_relaxed_u64(&pblock->max_item_size);
+    pstats->write_blocked   = _libshm_atomic_load_relaxed_u64(&pblock->write_blocked);
+
+    uint64_t now = _libshm_get_sys_ms64();
+    for (int i = 0; i < SHM_READER_TABLE_SLOTS && readers && n < max; i++)
+    {
+        const shm_reader_stats_block_t *ps = pblock->readers + i;
+        uint64_t owner = _libshm_atomic_load_acquire_u64(&ptable[i].owner);
+
+        if (_shm_reader_slot_expired(ptable + i, owner, now))
+        {
+            continue;
+        }
+
+        shm_reader_stats_info_t &o = readers[n++];
+        o.pid               = _shm_reader_owner_pid(owner);
+        o.reserved          = 0;
+        o.frames_read       = _libshm_atomic_load_relaxed_u64(&ps->frames_read);
+        o.frames_dropped    = _libshm_atomic_load_relaxed_u64(&ps->frames_dropped);
+        o.overruns          = _libshm_atomic_load_relaxed_u64(&ps->overruns);
+        for (int b = 0; b < SHM_STATS_LATENCY_BUCKETS; b++)
+        {
+            o.latency_ms[b] = _libshm_atomic_load_relaxed_u64(&ps->latency_ms[b]);
+        }
+    }
+    return n;
+}
+
+bool CTvuBaseShareMemory::IsWriteBlocked()
+{
+    const shm_reader_slot_t *ptable = (const shm_reader_slot_t *)_readerTable();
+
+    if (!m_bLossless || !ptable)
+    {
+        return false;
+    }
+
+    /* the item just before read_index could still be referenced by the reader. */
+    uint32_t windx = LIBSHMMEDIA_READ_SHM_U32(((shm_construct_t *)m_pHeader)->item_current);
+    uint32_t maxlag = m_uItemCounts > 1 ? m_uItemCounts - 1 : 1;
+
+    for (int i = 0; i < SHM_READER_TABLE_SLOTS; i++)
+    {
+        shm_reader_slot_t *pslot = (shm_reader_slot_t *)ptable + i;
+        uint64_t owner = _libshm_atomic_load_acquire_u64(&pslot->owner);
+
+        if (!owner)
+        {
+            continue;
+        }
+
+        uint32_t lag = windx - _libshm_atomic_load_acquire_u32(&pslot->read_index);
+        if (lag < maxlag || lag >= 0x80000000U)
+        {
+            continue;
+        }
+
+        /* only a blocking reader is checked for being gone, its slot is freed then. */
+        if (_shm_reader_slot_expired(pslot, owner, _libshm_get_sys_ms64()))
+        {
+            _libshm_atomic_cas_u64(&pslot->owner, owner, 0);
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
+
+void CTvuBaseShareMemory::WaitForRelease(unsigned int timeout)
+{
+    uint32_t *pword = _releaseWord();
+
+    if (!pword || !(m_iFlags & SHM_FLAG_WRITE))
+    {
+        _libshm_common_msleep(1);
+        return;
+    }
+
+    /* still re-check the readers gone without releasing in time. */
+    if (timeout > kShmWakeupWaitMaxMs)
+    {
+        timeout = kShmWakeupWaitMaxMs;
+    }
+
+    uint32_t seq = _libshm_wait_word_load(pword);
+    uint32_t sleepval = 0;
+    if (!IsWriteBlocked() || !_libshm_wait_word_arm(pword, seq, &sleepval))
+    {
+        return;
+    }
+
+    /* a reader released after the first check but saw no waiters bit. */
+    if (!IsWriteBlocked())
+    {
+        return;
+    }
+
+    _libshm_wait_word_sleep(pword, sleepval, timeout);
+    return;
+}
+
 bool CTvuBaseShareMemory::HasReaders(unsigned int timeout)
 {
     bool bret = true;
@@ -1117,7 +2009,7 @@ bool CTvuBaseShareMemory::HasReaders(unsigned int timeout)
         case kShmConstructExtVer1:
         {
             uint64_t now = _libshm_get_sys_ms64();
-            uint64_t time_stamp = pext->last_read_time_stamp;
+            uint64_t time_stamp = _libshm_atomic_load_relaxed_u64(&pext->last_read_time_stamp);
 
             if ((int64_t)(now - time_stamp) > timeout || (time_stamp == 0) )
             {
@@ -1145,7 +2037,11 @@ int CTvuBaseShareMemory::Sendable()
             return -1;
         }
 #endif
-        return  1;  // model regards reading faster then writing
+        if (m_bLossless && IsWriteBlocked())
+        {
+            return 0;
+        }
+        return  1;  // model regards reading faster then writing, except lossless mode
     } else {
         return -1;
     }
@@ -1179,7 +2075,7 @@ int CTvuBaseShareMemory::_readable(bool bClosed)
         {
             shm_construct_t *p1 = (shm_construct_t *)m_pHeader;
             uint32_t    r   = m_uReadIndex;
-            uint32_t    w   = LIBSHMMEDIA_READ_SHM_U32(p1->item_current);
+            uint32_t    w   = LIBSHMMEDIA_READ_SHM_U32(_libshm_atomic_load_acquire_u32(&p1->item_current));
             int gap = w - r;
             uint32_t count = GetItemCounts();
             uint32_t maxgap = count;
@@ -1197,6 +2093,16 @@ int CTvuBaseShareMemory::_readable(bool bClosed)
                             );
                 r += count * (gap/count);
                 m_uReadIndex = r;
+                _publishReadIndex();
+
+                shm_reader_stats_block_t *pstats = (shm_reader_stats_block_t *)_readerStats();
+                if (pstats)
+                {
+                    _libshm_atomic_store_relaxed_u64(&pstats->frames_dropped
+                        , _libshm_atomic_load_relaxed_u64(&pstats->frames_dropped) + count * (gap/count));
+                    _libshm_atomic_store_relaxed_u64(&pstats->overruns
+                        , _libshm_atomic_load_relaxed_u64(&pstats->overruns) + 1);
+                }
                 gap = w - r;
             }
 
@@ -1209,15 +2115,30 @@ int CTvuBaseShareMemory::_readable(bool bClosed)
     }
 }
 
-void CTvuBaseShareMemory::_setReadTime()
+void CTvuBaseShareMemory::_setReadTime(int readable)
 {
 #if _SHM_HEAD_FEATURE_EXT_EABLE
+    if (m_bMonitor)
+    {
+        return;
+    }
+
     shm_construct_ext_t *pext = (shm_construct_ext_t *)(m_pHeader + SHM_MEDIA_HEAD_INFO_V4_OFFSET);
     switch(pext->ext_ver)
     {
         case kShmConstructExtVer1:
         {
-            pext->last_read_time_stamp = _libshm_get_sys_ms64();
+            uint64_t now = _libshm_get_sys_ms64();
+            _libshm_atomic_store_relaxed_u64(&pext->last_read_time_stamp, now);
+            if (_ownReaderSlot())
+            {
+                shm_reader_slot_t *pslot = (shm_reader_slot_t *)m_pReaderSlot;
+                _libshm_atomic_store_relaxed_u64(&pslot->heartbeat, now);
+                if (readable == 0)
+                {
+                    _libshm_atomic_store_relaxed_u64(&pslot->sync_time, now);
+                }
+            }
         }
         break;
         default:
@@ -1243,7 +2164,27 @@ int CTvuBaseShareMemory::Readable(bool bClosed)
         }
     }
 #endif
-    _setReadTime();
+    _setReadTime(ret);
+
+    if (m_bReaderEvicted)
+    {
+        /* only a lossless reader was promised its items, a lossy one takes a slot again quietly. */
+        bool bLossless = m_bLossless;
+#if _SHM_HEAD_FEATURE_EXT_EABLE
+        if (m_uExtBufLen)
+        {
+            /* the writer may have turned lossless on after this reader opened. */
+            shm_construct_ext_t *pext = (shm_construct_ext_t *)(m_pHeader + SHM_MEDIA_HEAD_INFO_V4_OFFSET);
+            bLossless = (pext->ext_flags & kShmConstructExtFlagLossless) ? true : false;
+        }
+#endif
+        m_bReaderEvicted = false;
+        RegisterReader();
+        if (bLossless)
+        {
+            return -EPIPE;
+        }
+    }
     return ret;
 }
 
@@ -33,6 +33,10 @@
 #include "shmhead.h"
 //#include "tvu_util.h"
 #include "shm_variable_item_ring_buff.h"
+#include "libshm_atomic_internal.h"
+#include "libshm_hugepage_internal.h"
+#include "libshm_prefault_internal.h"
+#include "libshm_numa_internal.h"
 #include "buildversion.h"
 
 #if  _TVU_VIARIABLE_SHM_FEATURE_ENABLE
@@ -85,6 +89,12 @@ static inline bool  _is_shm_removed(const char *__name)
     snprintf(skeyfile, sizeof(skeyfile), "%s/%s", PREFIX_KEY_FILE, __name);
     int ret = stat(skeyfile, &os);
 
+#if defined (TVU_LINUX)
+    if (ret != 0 && _libshm_hugetlbfs_exists(__name))
+    {
+        ret = 0;
+    }
+#endif
     return ( ret == 0 ) ? false : true;
 }
 
@@ -142,6 +152,30 @@ bool CTvuVariableItemBaseShm::FinishWrite(const void *buff, size_t s)
     return bRet;
 }
 
+uint8_t *CTvuVariableItemBaseShm::GetWriteItemsAddr(size_t s, size_t counts)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    uint8_t *pret = NULL;
+    if (ptr)
+        pret = (uint8_t *)ptr->ApplyBatch(s, counts);
+    return pret;
+}
+
+bool CTvuVariableItemBaseShm::FinishWriteBatch(const void *buff, const size_t *sizes, size_t counts)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+
+    if (!(m_iFlags & SHM_FLAG_WRITE))
+        return false;
+
+    return ptr->CommitBatch(buff, sizes, counts);
+}
+
+size_t CTvuVariableItemBaseShm::GetBatchItemSpan(size_t s)
+{
+    return tvushm::SharedCompactRingBuffer::BatchItemSpan(s);
+}
+
 uint8_t *CTvuVariableItemBaseShm::GetReadItemAddr(size_t *ps)
 {
     tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
@@ -164,6 +198,17 @@ uint8_t *CTvuVariableItemBaseShm::GetReadItemAddrWithNoStep(size_t *ps)
     return pi;
 }
 
+int CTvuVariableItemBaseShm::GetReadItemAddrBatch(uint8_t **ppItems, size_t *psizes, int max)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    int n = 0;
+    if (ptr && max > 0)
+    {
+        n = (int)ptr->ReadBatch((void **)ppItems, psizes, (size_t)max);
+    }
+    return n;
+}
+
 bool CTvuVariableItemBaseShm::FinishRead()
 {
 //    if (m_iFlags & SHM_FLAG_READ)
@@ -187,16 +232,38 @@ int CTvuVariableItemBaseShm::InitCreateShm(uint32_t header_len, uint32_t item_co
 #if _SHM_HEAD_FEATURE_EXT_EABLE
     shm_construct_ext_t *pext = (shm_construct_ext_t *)(m_pHeader + SHM_MEDIA_HEAD_INFO_V4_OFFSET);
     pext->ext_ver   = SHM_CONSTRUCT_EXT_VER;
-    pext->reserve   = 0;
+    pext->ext_flags = 0;
     m_uExtBufLen    =
     pext->ext_len   = sizeof(shm_construct_ext_t);
-    memset(pext->a_reserve_, 0, sizeof(pext->a_reserve_));
+    pext->wakeup_word = 0;
     pext->item_current_64 = 0;
     pext->last_read_time_stamp = 0;
+    pext->numa_node = LIBSHM_NUMA_NODE_NONE;
+    pext->item_index_slots = 0;
+
+    if (m_bItemIndex)
+    {
+        uint8_t *pfixed = NULL;
+        size_t  fixed_len = 0;
+        uint64_t index_len = (uint64_t)item_count * sizeof(shm_item_index_entry_t);
+
+        GetRingShmFixedData(&pfixed, &fixed_len);
+        if (fixed_len >= SHM_ITEM_INDEX_OFFSET(header_len) + index_len)
+        {
+            memset(m_pHeader + SHM_ITEM_INDEX_OFFSET(header_len), 0, (size_t)index_len);
+            pext->item_index_slots = item_count;
+        }
+        else
+        {
+            DEBUG_WARN("vi shm[%s] fixed data %u too small for the item index of %u items\n"
+                , m_memoryName, (unsigned int)fixed_len, item_count);
+        }
+    }
 #endif
 
     m_uVersion = MEMHEADER_VARIABLE_ITEM_SHM_CURRENT_VERSION;
     p1->version = LIBSHMMEDIA_WRITE_SHM_U32(m_uVersion);
+    _loadItemIndex();
 
     return 0;
 }
@@ -246,6 +313,7 @@ int CTvuVariableItemBaseShm::InitOpenShm()
             break;
         }
 #endif
+        _loadItemIndex();
     }
 
     return ret;
@@ -261,6 +329,18 @@ CTvuVariableItemBaseShm::CTvuVariableItemBaseShm(void)
     memset(m_memoryName, 0, MAX_SHARE_MEMROY_NAME);
     m_iFlags = 0;
     _bForCreate = false;
+    m_bHugePage = false;
+    m_bPrefault = false;
+    m_bLock = false;
+    m_iPrefaultUs = 0;
+    m_iNumaNode = LIBSHM_NUMA_NODE_NONE;
+    m_uPayloadAlignment = 0;
+    m_bLossless = false;
+    m_bItemIndex = false;
+    m_bMonitor = false;
+    m_iLogLevel = -1;
+    m_uItemIndexSlots = 0;
+    m_pItemIndex = NULL;
     CreateRingShm();
     m_tmRemoveCheck = 0;
 }
@@ -280,6 +360,7 @@ uint8_t *CTvuVariableItemBaseShm::CreateOrOpen(const char *pMemoryName, const ui
     bool bshm = false;
     size_t head_size = 0;
     size_t isize = shm_total_size;
+    uint64_t fixed_len = header_len;
 
     _bForCreate = true;
 
@@ -293,10 +374,31 @@ uint8_t *CTvuVariableItemBaseShm::CreateOrOpen(const char *pMemoryName, const ui
         {
             DEBUG_PRINTF("Open shared memory of file[%s] successfully\n", pMemoryName);
             /* LL: open, should check init status */
+            tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+            if (!ptr->SetLossless(m_bLossless))
+            {
+                DEBUG_ERROR("vi shm %s existing, can not set lossless %d\n", pMemoryName, m_bLossless);
+                RingShmDestroy(false);
+                m_pHeader = NULL;
+                return NULL;
+            }
             goto EXIT;
         }
 
-        bshm = RingShmCreate(pMemoryName, header_len, isize, item_count, mode);
+        if (m_bItemIndex)
+        {
+            /* the item index follows the head, old readers only see header_len of it. */
+            fixed_len = SHM_ITEM_INDEX_OFFSET(header_len) + (uint64_t)item_count * sizeof(shm_item_index_entry_t);
+            if (fixed_len > UINT32_MAX)
+            {
+                DEBUG_WARN("vi shm[%s] too many items %u for the item index, created without it\n"
+                    , pMemoryName, item_count);
+                m_bItemIndex = false;
+                fixed_len = header_len;
+            }
+        }
+
+        bshm = RingShmCreate(pMemoryName, (uint32_t)fixed_len, isize, item_count, mode);
 
         if (!bshm)
         {
@@ -340,9 +442,91 @@ uint8_t *CTvuVariableItemBaseShm::CreateOrOpen(const char *pMemoryName, const ui
 
 EXIT:
     m_iFlags = SHM_FLAG_WRITE;
+    if (m_pHeader)
+    {
+        _bindNuma();
+        _warmup(true);
+    }
     return m_pHeader;
 }
 
+/**
+ *  place the ring on the node SetNumaNode asked and record it in the ext head,
+ *  it runs before the warm up, so the prefaulted pages land on the node.
+ */
+void CTvuVariableItemBaseShm::_bindNuma()
+{
+    tvushm::SharedCompactRingBuffer* ptr = (tvushm::SharedCompactRingBuffer*)m_pRingShm;
+    if (!ptr || m_iNumaNode == LIBSHM_NUMA_NODE_NONE || m_uExtBufLen < SHM_CONSTRUCT_EXT_NUMA_LEN)
+    {
+        return;
+    }
+
+    shm_construct_ext_t *pext = (shm_construct_ext_t *)(m_pHeader + SHM_MEDIA_HEAD_INFO_V4_OFFSET);
+    int ret = ptr->BindNuma(m_iNumaNode);
+
+    if (ret)
+    {
+        DEBUG_WARN("vi shm[%s] bind to numa node %d failed %d, placed by the default policy\n"
+            , m_memoryName, m_iNumaNode, ret);
+        pext->numa_node = LIBSHM_NUMA_NODE_NONE;
+        return;
+    }
+
+    pext->numa_node = m_iNumaNode;
+    DEBUG_INFO("vi shm[%s] bound to numa node %d\n", m_memoryName, m_iNumaNode);
+}
+
+int CTvuVariableItemBaseShm::GetNumaNode()
+{
+#if _SHM_HEAD_FEATURE_EXT_EABLE
+    if (m_pHeader && m_uExtBufLen >= SHM_CONSTRUCT_EXT_NUMA_LEN)
+    {
+        shm_construct_ext_t *pext = (shm_construct_ext_t *)(m_pHeader + SHM_MEDIA_HEAD_INFO_V4_OFFSET);
+        return pext->numa_node;
+    }
+#endif
+    return LIBSHM_NUMA_NODE_NONE;
+}
+
+/**
+ *  fault in and lock the whole ring as SetPrefault asked, failures only warn,
+ *  the ring works as well, but its first lap pays the faults.
+ */
+void CTvuVariableItemBaseShm::_warmup(bool bForWriting)
+{
+    tvushm::SharedCompactRingBuffer* ptr = (tvushm::SharedCompactRingBuffer*)m_pRingShm;
+    if (!ptr || (!m_bPrefault && !m_bLock))
+    {
+        return;
+    }
+
+    int64_t tmStart = _libshm_get_sys_us64();
+    int ret = 0;
+
+    if (m_bPrefault)
+    {
+        ret = ptr->Prefault(bForWriting);
+        if (ret)
+        {
+            DEBUG_WARN("vi shm[%s] prefault failed %d\n", m_memoryName, ret);
+        }
+    }
+
+    if (m_bLock)
+    {
+        ret = ptr->Lock();
+        if (ret)
+        {
+            DEBUG_WARN("vi shm[%s] mlock failed %d, check RLIMIT_MEMLOCK\n", m_memoryName, ret);
+        }
+    }
+
+    m_iPrefaultUs = _libshm_get_sys_us64() - tmStart;
+    DEBUG_INFO("vi shm[%s] warmed up, prefault %d, lock %d, took %" PRId64 " us\n"
+        , m_memoryName, m_bPrefault, m_bLock, m_iPrefaultUs);
+}
+
 
 bool CTvuVariableItemBaseShm::_isShmRemovedFromKernal()
 {
@@ -393,13 +577,26 @@ uint8_t *CTvuVariableItemBaseShm::_open(const char *pMemoryName, bool bForWritin
         DEBUG_ERROR("open init  %s failed\n", pMemoryName);
         RingShmDestroyAndSleep(_bForCreate);
     }
+    else if (!bForWriting)
+    {
+        tvushm::SharedCompactRingBuffer* ptr = (tvushm::SharedCompactRingBuffer*)m_pRingShm;
+        if (!m_bMonitor && ptr->IsLossless() && !ptr->RegisterReader())
+        {
+            DEBUG_WARN("vi shm %s lossless reader register failed, writer would not wait for it\n", pMemoryName);
+        }
+    }
 
     return m_pHeader;
 }
 
 uint8_t *CTvuVariableItemBaseShm::Open(const char *pMemoryName)
 {
-    return _open(pMemoryName, false);
+    uint8_t *p = _open(pMemoryName, false);
+    if (p)
+    {
+        _warmup(false);
+    }
+    return p;
 }
 
 bool CTvuVariableItemBaseShm::RingShmOpen(const char *name)
@@ -409,7 +606,7 @@ bool CTvuVariableItemBaseShm::RingShmOpen(const char *name)
     if (!ptr)
         return b;
 
-    b = ptr->Open(name);
+    b = ptr->Open(name, m_bMonitor);
     return b;
 }
 
@@ -425,10 +622,16 @@ bool CTvuVariableItemBaseShm::RingShmCreate(const char *pMemoryName, uint32_t he
     if (!ptr)
         return b;
 
-    b = ptr->Create(pMemoryName, header_len, isize, item_count, mode);
+    b = ptr->Create(pMemoryName, header_len, isize, item_count, mode, m_bHugePage, m_uPayloadAlignment, m_bLossless);
     return b;
 }
 
+size_t CTvuVariableItemBaseShm::GetPayloadAlignment()
+{
+    tvushm::SharedCompactRingBuffer* ptr = (tvushm::SharedCompactRingBuffer*)m_pRingShm;
+    return ptr ? ptr->GetPayloadAlignment() : 0;
+}
+
 int CTvuVariableItemBaseShm::RingShmDestroy(bool flagCreate)
 {
     tvushm::SharedCompactRingBuffer* ptr = (tvushm::SharedCompactRingBuffer*)m_pRingShm;
@@ -488,6 +691,92 @@ int CTvuVariableItemBaseShm::FreeRingShm(bool flagCreate)
     return 0;
 }
 
+bool CTvuVariableItemBaseShm::IsLossless()
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    return ptr ? ptr->IsLossless() : false;
+}
+
+int CTvuVariableItemBaseShm::GetPageBacking()
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    return (ptr && ptr->IsHugePage()) ? SHM_PAGE_BACKING_HUGETLBFS : SHM_PAGE_BACKING_NORMAL;
+}
+
+bool CTvuVariableItemBaseShm::IsWriteBlocked(size_t s, size_t counts)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    return ptr ? !ptr->IsWriteable(s, counts) : false;
+}
+
+void CTvuVariableItemBaseShm::WaitForRelease(unsigned int timeout)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+
+    /* the same check as Sendable. */
+    if (!ptr || !(m_iFlags & SHM_FLAG_WRITE) || !ptr->WaitWriteable((size_t)1, 1, timeout))
+    {
+        _libshm_common_msleep(1);
+    }
+}
+
+static int _leaseStateToErrno(int state)
+{
+    switch (state)
+    {
+    case tvushm::SharedCompactRingBuffer::LeaseIntact:
+        return 0;
+    case tvushm::SharedCompactRingBuffer::LeaseBroken:
+        return -EPIPE;
+    default:
+        return -EINVAL;
+    }
+}
+
+bool CTvuVariableItemBaseShm::HasLeases()
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    return ptr ? ptr->HasLeases() : false;
+}
+
+int CTvuVariableItemBaseShm::AcquireLease(uint64_t pos)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+
+    if (!ptr || !ptr->HasLeases())
+    {
+        return -ENOTSUP;
+    }
+
+    if (m_bMonitor)
+    {
+        return -EPERM;
+    }
+
+    int lease = ptr->AcquireLease(pos);
+    if (lease == tvushm::SharedCompactRingBuffer::LeaseNoSlot)
+    {
+        return -ENOSPC;
+    }
+    else if (lease == tvushm::SharedCompactRingBuffer::LeaseGone)
+    {
+        return -EAGAIN;
+    }
+    return lease;
+}
+
+int CTvuVariableItemBaseShm::CheckLease(int lease)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    return ptr ? _leaseStateToErrno(ptr->CheckLease(lease)) : -EINVAL;
+}
+
+int CTvuVariableItemBaseShm::ReleaseLease(int lease)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    return ptr ? _leaseStateToErrno(ptr->ReleaseLease(lease)) : -EINVAL;
+}
+
 bool CTvuVariableItemBaseShm::HasReaders(unsigned int timeout)
 {
     bool bret = true;
@@ -498,7 +787,7 @@ bool CTvuVariableItemBaseShm::HasReaders(unsigned int timeout)
         case kShmConstructExtVer1:
         {
             uint64_t now = _libshm_get_sys_ms64();
-            uint64_t time_stamp = pext->last_read_time_stamp;
+            uint64_t time_stamp = _libshm_atomic_load_relaxed_u64(&pext->last_read_time_stamp);
 
             if ((int64_t)(now - time_stamp) > timeout || (time_stamp == 0) )
             {
@@ -544,6 +833,10 @@ int CTvuVariableItemBaseShm::Sendable()
                 return -1;
             }
             ret = ptr->IsWriteable() ? 1 : 0;  // model regards reading faster then writing
+            if (ret > 0 && !ptr->IsWriteable((size_t)1))
+            {
+                ret = 0;
+            }
         }
         return ret;
     }
@@ -564,6 +857,11 @@ int CTvuVariableItemBaseShm::_readable()
                 return -1;
             }
             ret = ptr->IsReadable() ? 1 : 0;
+            if (ptr->CheckReaderEvicted())
+            {
+                /* the lossless cursor was taken back, items may be lost, reported once. */
+                ret = -EPIPE;
+            }
         }
         return ret;
     }
@@ -575,12 +873,17 @@ int CTvuVariableItemBaseShm::_readable()
 void CTvuVariableItemBaseShm::_setReadTime()
 {
 #if _SHM_HEAD_FEATURE_EXT_EABLE
+    if (m_bMonitor)
+    {
+        return;
+    }
+
     shm_construct_ext_t *pext = (shm_construct_ext_t *)(m_pHeader + SHM_MEDIA_HEAD_INFO_V4_OFFSET);
     switch(pext->ext_ver)
     {
         case kShmConstructExtVer1:
         {
-            pext->last_read_time_stamp = _libshm_get_sys_ms64();
+            _libshm_atomic_store_relaxed_u64(&pext->last_read_time_stamp, _libshm_get_sys_ms64());
         }
         break;
         default:
@@ -629,6 +932,64 @@ int CTvuVariableItemBaseShm::RemoveShmFromKernal(const char *shmname)
     return 0;
 }
 
+int CTvuVariableItemBaseShm::ProbeShm(const char *shmname)
+{
+    if (!shmname)
+    {
+        return -EINVAL;
+    }
+
+    /* the fixed data starts with the head of ours, not written yet while the creator is creating it. */
+    shm_construct_t head;
+    int ret = tvushm::SharedCompactRingBuffer::Probe(shmname, &head, sizeof(head));
+    if (ret > 0 && CHECK_INVALID_SHM_HEAD_VERSION(LIBSHMMEDIA_READ_SHM_U32(head.version)))
+    {
+        ret = 0;
+    }
+    return ret;
+}
+
+uint8_t *CTvuVariableItemBaseShm::PeekLatestItemAddr(size_t *ps)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    return ptr ? (uint8_t *)ptr->PeekLatest(ps, NULL) : NULL;
+}
+
+uint64_t CTvuVariableItemBaseShm::GetWrittenSince(uint64_t *pwindex, uint64_t *pbytes)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    if (!ptr || !pwindex)
+    {
+        return 0;
+    }
+
+    uint64_t windex = ptr->GetWriteIndex();
+    uint64_t counts = ptr->IndexStepsBetween(*pwindex, windex);
+    uint64_t maxCounts = ptr->GetMaxItemNum();
+    uint64_t pos = *pwindex;
+
+    if (counts > maxCounts)
+    {
+        pos = ptr->PreviousIndexStep(windex, maxCounts);
+        counts = maxCounts;
+    }
+
+    if (pbytes)
+    {
+        for (uint64_t i = 0; i < counts; i++, pos = ptr->NextIndexStep(pos))
+        {
+            size_t s = 0;
+            if (ptr->PeekSize(pos, &s))
+            {
+                *pbytes += s;
+            }
+        }
+    }
+
+    *pwindex = windex;
+    return counts;
+}
+
 void CTvuVariableItemBaseShm::GetInfo(uint64_t *pheadsize, uint64_t *ptotal_size, uint64_t *pmax_counts)
 {
     tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
@@ -696,6 +1057,186 @@ bool CTvuVariableItemBaseShm::SearchWholeItems(void *user, tvu_variableitem_base
     return bget;
 }
 
+void CTvuVariableItemBaseShm::_loadItemIndex()
+{
+    m_pItemIndex = NULL;
+    m_uItemIndexSlots = 0;
+#if _SHM_HEAD_FEATURE_EXT_EABLE
+    if (!m_pHeader || m_uExtBufLen < SHM_CONSTRUCT_EXT_ITEM_INDEX_LEN)
+    {
+        return;
+    }
+
+    shm_construct_ext_t *pext = (shm_construct_ext_t *)(m_pHeader + SHM_MEDIA_HEAD_INFO_V4_OFFSET);
+    uint32_t slots = pext->item_index_slots;
+    uint8_t *pfixed = NULL;
+    size_t  fixed_len = 0;
+
+    GetRingShmFixedData(&pfixed, &fixed_len);
+    if (!slots || fixed_len < SHM_ITEM_INDEX_OFFSET(m_uHeadLen) + (uint64_t)slots * sizeof(shm_item_index_entry_t))
+    {
+        return;
+    }
+
+    m_uItemIndexSlots = slots;
+    m_pItemIndex = (shm_item_index_entry_t *)(m_pHeader + SHM_ITEM_INDEX_OFFSET(m_uHeadLen));
+#endif
+}
+
+/**
+ *  the slot is invalidated first, the keys follow, then the tag publishes it.
+ *  a reader takes the slot only when it reads the same tag before and after the keys.
+ */
+void CTvuVariableItemBaseShm::UpdateItemIndex(size_t nth, uint64_t tvutimestamp, uint64_t pts)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    if (!ptr || !m_pItemIndex)
+    {
+        return;
+    }
+
+    uint64_t pos = ptr->GetWriteIndex();
+    for (size_t i = 0; i < nth; i++)
+    {
+        pos = ptr->NextIndexStep(pos);
+    }
+
+    shm_item_index_entry_t *pentry = m_pItemIndex + pos % m_uItemIndexSlots;
+    _libshm_atomic_store_relaxed_u64(&pentry->tag, 0);
+    _libshm_atomic_store_release_u64(&pentry->tvutimestamp, tvutimestamp);
+    _libshm_atomic_store_release_u64(&pentry->pts, pts);
+    _libshm_atomic_store_release_u64(&pentry->tag, pos + 1);
+}
+
+bool CTvuVariableItemBaseShm::_readItemIndex(uint64_t pos, shm_item_index_entry_t *pentry)
+{
+    const shm_item_index_entry_t *p = m_pItemIndex + pos % m_uItemIndexSlots;
+    uint64_t tag = _libshm_atomic_load_acquire_u64(&p->tag);
+
+    pentry->tvutimestamp = _libshm_atomic_load_acquire_u64(&p->tvutimestamp);
+    pentry->pts = _libshm_atomic_load_acquire_u64(&p->pts);
+    pentry->tag = _libshm_atomic_load_acquire_u64(&p->tag);
+
+    return tag == pos + 1 && pentry->tag == tag;
+}
+
+uint64_t CTvuVariableItemBaseShm::_itemIndexWindow()
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    uint64_t counts = ptr->GetMaxItemNum();
+
+    if (counts >= 2)
+    {
+        counts -= 1;
+    }
+
+    if (counts > m_uItemIndexSlots)
+    {
+        counts = m_uItemIndexSlots;
+    }
+    return counts;
+}
+
+uint64_t CTvuVariableItemBaseShm::GetItemIndexWindow(uint64_t *poldest)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    if (!ptr || !m_pItemIndex || !poldest)
+    {
+        return 0;
+    }
+
+    uint64_t windex = ptr->GetWriteIndex();
+    uint64_t counts = _itemIndexWindow();
+    *poldest = ptr->PreviousIndexStep(windex, counts);
+    return counts;
+}
+
+uint64_t CTvuVariableItemBaseShm::NextIndexStep(uint64_t pos)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    return ptr ? ptr->NextIndexStep(pos) : pos;
+}
+
+uint64_t CTvuVariableItemBaseShm::IndexStepsBetween(uint64_t from, uint64_t to)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    return ptr ? ptr->IndexStepsBetween(from, to) : 0;
+}
+
+/**
+ *  the window is the items SearchWholeItems walks, oldest first. the slots not
+ *  holding their item yet, never written or being rewritten by the writer, are all
+ *  at the old end of it, so they count as before the wanted one.
+ */
+bool CTvuVariableItemBaseShm::SearchItemIndex(void *ctx, tvu_variableitem_base_shm_item_index_cmp_fn_t fn, uint64_t *ppos, shm_item_index_entry_t *pentry)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    if (!ptr || !m_pItemIndex || !fn || !ppos || !pentry)
+    {
+        return false;
+    }
+
+    uint64_t windex = ptr->GetWriteIndex();
+    uint64_t counts = _itemIndexWindow();
+
+    uint64_t left = 0;
+    uint64_t right = counts;
+    int      cmp = -1;
+    shm_item_index_entry_t entry;
+
+    /* first one not before the wanted in [left, right). */
+    while (left < right)
+    {
+        uint64_t mid = left + (right - left) / 2;
+        uint64_t pos = ptr->PreviousIndexStep(windex, counts - mid);
+
+        cmp = _readItemIndex(pos, &entry) ? fn(ctx, &entry) : -1;
+        if (cmp == kItemIndexCmpNoKey)
+        {
+            DEBUG_WARN("vi shm[%s] item %" PRIu64 " has no searching key in the index\n", m_memoryName, pos);
+            return false;
+        }
+
+        if (cmp < 0)
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid;
+        }
+    }
+
+    if (left == counts)
+    {
+        /* all before the wanted one. */
+        return false;
+    }
+
+    uint64_t pos = ptr->PreviousIndexStep(windex, counts - left);
+    if (!_readItemIndex(pos, &entry))
+    {
+        return false;
+    }
+
+    cmp = fn(ctx, &entry);
+    if (cmp > 0 && left == 0)
+    {
+        /* the wanted one is older than the oldest item kept. */
+        return false;
+    }
+
+    *ppos = pos;
+    *pentry = entry;
+    return cmp >= 0;
+}
+
+uint8_t *CTvuVariableItemBaseShm::GetItemAddrByPos(uint64_t pos, size_t *ps)
+{
+    tvushm::SharedCompactRingBuffer *ptr = (tvushm::SharedCompactRingBuffer *)m_pRingShm;
+    return ptr ? (uint8_t *)ptr->ReadByPos(ps, pos) : NULL;
+}
+
 uint64_t CTvuVariableItemBaseShm::getRingShmPayloadSize()const
 {
     uint64_t  ret = 0;
@@ -2,8 +2,17 @@
 #include <string>
 #include <stdio.h>
 #include <string.h>
+#include <thread>
+#include <chrono>
+#if defined(TVU_LINUX)
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#endif
 
 #include "sharememory.h"
+#include "gtest_stress_item.h"
 
 static std::string make_shm_name()
 {
@@ -50,6 +59,161 @@ TEST(ShareMemoryBasic, CreateOpenClose)
 #endif
 }
 
+#if defined(TVU_LINUX)
+TEST(ShareMemoryBasic, WakeupWordWakesReader)
+{
+    std::string name = make_shm_name();
+
+    CTvuBaseShareMemory writer;
+    ASSERT_NE(writer.CreateOrOpen(name.c_str(), 1024, 4, 4096, nullptr), (uint8_t *)NULL);
+    ASSERT_TRUE(writer.IsWakeupSupported());
+
+    CTvuBaseShareMemory reader;
+    ASSERT_NE(reader.Open(name.c_str()), (uint8_t *)NULL);
+    ASSERT_TRUE(reader.IsWakeupSupported());
+
+    // sequence moved after sampling, waiting returns before the timeout
+    uint32_t seq = reader.GetWakeupSeq();
+    writer.FinishWrite();
+    EXPECT_NE(reader.GetWakeupSeq(), seq);
+    auto t0 = std::chrono::steady_clock::now();
+    reader.WaitForWrite(seq, 1000);
+    EXPECT_LT(std::chrono::steady_clock::now() - t0, std::chrono::milliseconds(1000));
+    EXPECT_GT(reader.Readable(false), 0);
+    reader.FinishRead();
+
+    // sleeping reader is woken by the writer, not by the timeout
+    seq = reader.GetWakeupSeq();
+    EXPECT_EQ(reader.Readable(false), 0);
+    std::thread th([&writer]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        writer.FinishWrite();
+    });
+    t0 = std::chrono::steady_clock::now();
+    reader.WaitForWrite(seq, 1000);
+    EXPECT_LT(std::chrono::steady_clock::now() - t0, std::chrono::milliseconds(1000));
+    th.join();
+    EXPECT_GT(reader.Readable(false), 0);
+
+    reader.CloseMapFile();
+    writer.CloseMapFile();
+}
+#endif
+
+#if defined(TVU_LINUX)
+// the pid of a reader slot is only a hint, the slot of a gone reader expires by its heartbeat
+TEST(ShareMemoryBasic, ReaderSlotExpiresByHeartbeat)
+{
+    std::string name = make_shm_name();
+
+    CTvuBaseShareMemory writer;
+    ASSERT_NE(writer.CreateOrOpen(name.c_str(), 1024, 4, 4096, nullptr), (uint8_t *)NULL);
+    ASSERT_TRUE(writer.IsReaderTableSupported());
+
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0)
+    {
+        CTvuBaseShareMemory reader;
+        if (!reader.Open(name.c_str()) || !reader.RegisterReader())
+            _exit(1);
+        // gone without releasing the slot
+        _exit(0);
+    }
+
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    shm_reader_info_t readers[4];
+    ASSERT_EQ(writer.GetReaders(readers, 4), 1);
+    EXPECT_EQ(readers[0].pid, (uint32_t)pid);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1200));
+    EXPECT_EQ(writer.GetReaders(readers, 4), 0);
+
+    writer.CloseMapFile();
+    CTvuBaseShareMemory::RemoveShmFromKernal(name.c_str());
+}
+
+TEST(ShareMemoryBasic, TwoProcessWriterReaderStress)
+{
+    const uint32_t kCount = 64;
+    const uint32_t kItemLen = 1024;
+    const uint64_t kTotal = 200000;
+    std::string name = make_shm_name();
+
+    CTvuBaseShareMemory writer;
+    ASSERT_NE(writer.CreateOrOpen(name.c_str(), 1024, kCount, kItemLen, nullptr), (uint8_t *)NULL);
+
+    StressProgress *prog = (StressProgress *)mmap(NULL, sizeof(StressProgress), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE((void *)prog, MAP_FAILED);
+    memset(prog, 0, sizeof(StressProgress));
+
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0)
+    {
+        int code = 0;
+        CTvuBaseShareMemory reader;
+        if (!reader.Open(name.c_str()))
+            _exit(1);
+        __atomic_store_n(&prog->ready, 1, __ATOMIC_RELEASE);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        for (uint64_t seq = 0; seq < kTotal && code == 0; )
+        {
+            if (reader.Readable(false) <= 0)
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                    code = 4;
+                sched_yield();
+                continue;
+            }
+            code = stress_check(reader.GetItemAddrByIndex(reader.GetReadIndex()), stress_len(seq, kItemLen), seq);
+            reader.FinishRead();
+            __atomic_store_n(&prog->consumed, ++seq, __ATOMIC_RELEASE);
+        }
+        reader.CloseMapFile();
+        _exit(code);
+    }
+
+    while (!__atomic_load_n(&prog->ready, __ATOMIC_ACQUIRE))
+        sched_yield();
+
+    // the writer runs unthrottled unless it would lap the reader, so every item must arrive intact.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    bool timeout = false;
+    for (uint64_t seq = 0; seq < kTotal && !timeout; seq++)
+    {
+        while (seq - __atomic_load_n(&prog->consumed, __ATOMIC_ACQUIRE) >= kCount / 2)
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                timeout = true;
+                break;
+            }
+            sched_yield();
+        }
+        stress_fill(writer.GetWriteItemAddr(), seq, stress_len(seq, kItemLen));
+        writer.FinishWrite();
+    }
+    if (timeout)
+        kill(pid, SIGKILL);
+
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_FALSE(timeout);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    EXPECT_EQ(__atomic_load_n(&prog->consumed, __ATOMIC_ACQUIRE), kTotal);
+
+    munmap(prog, sizeof(StressProgress));
+    writer.CloseMapFile();
+    CTvuBaseShareMemory::RemoveShmFromKernal(name.c_str());
+}
+#endif
+
 #if !defined(GTEST_MAIN_ENTRANCE)
 int main(int argc, char **argv)
 {
@@ -0,0 +1,140 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+#ifndef LIBSHM_ATOMIC_INTERNAL_H
+#define LIBSHM_ATOMIC_INTERNAL_H
+
+/**
+ *  ordered access to the ring indices living in shared memory.
+ *  the writer fills the item, then publishes the index by a release store,
+ *  the reader polls the index by an acquire load before touching the item.
+ *  the shm head structures are packed, so the helpers take untyped addresses,
+ *  the fields themselves are naturally aligned inside the mapping.
+**/
+
+#include <stdint.h>
+
+#if defined(TVU_WINDOWS) && !defined(TVU_MINGW)
+#include <intrin.h>
+#pragma intrinsic(_ReadWriteBarrier, _InterlockedCompareExchange64, _InterlockedIncrement)
+/* msvc only targets x86/x64 here, aligned plain access is atomic and TSO. */
+#define _LIBSHM_ATOMIC_COMPILER_BARRIER()   _ReadWriteBarrier()
+#endif
+
+static inline
+uint32_t _libshm_atomic_load_acquire_u32(const void *addr)
+{
+#if defined(_LIBSHM_ATOMIC_COMPILER_BARRIER)
+    uint32_t v = *(const volatile uint32_t *)addr;
+    _LIBSHM_ATOMIC_COMPILER_BARRIER();
+    return v;
+#else
+    return __atomic_load_n((const uint32_t *)addr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline
+uint64_t _libshm_atomic_load_acquire_u64(const void *addr)
+{
+#if defined(_LIBSHM_ATOMIC_COMPILER_BARRIER)
+    uint64_t v = *(const volatile uint64_t *)addr;
+    _LIBSHM_ATOMIC_COMPILER_BARRIER();
+    return v;
+#else
+    return __atomic_load_n((const uint64_t *)addr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline
+uint64_t _libshm_atomic_load_relaxed_u64(const void *addr)
+{
+#if defined(_LIBSHM_ATOMIC_COMPILER_BARRIER)
+    return *(const volatile uint64_t *)addr;
+#else
+    return __atomic_load_n((const uint64_t *)addr, __ATOMIC_RELAXED);
+#endif
+}
+
+static inline
+uint32_t _libshm_atomic_load_relaxed_u32(const void *addr)
+{
+#if defined(_LIBSHM_ATOMIC_COMPILER_BARRIER)
+    return *(const volatile uint32_t *)addr;
+#else
+    return __atomic_load_n((const uint32_t *)addr, __ATOMIC_RELAXED);
+#endif
+}
+
+static inline
+void _libshm_atomic_store_release_u32(void *addr, uint32_t v)
+{
+#if defined(_LIBSHM_ATOMIC_COMPILER_BARRIER)
+    _LIBSHM_ATOMIC_COMPILER_BARRIER();
+    *(volatile uint32_t *)addr = v;
+#else
+    __atomic_store_n((uint32_t *)addr, v, __ATOMIC_RELEASE);
+#endif
+}
+
+static inline
+void _libshm_atomic_store_release_u64(void *addr, uint64_t v)
+{
+#if defined(_LIBSHM_ATOMIC_COMPILER_BARRIER)
+    _LIBSHM_ATOMIC_COMPILER_BARRIER();
+    *(volatile uint64_t *)addr = v;
+#else
+    __atomic_store_n((uint64_t *)addr, v, __ATOMIC_RELEASE);
+#endif
+}
+
+static inline
+void _libshm_atomic_store_relaxed_u32(void *addr, uint32_t v)
+{
+#if defined(_LIBSHM_ATOMIC_COMPILER_BARRIER)
+    *(volatile uint32_t *)addr = v;
+#else
+    __atomic_store_n((uint32_t *)addr, v, __ATOMIC_RELAXED);
+#endif
+}
+
+static inline
+void _libshm_atomic_store_relaxed_u64(void *addr, uint64_t v)
+{
+#if defined(_LIBSHM_ATOMIC_COMPILER_BARRIER)
+    *(volatile uint64_t *)addr = v;
+#else
+    __atomic_store_n((uint64_t *)addr, v, __ATOMIC_RELAXED);
+#endif
+}
+
+static inline
+uint32_t _libshm_atomic_inc_u32(void *addr)
+{
+#if defined(_LIBSHM_ATOMIC_COMPILER_BARRIER)
+    return (uint32_t)_InterlockedIncrement((volatile long *)addr);
+#else
+    return __atomic_add_fetch((uint32_t *)addr, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+/* true if *addr was @expected and now holds @desired. */
+static inline
+bool _libshm_atomic_cas_u64(void *addr, uint64_t expected, uint64_t desired)
+{
+#if defined(_LIBSHM_ATOMIC_COMPILER_BARRIER)
+    return _InterlockedCompareExchange64((volatile __int64 *)addr, (__int64)desired, (__int64)expected) == (__int64)expected;
+#else
+    return __atomic_compare_exchange_n((uint64_t *)addr, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+#endif // LIBSHM_ATOMIC_INTERNAL_H
@@ -0,0 +1,103 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+#ifndef LIBSHM_HUGEPAGE_INTERNAL_H
+#define LIBSHM_HUGEPAGE_INTERNAL_H
+
+/**
+ *  hugepage backed shm regions.
+ *  a hugepage shm is a file of the hugetlbfs mount with the same name as the
+ *  posix shm would take in /dev/shm, so readers find it by the name only.
+ *  the mount is LIBSHMMEDIA_HUGETLBFS_DIR from environment, or /dev/hugepages.
+ *  the creator falls back to the normal posix shm when the mount is missing,
+ *  or the hugepage pool is too small to map the region.
+**/
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(TVU_LINUX)
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+
+#define LIBSHM_HUGETLBFS_DEFAULT_DIR    "/dev/hugepages"
+#define LIBSHM_HUGETLBFS_MAGIC          0x958458f6
+
+static inline
+const char *_libshm_hugetlbfs_dir()
+{
+    const char *dir = getenv("LIBSHMMEDIA_HUGETLBFS_DIR");
+    return (dir && dir[0]) ? dir : LIBSHM_HUGETLBFS_DEFAULT_DIR;
+}
+
+/* the file path of shm @name in the hugetlbfs mount, posix shm names start with '/'. */
+static inline
+void _libshm_hugetlbfs_path(const char *name, char *path, size_t npath)
+{
+    while (*name == '/')
+    {
+        name++;
+    }
+    snprintf(path, npath, "%s/%s", _libshm_hugetlbfs_dir(), name);
+}
+
+/* return the huge page size of the mount, 0 when it is not a hugetlbfs mount. */
+static inline
+size_t _libshm_hugetlbfs_page_size()
+{
+    struct statfs ofs;
+
+    if (statfs(_libshm_hugetlbfs_dir(), &ofs) != 0 || (uint32_t)ofs.f_type != LIBSHM_HUGETLBFS_MAGIC)
+    {
+        return 0;
+    }
+    return (size_t)ofs.f_bsize;
+}
+
+static inline
+int _libshm_hugetlbfs_open(const char *name, int oflag, mode_t mode)
+{
+    char path[1024];
+    _libshm_hugetlbfs_path(name, path, sizeof(path));
+    return open(path, oflag, mode);
+}
+
+static inline
+int _libshm_hugetlbfs_unlink(const char *name)
+{
+    char path[1024];
+    _libshm_hugetlbfs_path(name, path, sizeof(path));
+    return unlink(path);
+}
+
+static inline
+bool _libshm_hugetlbfs_exists(const char *name)
+{
+    char path[1024];
+    struct stat os;
+    _libshm_hugetlbfs_path(name, path, sizeof(path));
+    return stat(path, &os) == 0;
+}
+
+static inline
+size_t _libshm_hugepage_align(size_t size, size_t pagesize)
+{
+    return (size + pagesize - 1) / pagesize * pagesize;
+}
+#endif
+
+#endif
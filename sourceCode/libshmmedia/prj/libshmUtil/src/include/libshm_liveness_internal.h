@@ -0,0 +1,69 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+#ifndef LIBSHM_LIVENESS_INTERNAL_H
+#define LIBSHM_LIVENESS_INTERNAL_H
+
+/**
+ *  liveness of the slots a reader claims in shared memory, the reader slots of
+ *  the fixed ring, the reader cursors and the leases of the variable ring.
+ *  the owner refreshes a heartbeat of its slot, the heartbeat decides, the pid is
+ *  only a hint. a reader in another pid namespace is not found by its pid, a gone
+ *  one's pid could be reused, so the pid only shortens the silence after which
+ *  the slot expires.
+**/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "libshm_atomic_internal.h"
+
+#if defined(TVU_LINUX)
+#include <signal.h>
+#include <errno.h>
+#endif
+
+#define LIBSHM_SLOT_EXPIRE_MS   3000    /* a slot silent longer could be reclaimed */
+#define LIBSHM_SLOT_GONE_MS     1000    /* a slot silent longer whose pid is not found here could be reclaimed */
+
+static inline
+bool _libshm_process_gone(uint32_t pid)
+{
+#if defined(TVU_LINUX)
+    return kill((pid_t)pid, 0) < 0 && errno == ESRCH;
+#else
+    (void)pid;
+    return false;
+#endif
+}
+
+/**
+ *  whether the slot of @pid, last refreshed at *@pheartbeat(ms), could be reclaimed
+ *  at @now(ms). @pheartbeat is NULL for the slots of old layouts without one, only
+ *  the pid tells then.
+**/
+static inline
+bool _libshm_slot_expired(uint32_t pid, const uint64_t *pheartbeat, uint64_t now)
+{
+    if (!pheartbeat)
+    {
+        return _libshm_process_gone(pid);
+    }
+
+    int64_t silent = (int64_t)(now - _libshm_atomic_load_relaxed_u64(pheartbeat));
+    if (silent > LIBSHM_SLOT_EXPIRE_MS)
+    {
+        return true;
+    }
+    return silent > LIBSHM_SLOT_GONE_MS && _libshm_process_gone(pid);
+}
+
+#endif // LIBSHM_LIVENESS_INTERNAL_H
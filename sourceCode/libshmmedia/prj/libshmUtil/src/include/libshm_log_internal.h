@@ -0,0 +1,110 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+#ifndef LIBSHM_LOG_INTERNAL_H
+#define LIBSHM_LOG_INTERNAL_H
+
+/**
+ *  filtering and rate limiting of the log sites, the heartbeat macros of
+ *  libsharememory and libshmmediaProto are built on it.
+ *  a log is dropped, in order of cost,
+ *   - at compile time, below LIBSHM_LOG_COMPILE_LEVEL.
+ *   - below the level of the handle, or the global level, one relaxed load.
+ *   - over the counts of the site in its interval, the coarse clock and one
+ *     atomic increment of the site, no lock, no syscall.
+ *  the handle classes hide _libshmLogLevelOverride by a member of the same
+ *  name, so the logs in their methods follow the level of the handle, and the
+ *  logs anywhere else the global one.
+**/
+
+#include <stdint.h>
+#include "libshm_atomic_internal.h"
+#include "libshm_time_internal.h"
+
+/* the values of LIBSHM_MEDIA_LOG_LEVEL_* of libshmmedia_common.h. */
+#define LIBSHM_LOG_LEVEL_DEFAULT    (-1)    // a handle follows the global level.
+#define LIBSHM_LOG_LEVEL_INFO       1
+#define LIBSHM_LOG_LEVEL_WARN       2
+#define LIBSHM_LOG_LEVEL_ERROR      3
+#define LIBSHM_LOG_LEVEL_NONE       4
+
+/* the lowest level compiled in, -DLIBSHM_LOG_COMPILE_LEVEL=2 drops the info logs from the binaries. */
+#ifndef LIBSHM_LOG_COMPILE_LEVEL
+#define LIBSHM_LOG_COMPILE_LEVEL    LIBSHM_LOG_LEVEL_INFO
+#endif
+
+/* the global level, the logs below it are dropped. */
+extern uint32_t g_libshmLogLevel;
+
+/* the state of a log site, a zero initialized static of the site. */
+typedef struct libshm_log_site
+{
+    uint64_t    lastMs;     // start of the interval.
+    uint32_t    counts;     // hits in the interval.
+} libshm_log_site_t;
+
+/* 'i'/'w'/'e' of the log callbacks to LIBSHM_LOG_LEVEL_*. */
+static inline
+int _libshm_log_level_of(int level)
+{
+    return level == 'e' ? LIBSHM_LOG_LEVEL_ERROR : (level == 'w' ? LIBSHM_LOG_LEVEL_WARN : LIBSHM_LOG_LEVEL_INFO);
+}
+
+static inline
+int _libshmLogLevelOverride()
+{
+    return LIBSHM_LOG_LEVEL_DEFAULT;
+}
+
+static inline
+bool _libshm_log_level_enabled(int level, int handleLevel)
+{
+    int threshold = handleLevel >= 0 ? handleLevel : (int)_libshm_atomic_load_relaxed_u32(&g_libshmLogLevel);
+    return level >= threshold;
+}
+
+/**
+ *  counts a hit of @site, true when it is to be printed: the first of a new
+ *  interval of @seconds, or one of the first @maxCounts of the interval.
+ *  @pcounts gets the hits of the interval, @pintervalMs the time since the
+ *  interval started, the last interval when @ptimeout.
+ */
+static inline
+bool _libshm_log_site_hit(libshm_log_site_t *site, uint64_t now, uint32_t seconds, uint32_t maxCounts
+                          , uint32_t *pcounts, uint64_t *pintervalMs, bool *ptimeout)
+{
+    uint32_t counts = _libshm_atomic_inc_u32(&site->counts);
+    uint64_t last   = _libshm_atomic_load_relaxed_u64(&site->lastMs);
+
+    /* a clock stepped back by more than a second starts a new interval too. */
+    *ptimeout = false;
+    if ((now >= last + seconds * (uint64_t)1000 || now + 1000 < last)
+        && _libshm_atomic_cas_u64(&site->lastMs, last, now))
+    {
+        /* only the thread moving the interval resets it, the hits racing it may be lost. */
+        _libshm_atomic_store_relaxed_u32(&site->counts, 0);
+        *ptimeout    = true;
+        *pcounts     = counts;
+        *pintervalMs = last && now > last ? now - last : 0;
+        return true;
+    }
+
+    if (counts < maxCounts)
+    {
+        *pcounts     = counts;
+        *pintervalMs = now > last ? now - last : 0;
+        return true;
+    }
+    return false;
+}
+
+#endif // LIBSHM_LOG_INTERNAL_H
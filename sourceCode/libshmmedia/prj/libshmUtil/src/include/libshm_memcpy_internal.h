@@ -0,0 +1,46 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+#ifndef LIBSHM_MEMCPY_INTERNAL_H
+#define LIBSHM_MEMCPY_INTERNAL_H
+
+/**
+ *  copy of the frame payloads into the shm.
+ *  the writer never reads the payload again, another process does, so large
+ *  copies bypass the writer's cache by non-temporal stores, and do not evict
+ *  its working set. the kernel is chosen by the cpu at the first call,
+ *  AVX-512/AVX2/SSE2 on x86-64, NEON on aarch64, memcpy on the others.
+**/
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* copies shorter than it use memcpy, the stores are in the cache anyway. */
+#define LIBSHM_STREAMING_COPY_THRESHOLD     (256 * 1024)
+
+namespace tvushm {
+
+    typedef void *(*MemcpyFunc_t)(void *dst, const void *src, size_t len);
+
+    /**
+     *  memcpy with non-temporal stores from LIBSHM_STREAMING_COPY_THRESHOLD bytes.
+     *  the stores are fenced before returning, the publishing of the item after
+     *  it orders them as normal stores.
+     */
+    void *MemcpyStreaming(void *dst, const void *src, size_t len);
+
+    /* "avx512", "avx2", "sse2", "neon" or "memcpy", the kernel MemcpyStreaming runs. */
+    const char *MemcpyStreamingKernelName();
+
+}
+
+#endif // LIBSHM_MEMCPY_INTERNAL_H
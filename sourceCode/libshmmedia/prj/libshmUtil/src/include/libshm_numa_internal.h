@@ -0,0 +1,63 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+#ifndef LIBSHM_NUMA_INTERNAL_H
+#define LIBSHM_NUMA_INTERNAL_H
+
+/**
+ *  NUMA placement of a mapped shm region, by the raw mbind syscall so the
+ *  library does not depend on libnuma.
+ *  the policy is MPOL_PREFERRED, pages go to the node while it has free memory
+ *  and fall back to the other nodes then, the ring never fails with SIGBUS.
+ *  on a shared mapping the policy is kept by the shm object, the pages faulted
+ *  in later by any process follow it.
+**/
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define LIBSHM_NUMA_NODE_NONE       (-1)
+
+#if defined(TVU_LINUX)
+#include <unistd.h>
+#include <errno.h>
+#include <sys/syscall.h>
+
+#define LIBSHM_NUMA_MAX_NODES       1024
+#define LIBSHM_MPOL_PREFERRED       1
+#define LIBSHM_MPOL_MF_MOVE         (1 << 1)
+
+/* return 0 success, or the errno, EINVAL when the node does not exist. */
+static inline
+int _libshm_numa_bind(void *addr, size_t len, int node)
+{
+    const size_t bits = 8 * sizeof(unsigned long);
+    unsigned long mask[LIBSHM_NUMA_MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+
+    if (node < 0 || node >= LIBSHM_NUMA_MAX_NODES)
+    {
+        return EINVAL;
+    }
+
+    mask[node / bits] |= 1UL << (node % bits);
+
+    /* maxnode counts one more than the bits of the mask. */
+    if (syscall(SYS_mbind, addr, len, LIBSHM_MPOL_PREFERRED, mask
+        , (unsigned long)LIBSHM_NUMA_MAX_NODES + 1, LIBSHM_MPOL_MF_MOVE) != 0)
+    {
+        return errno;
+    }
+    return 0;
+}
+#endif
+
+#endif
@@ -0,0 +1,82 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+#ifndef LIBSHM_PREFAULT_INTERNAL_H
+#define LIBSHM_PREFAULT_INTERNAL_H
+
+/**
+ *  warm up of a mapped shm region.
+ *  a fresh mapping takes one page fault for every page on first touch, the
+ *  writer's first lap over a large ring pays all of them in the live path.
+ *  prefault populates the page tables up front, mlock keeps them resident.
+**/
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(TVU_LINUX)
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ      22
+#endif
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE     23
+#endif
+
+/**
+ *  fault in every page of the page aligned [addr, addr+len), the data is not changed.
+ *  @bWrite, populate writable pages, readers only need readable ones.
+ *  return 0 success, or the errno.
+**/
+static inline
+int _libshm_prefault(void *addr, size_t len, bool bWrite)
+{
+    if (madvise(addr, len, bWrite ? MADV_POPULATE_WRITE : MADV_POPULATE_READ) == 0)
+    {
+        return 0;
+    }
+
+    if (errno != EINVAL)
+    {
+        return errno;
+    }
+
+    /* kernels before 5.14, touch one byte of every page. adding 0 atomically writes
+     * the page without racing the other processes which are using it. */
+    size_t pagesize = (size_t)sysconf(_SC_PAGESIZE);
+    uint8_t *p = (uint8_t *)addr;
+    for (size_t off = 0; off < len; off += pagesize)
+    {
+        if (bWrite)
+        {
+            __atomic_fetch_add(p + off, 0, __ATOMIC_RELAXED);
+        }
+        else
+        {
+            (void)*(volatile uint8_t *)(p + off);
+        }
+    }
+    return 0;
+}
+
+/* return 0 success, or the errno, EPERM/ENOMEM when RLIMIT_MEMLOCK is too small. */
+static inline
+int _libshm_mlock(const void *addr, size_t len)
+{
+    return mlock(addr, len) == 0 ? 0 : errno;
+}
+#endif
+
+#endif
@@ -0,0 +1,45 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+#ifndef LIBSHM_PREFETCH_INTERNAL_H
+#define LIBSHM_PREFETCH_INTERNAL_H
+
+/**
+ *  software prefetch of an item the reader is going to consume.
+ *  the shm pages are resident already, the misses are of the cache, so the
+ *  lines are prefetched, madvise(MADV_WILLNEED) would not help.
+ *  the hardware prefetcher follows the stream after the first lines.
+**/
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define LIBSHM_CACHE_LINE_SIZE      64
+
+/* prefetch the lines of [addr, addr+len) for reading, into all cache levels. */
+static inline
+void _libshm_prefetch(const void *addr, size_t len)
+{
+#if defined(__GNUC__)
+    const uint8_t *p = (const uint8_t *)((uintptr_t)addr & ~(uintptr_t)(LIBSHM_CACHE_LINE_SIZE - 1));
+    const uint8_t *end = (const uint8_t *)addr + len;
+    for (; p < end; p += LIBSHM_CACHE_LINE_SIZE)
+    {
+        __builtin_prefetch(p, 0, 3);
+    }
+#else
+    (void)addr;
+    (void)len;
+#endif
+}
+
+#endif
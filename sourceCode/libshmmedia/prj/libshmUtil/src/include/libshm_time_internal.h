@@ -15,6 +15,7 @@
 
 #include <unistd.h>
 #include <sys/time.h>
+#include <time.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -56,6 +57,22 @@ int64_t _libshm_get_sys_ms64()
     return _libshm_get_sys_us64()/1000;
 }
 
+/**
+ *  the wall clock of _libshm_get_sys_ms64 at the resolution of the kernel tick,
+ *  read from the vDSO without a syscall, for the logging paths run per frame.
+ */
+static inline
+int64_t _libshm_get_sys_ms64_coarse()
+{
+#if defined(TVU_LINUX) && defined(CLOCK_REALTIME_COARSE)
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#else
+    return _libshm_get_sys_ms64();
+#endif
+}
+
 static inline
     void _libshm_common_usleep(int n)
 {
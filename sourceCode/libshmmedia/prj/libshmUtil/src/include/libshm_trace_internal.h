@@ -0,0 +1,145 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+#ifndef LIBSHM_TRACE_INTERNAL_H
+#define LIBSHM_TRACE_INTERNAL_H
+
+/**
+ *  tracing points of the media paths, the time of a frame broken down by stage.
+ *  the points are compiled in by LIBSHM_ENABLE_TRACE
+ *  (cmake -DENABLE_FEATURE_TRACE=ON, make ENABLE_TRACE=1), out by default.
+ *  a point compiled in is
+ *   - a pair of USDT probes libshmmedia:<name>__begin/<name>__end when <sys/sdt.h>
+ *     is there, a nop until perf/bpftrace attaches to it.
+ *   - a complete event into the ring of the calling thread while the recording is
+ *     on, one relaxed load when it is off. no lock, no syscall, each thread only
+ *     writes its own ring, the oldest events are overwritten.
+ *  the recorder is always built, TraceDumpChromeJson writes the rings as the json
+ *  of chrome://tracing and perfetto.
+**/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "libshm_atomic_internal.h"
+
+/* events kept per thread, a power of 2. */
+#define LIBSHM_TRACE_RING_EVENTS        4096
+/* threads recording at the same time, the others record nothing. */
+#define LIBSHM_TRACE_THREADS_MAX        64
+
+namespace tvushm {
+
+    typedef struct TraceEvent
+    {
+        const char  *name;      // static string of the point.
+        uint64_t    beginNs;
+        uint64_t    durNs;
+        uint64_t    arg;
+        uint32_t    tid;
+    } TraceEvent_t;
+
+    extern uint32_t g_libshmTraceEnabled;
+
+    static inline
+    bool TraceIsEnabled()
+    {
+        return _libshm_atomic_load_relaxed_u32(&g_libshmTraceEnabled) != 0;
+    }
+
+    /* turning it on drops the events recorded before. */
+    void TraceSetEnabled(bool enable);
+
+    /* monotonic ns. */
+    uint64_t TraceNowNs();
+
+    /* appends an event to the ring of the calling thread. */
+    void TraceRecord(const char *name, uint64_t beginNs, uint64_t endNs, uint64_t arg);
+
+    /* events not recorded since the last enabling, no ring left for the thread. */
+    uint64_t TraceDroppedEvents();
+
+    /**
+     *  writes the events of every thread recorded since the last enabling, as a
+     *  chrome trace json object. it may run while the others are recording.
+     *  return the events count written, -errno when writing failed.
+     */
+    int TraceDumpChromeJson(FILE *fp);
+
+    class TraceScope
+    {
+    public:
+        explicit TraceScope(const char *name)
+            : _name(name)
+            , _beginNs(TraceIsEnabled() ? TraceNowNs() : 0)
+            , _arg(0)
+        {
+        }
+
+        ~TraceScope()
+        {
+            if (_beginNs)
+            {
+                TraceRecord(_name, _beginNs, TraceNowNs(), _arg);
+            }
+        }
+
+        void SetArg(uint64_t arg)
+        {
+            _arg = arg;
+        }
+
+    private:
+        TraceScope(const TraceScope &);
+        TraceScope &operator=(const TraceScope &);
+
+        const char  *_name;
+        uint64_t    _beginNs;
+        uint64_t    _arg;
+    };
+
+}
+
+#if defined(LIBSHM_ENABLE_TRACE)
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define LIBSHM_TRACE_USDT(probe)        DTRACE_PROBE(libshmmedia, probe)
+#endif
+#endif
+
+#if !defined(LIBSHM_TRACE_USDT)
+#define LIBSHM_TRACE_USDT(probe)        do {} while (0)
+#endif
+
+/**
+ *  traces the rest of the enclosing block as the stage @name, an identifier
+ *  unique in the block, and the name of its USDT probes.
+ */
+#define LIBSHM_TRACE_SCOPE(name) \
+    LIBSHM_TRACE_USDT(name##__begin); \
+    struct _LibShmTraceUsdtEnd_##name { ~_LibShmTraceUsdtEnd_##name() { LIBSHM_TRACE_USDT(name##__end); } } _libshm_trace_usdt_end_##name; \
+    (void)_libshm_trace_usdt_end_##name; \
+    tvushm::TraceScope _libshm_trace_scope_##name(#name)
+
+/* the value shown as args.v of the event of the stage @name, e.g. the bytes copied. */
+#define LIBSHM_TRACE_ARG(name, v)       _libshm_trace_scope_##name.SetArg((uint64_t)(v))
+
+#else
+
+#define LIBSHM_TRACE_SCOPE(name)        do {} while (0)
+#define LIBSHM_TRACE_ARG(name, v)       do {} while (0)
+
+#endif
+
+#endif // LIBSHM_TRACE_INTERNAL_H
@@ -0,0 +1,151 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+#ifndef LIBSHM_WAIT_WORD_INTERNAL_H
+#define LIBSHM_WAIT_WORD_INTERNAL_H
+
+/**
+ *  a 32 bits word in shared memory one side sleeps on by futex until the
+ *  other side moves it. the low 31 bits are a sequence, the high bit is set
+ *  by a sleeper before it sleeps, so the other side only enters the kernel
+ *  when someone sleeps.
+ *  sleeper: sample the word, check its condition, arm, check again, sleep.
+ *  waker:   publish the new state, then wake the word.
+ *  only on linux, the helpers return false/do nothing on the others and the
+ *  callers fall back to sleeping a while.
+**/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(TVU_LINUX)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+#include <limits.h>
+#endif
+
+#define LIBSHM_WAIT_WORD_WAITERS_BIT        0x80000000U
+#define LIBSHM_WAIT_WORD_SEQ_MASK           0x7FFFFFFFU
+
+#if defined(TVU_LINUX)
+/* the word lives in MAP_SHARED memory, so it must not use the FUTEX_PRIVATE_FLAG ops. */
+static inline
+long _libshm_futex(uint32_t *uaddr, int op, uint32_t val, const struct timespec *ts)
+{
+    return syscall(SYS_futex, uaddr, op, val, ts, NULL, 0);
+}
+#endif
+
+static inline
+uint32_t _libshm_wait_word_load(const uint32_t *pword)
+{
+#if defined(TVU_LINUX)
+    return __atomic_load_n(pword, __ATOMIC_ACQUIRE);
+#else
+    (void)pword;
+    return 0;
+#endif
+}
+
+/**
+ *  set the waiters bit before sleeping on the word, false when the word moved
+ *  after @seq was sampled, there is no need to sleep then.
+**/
+static inline
+bool _libshm_wait_word_arm(uint32_t *pword, uint32_t seq, uint32_t *psleepval)
+{
+#if defined(TVU_LINUX)
+    uint32_t sleepval = (seq & LIBSHM_WAIT_WORD_SEQ_MASK) | LIBSHM_WAIT_WORD_WAITERS_BIT;
+    uint32_t cur = seq;
+
+    if (cur != sleepval
+        && !__atomic_compare_exchange_n(pword, &cur, sleepval, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+    {
+        if ((cur & LIBSHM_WAIT_WORD_SEQ_MASK) != (seq & LIBSHM_WAIT_WORD_SEQ_MASK))
+        {
+            return false;
+        }
+        /* another sleeper has already set the waiters bit. */
+    }
+
+    *psleepval = sleepval;
+    return true;
+#else
+    (void)pword;
+    (void)seq;
+    (void)psleepval;
+    return false;
+#endif
+}
+
+/* sleep while the word still holds @sleepval, at most @timeout ms. */
+static inline
+void _libshm_wait_word_sleep(uint32_t *pword, uint32_t sleepval, unsigned int timeout)
+{
+#if defined(TVU_LINUX)
+    struct timespec ts;
+    ts.tv_sec   = timeout / 1000;
+    ts.tv_nsec  = (timeout % 1000) * 1000000L;
+    _libshm_futex(pword, FUTEX_WAIT, sleepval, &ts);
+#else
+    (void)pword;
+    (void)sleepval;
+    (void)timeout;
+#endif
+}
+
+/**
+ *  move the sequence, and wake the sleepers when one armed the word.
+ *  the seq_cst CAS publishes the state stored before it.
+**/
+static inline
+void _libshm_wait_word_wake(uint32_t *pword)
+{
+#if defined(TVU_LINUX)
+    uint32_t old = __atomic_load_n(pword, __ATOMIC_RELAXED);
+    uint32_t val = 0;
+    do {
+        val = (old + 1) & LIBSHM_WAIT_WORD_SEQ_MASK;
+    } while (!__atomic_compare_exchange_n(pword, &old, val, true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+
+    if (old & LIBSHM_WAIT_WORD_WAITERS_BIT)
+    {
+        _libshm_futex(pword, FUTEX_WAKE, INT_MAX, NULL);
+    }
+#else
+    (void)pword;
+#endif
+}
+
+/**
+ *  as _libshm_wait_word_wake, but for a frequent waker with rare sleepers,
+ *  the word is only moved when a sleeper armed it. the fence pairs with the
+ *  CAS of _libshm_wait_word_arm, either the waker sees the waiters bit or
+ *  the sleeper's second check sees the state stored before.
+**/
+static inline
+void _libshm_wait_word_wake_armed(uint32_t *pword)
+{
+#if defined(TVU_LINUX)
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(pword, __ATOMIC_RELAXED) & LIBSHM_WAIT_WORD_WAITERS_BIT)
+    {
+        _libshm_wait_word_wake(pword);
+    }
+#else
+    (void)pword;
+#endif
+}
+
+#endif // LIBSHM_WAIT_WORD_INTERNAL_H
@@ -0,0 +1,176 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+#include "libshm_memcpy_internal.h"
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define LIBSHM_MEMCPY_X86   1
+#elif defined(__aarch64__) && defined(__GNUC__)
+#define LIBSHM_MEMCPY_NEON  1
+#endif
+
+/* the streaming stores go by whole lines, the destination is aligned by a normal copy first. */
+#define STREAMING_LINE      64
+
+namespace tvushm {
+
+    typedef size_t (*StreamingLinesFunc_t)(uint8_t *dst, const uint8_t *src, size_t len);
+
+#if LIBSHM_MEMCPY_X86
+    /* each copies the whole lines of @len to the line aligned @dst, return the bytes copied. */
+    static size_t _streamingLinesSse2(uint8_t *dst, const uint8_t *src, size_t len)
+    {
+        size_t n = len & ~(size_t)(STREAMING_LINE - 1);
+        for (size_t off = 0; off < n; off += STREAMING_LINE)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i *)(src + off));
+            __m128i b = _mm_loadu_si128((const __m128i *)(src + off + 16));
+            __m128i c = _mm_loadu_si128((const __m128i *)(src + off + 32));
+            __m128i d = _mm_loadu_si128((const __m128i *)(src + off + 48));
+            _mm_stream_si128((__m128i *)(dst + off), a);
+            _mm_stream_si128((__m128i *)(dst + off + 16), b);
+            _mm_stream_si128((__m128i *)(dst + off + 32), c);
+            _mm_stream_si128((__m128i *)(dst + off + 48), d);
+        }
+        _mm_sfence();
+        return n;
+    }
+
+    __attribute__((target("avx2")))
+    static size_t _streamingLinesAvx2(uint8_t *dst, const uint8_t *src, size_t len)
+    {
+        size_t n = len & ~(size_t)(2 * STREAMING_LINE - 1);
+        for (size_t off = 0; off < n; off += 2 * STREAMING_LINE)
+        {
+            __m256i a = _mm256_loadu_si256((const __m256i *)(src + off));
+            __m256i b = _mm256_loadu_si256((const __m256i *)(src + off + 32));
+            __m256i c = _mm256_loadu_si256((const __m256i *)(src + off + 64));
+            __m256i d = _mm256_loadu_si256((const __m256i *)(src + off + 96));
+            _mm256_stream_si256((__m256i *)(dst + off), a);
+            _mm256_stream_si256((__m256i *)(dst + off + 32), b);
+            _mm256_stream_si256((__m256i *)(dst + off + 64), c);
+            _mm256_stream_si256((__m256i *)(dst + off + 96), d);
+        }
+        _mm_sfence();
+        return n;
+    }
+
+    __attribute__((target("avx512f")))
+    static size_t _streamingLinesAvx512(uint8_t *dst, const uint8_t *src, size_t len)
+    {
+        size_t n = len & ~(size_t)(4 * STREAMING_LINE - 1);
+        for (size_t off = 0; off < n; off += 4 * STREAMING_LINE)
+        {
+            __m512i a = _mm512_loadu_si512((const void *)(src + off));
+            __m512i b = _mm512_loadu_si512((const void *)(src + off + 64));
+            __m512i c = _mm512_loadu_si512((const void *)(src + off + 128));
+            __m512i d = _mm512_loadu_si512((const void *)(src + off + 192));
+            _mm512_stream_si512((__m512i *)(dst + off), a);
+            _mm512_stream_si512((__m512i *)(dst + off + 64), b);
+            _mm512_stream_si512((__m512i *)(dst + off + 128), c);
+            _mm512_stream_si512((__m512i *)(dst + off + 192), d);
+        }
+        _mm_sfence();
+        return n;
+    }
+#endif
+
+#if LIBSHM_MEMCPY_NEON
+    static size_t _streamingLinesNeon(uint8_t *dst, const uint8_t *src, size_t len)
+    {
+        size_t n = len & ~(size_t)(STREAMING_LINE - 1);
+        for (size_t off = 0; off < n; off += STREAMING_LINE)
+        {
+            __asm__ __volatile__(
+                "ldp q0, q1, [%1]\n\t"
+                "ldp q2, q3, [%1, #32]\n\t"
+                "stnp q0, q1, [%0]\n\t"
+                "stnp q2, q3, [%0, #32]\n\t"
+                :
+                : "r"(dst + off), "r"(src + off)
+                : "v0", "v1", "v2", "v3", "memory");
+        }
+        __asm__ __volatile__("dmb ishst" ::: "memory");
+        return n;
+    }
+#endif
+
+    struct StreamingKernel
+    {
+        StreamingLinesFunc_t    fn;
+        const char              *name;
+    };
+
+    static StreamingKernel _selectKernel()
+    {
+        StreamingKernel k = { NULL, "memcpy" };
+#if LIBSHM_MEMCPY_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            k.fn = _streamingLinesAvx512;
+            k.name = "avx512";
+        }
+        else if (__builtin_cpu_supports("avx2"))
+        {
+            k.fn = _streamingLinesAvx2;
+            k.name = "avx2";
+        }
+        else
+        {
+            k.fn = _streamingLinesSse2;
+            k.name = "sse2";
+        }
+#elif LIBSHM_MEMCPY_NEON
+        k.fn = _streamingLinesNeon;
+        k.name = "neon";
+#endif
+        return k;
+    }
+
+    static const StreamingKernel &_kernel()
+    {
+        static const StreamingKernel k = _selectKernel();
+        return k;
+    }
+
+    void *MemcpyStreaming(void *dst, const void *src, size_t len)
+    {
+        const StreamingKernel &k = _kernel();
+
+        if (len < LIBSHM_STREAMING_COPY_THRESHOLD || !k.fn)
+        {
+            return memcpy(dst, src, len);
+        }
+
+        uint8_t *d = (uint8_t *)dst;
+        const uint8_t *s = (const uint8_t *)src;
+        size_t head = (size_t)(-(uintptr_t)d & (STREAMING_LINE - 1));
+
+        memcpy(d, s, head);
+        d += head;
+        s += head;
+        len -= head;
+
+        size_t n = k.fn(d, s, len);
+        memcpy(d + n, s + n, len - n);
+        return dst;
+    }
+
+    const char *MemcpyStreamingKernelName()
+    {
+        return _kernel().name;
+    }
+
+}
@@ -89,7 +89,7 @@ public:
             nodes_ = std::move(other.nodes_);
             free_list_ = std::move(other.free_list_);
             capacity_ = other.capacity_;
-            used_count_ = other.used_count_.load();
+            used_count_ = other.used_count_;
             initializer_ = std::move(other.initializer_);
             destructor_ = std::move(other.destructor_);
 
@@ -0,0 +1,231 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+#include "libshm_trace_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <chrono>
+#include <vector>
+
+#if defined(TVU_LINUX)
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#define TRACE_RING_MASK     (LIBSHM_TRACE_RING_EVENTS - 1)
+
+namespace tvushm {
+
+    uint32_t g_libshmTraceEnabled = 0;
+
+    /* only the owner thread writes its ring, the dumper reads the events below head. */
+    typedef struct TraceRing
+    {
+        uint64_t        head;
+        TraceEvent_t    events[LIBSHM_TRACE_RING_EVENTS];
+    } TraceRing_t;
+
+    /* owner is the tid of the thread holding the slot, 0 free. ring stays for the next owner. */
+    typedef struct TraceSlot
+    {
+        uint64_t        owner;
+        uint64_t        ring;
+    } TraceSlot_t;
+
+    static TraceSlot_t  s_slots[LIBSHM_TRACE_THREADS_MAX];
+    static uint64_t     s_startNs   = 0;
+    static uint32_t     s_dropped   = 0;
+
+    static uint32_t _getTid()
+    {
+#if defined(TVU_LINUX)
+        return (uint32_t)syscall(SYS_gettid);
+#else
+        static uint32_t s_tids = 0;
+        return _libshm_atomic_inc_u32(&s_tids);
+#endif
+    }
+
+    /* gives the slot back when the thread exits. */
+    class TraceThreadSlot
+    {
+    public:
+        TraceThreadSlot() : _ring(NULL), _slot(-1), _tid(0) {}
+
+        ~TraceThreadSlot()
+        {
+            if (_slot >= 0)
+            {
+                _libshm_atomic_store_release_u64(&s_slots[_slot].owner, 0);
+            }
+        }
+
+        TraceRing_t *Ring(uint32_t *ptid)
+        {
+            if (_slot == -1)
+            {
+                _claim();
+            }
+            *ptid = _tid;
+            return _ring;
+        }
+
+    private:
+        void _claim()
+        {
+            _tid = _getTid();
+            _slot = -2;
+
+            for (int i = 0; i < LIBSHM_TRACE_THREADS_MAX; i++)
+            {
+                if (!_libshm_atomic_cas_u64(&s_slots[i].owner, 0, _tid ? _tid : 1))
+                {
+                    continue;
+                }
+
+                TraceRing_t *ring = (TraceRing_t *)(uintptr_t)_libshm_atomic_load_acquire_u64(&s_slots[i].ring);
+                if (!ring)
+                {
+                    ring = (TraceRing_t *)calloc(1, sizeof(TraceRing_t));
+                    if (!ring)
+                    {
+                        _libshm_atomic_store_release_u64(&s_slots[i].owner, 0);
+                        return;
+                    }
+                    _libshm_atomic_store_release_u64(&s_slots[i].ring, (uint64_t)(uintptr_t)ring);
+                }
+                _ring = ring;
+                _slot = i;
+                return;
+            }
+        }
+
+        TraceRing_t *_ring;
+        int         _slot;     // -1 not claimed yet, -2 no slot left.
+        uint32_t    _tid;
+    };
+
+    static thread_local TraceThreadSlot t_slot;
+
+    void TraceSetEnabled(bool enable)
+    {
+        if (enable)
+        {
+            _libshm_atomic_store_relaxed_u32(&s_dropped, 0);
+            _libshm_atomic_store_release_u64(&s_startNs, TraceNowNs());
+        }
+        _libshm_atomic_store_release_u32(&g_libshmTraceEnabled, enable ? 1 : 0);
+    }
+
+    uint64_t TraceNowNs()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void TraceRecord(const char *name, uint64_t beginNs, uint64_t endNs, uint64_t arg)
+    {
+        uint32_t    tid  = 0;
+        TraceRing_t *ring = t_slot.Ring(&tid);
+
+        if (!ring)
+        {
+            _libshm_atomic_inc_u32(&s_dropped);
+            return;
+        }
+
+        uint64_t        head = ring->head;
+        TraceEvent_t    &ev  = ring->events[head & TRACE_RING_MASK];
+        ev.name     = name;
+        ev.beginNs  = beginNs;
+        ev.durNs    = endNs > beginNs ? endNs - beginNs : 0;
+        ev.arg      = arg;
+        ev.tid      = tid;
+        _libshm_atomic_store_release_u64(&ring->head, head + 1);
+    }
+
+    uint64_t TraceDroppedEvents()
+    {
+        return _libshm_atomic_load_relaxed_u32(&s_dropped);
+    }
+
+    /* copies the events of @ring not overwritten while copying. */
+    static void _snapshotRing(TraceRing_t *ring, uint64_t startNs, std::vector<TraceEvent_t> &out)
+    {
+        uint64_t head = _libshm_atomic_load_acquire_u64(&ring->head);
+        uint64_t from = head > LIBSHM_TRACE_RING_EVENTS ? head - LIBSHM_TRACE_RING_EVENTS : 0;
+        std::vector<TraceEvent_t> events;
+
+        events.reserve((size_t)(head - from));
+        for (uint64_t i = from; i < head; i++)
+        {
+            events.push_back(ring->events[i & TRACE_RING_MASK]);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint64_t now = _libshm_atomic_load_acquire_u64(&ring->head);
+        uint64_t valid = now > LIBSHM_TRACE_RING_EVENTS ? now - LIBSHM_TRACE_RING_EVENTS : 0;
+
+        for (uint64_t i = from; i < head; i++)
+        {
+            const TraceEvent_t &ev = events[(size_t)(i - from)];
+            if (i >= valid && ev.beginNs >= startNs)
+            {
+                out.push_back(ev);
+            }
+        }
+    }
+
+    int TraceDumpChromeJson(FILE *fp)
+    {
+        uint64_t startNs = _libshm_atomic_load_acquire_u64(&s_startNs);
+        std::vector<TraceEvent_t> events;
+
+        for (int i = 0; i < LIBSHM_TRACE_THREADS_MAX; i++)
+        {
+            TraceRing_t *ring = (TraceRing_t *)(uintptr_t)_libshm_atomic_load_acquire_u64(&s_slots[i].ring);
+            if (ring)
+            {
+                _snapshotRing(ring, startNs, events);
+            }
+        }
+
+#if defined(TVU_LINUX)
+        int pid = (int)getpid();
+#else
+        int pid = 1;
+#endif
+        fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped\":%llu},\"traceEvents\":[\n"
+            , (unsigned long long)TraceDroppedEvents());
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            const TraceEvent_t &ev = events[i];
+            fprintf(fp, "%s{\"name\":\"%s\",\"cat\":\"libshmmedia\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u"
+                ",\"ts\":%llu.%03u,\"dur\":%llu.%03u,\"args\":{\"v\":%llu}}\n"
+                , i ? "," : ""
+                , ev.name, pid, ev.tid
+                , (unsigned long long)(ev.beginNs / 1000), (unsigned)(ev.beginNs % 1000)
+                , (unsigned long long)(ev.durNs / 1000), (unsigned)(ev.durNs % 1000)
+                , (unsigned long long)ev.arg
+            );
+        }
+        fprintf(fp, "]}\n");
+
+        if (fflush(fp) != 0 || ferror(fp))
+        {
+            return errno ? -errno : -EIO;
+        }
+        return (int)events.size();
+    }
+
+}
@@ -0,0 +1,72 @@
+// Benchmarks of libshm_memcpy, built into the opt-in unitTestBench binary
+#include <gtest/gtest.h>
+#include "libshm_memcpy_internal.h"
+#include <string.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <vector>
+
+using namespace tvushm;
+
+static void fill_pattern(std::vector<uint8_t> &v)
+{
+    for (size_t i = 0; i < v.size(); i++)
+    {
+        v[i] = (uint8_t)(i * 131 + (i >> 8));
+    }
+}
+
+static double now_us()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+// a frame per round into a ring of 128 MiB, as a writer does, the destination is never hot
+TEST(MemcpyStreaming, Benchmark_MemcpyStreamingVsMemcpy) {
+    const struct { const char *name; size_t len; } frames[] = {
+        { "1080p", 1920 * 1080 * 2 },
+        { "4K",    3840 * 2160 * 2 },
+        { "8K",    7680 * 4320 * 2 },
+    };
+
+    for (size_t f = 0; f < sizeof(frames) / sizeof(frames[0]); f++)
+    {
+        int ring = (int)((128u * 1024 * 1024) / frames[f].len);
+        if (ring < 2)
+        {
+            ring = 2;
+        }
+        std::vector<uint8_t> src(frames[f].len);
+        std::vector<uint8_t> dst(frames[f].len * ring);
+        fill_pattern(src);
+        int rounds = (int)((512u * 1024 * 1024) / frames[f].len);
+        if (rounds < ring)
+        {
+            rounds = ring;
+        }
+
+        double plain = 0, streaming = 0;
+        for (int pass = 0; pass < 2; pass++)
+        {
+            double t0 = now_us();
+            for (int r = 0; r < rounds; r++)
+            {
+                memcpy(dst.data() + (r % ring) * frames[f].len, src.data(), frames[f].len);
+            }
+            plain = (double)frames[f].len * rounds / (now_us() - t0);
+
+            t0 = now_us();
+            for (int r = 0; r < rounds; r++)
+            {
+                MemcpyStreaming(dst.data() + (r % ring) * frames[f].len, src.data(), frames[f].len);
+            }
+            streaming = (double)frames[f].len * rounds / (now_us() - t0);
+        }
+        EXPECT_EQ(0, memcmp(dst.data(), src.data(), frames[f].len));
+
+        printf("[ BENCH    ] %s frame %zu bytes: memcpy %.0f MB/s, streaming(%s) %.0f MB/s\n"
+               , frames[f].name, frames[f].len, plain, MemcpyStreamingKernelName(), streaming);
+    }
+}
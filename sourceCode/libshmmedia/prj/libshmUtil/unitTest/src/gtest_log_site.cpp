@@ -0,0 +1,69 @@
+// Unit tests for the rate limiting and the level filter of the log sites
+#include <gtest/gtest.h>
+#include "libshm_log_internal.h"
+
+static int hits_printed(libshm_log_site_t *site, uint64_t now, uint32_t seconds, uint32_t maxCounts, int hits)
+{
+    int printed = 0;
+    for (int i = 0; i < hits; i++)
+    {
+        uint32_t counts = 0;
+        uint64_t intervalMs = 0;
+        bool timeout = false;
+        if (_libshm_log_site_hit(site, now, seconds, maxCounts, &counts, &intervalMs, &timeout))
+        {
+            printed++;
+        }
+    }
+    return printed;
+}
+
+TEST(LogSite, PrintsMaxCountsPerInterval) {
+    libshm_log_site_t site = {0, 0};
+    uint32_t counts = 0;
+    uint64_t intervalMs = 0;
+    bool timeout = false;
+
+    /* the first hit starts the interval. */
+    EXPECT_TRUE(_libshm_log_site_hit(&site, 100000, 10, 3, &counts, &intervalMs, &timeout));
+    EXPECT_TRUE(timeout);
+    EXPECT_EQ(100000u, site.lastMs);
+
+    /* then 2 more, as the counts of the interval restart from the first. */
+    EXPECT_EQ(2, hits_printed(&site, 101000, 10, 3, 50));
+
+    /* the next interval prints its first with the hits after the first of the last one, and its time. */
+    EXPECT_TRUE(_libshm_log_site_hit(&site, 110000, 10, 3, &counts, &intervalMs, &timeout));
+    EXPECT_TRUE(timeout);
+    EXPECT_EQ(51u, counts);
+    EXPECT_EQ(10000u, intervalMs);
+
+    EXPECT_EQ(2, hits_printed(&site, 110500, 10, 3, 50));
+}
+
+TEST(LogSite, ClockSteppedBackStartsAnInterval) {
+    libshm_log_site_t site = {0, 0};
+    EXPECT_EQ(1, hits_printed(&site, 500000, 10, 1, 5));
+    /* a little jitter back stays in the interval, a step back of seconds does not. */
+    EXPECT_EQ(0, hits_printed(&site, 499500, 10, 1, 5));
+    EXPECT_EQ(1, hits_printed(&site, 400000, 10, 1, 5));
+    EXPECT_EQ(400000u, site.lastMs);
+}
+
+TEST(LogSite, LevelFilter) {
+    uint32_t saved = g_libshmLogLevel;
+
+    g_libshmLogLevel = LIBSHM_LOG_LEVEL_WARN;
+    EXPECT_FALSE(_libshm_log_level_enabled(_libshm_log_level_of('i'), LIBSHM_LOG_LEVEL_DEFAULT));
+    EXPECT_TRUE(_libshm_log_level_enabled(_libshm_log_level_of('w'), LIBSHM_LOG_LEVEL_DEFAULT));
+    EXPECT_TRUE(_libshm_log_level_enabled(_libshm_log_level_of('e'), LIBSHM_LOG_LEVEL_DEFAULT));
+
+    /* the level of a handle wins over the global one, both ways. */
+    EXPECT_TRUE(_libshm_log_level_enabled(_libshm_log_level_of('i'), LIBSHM_LOG_LEVEL_INFO));
+    EXPECT_FALSE(_libshm_log_level_enabled(_libshm_log_level_of('e'), LIBSHM_LOG_LEVEL_NONE));
+
+    g_libshmLogLevel = LIBSHM_LOG_LEVEL_NONE;
+    EXPECT_FALSE(_libshm_log_level_enabled(_libshm_log_level_of('e'), LIBSHM_LOG_LEVEL_DEFAULT));
+
+    g_libshmLogLevel = saved;
+}
@@ -0,0 +1,55 @@
+// Unit tests for libshm_memcpy
+#include <gtest/gtest.h>
+#include "libshm_memcpy_internal.h"
+#include <string.h>
+#include <stdio.h>
+#include <vector>
+
+using namespace tvushm;
+
+static void fill_pattern(std::vector<uint8_t> &v)
+{
+    for (size_t i = 0; i < v.size(); i++)
+    {
+        v[i] = (uint8_t)(i * 131 + (i >> 8));
+    }
+}
+
+TEST(MemcpyStreaming, KernelName) {
+    const char *name = MemcpyStreamingKernelName();
+    ASSERT_NE(name, (const char *)NULL);
+    EXPECT_GT(strlen(name), 0u);
+}
+
+TEST(MemcpyStreaming, CopiesAroundThresholdAndMisalignment) {
+    const size_t sizes[] = {
+        0, 1, 63, 4096,
+        LIBSHM_STREAMING_COPY_THRESHOLD - 1,
+        LIBSHM_STREAMING_COPY_THRESHOLD,
+        LIBSHM_STREAMING_COPY_THRESHOLD + 1,
+        LIBSHM_STREAMING_COPY_THRESHOLD + 255,
+        3 * LIBSHM_STREAMING_COPY_THRESHOLD + 77,
+    };
+    const size_t maxLen = 3 * LIBSHM_STREAMING_COPY_THRESHOLD + 77;
+    std::vector<uint8_t> src(maxLen + 64);
+    std::vector<uint8_t> dst(maxLen + 128);
+    fill_pattern(src);
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        for (size_t doff = 0; doff < 64; doff += 13)
+        {
+            size_t soff = (doff * 7) & 63;
+            memset(dst.data(), 0xEE, dst.size());
+            void *ret = MemcpyStreaming(dst.data() + doff, src.data() + soff, sizes[s]);
+            EXPECT_EQ(ret, (void *)(dst.data() + doff));
+            ASSERT_EQ(0, memcmp(dst.data() + doff, src.data() + soff, sizes[s]))
+                << "len " << sizes[s] << " dst offset " << doff;
+            for (size_t i = 0; i < doff; i++)
+            {
+                ASSERT_EQ(dst[i], 0xEE);
+            }
+            ASSERT_EQ(dst[doff + sizes[s]], 0xEE);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+/**
+ *  the items of the two-process writer/reader stress tests of the rings,
+ *  each one carries its sequence and a hash of its body, so a reader tells
+ *  a lost, reordered or torn item.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace {
+
+struct StressItemHead
+{
+    uint64_t seq;
+    uint64_t len;
+    uint64_t hash;
+};
+
+/* lives in an anonymous shared mapping, visible to both sides of fork. */
+struct StressProgress
+{
+    uint32_t ready;
+    uint64_t consumed;
+};
+
+static inline uint64_t stress_fnv1a(const uint8_t *p, size_t n)
+{
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < n; i++)
+    {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* bytes of the item @seq with the head, at most @maxlen. */
+static inline size_t stress_len(uint64_t seq, size_t maxlen)
+{
+    return sizeof(StressItemHead) + 16 + (size_t)((seq * 2654435761ULL) % (maxlen - sizeof(StressItemHead) - 16));
+}
+
+static inline void stress_fill(uint8_t *p, uint64_t seq, size_t total)
+{
+    StressItemHead *head = (StressItemHead *)p;
+    uint8_t *body = p + sizeof(StressItemHead);
+    size_t len = total - sizeof(StressItemHead);
+    for (size_t i = 0; i < len; i++)
+    {
+        body[i] = (uint8_t)(seq + i * 31);
+    }
+    head->seq = seq;
+    head->len = len;
+    head->hash = stress_fnv1a(body, len);
+}
+
+/* 0 ok, 2 lost or reordered item, 3 torn payload. */
+static inline int stress_check(const uint8_t *p, size_t total, uint64_t seq)
+{
+    const StressItemHead *head = (const StressItemHead *)p;
+    if (total < sizeof(StressItemHead) || head->seq != seq)
+        return 2;
+    if (head->len != total - sizeof(StressItemHead)
+        || head->hash != stress_fnv1a(p + sizeof(StressItemHead), (size_t)head->len))
+        return 3;
+    return 0;
+}
+
+} // namespace
@@ -0,0 +1,128 @@
+// Unit tests for the trace event recorder
+#include <gtest/gtest.h>
+#include "libshm_trace_internal.h"
+#include <string.h>
+#include <stdio.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tvushm;
+
+static std::string dump_to_string(int *pcount)
+{
+    FILE *fp = tmpfile();
+    std::string out;
+    if (!fp)
+    {
+        *pcount = -1;
+        return out;
+    }
+
+    *pcount = TraceDumpChromeJson(fp);
+    rewind(fp);
+
+    char buf[4096];
+    size_t n = 0;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+    {
+        out.append(buf, n);
+    }
+    fclose(fp);
+    return out;
+}
+
+static int count_of(const std::string &s, const std::string &sub)
+{
+    int n = 0;
+    for (size_t pos = s.find(sub); pos != std::string::npos; pos = s.find(sub, pos + sub.size()))
+    {
+        n++;
+    }
+    return n;
+}
+
+TEST(Trace, RecordsScopesOnlyWhileEnabled) {
+    TraceSetEnabled(false);
+    {
+        TraceScope off("gtest_trace_off");
+    }
+
+    TraceSetEnabled(true);
+    {
+        TraceScope on("gtest_trace_on");
+        on.SetArg(1234);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        TraceScope worker("gtest_trace_loop");
+    }
+    TraceSetEnabled(false);
+
+    int count = 0;
+    std::string json = dump_to_string(&count);
+    EXPECT_EQ(4, count);
+    EXPECT_EQ(0u, TraceDroppedEvents());
+    EXPECT_EQ(0, count_of(json, "\"gtest_trace_off\""));
+    EXPECT_EQ(1, count_of(json, "\"gtest_trace_on\""));
+    EXPECT_EQ(3, count_of(json, "\"gtest_trace_loop\""));
+    EXPECT_NE(std::string::npos, json.find("\"args\":{\"v\":1234}"));
+    EXPECT_EQ(0u, json.find("{\"displayTimeUnit\""));
+    EXPECT_NE(std::string::npos, json.find("\"ph\":\"X\""));
+}
+
+TEST(Trace, EnablingDropsTheEventsBefore) {
+    TraceSetEnabled(true);
+    TraceRecord("gtest_trace_old", TraceNowNs(), TraceNowNs(), 0);
+    TraceSetEnabled(true);
+    TraceRecord("gtest_trace_new", TraceNowNs(), TraceNowNs(), 0);
+    TraceSetEnabled(false);
+
+    int count = 0;
+    std::string json = dump_to_string(&count);
+    EXPECT_EQ(1, count);
+    EXPECT_EQ(0, count_of(json, "\"gtest_trace_old\""));
+    EXPECT_EQ(1, count_of(json, "\"gtest_trace_new\""));
+}
+
+TEST(Trace, ThreadRingsKeepTheLatestEvents) {
+    const int threads = 4;
+    const int events = LIBSHM_TRACE_RING_EVENTS + 100;
+
+    /* the threads hold their slots till all are done, no ring is taken over by another. */
+    std::atomic<int> done(0);
+
+    TraceSetEnabled(true);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.push_back(std::thread([t, events, threads, &done]() {
+            for (int i = 0; i < events; i++)
+            {
+                uint64_t now = TraceNowNs();
+                TraceRecord("gtest_trace_thread", now, now + 10, (uint64_t)t * 1000000 + i);
+            }
+            done++;
+            while (done.load() < threads)
+            {
+                std::this_thread::yield();
+            }
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); t++)
+    {
+        workers[t].join();
+    }
+    TraceSetEnabled(false);
+
+    int count = 0;
+    std::string json = dump_to_string(&count);
+    EXPECT_EQ(threads * LIBSHM_TRACE_RING_EVENTS, count);
+    EXPECT_EQ(threads * LIBSHM_TRACE_RING_EVENTS, count_of(json, "\"gtest_trace_thread\""));
+    /* the oldest of each ring was overwritten, the latest is kept. */
+    EXPECT_EQ(std::string::npos, json.find("\"args\":{\"v\":0}}"));
+    char latest[64];
+    snprintf(latest, sizeof(latest), "\"args\":{\"v\":%d}}", events - 1);
+    EXPECT_NE(std::string::npos, json.find(latest));
+}
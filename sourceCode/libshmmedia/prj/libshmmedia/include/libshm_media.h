@@ -82,6 +82,85 @@ libshm_media_handle_t LibShmMediaCreate2
     , mode_t mode
 );
 
+/**
+ *  Functionality:
+ *      used to create the share memory, or just open it if the share memory had existed.
+ *      Same as LibShmMediaCreate2 but allows specifying the creating flags.
+ *  Parameter:
+ *      @pMemoryName:
+ *          share memory entry name
+ *      @header_len:
+ *          the share memory head size, which would store the media head data.
+ *      @item_count:
+ *          how many counts of share memory item counts.
+ *      @item_length:
+ *          every item size.
+ *      @mode:
+ *          permission bits passed to shm_open (e.g. S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP).
+ *      @flags:
+ *          LIBSHM_MEDIA_CREATE_FLAG_XXX.
+ *          LIBSHM_MEDIA_CREATE_FLAG_LOSSLESS, the writer keeps every item until all
+ *          registered readers(see LibShmMediaGetReaders) read it. Sending returns -EAGAIN
+ *          when the slowest reader still holds the next item, LibShmMediaPollSendable
+ *          waits for it. At most item_count - 1 items are in flight. A reader silent
+ *          over 3s loses its slot, its next read returns -EPIPE once for the items
+ *          it may have missed, and it is registered again.
+ *          LIBSHM_MEDIA_CREATE_FLAG_HUGEPAGE, back the share memory by huge pages,
+ *          see LibShmMediaGetPageBacking for the backing really used.
+ *          LIBSHM_MEDIA_CREATE_FLAG_PREFAULT, fault in every page before returning,
+ *          LIBSHM_MEDIA_CREATE_FLAG_MLOCK, mlock the share memory, failing only warns.
+ *          see LibShmMediaGetPrefaultTime for how long it took.
+ *  Return:
+ *      NULL, open failed. Or return the share memory handle.
+ */
+_LIBSHMMEDIA_DLL_
+libshm_media_handle_t LibShmMediaCreate3
+(
+    const char * pMemoryName
+    , uint32_t header_len
+    , uint32_t item_count
+    , uint32_t item_length
+    , mode_t mode
+    , uint32_t flags
+);
+
+/**
+ *  Functionality:
+ *      used to create the share memory on a NUMA node, or just open it if the share
+ *      memory had existed. Same as LibShmMediaCreate3 but allows specifying the node.
+ *  Parameter:
+ *      @pMemoryName:
+ *          share memory entry name
+ *      @header_len:
+ *          the share memory head size, which would store the media head data.
+ *      @item_count:
+ *          how many counts of share memory item counts.
+ *      @item_length:
+ *          every item size.
+ *      @mode:
+ *          permission bits passed to shm_open.
+ *      @flags:
+ *          LIBSHM_MEDIA_CREATE_FLAG_XXX, see LibShmMediaCreate3.
+ *      @numa_node:
+ *          the node the pages are preferred on, LIBSHM_MEDIA_NUMA_NODE_NONE for none.
+ *          the node is recorded in the share memory head, readers query it by
+ *          LibShmMediaGetNumaNode to run on the same node. when the node could not be
+ *          applied, the share memory is placed as usual and records none.
+ *  Return:
+ *      NULL, open failed. Or return the share memory handle.
+ */
+_LIBSHMMEDIA_DLL_
+libshm_media_handle_t LibShmMediaCreate4
+(
+    const char * pMemoryName
+    , uint32_t header_len
+    , uint32_t item_count
+    , uint32_t item_length
+    , mode_t mode
+    , uint32_t flags
+    , int numa_node
+);
+
 /**
  *  Functionality:
  *      used to open the existed share memory.
@@ -105,6 +184,33 @@ libshm_media_handle_t LibShmMediaOpen(
     , void *opaq
 );
 
+/**
+ *  Functionality:
+ *      used to open the existed share memory, same as LibShmMediaOpen but allows
+ *      specifying the opening flags.
+ *  Parameter:
+ *      @pMemoryName:
+ *          share memory entry name
+ *      @cb      :
+ *          user callback function
+ *      @opaq    :
+ *          user self data
+ *      @flags   :
+ *          LIBSHM_MEDIA_OPEN_FLAG_XXX.
+ *          LIBSHM_MEDIA_OPEN_FLAG_PREFAULT, fault in every page of the share memory before returning.
+ *          LIBSHM_MEDIA_OPEN_FLAG_MLOCK, mlock the share memory, failing only warns.
+ *          see LibShmMediaGetPrefaultTime for how long it took.
+ *  Return:
+ *      NULL, open failed. Or return the share memory handle.
+ */
+_LIBSHMMEDIA_DLL_
+libshm_media_handle_t LibShmMediaOpen2(
+    const char * pMemoryName
+    , libshm_media_readcb_t cb
+    , void *opaq
+    , uint32_t flags
+);
+
 
 /**
  *  Functionality:
@@ -131,7 +237,19 @@ _LIBSHMMEDIA_DLL_
 uint32_t LibShmMediaGetVersion(libshm_media_handle_t h);
 uint32_t LibShmMediaGetHeadVersion(libshm_media_handle_t h);
 //void LibShmMediaSetCloseflag(libshm_media_handle_t h, int bclose);
-//int LibShmMediaCheckCloseflag(libshm_media_handle_t h);
+
+/**
+ *  Functionality:
+ *      check whether the creator has closed the share memory.
+ *  Parameter:
+ *      @h:
+ *          share memory handle.
+ *  Return:
+ *      1 : closed, the handle should be destroyed.
+ *      0 : still open.
+ */
+_LIBSHMMEDIA_DLL_
+int LibShmMediaCheckCloseflag(libshm_media_handle_t h);
 
 /**
  *  Functionality:
@@ -308,14 +426,54 @@ const char *LibShmMediaGetName(libshm_media_handle_t h);
 _LIBSHMMEDIA_DLL_ 
 int LibShmMediaIsCreator(libshm_media_handle_t h);
 
+/**
+ *  Functionality:
+ *      get the page backing of the share memory, for creator and reader both.
+ *      creating with LIBSHM_MEDIA_CREATE_FLAG_HUGEPAGE falls back to normal pages
+ *      when huge pages are not available, this tells which one was used.
+ *  Parameters:
+ *      @h[IN]          : share memory handle.
+ *  Return:
+ *      LIBSHM_MEDIA_PAGE_BACKING_NORMAL    : normal pages of /dev/shm.
+ *      LIBSHM_MEDIA_PAGE_BACKING_HUGETLBFS : huge pages of the hugetlbfs mount.
+**/
+_LIBSHMMEDIA_DLL_
+int LibShmMediaGetPageBacking(libshm_media_handle_t h);
+
+/**
+ *  Functionality:
+ *      get how long the warm up of the share memory took when creating or opening,
+ *      as asked by the PREFAULT/MLOCK creating or opening flags.
+ *  Parameters:
+ *      @h[IN]          : share memory handle.
+ *  Return:
+ *      micro-seconds of prefaulting and locking, 0 when neither was asked.
+**/
+_LIBSHMMEDIA_DLL_
+int64_t LibShmMediaGetPrefaultTime(libshm_media_handle_t h);
+
+/**
+ *  Functionality:
+ *      get the NUMA node the creator placed the share memory on, for creator and
+ *      reader both. readers pin themselves to the node's cpus to read locally.
+ *  Parameters:
+ *      @h[IN]          : share memory handle.
+ *  Return:
+ *      the node number, LIBSHM_MEDIA_NUMA_NODE_NONE when the share memory was not
+ *      placed on a node, or was created by an older library.
+**/
+_LIBSHMMEDIA_DLL_
+int LibShmMediaGetNumaNode(libshm_media_handle_t h);
+
 /**
  *  Functionality:
  *      Poll whether the share memory is sendable.
+ *      Only a lossless writer would wait, until the slowest reader releases an item.
  *  Parameters:
  *      @h[IN]          : share memory handle.
  *      @timeout[IN]    : how many milli-seconds to poll.
  *  Return:
- *      0   :   not ready
+ *      0   :   not ready, lossless writer is blocked by the slowest reader.
  *      +   :   ready, there is data in.
  *      -   :   I/O error, need to destroy/create the handle again.
  */
@@ -331,6 +489,8 @@ int LibShmMediaPollSendable(libshm_media_handle_t h, unsigned int timeout);
  *  Return:
  *      0   :   not ready
  *      +   :   ready, there is data in.
+ *      -EPIPE  :   lossless reader lost its slot, items may have been overwritten unread,
+ *                  the handle is still usable.
  *      -   :   I/O error, need to destroy/create the handle again.
  */
 _LIBSHMMEDIA_DLL_ 
@@ -346,6 +506,7 @@ int LibShmMediaPollReadable(libshm_media_handle_t h, unsigned int timeout);
  *  Reutrn:
  *      0   :   not ready
  *      +   :   Send success, express writing size.
+ *      -EAGAIN :   lossless writer is blocked by the slowest reader, retry later.
  *      -   :   I/O error
  */
 _LIBSHMMEDIA_DLL_ 
@@ -374,6 +535,36 @@ int LibShmMediaSendDataWithFrequency1000(
     , const libshm_media_item_param_t *pmi
 );
 
+/**
+ *  Functionality:
+ *      select how the writer copies the video/audio payloads of the items.
+ *  Parameters:
+ *      @h[IN]      : share memory handle.
+ *      @mode[IN]   : LIBSHM_MEDIA_COPY_MODE_XXX, the default is LIBSHM_MEDIA_COPY_MODE_DEFAULT.
+ *          LIBSHM_MEDIA_COPY_MODE_STREAMING stores the payloads of 256 KiB and more
+ *          by non-temporal SIMD stores (AVX-512/AVX2/SSE2/NEON, chosen by the cpu),
+ *          for uncompressed video which only the readers touch again.
+ *  Reutrn:
+ *      0       :   success.
+ *      -EINVAL :   invalid handle or mode.
+ */
+_LIBSHMMEDIA_DLL_
+int LibShmMediaSetCopyMode(libshm_media_handle_t h, int mode);
+
+/**
+ *  Functionality:
+ *      set the log level of the handle, for the noisy or the quiet ones of a process.
+ *  Parameters:
+ *      @h[IN]      : share memory handle.
+ *      @level[IN]  : LIBSHM_MEDIA_LOG_LEVEL_XXX, LIBSHM_MEDIA_LOG_LEVEL_DEFAULT follows
+ *                    the level of LibShmMediaSetLogLevel, the default.
+ *  Reutrn:
+ *      0       :   success.
+ *      -EINVAL :   invalid handle or level.
+ */
+_LIBSHMMEDIA_DLL_
+int LibShmMediaSetHandleLogLevel(libshm_media_handle_t h, int level);
+
 /**
  *  Functionality:
  *      poll to read out shm media head out, to parse media detail information.
@@ -435,6 +626,30 @@ int LibShmMediaPollReadDataV2(
     , unsigned int                timeout
     );
 
+/**
+ *  Functionality:
+ *      Poll to read out all the ready media items, at most @max, under one readable
+ *      check, and put read index step once over them.
+ *      In lossless mode all the returned items stay protected until next read call.
+ *  Parameter:
+ *      @pmh : destination head information structure, refreshed by the read items.
+ *      @pmi : destination data information array, at least @max elements.
+ *      @max : max item counts to read.
+ *      @timeout : milli-seconds unit, poll's timeout
+ *  Return:
+ *      0   -- means to wait & try again
+ *      <0  -- means failure, -EINVAL for invalid parameters
+ *      >0  -- means the counts of items read out into @pmi
+ */
+_LIBSHMMEDIA_DLL_
+int LibShmMediaPollReadDataBatch(
+    libshm_media_handle_t         h
+    , libshm_media_head_param_t   *pmh
+    , libshm_media_item_param_t   *pmi
+    , int                         max
+    , unsigned int                timeout
+    );
+
 /**
  *  Functionality:
  *      used to read out data, non-blocking mode, and put read index step if success.
@@ -500,6 +715,49 @@ void LibShmMediaReadIndexStep(
     libshm_media_handle_t         h
 );
 
+/**
+ *  Functionality:
+ *      check whether the item read out by zero-copy had been overwritten by the writer,
+ *      seqlock style, call it after the item's data was consumed.
+ *  Parameter:
+ *      h   -- the handle.
+ *      pmi -- the item param gotten from the read APIs, u_read_index is used.
+ *  Return:
+ *      1   -- the data is still intact
+ *      0   -- the item had been overwritten or being overwritten, drop the result.
+ *      <0  -- invalid parameters.
+ */
+_LIBSHMMEDIA_DLL_
+int LibShmMediaValidateRead(
+    libshm_media_handle_t         h
+    , const libshm_media_item_param_t *pmi
+);
+
+/**
+ *  Functionality:
+ *      prefetch the items after the reading one into the cache, for the reader.
+ *      every time the read index steps, the first @bytes of the next @depth items
+ *      already written are prefetched, the media head and the start of the first
+ *      plane are in them. the consumer's first touch of the item does not stall then.
+ *  Parameter:
+ *      h       -- the handle.
+ *      depth   -- how many items to prefetch, 0 disables it, at most
+ *                 LIBSHM_MEDIA_PREFETCH_MAX_DEPTH.
+ *      bytes   -- bytes of every item to prefetch, 0 for LIBSHM_MEDIA_PREFETCH_DEFAULT_BYTES,
+ *                 no more than the item length.
+ *  Return:
+ *      0   -- success.
+ *      <0  -- -EINVAL for invalid parameters.
+ */
+#define LIBSHM_MEDIA_PREFETCH_MAX_DEPTH         8
+#define LIBSHM_MEDIA_PREFETCH_DEFAULT_BYTES     (16 * 1024)
+_LIBSHMMEDIA_DLL_
+int LibShmMediaSetReadPrefetch(
+    libshm_media_handle_t         h
+    , unsigned int                depth
+    , unsigned int                bytes
+);
+
 /**
  *  Functionality:
  *      to set shm read handle's reading index.
@@ -630,6 +888,22 @@ int LibShmMediaReadItemWithTvutimestampV2(
 _LIBSHMMEDIA_DLL_
 int
 LibShmMediaRemoveShmidFromSystem(const char * pMemoryName);
+
+/**
+ *  Functionality:
+ *      tell the kind of the named share memory by its head, without opening it,
+ *      e.g. for a tool walking the /dev/shm entries.
+ *  Parameters:
+ *      @pMemoryName[IN]    : share memory name.
+ *  Return:
+ *      LIBSHM_MEDIA_SHM_TYPE_FIXED     : LibShmMediaOpen opens it.
+ *      LIBSHM_MEDIA_SHM_TYPE_VARIABLE  : LibViShmMediaOpen opens it.
+ *      LIBSHM_MEDIA_SHM_TYPE_NONE      : not a share memory of this library.
+ *      <0  : -errno, e.g. -ENOENT no such share memory, -EACCES no privilege.
+**/
+_LIBSHMMEDIA_DLL_
+int
+LibShmMediaProbeShm(const char * pMemoryName);
 #endif
 
 __EXTERN_C_END
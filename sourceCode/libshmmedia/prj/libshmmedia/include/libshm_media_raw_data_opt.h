@@ -15,6 +15,41 @@
 
 #include "libshm_media.h"
 
+typedef struct SLibShmMediaReaderInfo
+{
+    uint32_t    u_pid;          // process id of the reader.
+    uint32_t    u_read_index;   // next item index the reader would read.
+    uint32_t    u_lag_items;    // items written but not read yet by the reader.
+    uint32_t    u_reserved;
+    uint64_t    u_lag_ms;       // milli-seconds since the reader was last caught up, 0 when no lag items.
+    uint64_t    u_idle_ms;      // milli-seconds since the reader last polled.
+}libshm_media_reader_info_t;
+
+#define LIBSHM_MEDIA_STATS_READERS_MAX      16
+/* bucket i counts the items read less than 2^i ms after the writer created them, the last one the later ones. */
+#define LIBSHM_MEDIA_STATS_LATENCY_BUCKETS  12
+
+typedef struct SLibShmMediaReaderStats
+{
+    uint32_t    u_pid;              // process id of the reader.
+    uint32_t    u_reserved;
+    uint64_t    u_frames_read;      // items the reader stepped over by reading.
+    uint64_t    u_frames_dropped;   // items skipped when the writer lapped the reader.
+    uint64_t    u_overruns;         // times the writer lapped the reader.
+    uint64_t    u_latency_ms[LIBSHM_MEDIA_STATS_LATENCY_BUCKETS];  // write-to-read latency histogram.
+}libshm_media_reader_stats_t;
+
+typedef struct SLibShmMediaStats
+{
+    uint64_t    u_frames_written;   // items the writer committed.
+    uint64_t    u_bytes_written;    // payload bytes of them.
+    uint64_t    u_max_item_size;    // largest item written.
+    uint64_t    u_write_blocked;    // lossless writes refused for the slowest reader.
+    uint32_t    u_readers;          // valid elements of readers.
+    uint32_t    u_reserved;
+    libshm_media_reader_stats_t readers[LIBSHM_MEDIA_STATS_READERS_MAX];
+}libshm_media_stats_t;
+
 __EXTERN_C_BEGIN
 /* if LIBSHM_MEDIA_RAW_DATA_OPT apis */
 
@@ -105,6 +140,71 @@ int LibShmMediaRawDataRead(
 _LIBSHMMEDIA_DLL_
 int LibShmMediaHasReader(libshm_media_handle_t h, unsigned int timeout = 100/*milli-seconds*/);
 
+/**
+ *  Functionality:
+ *      used to list the readers registered in the shm head, every LibShmMediaOpen
+ *  handle holds one slot until it was destroyed.
+ *  Parameters:
+ *      @h[IN]          : share memory handle.
+ *      @readers[OUT]   : array for storing the readers status.
+ *      @max[IN]        : the element counts of @readers.
+ *  Return:
+ *      >=0 : the counts of readers stored into @readers,
+ *            0 also for the shm created by old version, which has no reader table.
+ *      <0  : invalid parameters.
+**/
+_LIBSHMMEDIA_DLL_
+int LibShmMediaGetReaders(libshm_media_handle_t h, libshm_media_reader_info_t *readers, int max);
+
+/**
+ *  Functionality:
+ *      used to get the reader lagging most items behind the writing index.
+ *  Parameters:
+ *      @h[IN]          : share memory handle.
+ *      @preader[OUT]   : the slowest reader status.
+ *  Return:
+ *      1   : got the slowest reader.
+ *      0   : no registered reader.
+ *      <0  : invalid parameters.
+**/
+_LIBSHMMEDIA_DLL_
+int LibShmMediaGetSlowestReader(libshm_media_handle_t h, libshm_media_reader_info_t *preader);
+
+/**
+ *  Functionality:
+ *      used to get the statistics counters of the shm head. the writer and every
+ *      registered reader keep them in the shm, so any handle of the shm, e.g. an
+ *      exporter opening it only for this, gets the counters of all of them.
+ *      the counters of a reader start when it registers, its slot may be reused
+ *      by a later reader after it was destroyed.
+ *  Parameters:
+ *      @h[IN]          : share memory handle.
+ *      @pstats[OUT]    : the counters.
+ *  Return:
+ *      >=0 : the counts of readers stored into @pstats.
+ *      -ENOTSUP    : the shm was created by old version, which has no statistics block.
+ *      -EINVAL     : invalid parameters.
+**/
+_LIBSHMMEDIA_DLL_
+int LibShmMediaGetStats(libshm_media_handle_t h, libshm_media_stats_t *pstats);
+
+/**
+ *  Functionality:
+ *      used to get the head parameters of the newest written item, e.g. the resolution,
+ *      fourcc and sample rate, for a monitor opened by LIBSHM_MEDIA_OPEN_FLAG_MONITOR.
+ *      the read index and the read time of @h are not touched, the writer may be
+ *      writing the item over meanwhile, it is for showing, not for reading the data.
+ *  Parameters:
+ *      @h[IN]      : share memory handle.
+ *      @pmh[OUT]   : the head parameters.
+ *  Return:
+ *      >0  : success.
+ *      0   : nothing written yet.
+ *      <0  : invalid parameters, or the item was invalid.
+**/
+_LIBSHMMEDIA_DLL_
+int LibShmMediaPeekLatestHead(libshm_media_handle_t h, libshm_media_head_param_t *pmh);
+
 /**
  *  Functionality:
  *      used to get the item address points for user to write at its layer,
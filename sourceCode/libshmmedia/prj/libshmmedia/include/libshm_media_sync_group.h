@@ -0,0 +1,148 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************
+ *  Description:
+ *      synchronized reading of several shms by tvutimestamp.
+ *      the group keeps one target tvutimestamp for all of its sources, every
+ *      polling returns the item of each source matching the target, then the
+ *      target steps one frame.
+ *
+*******************************************************************/
+#ifndef LIBSHM_MEDIA_SYNC_GROUP_H
+#define LIBSHM_MEDIA_SYNC_GROUP_H
+
+#include "libshm_media.h"
+#include "libshm_media_variable_item.h"
+
+#define LIBSHM_MEDIA_SYNC_GROUP_MAX_SOURCES     64
+
+/* the source had the item in the tolerance of the target. */
+#define LIBSHM_MEDIA_SYNC_STATUS_MATCHED        0
+/* the source had not written the item of the target till timeout. */
+#define LIBSHM_MEDIA_SYNC_STATUS_LATE           1
+/* the source had gone past the target without any item in the tolerance. */
+#define LIBSHM_MEDIA_SYNC_STATUS_MISSING        2
+
+typedef void * libshm_media_sync_group_handle_t;
+
+typedef struct SLibShmMediaSyncFrame
+{
+    int         i_status;           // LIBSHM_MEDIA_SYNC_STATUS_XXX.
+    int         i_reserved;
+    uint64_t    u64_tvutimestamp;   // tvutimestamp of the matched item, or of the latest item checked, -1 for none.
+    int64_t     i64_offset_ms;      // u64_tvutimestamp minus the target in milli-seconds, 0 for none.
+    libshm_media_head_param_t   o_head; // valid only for LIBSHM_MEDIA_SYNC_STATUS_MATCHED.
+    libshm_media_item_param_t   o_item; // valid only for LIBSHM_MEDIA_SYNC_STATUS_MATCHED.
+}libshm_media_sync_frame_t;
+
+__EXTERN_C_BEGIN
+
+/**
+ *  Functionality:
+ *      create one synchronized reading group.
+ *  Parameter:
+ *      @tolerance_ms:
+ *          an item matches the target while its tvutimestamp is at most
+ *          tolerance_ms away from the target.
+ *  Return:
+ *      NULL, failed. Or return the group handle.
+ */
+_LIBSHMMEDIA_DLL_
+libshm_media_sync_group_handle_t LibShmMediaSyncGroupCreate(uint32_t tolerance_ms);
+
+/**
+ *  Functionality:
+ *      destroy the group, the source handles are not destroyed.
+ */
+_LIBSHMMEDIA_DLL_
+void LibShmMediaSyncGroupDestroy(libshm_media_sync_group_handle_t g);
+
+/**
+ *  Functionality:
+ *      add one reader of the constant sized items shm to the group.
+ *      the group owns the reading index of the handle since then, searching
+ *      starts from it, and it steps over the items the group has gone past.
+ *  Parameter:
+ *      @h:
+ *          the handle from LibShmMediaOpen.
+ *  Return:
+ *      >=0 : the source id, the index of its frame in the polling results.
+ *      -EINVAL : invalid parameters.
+ *      -ENOSPC : the group has LIBSHM_MEDIA_SYNC_GROUP_MAX_SOURCES sources.
+ */
+_LIBSHMMEDIA_DLL_
+int LibShmMediaSyncGroupAddSource(libshm_media_sync_group_handle_t g, libshm_media_handle_t h);
+
+/**
+ *  Functionality:
+ *      add one reader of the variable sized items shm to the group, the same
+ *      as LibShmMediaSyncGroupAddSource.
+ *  Parameter:
+ *      @h:
+ *          the handle from LibViShmMediaOpen.
+ *  Return:
+ *      >=0 : the source id, the index of its frame in the polling results.
+ *      -EINVAL : invalid parameters.
+ *      -ENOSPC : the group has LIBSHM_MEDIA_SYNC_GROUP_MAX_SOURCES sources.
+ *      -ENOTSUP : the shm was created without the item index.
+ */
+_LIBSHMMEDIA_DLL_
+int LibShmMediaSyncGroupAddViSource(libshm_media_sync_group_handle_t g, libshm_media_handle_t h);
+
+/**
+ *  Functionality:
+ *      set the target tvutimestamp of the next polling.
+ *  Return:
+ *      0 : success.
+ *      -EINVAL : invalid parameters or tvutimestamp.
+ */
+_LIBSHMMEDIA_DLL_
+int LibShmMediaSyncGroupSetTarget(libshm_media_sync_group_handle_t g, uint64_t tvutimestamp);
+
+/**
+ *  Functionality:
+ *      get the target tvutimestamp of the next polling.
+ *  Return:
+ *      the target, -1 when it was not set.
+ */
+_LIBSHMMEDIA_DLL_
+uint64_t LibShmMediaSyncGroupGetTarget(libshm_media_sync_group_handle_t g);
+
+/**
+ *  Functionality:
+ *      read the frame set of the target. it returns once every source has
+ *      matched or gone past the target, or timeout. the sources still waiting
+ *      are LIBSHM_MEDIA_SYNC_STATUS_LATE then.
+ *      the target steps one frame of its fps after every source was resolved,
+ *      see LibshmutilTvutimestampMerge. on timeout it stays, to be polled again.
+ *  Parameter:
+ *      @frames:
+ *          frames[id] is filled for the source of id.
+ *      @max:
+ *          the counts of @frames, not less than the counts of the sources.
+ *      @timeout:
+ *          max waiting milli-seconds, 0 for non-block.
+ *  Return:
+ *      >=0 : the counts of the matched sources.
+ *      -EINVAL : invalid parameters, or the target was not set.
+ */
+_LIBSHMMEDIA_DLL_
+int LibShmMediaSyncGroupPollFrames(
+    libshm_media_sync_group_handle_t g
+    , libshm_media_sync_frame_t *frames
+    , int max
+    , unsigned int timeout
+);
+
+__EXTERN_C_END
+
+#endif // LIBSHM_MEDIA_SYNC_GROUP_H
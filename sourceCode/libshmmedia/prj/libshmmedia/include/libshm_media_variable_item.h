@@ -89,6 +89,90 @@ libshm_media_handle_t LibViShmMediaCreate2
     , mode_t mode
 );
 
+/**
+ *  Functionality:
+ *      used to create the share memory with specified permission mode and creating flags,
+ *      or just open it if the share memory had existed.
+ *  Parameter:
+ *      @pMemoryName:
+ *          share memory entry name
+ *      @header_len:
+ *          the share memory head size, which would store the media head data.
+ *      @item_count:
+ *          how many counts of share memory item counts.
+ *      @total_size:
+ *          total shm size.
+ *      @mode:
+ *          the permission mode for shm_open (e.g. S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP).
+ *      @flags:
+ *          LIBSHM_MEDIA_CREATE_FLAG_XXX.
+ *          LIBSHM_MEDIA_CREATE_FLAG_LOSSLESS, the writer keeps every item until the readers
+ *          opened after creating read it, at most 6 readers are waited for. Sending returns
+ *          -EAGAIN when the slowest reader still holds the space the item needs,
+ *          LibViShmMediaPollSendable waits for it. A reader silent over 3s loses its
+ *          cursor, its next poll returns -EPIPE once for the items it may have missed.
+ *          LIBSHM_MEDIA_CREATE_FLAG_HUGEPAGE, back the ring by huge pages, the ring size
+ *          is rounded up to whole huge pages. see LibViShmMediaGetPageBacking.
+ *          LIBSHM_MEDIA_CREATE_FLAG_PREFAULT, fault in every page before returning,
+ *          LIBSHM_MEDIA_CREATE_FLAG_MLOCK, mlock the share memory, failing only warns.
+ *          see LibViShmMediaGetPrefaultTime for how long it took.
+ *          LIBSHM_MEDIA_CREATE_FLAG_ALIGN_64/_4K/_2M, every item starts at a multiple of
+ *          64 bytes, 4 KiB or 2 MiB, for aligned SIMD loads and DMA, and the video data
+ *          of the items sent, the first plane, starts at the same alignment. each item
+ *          may waste up to twice the alignment of space. see LibViShmMediaGetPayloadAlignment.
+ *          LIBSHM_MEDIA_CREATE_FLAG_ITEM_INDEX, keep the index of the items' tvutimestamp
+ *          and pts, LibViShmMediaSearchItemWithTvutimestamp/Pts and the sync group need it.
+ *  Return:
+ *      NULL, open failed. Or return the share memory handle.
+ */
+_LIBSHMMEDIA_DLL_
+libshm_media_handle_t LibViShmMediaCreate3
+(
+    const char * pMemoryName
+    , uint32_t header_len
+    , uint32_t item_count
+    , uint64_t total_size
+    , mode_t mode
+    , uint32_t flags
+);
+
+/**
+ *  Functionality:
+ *      used to create the share memory on a NUMA node, or just open it if the share
+ *      memory had existed. Same as LibViShmMediaCreate3 but allows specifying the node.
+ *  Parameter:
+ *      @pMemoryName:
+ *          share memory entry name
+ *      @header_len:
+ *          the share memory head size, which would store the media head data.
+ *      @item_count:
+ *          how many counts of share memory item counts.
+ *      @total_size:
+ *          total shm size.
+ *      @mode:
+ *          permission bits passed to shm_open.
+ *      @flags:
+ *          LIBSHM_MEDIA_CREATE_FLAG_XXX, see LibViShmMediaCreate3.
+ *      @numa_node:
+ *          the node the pages are preferred on, LIBSHM_MEDIA_NUMA_NODE_NONE for none.
+ *          the node is recorded in the share memory head, readers query it by
+ *          LibViShmMediaGetNumaNode to run on the same node. when the node could not be
+ *          applied, the share memory is placed as usual and records none.
+ *  Return:
+ *      NULL, open failed. Or return the share memory handle.
+ */
+_LIBSHMMEDIA_DLL_
+libshm_media_handle_t LibViShmMediaCreate4
+(
+    const char * pMemoryName
+    , uint32_t header_len
+    , uint32_t item_count
+    , uint64_t total_size
+    , mode_t mode
+    , uint32_t flags
+    , int numa_node
+);
+
 /**
  *  Functionality:
  *      used to open the existed share memory.
@@ -112,6 +196,33 @@ libshm_media_handle_t LibViShmMediaOpen(
     , void *opaq
 );
 
+/**
+ *  Functionality:
+ *      used to open the existed share memory, same as LibViShmMediaOpen but allows
+ *      specifying the opening flags.
+ *  Parameter:
+ *      @pMemoryName:
+ *          share memory entry name
+ *      @cb      :
+ *          user callback function
+ *      @opaq    :
+ *          user self data
+ *      @flags   :
+ *          LIBSHM_MEDIA_OPEN_FLAG_XXX.
+ *          LIBSHM_MEDIA_OPEN_FLAG_PREFAULT, fault in every page of the share memory before returning.
+ *          LIBSHM_MEDIA_OPEN_FLAG_MLOCK, mlock the share memory, failing only warns.
+ *          see LibViShmMediaGetPrefaultTime for how long it took.
+ *  Return:
+ *      NULL, open failed. Or return the share memory handle.
+ */
+_LIBSHMMEDIA_DLL_
+libshm_media_handle_t LibViShmMediaOpen2(
+    const char * pMemoryName
+    , libshm_media_readcb_t cb
+    , void *opaq
+    , uint32_t flags
+);
+
 
 /**
  *  Functionality:
@@ -289,14 +400,67 @@ const char *LibViShmMediaGetName(libshm_media_handle_t h);
 _LIBSHMMEDIA_DLL_ 
 int LibViShmMediaIsCreator(libshm_media_handle_t h);
 
+/**
+ *  Functionality:
+ *      get the page backing of the share memory, for creator and reader both.
+ *      creating with LIBSHM_MEDIA_CREATE_FLAG_HUGEPAGE falls back to normal pages
+ *      when huge pages are not available, this tells which one was used.
+ *  Parameters:
+ *      @h[IN]          : share memory handle.
+ *  Return:
+ *      LIBSHM_MEDIA_PAGE_BACKING_NORMAL    : normal pages of /dev/shm.
+ *      LIBSHM_MEDIA_PAGE_BACKING_HUGETLBFS : huge pages of the hugetlbfs mount.
+**/
+_LIBSHMMEDIA_DLL_
+int LibViShmMediaGetPageBacking(libshm_media_handle_t h);
+
+/**
+ *  Functionality:
+ *      get how long the warm up of the share memory took when creating or opening,
+ *      as asked by the PREFAULT/MLOCK creating or opening flags.
+ *  Parameters:
+ *      @h[IN]          : share memory handle.
+ *  Return:
+ *      micro-seconds of prefaulting and locking, 0 when neither was asked.
+**/
+_LIBSHMMEDIA_DLL_
+int64_t LibViShmMediaGetPrefaultTime(libshm_media_handle_t h);
+
+/**
+ *  Functionality:
+ *      get the NUMA node the creator placed the share memory on, for creator and
+ *      reader both. readers pin themselves to the node's cpus to read locally.
+ *  Parameters:
+ *      @h[IN]          : share memory handle.
+ *  Return:
+ *      the node number, LIBSHM_MEDIA_NUMA_NODE_NONE when the share memory was not
+ *      placed on a node, or was created by an older library.
+**/
+_LIBSHMMEDIA_DLL_
+int LibViShmMediaGetNumaNode(libshm_media_handle_t h);
+
+/**
+ *  Functionality:
+ *      get the alignment every item starts at, LIBSHM_MEDIA_CREATE_FLAG_ALIGN_XXX
+ *      of the creator decides it. the item address returned by raw data apply and
+ *      by reading is aligned to it, up to the page size of the mapping.
+ *  Parameters:
+ *      @h[IN]          : share memory handle.
+ *  Return:
+ *      the alignment in bytes, 8 for the share memory created without the flags.
+**/
+_LIBSHMMEDIA_DLL_
+uint32_t LibViShmMediaGetPayloadAlignment(libshm_media_handle_t h);
+
 /**
  *  Functionality:
  *      Poll whether the share memory is sendable.
+ *      Only a lossless writer would wait, until the slowest reader releases the ring.
  *  Parameters:
  *      @h[IN]          : share memory handle.
  *      @timeout[IN]    : how many milli-seconds to poll.
  *  Return:
- *      0   :   not ready
+ *      0   :   not ready, lossless writer is blocked by the slowest reader.
  *      +   :   ready, there is data in.
  *      -   :   I/O error, need to destroy/create the handle again.
  */
@@ -312,6 +476,8 @@ int LibViShmMediaPollSendable(libshm_media_handle_t h, uint32_t timeout);
  *  Return:
  *      0   :   not ready
  *      +   :   ready, there is data in.
+ *      -EPIPE  :   lossless reader lost its cursor, items may have been overwritten unread,
+ *                  the handle is still usable.
  *      -   :   I/O error, need to destroy/create the handle again.
  */
 _LIBSHMMEDIA_DLL_ 
@@ -327,6 +493,7 @@ int LibViShmMediaPollReadable(libshm_media_handle_t h, uint32_t timeout);
  *  Reutrn:
  *      0   :   not ready
  *      +   :   Send success, express writing size.
+ *      -EAGAIN :   lossless writer is blocked by the slowest reader, retry later.
  *      -   :   I/O error
  */
 _LIBSHMMEDIA_DLL_ 
@@ -336,6 +503,117 @@ int LibViShmMediaSendData(
     , const libshm_media_item_param_t *pmi
 );
 
+/**
+ *  Functionality:
+ *      used to write several items sharing one head to share memory at once.
+ *      the space of all items is reserved together and they are published by one
+ *      index update, readers get all of them or none.
+ *  Parameters:
+ *      @h[IN]      : share memory handle.
+ *      @pmh[IN]    : inputting head information, for all the items.
+ *      @pmi[IN]    : inputting data information array.
+ *      @counts[IN] : item counts of @pmi, at most 64.
+ *  Reutrn:
+ *      0   :   not ready, or @counts is 0.
+ *      +   :   Send success, express the sent item counts.
+ *      -EAGAIN :   lossless writer is blocked by the slowest reader, retry later.
+ *      -EINVAL :   invalid parameters, an empty item, or an item failed to be written,
+ *                  none of the batch is published then.
+ *      -   :   I/O error
+ */
+_LIBSHMMEDIA_DLL_
+int LibViShmMediaSendDataBatch(
+      libshm_media_handle_t h
+    , const libshm_media_head_param_t *pmh
+    , const libshm_media_item_param_t *pmi
+    , int counts
+);
+
+/**
+ *  Functionality:
+ *      select how the writer copies the video/audio payloads, see LibShmMediaSetCopyMode.
+ *  Parameters:
+ *      @h[IN]      : share memory handle.
+ *      @mode[IN]   : LIBSHM_MEDIA_COPY_MODE_XXX.
+ *  Reutrn:
+ *      0       :   success.
+ *      -EINVAL :   invalid handle or mode.
+ */
+_LIBSHMMEDIA_DLL_
+int LibViShmMediaSetCopyMode(libshm_media_handle_t h, int mode);
+
+/**
+ *  Functionality:
+ *      set the log level of the handle, see LibShmMediaSetHandleLogLevel.
+ *  Parameters:
+ *      @h[IN]      : share memory handle.
+ *      @level[IN]  : LIBSHM_MEDIA_LOG_LEVEL_XXX.
+ *  Reutrn:
+ *      0       :   success.
+ *      -EINVAL :   invalid handle or level.
+ */
+_LIBSHMMEDIA_DLL_
+int LibViShmMediaSetHandleLogLevel(libshm_media_handle_t h, int level);
+
+/**
+ *  Functionality:
+ *      read the next item as LibViShmMediaReadDataWithoutIndexStep, and lease it.
+ *      the payloads of @pmi point into the shm, the lease pins them until
+ *      LibViShmMediaRelease, so they can be used without copying after reading on.
+ *      a lossless writer waits on a leased item, a lossy one writes over it and
+ *      breaks the lease, LibViShmMediaCheckLease tells it.
+ *      at most 16 leases in a shm, the handle releases the ones left when destroyed.
+ *  Parameters:
+ *      @h[IN]      : share memory handle.
+ *      @pmh[OUT]   : outputting head information.
+ *      @pmi[OUT]   : outputting data information.
+ *      @please[OUT]: the lease of the item.
+ *  Reutrn:
+ *      0   :   no item ready.
+ *      +   :   read success, express reading size.
+ *      -ENOSPC :   all the lease slots are in use, the item is left unread.
+ *      -ENOTSUP:   the shm was created without leases.
+ *      -EAGAIN :   the item was overwritten before being leased, read on.
+ *      -EPERM  :   the handle was opened as a monitor.
+ *      -EINVAL :   invalid parameters.
+ */
+_LIBSHMMEDIA_DLL_
+int LibViShmMediaAcquire(
+    libshm_media_handle_t         h
+    , libshm_media_head_param_t   *pmh
+    , libshm_media_item_param_t   *pmi
+    , int                         *please
+);
+
+/**
+ *  Functionality:
+ *      tell whether the item of @lease is still intact.
+ *  Parameters:
+ *      @h[IN]      : share memory handle.
+ *      @lease[IN]  : lease of LibViShmMediaAcquire.
+ *  Reutrn:
+ *      0       :   intact.
+ *      -EPIPE  :   broken, the lossy writer wrote over the item, or the lease was taken
+ *                  back after its owner was silent over 3s.
+ *      -EINVAL :   invalid handle, or the lease is not held.
+ */
+_LIBSHMMEDIA_DLL_
+int LibViShmMediaCheckLease(libshm_media_handle_t h, int lease);
+
+/**
+ *  Functionality:
+ *      release @lease, the payloads of the item must not be used after it.
+ *  Parameters:
+ *      @h[IN]      : share memory handle.
+ *      @lease[IN]  : lease of LibViShmMediaAcquire.
+ *  Reutrn:
+ *      0       :   released, the item was intact until now.
+ *      -EPIPE  :   released, the lease had been broken, the payloads used may be torn.
+ *      -EINVAL :   invalid handle, or the lease is not held.
+ */
+_LIBSHMMEDIA_DLL_
+int LibViShmMediaRelease(libshm_media_handle_t h, int lease);
+
 /**
  *  Functionality:
  *      used to write data to share memory, with maximum frequency 1ms per one item.
@@ -399,6 +677,30 @@ int LibViShmMediaPollReadData(
       , uint32_t                    timeout
 );
 
+/**
+ *  Functionality:
+ *      Poll to read out all the ready media items, at most @max and no more than 64
+ *      in one call, under one readable check.
+ *      In lossless mode all the returned items stay protected until next read call.
+ *  Parameter:
+ *      @pmh : destination head information structure, refreshed by the read items.
+ *      @pmi : destination data information array, at least @max elements.
+ *      @max : max item counts to read.
+ *      @timeout : milli-seconds unit, poll's timeout
+ *  Return:
+ *      0   -- means to wait & try again
+ *      <0  -- means failure, -EINVAL for invalid parameters
+ *      >0  -- means the counts of items read out into @pmi
+ */
+_LIBSHMMEDIA_DLL_
+int LibViShmMediaPollReadDataBatch(
+      libshm_media_handle_t         h
+      , libshm_media_head_param_t   *pmh
+      , libshm_media_item_param_t   *pmi
+      , int                         max
+      , uint32_t                    timeout
+);
+
 /**
  *  Functionality:
  *      used to read out data, non-blocking mode, and put read index step if success.
@@ -465,6 +767,53 @@ int  LibViShmMediaSearchItems(
       , libshmmedia_item_checking_fn_t      fn
 );
 
+/**
+ *  Functionality:
+ *      to search out the first item whose tvutimestamp is not before @tvutimestamp.
+ *      the writer keeps an index of the items' tvutimestamp and pts in the shm,
+ *      it is binary searched, the items are not parsed one by one.
+ *      the item without tvutimestamp in the extended data stops the searching.
+ *  Parameter:
+ *      @h, the handle.
+ *      @tvutimestamp, the wanted tvutimestamp.
+ *      @pmh, [OUT] the media head of the item, could be NULL.
+ *      @pmi, [OUT] the item, could be NULL.
+ *  Return:
+ *      >0 -- searched, the read length. the reading index would be just on the searched index.
+ *      0  -- not searched, the reading index would be just on the writing index.
+ *      -EINVAL -- invalid tvutimestamp.
+ *      -ENOTSUP -- the shm was created without LIBSHM_MEDIA_CREATE_FLAG_ITEM_INDEX,
+ *                  or by an old version without the index.
+**/
+_LIBSHMMEDIA_DLL_
+int  LibViShmMediaSearchItemWithTvutimestamp(
+      libshm_media_handle_t        h
+      , uint64_t tvutimestamp
+      , libshm_media_head_param_t   *pmh
+      , libshm_media_item_param_t   *pmi
+);
+
+/**
+ *  Functionality:
+ *      to search out the first item whose pts is not before @pts, as
+ *      LibViShmMediaSearchItemWithTvutimestamp, the pts is the one
+ *      LibShmMediaItemParamGetPts(pmi, 0) returns.
+ *  Parameter:
+ *      @h, the handle.
+ *      @pts, the wanted pts.
+ *      @pmh, [OUT] the media head of the item, could be NULL.
+ *      @pmi, [OUT] the item, could be NULL.
+ *  Return:
+ *      the same as LibViShmMediaSearchItemWithTvutimestamp.
+**/
+_LIBSHMMEDIA_DLL_
+int  LibViShmMediaSearchItemWithPts(
+      libshm_media_handle_t        h
+      , uint64_t pts
+      , libshm_media_head_param_t   *pmh
+      , libshm_media_item_param_t   *pmi
+);
+
 /**
  *  Functionality:
  *      destroy the existing share memory.
@@ -511,6 +860,31 @@ int LibViShmMediaItemCommitBuffer(
     unsigned int nlen
 );
 
+/**
+ *  Functionality:
+ *      as LibViShmMediaItemCommitBuffer, and records the keys of the item in the item
+ *      index of a shm created with LIBSHM_MEDIA_CREATE_FLAG_ITEM_INDEX. the item is not
+ *      parsed, LibViShmMediaItemCommitBuffer records none, so the indexed searching
+ *      stops at it.
+ *  Parameters:
+ *      @h[IN]      : share memory handle.
+ *      @pItemAddr[IN]  : item address point.
+ *      @nlen[IN]    : commit buffer length.
+ *      @tvutimestamp[IN] : the tvutimestamp of the item, (uint64_t)-1 for none.
+ *      @pts[IN]    : the pts of the item, as LibShmMediaItemParamGetPts(pmi, 0), (uint64_t)-1 for none.
+ *  Reutrn:
+ *      0   :   success
+ *      <0   :  failed, not supported.
+ */
+_LIBSHMMEDIA_DLL_
+int LibViShmMediaItemCommitBuffer2(
+    libshm_media_handle_t h,
+    uint8_t *pItemAddr,
+    unsigned int nlen,
+    uint64_t tvutimestamp,
+    uint64_t pts
+);
+
 
 /**
  *  Functionality:
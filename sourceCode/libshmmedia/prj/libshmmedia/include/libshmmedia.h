@@ -14,4 +14,5 @@
 #define _LIBSHMMEDIA_APIS_H
 #include "libshm_media.h"
 #include "libshm_media_variable_item.h"
+#include "libshm_media_sync_group.h"
 #endif // _LIBSHMMEDIA_APIS_H
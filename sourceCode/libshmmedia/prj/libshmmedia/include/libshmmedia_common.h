@@ -52,6 +52,87 @@
 typedef void * libshm_media_handle_t;
 typedef libshm_media_handle_t libshmmedia_handle_t;
 
+/**
+ *  creating flags of LibShmMediaCreate3/LibViShmMediaCreate3.
+ *  LIBSHM_MEDIA_CREATE_FLAG_LOSSLESS : the writer never overwrites the data which
+ *  the slowest opened reader has not read, sending returns -EAGAIN instead.
+ *  LIBSHM_MEDIA_CREATE_FLAG_HUGEPAGE : map the share memory from the hugetlbfs mount,
+ *  LIBSHMMEDIA_HUGETLBFS_DIR from environment or /dev/hugepages, it falls back to
+ *  normal pages when the mount is missing or its huge page pool is too small.
+ *  LIBSHM_MEDIA_CREATE_FLAG_PREFAULT : fault in every page of the share memory when
+ *  creating, the first lap of the writer does not take page faults then.
+ *  LIBSHM_MEDIA_CREATE_FLAG_MLOCK : mlock the share memory, it needs RLIMIT_MEMLOCK.
+ *  LIBSHM_MEDIA_CREATE_FLAG_ALIGN_XXX : LibViShmMediaCreate3 only, every item starts
+ *  at a multiple of 64 bytes, 4 KiB or 2 MiB, the largest one set wins. default is 8.
+ *  the video data of the items sent starts at the same alignment.
+ *  LIBSHM_MEDIA_CREATE_FLAG_ITEM_INDEX : LibViShmMediaCreate3 only, the writer keeps an
+ *  index of the items' tvutimestamp and pts in the shm, for the indexed searching and
+ *  the sync group. every send then parses the extended data of the item for its keys.
+ */
+#define LIBSHM_MEDIA_CREATE_FLAG_LOSSLESS   0x00000001
+#define LIBSHM_MEDIA_CREATE_FLAG_HUGEPAGE   0x00000002
+#define LIBSHM_MEDIA_CREATE_FLAG_PREFAULT   0x00000004
+#define LIBSHM_MEDIA_CREATE_FLAG_MLOCK      0x00000008
+#define LIBSHM_MEDIA_CREATE_FLAG_ALIGN_64   0x00000010
+#define LIBSHM_MEDIA_CREATE_FLAG_ALIGN_4K   0x00000020
+#define LIBSHM_MEDIA_CREATE_FLAG_ALIGN_2M   0x00000040
+#define LIBSHM_MEDIA_CREATE_FLAG_ITEM_INDEX 0x00000080
+
+/**
+ *  opening flags of LibShmMediaOpen2/LibViShmMediaOpen2, for the reader's own mapping.
+ *  LIBSHM_MEDIA_OPEN_FLAG_PREFAULT : fault in every page of the share memory when opening.
+ *  LIBSHM_MEDIA_OPEN_FLAG_MLOCK : mlock the share memory, it needs RLIMIT_MEMLOCK.
+ *  LIBSHM_MEDIA_OPEN_FLAG_MONITOR : the handle only watches the share memory, it claims
+ *  no reader slot nor lossless cursor, so the writer never waits for it. it must not
+ *  read the items, only the peeking apis, e.g. LibShmMediaPeekLatestHead, are for it.
+ *  the share memory is mapped read-only, read permission on it is enough.
+ */
+#define LIBSHM_MEDIA_OPEN_FLAG_PREFAULT     0x00000001
+#define LIBSHM_MEDIA_OPEN_FLAG_MLOCK        0x00000002
+#define LIBSHM_MEDIA_OPEN_FLAG_MONITOR      0x00000004
+
+/**
+ *  kinds of the share memory, see LibShmMediaProbeShm.
+ *  LIBSHM_MEDIA_SHM_TYPE_NONE : not a share memory of this library.
+ *  LIBSHM_MEDIA_SHM_TYPE_FIXED : fixed item ring, LibShmMediaOpen opens it.
+ *  LIBSHM_MEDIA_SHM_TYPE_VARIABLE : variable item ring, LibViShmMediaOpen opens it.
+ */
+#define LIBSHM_MEDIA_SHM_TYPE_NONE          0
+#define LIBSHM_MEDIA_SHM_TYPE_FIXED         1
+#define LIBSHM_MEDIA_SHM_TYPE_VARIABLE      2
+
+/**
+ *  copy modes of LibShmMediaSetCopyMode/LibViShmMediaSetCopyMode, how the writer
+ *  copies the video/audio payloads into the share memory.
+ *  LIBSHM_MEDIA_COPY_MODE_DEFAULT : memcpy.
+ *  LIBSHM_MEDIA_COPY_MODE_STREAMING : non-temporal stores from 256 KiB, uncompressed
+ *  frames go to the share memory without evicting the writer's own cache.
+ */
+#define LIBSHM_MEDIA_COPY_MODE_DEFAULT      0
+#define LIBSHM_MEDIA_COPY_MODE_STREAMING    1
+
+/**
+ *  numa_node of LibShmMediaCreate4/LibViShmMediaCreate4, no NUMA placement.
+ */
+#define LIBSHM_MEDIA_NUMA_NODE_NONE         (-1)
+
+/**
+ *  page backing of the share memory, see LibShmMediaGetPageBacking/LibViShmMediaGetPageBacking.
+ */
+#define LIBSHM_MEDIA_PAGE_BACKING_NORMAL        0
+#define LIBSHM_MEDIA_PAGE_BACKING_HUGETLBFS     1
+
+/**
+ *  log levels of LibShmMediaSetLogLevel/LibShmMediaSetHandleLogLevel/LibViShmMediaSetHandleLogLevel,
+ *  the logs below the level are dropped before being formatted.
+ *  LIBSHM_MEDIA_LOG_LEVEL_DEFAULT : a handle follows the global level.
+ */
+#define LIBSHM_MEDIA_LOG_LEVEL_DEFAULT          (-1)
+#define LIBSHM_MEDIA_LOG_LEVEL_INFO             1
+#define LIBSHM_MEDIA_LOG_LEVEL_WARN             2
+#define LIBSHM_MEDIA_LOG_LEVEL_ERROR            3
+#define LIBSHM_MEDIA_LOG_LEVEL_NONE             4
+
 
 /**
  *  opaq    : user context
@@ -81,6 +162,11 @@ void LibShmMediaSetLogCb(int(*cb)(int level, const char *fmt, ...));
 /**
  *  Functionality:
  *      Caller can callback the library's logs, by using va_list.
+ *      the logs of the variable sized ring's buffer are asynchronous by default,
+ *      they reach @cb from a background thread of the library, possibly after the
+ *      call logging them returned, see LibShmMediaSetLogAsync to call it in the
+ *      logging thread. the logs queued before are handed to the previous callback,
+ *      which the background thread no longer calls once this returns.
  *  Parameters:
  *      @cb:
  *          cb, level has the types as:
@@ -93,6 +179,92 @@ void LibShmMediaSetLogCb(int(*cb)(int level, const char *fmt, ...));
 _LIBSHMMEDIA_DLL_
 void LibShmMediaSetLogCallback(int(*cb)(int , const char *, va_list ap));
 
+/**
+ *  Functionality:
+ *      Sets the global log level, the logs of the library below it are dropped at
+ *      the cost of a load, before being formatted. the handles set by
+ *      LibShmMediaSetHandleLogLevel/LibViShmMediaSetHandleLogLevel follow their own.
+ *      the logs below LIBSHM_LOG_COMPILE_LEVEL, a build define, are not compiled in.
+ *  Parameters:
+ *      @level:
+ *          LIBSHM_MEDIA_LOG_LEVEL_INFO(the default), _WARN, _ERROR or _NONE.
+ *  Return:
+ *      0 : success.
+ *      -EINVAL : invalid level.
+ */
+_LIBSHMMEDIA_DLL_
+int LibShmMediaSetLogLevel(int level);
+
+/**
+ *  Functionality:
+ *      Selects how the logs of the variable sized ring's buffer reach the callback.
+ *      async, the default, queues them as preformatted records into a bounded
+ *      lock-free queue, a background thread hands them to the callback of
+ *      LibShmMediaSetLogCallback, the reader and writer threads never wait for it.
+ *      a record finding the queue full is dropped, see LibShmMediaGetDroppedLogs.
+ *      sync calls the callback in the logging thread.
+ *  Parameters:
+ *      @enable:
+ *          non-zero for async, zero for sync, the records queued are handed over first.
+ *  Return:
+ *      void.
+ */
+_LIBSHMMEDIA_DLL_
+void LibShmMediaSetLogAsync(int enable);
+
+/**
+ *  Functionality:
+ *      Hands the queued log records to the callback in the calling thread, e.g.
+ *      before the callback's sink is closed.
+ *  Return:
+ *      the records handed over.
+ */
+_LIBSHMMEDIA_DLL_
+int LibShmMediaFlushLogs(void);
+
+/**
+ *  Functionality:
+ *      Counts the log records dropped for the queue full since the process started.
+ *  Return:
+ *      the records dropped.
+ */
+_LIBSHMMEDIA_DLL_
+uint64_t LibShmMediaGetDroppedLogs(void);
+
+/**
+ *  Functionality:
+ *      Turns the recording of the tracing points on or off, for the time of a frame
+ *      broken down by stage(poll_readable, read_item_buffer, head_compare,
+ *      parse_extend_data, write_item_v4, ...), of every handle of the process.
+ *      the points are only there when the library is built with LIBSHM_ENABLE_TRACE
+ *      (cmake -DENABLE_FEATURE_TRACE=ON, make ENABLE_TRACE=1), they are USDT probes
+ *      libshmmedia:<stage>__begin/__end as well when <sys/sdt.h> is found.
+ *      each thread records into its own ring of the latest events.
+ *  Parameters:
+ *      @enable:
+ *          non-zero to record, turning it on drops the events recorded before.
+ *  Return:
+ *      0 : success.
+ *      -ENOTSUP : the library was built without the tracing points.
+ */
+_LIBSHMMEDIA_DLL_
+int LibShmMediaTraceEnable(int enable);
+
+/**
+ *  Functionality:
+ *      Writes the events recorded since LibShmMediaTraceEnable as chrome trace json,
+ *      to be loaded by chrome://tracing or perfetto. It can be called while recording.
+ *  Parameters:
+ *      @path:
+ *          the file to write.
+ *  Return:
+ *      >= 0 : the events count written.
+ *      -ENOTSUP : the library was built without the tracing points.
+ *      < 0 : -errno of the file.
+ */
+_LIBSHMMEDIA_DLL_
+int LibShmMediaTraceDump(const char *path);
+
 __EXTERN_C_END
 
 #endif // LIBSHMMEDIA_COMMON_H
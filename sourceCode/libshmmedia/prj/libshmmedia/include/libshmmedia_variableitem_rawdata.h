@@ -112,6 +112,38 @@ int LibViShmMediaRawDataRead(
 _LIBSHMMEDIA_DLL_
 int LibViShmMediaHasReader(libshm_media_handle_t h, unsigned int timeout = 100/*milli-seconds*/);
 
+/**
+ *  Functionality:
+ *      used to get the head parameters of the newest written item, the same as
+ *      LibShmMediaPeekLatestHead, for a monitor opened by LIBSHM_MEDIA_OPEN_FLAG_MONITOR.
+ *  Parameters:
+ *      @h[IN]      : share memory handle.
+ *      @pmh[OUT]   : the head parameters.
+ *  Return:
+ *      >0  : success.
+ *      0   : nothing written yet.
+ *      <0  : invalid parameters, or the item was invalid.
+**/
+_LIBSHMMEDIA_DLL_
+int LibViShmMediaPeekLatestHead(libshm_media_handle_t h, libshm_media_head_param_t *pmh);
+
+/**
+ *  Functionality:
+ *      used to count the items written since the write index was *pwindex, and
+ *      their bytes, for a monitor computing the rates. the write index of the variable
+ *      item ring wraps, so it calls this at least once a ring of items.
+ *  Parameters:
+ *      @h[IN]              : share memory handle.
+ *      @pwindex[IN/OUT]    : the write index counted from, LibViShmMediaGetWriteIndex
+ *                            for the first time, moved to the current write index.
+ *      @pbytes[IN/OUT]     : the item sizes are added to it, NULL when not needed.
+ *  Return:
+ *      the counts of items, at most LibViShmMediaGetItemCounts, the items overwritten
+ *      before are not in @pbytes.
+**/
+_LIBSHMMEDIA_DLL_
+uint64_t LibViShmMediaGetWrittenSince(libshm_media_handle_t h, uint64_t *pwindex, uint64_t *pbytes);
+
 __EXTERN_C_END
 
 #endif // LibViShmMedia_VARIABLEITEM_RAWDATA_H
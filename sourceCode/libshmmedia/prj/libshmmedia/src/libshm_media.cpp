@@ -30,6 +30,8 @@
 #include "libshm_time_internal.h"
 #include "TvuLog.h"
 #include "libshm_tvu_timestamp.h"
+#include "libshm_prefetch_internal.h"
+#include "shm_variable_item_ring_buff.h"
 
 #define NOT_EQUAL_DATA(d, s) ((s>0) && s!=d)
 
@@ -41,6 +43,10 @@
 #define INVALID_AUDIO_DEPTH(d) (d <= 0)
 #define INVALID_AUDIO_SAMPLERATE(s) (s < 8000)
 #define INVALID_AUDIO_CHANNEL_LAYOUT(c) (c==0)
+
+/* items walked from the last matching before falling back to bisecting. */
+#define LIBSHM_MEDIA_SEARCH_HINT_STEPS  8
+
 #ifdef TVU_WINDOWS
 #pragma comment(lib,"ws2_32.lib")
 #endif
@@ -192,6 +198,16 @@ int CLibShmMediaCtx::CreateShmEntry(const char * pMemoryName, uint32_t header_le
 }
 
 int CLibShmMediaCtx::CreateShmEntry(const char * pMemoryName, uint32_t header_len, uint32_t item_count, uint32_t item_length, mode_t mode)
+{
+    return CreateShmEntry(pMemoryName, header_len, item_count, item_length, mode, 0);
+}
+
+int CLibShmMediaCtx::CreateShmEntry(const char * pMemoryName, uint32_t header_len, uint32_t item_count, uint32_t item_length, mode_t mode, uint32_t flags)
+{
+    return CreateShmEntry(pMemoryName, header_len, item_count, item_length, mode, flags, LIBSHM_MEDIA_NUMA_NODE_NONE);
+}
+
+int CLibShmMediaCtx::CreateShmEntry(const char * pMemoryName, uint32_t header_len, uint32_t item_count, uint32_t item_length, mode_t mode, uint32_t flags, int numa_node)
 {
     CTvuBaseShareMemory    *pshm   = NULL;
     uint32_t        ver     = 0;
@@ -230,12 +246,20 @@ int CLibShmMediaCtx::CreateShmEntry(const char * pMemoryName, uint32_t header_le
         goto FAILED;
     }
 
+    min_head_len += CTvuBaseShareMemory::GetReaderTableLen(); /* reader registration table follows the ext head */
+    min_head_len += CTvuBaseShareMemory::GetStatsBlockLen(); /* statistics block follows the reader table */
+
     if (header_len < min_head_len)
     {
         header_len = min_head_len+16;
     }
     header_len = _LISHMMEDIA_MEM_ALIGN(header_len, 16);//make sure multiple by 16
 
+    pshm->SetHugePage((flags & LIBSHM_MEDIA_CREATE_FLAG_HUGEPAGE) ? true : false);
+    pshm->SetPrefault((flags & LIBSHM_MEDIA_CREATE_FLAG_PREFAULT) ? true : false
+        , (flags & LIBSHM_MEDIA_CREATE_FLAG_MLOCK) ? true : false);
+    pshm->SetNumaNode(numa_node);
+
     if (!pshm->CreateOrOpen(pMemoryName, header_len, item_count, item_total_length, mode, &libshmmediapro::setCloseFlag))
     {
         DEBUG_ERROR("sharemeory[name=>%s, head len=>%d, "
@@ -277,6 +301,12 @@ int CLibShmMediaCtx::CreateShmEntry(const char * pMemoryName, uint32_t header_le
         goto FAILED;
     }
 
+    if (pshm->SetLossless((flags & LIBSHM_MEDIA_CREATE_FLAG_LOSSLESS) ? true : false) < 0)
+    {
+        DEBUG_ERROR("sharemeory[name=>%s] lossless mode set failed\n", pMemoryName);
+        goto FAILED;
+    }
+
     DEBUG_INFO("sharemeory[name=>%s] create success, item head info=>{V3=>%lu, V4_0=>%lu, V4_1=>%lu, V4=>%lu}\n", pMemoryName
                , sizeof(shm_media_item_info_v3_t), sizeof(shm_media_item_info_v40_t)
                , sizeof(shm_media_item_info_v4_subv1_t), sizeof(shm_media_item_info_v4_t));
@@ -299,6 +329,11 @@ FAILED:
 }
 
 int CLibShmMediaCtx::OpenShmEntry(const char * pMemoryName, libshm_media_readcb_t cb, void *opaq)
+{
+    return OpenShmEntry(pMemoryName, cb, opaq, 0);
+}
+
+int CLibShmMediaCtx::OpenShmEntry(const char * pMemoryName, libshm_media_readcb_t cb, void *opaq, uint32_t flags)
 {
     CTvuBaseShareMemory    *pshm   = NULL;
     uint32_t        ver     = 0;
@@ -311,6 +346,10 @@ int CLibShmMediaCtx::OpenShmEntry(const char * pMemoryName, libshm_media_readcb_
         goto FAILED;
     }
 
+    pshm->SetPrefault((flags & LIBSHM_MEDIA_OPEN_FLAG_PREFAULT) ? true : false
+        , (flags & LIBSHM_MEDIA_OPEN_FLAG_MLOCK) ? true : false);
+    pshm->SetMonitor((flags & LIBSHM_MEDIA_OPEN_FLAG_MONITOR) ? true : false);
+
     if (!pshm->Open(pMemoryName))
     {
         DEBUG_ERROR("sharemeory[name=>%s] open failed\n", pMemoryName);
@@ -324,6 +363,13 @@ int CLibShmMediaCtx::OpenShmEntry(const char * pMemoryName, libshm_media_readcb_
     DEBUG_INFO("sharemeory[name=>%s] open success, item head info=>{V3=>%lu, V4_0=>%lu, V4_1=>%lu, V4=>%lu}\n", pMemoryName
                , sizeof(shm_media_item_info_v3_t), sizeof(shm_media_item_info_v40_t)
                , sizeof(shm_media_item_info_v4_subv1_t), sizeof(shm_media_item_info_v4_t));
+
+    /* a monitor takes no reader slot, the lossless writer does not wait for it. */
+    if (pshm->IsReaderTableSupported() && !(flags & LIBSHM_MEDIA_OPEN_FLAG_MONITOR))
+    {
+        pshm->RegisterReader();
+    }
+
     m_uVersion      = ver;
     m_uItemVer      = LIBSHM_MEDIA_ITEM_CURRENT_VERSION;
     m_pShmObj       = pshm;
@@ -342,7 +388,7 @@ FAILED:
 
 void CLibShmMediaCtx::SetCloseFlag(bool bclose)
 {
-    if (!m_pShmObj)
+    if (!m_pShmObj || m_pShmObj->IsMonitor())
         return;
 
 #ifdef _LIBSHMMEDIA_PROTOCOL_APIS_DONE
@@ -378,6 +424,8 @@ void CLibShmMediaCtx::SetCloseFlag(bool bclose)
     }
 #endif
 
+    /* readers sleeping on the wakeup word should see the close flag at once. */
+    m_pShmObj->WakeupReaders();
 }
 
 bool CLibShmMediaCtx::CheckCloseFlag()
@@ -636,9 +684,10 @@ static int _copy_shm_header(libshm_media_head_param_t *porg, const libshm_media_
 
 //#define MULTIPLE_PROCESS_ATOMIC_OPT_TEST    1
 
-int CLibShmMediaCtx::FinishWrite()
+int CLibShmMediaCtx::FinishWrite(uint32_t bytes)
 {
     m_pShmObj->FinishWrite();
+    m_pShmObj->CountWrite(bytes);
 #ifdef MULTIPLE_PROCESS_ATOMIC_OPT_TEST
     uint8_t *ph = m_pShmObj->GetHeader();
     uint64_t flag = *(uint64_t *)(ph + sizeof(shm_media_head_info_v4_t));
@@ -678,6 +727,7 @@ int CLibShmMediaCtx::SendHead(const libshm_media_head_param_t *pmh)
 
 int CLibShmMediaCtx::_sendV4Data(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmiv, uint8_t *pItemAddr, uint32_t item_len)
 {
+    LIBSHM_TRACE_SCOPE(send_v4_data);
     unsigned int size = 0;
     int         w_len = 0;
     if (!pmh || !pmiv)
@@ -691,10 +741,13 @@ int CLibShmMediaCtx::_sendV4Data(const libshm_media_head_param_t *pmh, const lib
     tvushm::BufferController_t tmpBuf;
     int  nout = 0;
     const uint8_t* pout = NULL;
-    if (!(tvushm::keyValueProtoAppendToBuffer(tmpBuf, hChannel) <= 0))
     {
-        pout = tmpBuf.GetOrigPtr();
-        nout = tmpBuf.GetBufLength();
+        LIBSHM_TRACE_SCOPE(channel_layout_proto);
+        if (!(tvushm::keyValueProtoAppendToBuffer(tmpBuf, hChannel) <= 0))
+        {
+            pout = tmpBuf.GetOrigPtr();
+            nout = tmpBuf.GetBufLength();
+        }
     }
 
     const libshm_media_item_param_v1_t *pmi = (const libshm_media_item_param_v1_t *)pmiv;
@@ -750,13 +803,21 @@ int CLibShmMediaCtx::_sendV4Data(const libshm_media_head_param_t *pmh, const lib
         memset(&rii, 0, sizeof(rii));
         rii.nKeyValueSize_ = nout;
         rii.pKeyValuePtr_ = pout;
+        rii.fnCopy_ = m_fnCopy;
     }
 
+    libshmmediapro::invalidateItemGeneration(pItemAddr);
     {
+        LIBSHM_TRACE_SCOPE(write_item_v4);
         w_len = libshmmediapro::writeItemBufferV4(pmh, pmiv, rii, pItemAddr);
+        LIBSHM_TRACE_ARG(write_item_v4, w_len);
     }
 
-    FinishWrite();
+    if (w_len > 0)
+    {
+        libshmmediapro::publishItemGeneration(pItemAddr, (uint64_t)m_pShmObj->GetWriteIndex() + 1);
+    }
+    FinishWrite(w_len > 0 ? w_len : 0);
     return w_len;
 }
 
@@ -965,7 +1026,7 @@ int CLibShmMediaCtx::_sendV4Data(const libshm_media_head_param_t *pmh, const lib
 
         pi3->length = item_w_offset;
         w_len = item_w_offset;
-        FinishWrite();
+        FinishWrite(w_len);
     }
     return w_len;
 }
@@ -973,6 +1034,7 @@ int CLibShmMediaCtx::_sendV4Data(const libshm_media_head_param_t *pmh, const lib
 
 int CLibShmMediaCtx::SendData(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmiv)
 {
+    LIBSHM_TRACE_SCOPE(send_data);
     const libshm_media_item_param_v1_t *pmi = (const libshm_media_item_param_v1_t *)pmiv;
     uint8_t     *pItemAddr  = m_pShmObj->GetWriteItemAddr();
     uint32_t    item_len    = m_pShmObj->GetItemLength();
@@ -985,6 +1047,24 @@ int CLibShmMediaCtx::SendData(const libshm_media_head_param_t *pmh, const libshm
     unsigned int size       = 0;
     int         w_len       = 0;
     int64_t     now         = 0;
+    int         nplanes     = libshmmediapro::checkItemVideoPlanes(pmiv);
+
+    if (nplanes < 0)
+    {
+        return nplanes;
+    }
+
+    if (nplanes > 0 && m_uVersion != LIBSHM_MEDIA_HEAD_VERSION_V4)
+    {
+        DEBUG_ERROR("shm[%s] version %u, video planes need V4\n", m_pShmObj->GetName(), m_uVersion);
+        return -ENOTSUP;
+    }
+
+    if (m_pShmObj->IsLossless() && m_pShmObj->IsWriteBlocked())
+    {
+        m_pShmObj->CountWriteBlocked();
+        return -EAGAIN;
+    }
 
     now = _libshm_get_sys_ms64();
 
@@ -1106,7 +1186,7 @@ int CLibShmMediaCtx::SendData(const libshm_media_head_param_t *pmh, const libshm
 
                     pi12->length = LIBSHMMEDIA_ITEM_WRITE_SHM_U32(item_w_offset);
                     w_len = item_w_offset;
-                    FinishWrite();
+                    FinishWrite(w_len);
                 }
             }
             else
@@ -1271,7 +1351,7 @@ int CLibShmMediaCtx::SendData(const libshm_media_head_param_t *pmh, const libshm
 
                     pi3->length = LIBSHMMEDIA_ITEM_WRITE_SHM_U32(item_w_offset);
                     w_len = item_w_offset;
-                    FinishWrite();
+                    FinishWrite(w_len);
                 }
             }
             else
@@ -1410,6 +1490,7 @@ int CLibShmMediaCtx::PollReadDataWithoutIndexStep(
     , libshmmedia_extend_data_info_t *pext
     , unsigned int timeout)
 {
+    LIBSHM_TRACE_SCOPE(poll_read_data);
     uint32_t    read_index  = m_pShmObj->GetReadIndex();
     int         ret     = PollReadable(timeout);
 
@@ -1428,6 +1509,61 @@ int CLibShmMediaCtx::PollReadDataWithoutIndexStep(
     return ret;
 }
 
+/**
+ *  all ready items are parsed under one readable check, and the read index
+ *  is stepped once after them.
+ */
+int CLibShmMediaCtx::PollReadDataBatch(
+    libshm_media_head_param_t *pmh
+    , libshm_media_item_param_t   *pmi
+    , int max
+    , unsigned int timeout)
+{
+    if (!pmh || !pmi || max <= 0)
+    {
+        DEBUG_ERROR("invalid batch parameters, max:%d", max);
+        return -EINVAL;
+    }
+
+    int         ret     = PollReadable(timeout);
+
+    if (ret <= 0) {
+        return ret;
+    }
+
+    /* read index may be moved forward by PollReadable when the reader falls behind. */
+    uint32_t    read_index  = m_pShmObj->GetReadIndex();
+    int         ready       = ret < max ? ret : max;
+    int         n           = 0;
+
+    for (; n < ready; n++)
+    {
+        if (ReadItemData(pmh, pmi + n, NULL, read_index + n) <= 0)
+        {
+            DEBUG_WARN_CR("parse item data failed."
+                        "rindex:%u", read_index + n);
+            break;
+        }
+    }
+
+    if (n > 0)
+    {
+        SetRIndex(read_index + n);
+        if (n > 1)
+        {
+            /* lossless writer must keep all the batch, not only the last item. */
+            m_pShmObj->HoldReadIndex(read_index + 1);
+        }
+        _prefetchAhead();
+        m_pShmObj->CountRead(n);
+        for (int i = 0; i < n; i++)
+        {
+            _countReadLatency(pmi + i);
+        }
+    }
+    return n;
+}
+
 int CLibShmMediaCtx::PollReadDateWithTvutimestamp(
     libshm_media_head_param_t *pmh, libshm_media_item_param_t *pmi
     , libshmmedia_extend_data_info_t *pext
@@ -1466,7 +1602,7 @@ int CLibShmMediaCtx::PollReadDateWithTvutimestamp(
             );
         ret = matchintItem.GetItem().GetReadingRet();
         *pmh = matchintItem.GetItem().curHead_;
-        *pmi = matchintItem.GetItem().curItem_;
+        libshmmediapro::_itemParamLowCopy(*pmi, matchintItem.GetItem().curItem_);
         if (pext)
         {
             *pext  = matchintItem.GetItem().curExt_;
@@ -1490,7 +1626,7 @@ int CLibShmMediaCtx::PollReadDateWithTvutimestamp(
             );
         ret = matchintItem.GetItem().GetReadingRet();
         *pmh = matchintItem.GetItem().curHead_;
-        *pmi = matchintItem.GetItem().curItem_;
+        libshmmediapro::_itemParamLowCopy(*pmi, matchintItem.GetItem().curItem_);
         if (pext)
         {
             *pext  = matchintItem.GetItem().curExt_;
@@ -1518,7 +1654,7 @@ int CLibShmMediaCtx::PollReadDateWithTvutimestamp(
             , firstItem.itemIdx
         );
         *pmh = firstItem.GetItem().curHead_;
-        *pmi = firstItem.GetItem().curItem_;
+        libshmmediapro::_itemParamLowCopy(*pmi, firstItem.GetItem().curItem_);
         if (pext)
         {
             *pext  = firstItem.GetItem().curExt_;
@@ -1535,6 +1671,7 @@ int CLibShmMediaCtx::ReadItemData(
     , libshmmedia_extend_data_info_t *pext
     , unsigned int rindex)
 {
+    LIBSHM_TRACE_SCOPE(read_item_data);
     uint32_t    read_index  = rindex;
     uint8_t     *pItemAddr  = m_pShmObj->GetItemAddrByIndex(read_index);
     int         r_len       = -1;
@@ -1553,7 +1690,7 @@ int CLibShmMediaCtx::ReadItemData(
 
     libshm_media_item_param_t   oipv;
     {
-        memset(&oipv, 0, sizeof(oipv));
+        LibShmMediaItemParamInit(&oipv, sizeof(oipv));
     }
 
     libshm_media_head_param_t   ohp;
@@ -1562,22 +1699,29 @@ int CLibShmMediaCtx::ReadItemData(
         ohp.h_channel = libshmmediapro::_headParamGetChannelLayout(*pmh);
     }
 
-    unsigned int buffer_len = libshmmediapro::getBufferLenFromItemBuffer(pItemAddr, m_uVersion);
+    {
+        LIBSHM_TRACE_SCOPE(read_item_buffer);
+        unsigned int buffer_len = libshmmediapro::getBufferLenFromItemBuffer(pItemAddr, m_uVersion);
 
-    r_len = libshmmediapro::readDataFromItemBuffer(&ohp, &oipv, pItemAddr, buffer_len);
+        r_len = libshmmediapro::readDataFromItemBuffer(&ohp, &oipv, pItemAddr, buffer_len);
+        LIBSHM_TRACE_ARG(read_item_buffer, r_len);
+    }
 
     libshm_media_item_param_t &oip = oipv;
 
     if (r_len > 0)
     {
         oip.u_read_index = read_index;
-        if (libshmmediapro::_headParamLowCompare(*pmh, ohp))
         {
-            libshmmediapro::_headParamLowCopy(*pmh, ohp);
-            //return -1;
+            LIBSHM_TRACE_SCOPE(head_compare);
+            if (libshmmediapro::_headParamLowCompare(*pmh, ohp))
+            {
+                libshmmediapro::_headParamLowCopy(*pmh, ohp);
+                //return -1;
+            }
         }
 
-        *pmi = oipv;
+        libshmmediapro::_itemParamLowCopy(*pmi, oipv);
         if (m_fnReadCb) {
             int ret   = m_fnReadCb(m_pOpaq, &oipv);
             if (ret < 0) {
@@ -1589,6 +1733,7 @@ int CLibShmMediaCtx::ReadItemData(
         {
             if (oipv.i_userDataLen > 0 && oipv.p_userData)
             {
+                LIBSHM_TRACE_SCOPE(parse_extend_data);
                 LibShmMeidaParseExtendDataV2(pext, oipv.p_userData, oipv.i_userDataLen);
             }
 
@@ -1947,6 +2092,7 @@ int CLibShmMediaCtx::PollReadDataWithoutIndexStep(libshm_media_head_param_t *pmh
 int CLibShmMediaCtx::FinishRead()
 {
     m_pShmObj->FinishRead();
+    _prefetchAhead();
 
 #ifdef MULTIPLE_PROCESS_ATOMIC_OPT_TEST
     uint8_t *ph = m_pShmObj->GetHeader();
@@ -1979,6 +2125,7 @@ int CLibShmMediaCtx::PollReadData(
     if (ret > 0)
     {
         FinishRead();
+        _countReadLatency(pmi);
     }
     return ret;
 }
@@ -2092,7 +2239,7 @@ CLibShmMediaCtx::_readOutItemInfor(uint32_t rindex)
 
     tvushm::ItemInfo &item = _itemNodes[itemIdx];
 
-    if (item.IsReadingSuccess(rindex))
+    if (_isItemNodeCached(item, rindex))
     {
         return item;
     }
@@ -2151,6 +2298,98 @@ int CLibShmMediaCtx::_readOutFirstItemInfor(ResultRecorder &rec)
     return _readOutItemInfor(rindex, rec);
 }
 
+bool CLibShmMediaCtx::_isItemNodeCached(const tvushm::ItemInfo &item, uint32_t rindex)
+{
+    if (!item.IsReadingSuccess(rindex))
+    {
+        return false;
+    }
+
+    /**
+     * the writer has not got back to the slot of the item, the oldest item
+     * shares its slot with the one being written at the write index.
+    **/
+    return (uint32_t)(GetWIndex() - rindex - 1) < GetItemCounts() - 1;
+}
+
+void CLibShmMediaCtx::_saveSearchHint(SearchHint &hint, uint32_t itemIdx)
+{
+    hint.valid_ = true;
+    hint.itemIdx_ = itemIdx;
+}
+
+bool CLibShmMediaCtx::_searchNearHint(
+    const SearchHint &hint
+    , const uint64_t &value
+    , uint32_t rindex
+    , uint32_t windex
+    , ResultRecorder &matchingItem
+    , FnCmpFetchingItem_t fnCmp
+    , FnHasGottenTimeVal_t fnHasGotTime
+    )
+{
+    if (!hint.valid_)
+    {
+        return false;
+    }
+
+    uint32_t idx = hint.itemIdx_;
+    if ((int32_t)(idx - rindex) < 0) /* the reader had stepped over the last matching */
+    {
+        idx = rindex;
+    }
+
+    if ((int32_t)(windex - 1 - idx) < 0)
+    {
+        return false;
+    }
+
+    ResultRecorder result;
+    fnCmp(idx, value, result);
+    if (!fnHasGotTime(result.pItem, idx))
+    {
+        return false;
+    }
+
+    if (result.cmpRet > 0)
+    {
+        /* only matching while the value is just behind the hint. */
+        if (idx == rindex)
+        {
+            return false;
+        }
+
+        ResultRecorder prev;
+        fnCmp(idx - 1, value, prev);
+        if (!fnHasGotTime(prev.pItem, idx - 1) || prev.cmpRet >= 0)
+        {
+            return false;
+        }
+
+        matchingItem = result;
+        return true;
+    }
+
+    for (int i = 0; result.cmpRet < 0; i++)
+    {
+        if (i == LIBSHM_MEDIA_SEARCH_HINT_STEPS || idx + 1 == windex)
+        {
+            return false;
+        }
+
+        idx++;
+        result = ResultRecorder();
+        fnCmp(idx, value, result);
+        if (!fnHasGotTime(result.pItem, idx))
+        {
+            return false;
+        }
+    }
+
+    matchingItem = result;
+    return true;
+}
+
 /**
  * return the reading status.
  **/
@@ -2222,6 +2461,7 @@ bool CLibShmMediaCtx::SearchItemWithTvutimestamp(
     , libshmmedia_extend_data_info_t *pext
     )
 {
+    LIBSHM_TRACE_SCOPE(search_tvutimestamp);
     uint32_t    windex  = GetWIndex();
     //uint32_t    counts  = GetItemCounts();
     uint32_t    rindex  = GetRIndex();//windex >= counts ? (windex - counts + 1) : 0;
@@ -2253,6 +2493,24 @@ bool CLibShmMediaCtx::SearchItemWithTvutimestamp(
         uint32_t startInx = rindex;
         uint32_t endInx = windex - 1;
 
+        ResultRecorder hinted;
+        if (_searchNearHint(m_oTvutimestampHint, tvutimestamp, rindex, windex, hinted
+            , std::bind(&CLibShmMediaCtx::_cmpMatchingTvutimestamp, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)
+            , std::bind(&tvushm::ItemInfo::HasGottenTvutimestamp, std::placeholders::_1, std::placeholders::_2))
+            && hinted.cmpRet == 0)
+        {
+            matchingTvustamp = hinted.GetItem().GetTvutimestamp();
+            matchingIdx = hinted.itemIdx;
+            if (pmh)
+                *pmh = hinted.GetItem().curHead_;
+            if (pmi)
+                libshmmediapro::_itemParamLowCopy(*pmi, hinted.GetItem().curItem_);
+            if (pext)
+                *pext = hinted.GetItem().curExt_;
+            bGotMatching = true;
+            break;
+        }
+
         // in the rage
         uint32_t left = startInx;
         uint32_t right = endInx ;
@@ -2292,7 +2550,7 @@ bool CLibShmMediaCtx::SearchItemWithTvutimestamp(
                 if (pmh)
                     *pmh = result.GetItem().curHead_;
                 if (pmi)
-                    *pmi = result.GetItem().curItem_;
+                    libshmmediapro::_itemParamLowCopy(*pmi, result.GetItem().curItem_);
                 if (pext)
                     *pext = result.GetItem().curExt_;
                 bGotMatching = true;
@@ -2308,6 +2566,7 @@ bool CLibShmMediaCtx::SearchItemWithTvutimestamp(
     int64_t diffTime = _libshm_get_sys_ms64() - beginTime;
     if (bGotMatching)
     {
+        _saveSearchHint(m_oTvutimestampHint, matchingIdx);
         if (diffTime <= 5)
         {
             DEBUG_INFO_CR(
@@ -2369,8 +2628,10 @@ bool CLibShmMediaCtx::SearchFirstItemMatching(
     , FnHasGottenTimeVal_t fnHasGotTime
     , FnTimestampValMinus_t fnMinus
     , const char *module
+    , SearchHint &hint
 )
 {
+    LIBSHM_TRACE_SCOPE(search_first_matching);
     uint32_t    windex  = GetWIndex();
     //uint32_t    counts  = GetItemCounts();
     uint32_t    rindex  = GetRIndex();//windex >= counts ? (windex - counts + 1) : 0;
@@ -2411,6 +2672,13 @@ bool CLibShmMediaCtx::SearchFirstItemMatching(
         uint32_t startInx = rindex;
         uint32_t endInx = windex - 1;
 
+        if (_searchNearHint(hint, tvutimestamp, rindex, windex, matchingItem, fnCmp, fnHasGotTime))
+        {
+            matchingTvustamp = fnGetTime(matchingItem.pItem);
+            bGotMatching = true;
+            break;
+        }
+
         ResultRecorder lastResult;
         {
             fnCmp(startInx, tvutimestamp, lastResult);
@@ -2586,6 +2854,7 @@ bool CLibShmMediaCtx::SearchFirstItemMatching(
     int64_t diffTime = _libshm_get_sys_ms64() - beginTime;
     if (bGotMatching)
     {
+        _saveSearchHint(hint, matchingItem.itemIdx);
         if (diffTime <= 5)
         {
             DEBUG_INFO_CR(
@@ -2648,7 +2917,7 @@ bool CLibShmMediaCtx::SearchTheFirstMatchingItemWithTvutimestamp(
     FnHasGottenTimeVal_t fnGottenTime =
         std::bind(&tvushm::ItemInfo::HasGottenTvutimestamp, std::placeholders::_1, std::placeholders::_2);
     FnTimestampValMinus_t fnMinus = std::bind(&LibshmutilTvutimestampMinusWithMS, std::placeholders::_1, std::placeholders::_2);
-    return SearchFirstItemMatching(tvutimestamp, matchingItem, fnPtsValid, fnCmp, fnGetTime, fnGottenTime, fnMinus, "tvutimestamp");
+    return SearchFirstItemMatching(tvutimestamp, matchingItem, fnPtsValid, fnCmp, fnGetTime, fnGottenTime, fnMinus, "tvutimestamp", m_oTvutimestampHint);
     // uint32_t    windex  = GetWIndex();
     // //uint32_t    counts  = GetItemCounts();
     // uint32_t    rindex  = GetRIndex();//windex >= counts ? (windex - counts + 1) : 0;
@@ -2925,7 +3194,7 @@ bool CLibShmMediaCtx::SearchTheFirstMatchingItemWithPts(
     FnHasGottenTimeVal_t fnGottenTime =
         std::bind(&tvushm::ItemInfo::HasGottenPts, std::placeholders::_1, std::placeholders::_2);
     FnTimestampValMinus_t fnMinus = std::bind(&_uint64Minus, std::placeholders::_1, std::placeholders::_2);
-    return SearchFirstItemMatching(pts, matchingItem, fnPtsValid, fnCmp, fnGetTime, fnGottenTime, fnMinus, "pts");
+    return SearchFirstItemMatching(pts, matchingItem, fnPtsValid, fnCmp, fnGetTime, fnGottenTime, fnMinus, "pts", m_oPtsHint);
 }
 
 #if defined(TVU_LINUX)
@@ -2933,8 +3202,43 @@ int CLibShmMediaCtx::RemoveShm(const char *shmname)
 {
     return CTvuBaseShareMemory::RemoveShmFromKernal(shmname);
 }
+
+int CLibShmMediaCtx::ProbeShm(const char *shmname)
+{
+    int ret = CTvuBaseShareMemory::ProbeShm(shmname);
+    if (ret > 0)
+    {
+        return LIBSHM_MEDIA_SHM_TYPE_FIXED;
+    }
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    ret = CTvuVariableItemBaseShm::ProbeShm(shmname);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    return ret > 0 ? LIBSHM_MEDIA_SHM_TYPE_VARIABLE : LIBSHM_MEDIA_SHM_TYPE_NONE;
+}
 #endif
 
+int CLibShmMediaCtx::PeekLatestHead(libshm_media_head_param_t *pmh)
+{
+    uint32_t    w_index     = m_pShmObj->GetWriteIndex();
+
+    if (!w_index)
+    {
+        return 0;
+    }
+
+    uint8_t     *pItemAddr  = m_pShmObj->GetItemAddrByIndex(w_index - 1);
+    unsigned int item_len   = libshmmediapro::getBufferLenFromItemBuffer(pItemAddr, m_uVersion);
+
+    return libshmmediapro::readHeadFromItemBuffer(pmh, pItemAddr, item_len);
+}
+
 int CLibShmMediaCtx::PollReadRawData(libshmmedia_raw_head_param_t   *pmh, libshmmedia_raw_data_param_t   *pmi, unsigned int timeout)
 {
     uint32_t    read_index  = m_pShmObj->GetReadIndex();
@@ -3012,11 +3316,18 @@ int CLibShmMediaCtx::PollReadRawData(libshmmedia_raw_head_param_t   *pmh, libshm
 
 int CLibShmMediaCtx::ApplyRawData(libshmmedia_raw_data_param_t   *pmi)
 {
+    LIBSHM_TRACE_SCOPE(apply_raw_data);
     if (!IsCreator())
     {
         return 0;
     }
 
+    if (m_pShmObj->IsLossless() && m_pShmObj->IsWriteBlocked())
+    {
+        m_pShmObj->CountWriteBlocked();
+        return -EAGAIN;
+    }
+
     uint8_t     *pItemAddr  = m_pShmObj->GetWriteItemAddr();
     int32_t     item_len    = (int32_t)m_pShmObj->GetItemLength();
 
@@ -3025,6 +3336,7 @@ int CLibShmMediaCtx::ApplyRawData(libshmmedia_raw_data_param_t   *pmi)
         return -1;
     }
 
+    libshmmediapro::invalidateItemGeneration(pItemAddr);
     pmi->pRawData_ = pItemAddr;
     pmi->uRawData_ = item_len;
 
@@ -3033,16 +3345,24 @@ int CLibShmMediaCtx::ApplyRawData(libshmmedia_raw_data_param_t   *pmi)
 
 uint8_t *CLibShmMediaCtx::ApplyRawData(size_t len)
 {
+    LIBSHM_TRACE_SCOPE(apply_raw_data);
     if (!IsCreator())
     {
         return NULL;
     }
+
+    if (m_pShmObj->IsLossless() && m_pShmObj->IsWriteBlocked())
+    {
+        m_pShmObj->CountWriteBlocked();
+        return NULL;
+    }
     uint8_t     *pItemAddr  = m_pShmObj->GetWriteItemAddr();
     uint32_t     item_len    = m_pShmObj->GetItemLength();
     uint8_t     *pret = NULL;
 
     if (item_len >= len)
     {
+        libshmmediapro::invalidateItemGeneration(pItemAddr);
         pret = pItemAddr;
     }
 
@@ -3051,16 +3371,24 @@ uint8_t *CLibShmMediaCtx::ApplyRawData(size_t len)
 
 int CLibShmMediaCtx::ApplyItemBuffer(const libshm_media_item_param_t *pmi, libshm_media_item_addr_layout_t *pLayout)
 {
+    LIBSHM_TRACE_SCOPE(apply_item_buffer);
     if (!IsCreator())
     {
         return 0;
     }
 
+    if (m_pShmObj->IsLossless() && m_pShmObj->IsWriteBlocked())
+    {
+        m_pShmObj->CountWriteBlocked();
+        return -EAGAIN;
+    }
+
     uint8_t     *pItemAddr  = m_pShmObj->GetWriteItemAddr();
     uint32_t     item_len    = m_pShmObj->GetItemLength();
 
     uint32_t    item_ver = GetItemVersion();
     int ret = 0;
+    libshmmediapro::invalidateItemGeneration(pItemAddr);
     ret = libshmmediapro::getWriteItemBufferLayoutWithVer(pmi, pItemAddr, pLayout, item_ver);
     if (ret <= 0)
     {
@@ -3079,12 +3407,181 @@ int CLibShmMediaCtx::ApplyItemBuffer(const libshm_media_item_param_t *pmi, libsh
 
 int CLibShmMediaCtx::CommitRawData(size_t commit_len)
 {
-    FinishWrite();
+    LIBSHM_TRACE_SCOPE(commit_raw_data);
+    libshmmediapro::publishItemGeneration(m_pShmObj->GetWriteItemAddr(), (uint64_t)m_pShmObj->GetWriteIndex() + 1);
+    FinishWrite(commit_len);
     return commit_len;
 }
 
+int CLibShmMediaCtx::ValidateRead(const libshm_media_item_param_t *pmi)
+{
+    uint32_t        rindex      = pmi->u_read_index;
+    const uint8_t   *pItemAddr  = m_pShmObj->GetItemAddrByIndex(rindex);
+
+    /* everything the caller read from the item must be done before the checking. */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    if (m_uVersion == LIBSHM_MEDIA_HEAD_VERSION_V4 && libshmmediapro::itemHasGeneration(pItemAddr))
+    {
+        uint64_t gen = libshmmediapro::loadItemGeneration(pItemAddr);
+        return (gen == (uint64_t)rindex + 1) ? 1 : 0;
+    }
+
+    /**
+     *  writer of old version does not stamp the item,
+     *  the slot is only rewritten after write index reaching rindex + counts.
+    **/
+    uint32_t w = m_pShmObj->GetWriteIndex();
+    return ((uint32_t)(w - rindex) < m_pShmObj->GetItemCounts()) ? 1 : 0;
+}
+
+int CLibShmMediaCtx::SetReadPrefetch(uint32_t depth, uint32_t bytes)
+{
+    if (depth > LIBSHM_MEDIA_PREFETCH_MAX_DEPTH)
+    {
+        DEBUG_ERROR("prefetch depth %u over %d", depth, LIBSHM_MEDIA_PREFETCH_MAX_DEPTH);
+        return -EINVAL;
+    }
+
+    if (!bytes)
+    {
+        bytes = LIBSHM_MEDIA_PREFETCH_DEFAULT_BYTES;
+    }
+
+    m_uPrefetchDepth = depth;
+    m_uPrefetchBytes = bytes < GetItemLen() ? bytes : GetItemLen();
+    m_uPrefetchedIndex = GetRIndex();
+    _prefetchAhead();
+    return 0;
+}
+
+int CLibShmMediaCtx::SetCopyMode(int mode)
+{
+    switch (mode)
+    {
+    case LIBSHM_MEDIA_COPY_MODE_DEFAULT:
+        m_fnCopy = NULL;
+        break;
+    case LIBSHM_MEDIA_COPY_MODE_STREAMING:
+        m_fnCopy = tvushm::MemcpyStreaming;
+        break;
+    default:
+        DEBUG_ERROR("copy mode %d invalid", mode);
+        return -EINVAL;
+    }
+    return 0;
+}
+
+/**
+ *  only the items written are prefetched, the slot the writer is filling would
+ *  bounce its lines between the two caches. each item is prefetched once, the
+ *  next stepping only adds the new one at the end of the depth.
+ */
+void CLibShmMediaCtx::_prefetchAhead()
+{
+    if (!m_uPrefetchDepth)
+    {
+        return;
+    }
+
+    uint32_t rindex = GetRIndex();
+    uint32_t windex = GetWIndex();
+    uint32_t ready = windex - rindex;
+    uint32_t index = m_uPrefetchedIndex;
+
+    if (ready > m_uPrefetchDepth)
+    {
+        ready = m_uPrefetchDepth;
+    }
+
+    if ((uint32_t)(index - rindex) > ready)
+    {
+        /* the read index was moved, by seeking or falling behind. */
+        index = rindex;
+    }
+
+    for (; index != rindex + ready; index++)
+    {
+        _libshm_prefetch(m_pShmObj->GetItemAddrByIndex(index), m_uPrefetchBytes);
+    }
+    m_uPrefetchedIndex = index;
+}
+
+int CLibShmMediaCtx::GetReaders(libshm_media_reader_info_t *readers, int max)
+{
+    shm_reader_info_t   slots[SHM_READER_TABLE_SLOTS];
+
+    if (max > SHM_READER_TABLE_SLOTS)
+    {
+        max = SHM_READER_TABLE_SLOTS;
+    }
+
+    int n = m_pShmObj->GetReaders(slots, max);
+    uint32_t w = m_pShmObj->GetWriteIndex();
+    uint64_t now = _libshm_get_sys_ms64();
+
+    for (int i = 0; i < n; i++)
+    {
+        libshm_media_reader_info_t &o = readers[i];
+        int gap = (int)(w - slots[i].read_index); /* reader seeking ahead is no lag */
+
+        memset((void *)&o, 0, sizeof(o));
+        o.u_pid         = slots[i].pid;
+        o.u_read_index  = slots[i].read_index;
+        o.u_lag_items   = gap > 0 ? (uint32_t)gap : 0;
+        o.u_lag_ms      = (o.u_lag_items && now > slots[i].sync_time) ? now - slots[i].sync_time : 0;
+        o.u_idle_ms     = now > slots[i].heartbeat ? now - slots[i].heartbeat : 0;
+    }
+    return n;
+}
+
+int CLibShmMediaCtx::GetStats(libshm_media_stats_t *pstats)
+{
+    shm_stats_info_t            w;
+    shm_reader_stats_info_t     readers[SHM_READER_TABLE_SLOTS];
+    int max = SHM_READER_TABLE_SLOTS < LIBSHM_MEDIA_STATS_READERS_MAX ? SHM_READER_TABLE_SLOTS : LIBSHM_MEDIA_STATS_READERS_MAX;
+
+    int n = m_pShmObj->GetStats(&w, readers, max);
+    if (n < 0)
+    {
+        return -ENOTSUP;
+    }
+
+    memset((void *)pstats, 0, sizeof(*pstats));
+    pstats->u_frames_written    = w.frames_written;
+    pstats->u_bytes_written     = w.bytes_written;
+    pstats->u_max_item_size     = w.max_item_size;
+    pstats->u_write_blocked     = w.write_blocked;
+    pstats->u_readers           = n;
+    for (int i = 0; i < n; i++)
+    {
+        libshm_media_reader_stats_t &o = pstats->readers[i];
+        o.u_pid             = readers[i].pid;
+        o.u_frames_read     = readers[i].frames_read;
+        o.u_frames_dropped  = readers[i].frames_dropped;
+        o.u_overruns        = readers[i].overruns;
+        for (int b = 0; b < LIBSHM_MEDIA_STATS_LATENCY_BUCKETS && b < SHM_STATS_LATENCY_BUCKETS; b++)
+        {
+            o.u_latency_ms[b] = readers[i].latency_ms[b];
+        }
+    }
+    return n;
+}
+
+/* the ms from the writer creating the item to reading it, by the first creating time it has. */
+void CLibShmMediaCtx::_countReadLatency(const libshm_media_item_param_t *pmi)
+{
+    int64_t ct = pmi->i64_vct > 0 ? pmi->i64_vct : (pmi->i64_act > 0 ? pmi->i64_act : pmi->i64_userDataCT);
+
+    if (ct > 0)
+    {
+        m_pShmObj->CountReadLatency(_libshm_get_sys_ms64() - ct);
+    }
+}
+
 int CLibShmMediaCtx::CommitItemBuffer(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmi)
 {
+    LIBSHM_TRACE_SCOPE(commit_item_buffer);
     if (!IsCreator())
     {
         return 0;
@@ -3148,6 +3645,35 @@ LibShmMediaCreate2
     , uint32_t item_length
     , mode_t mode
 )
+{
+    return LibShmMediaCreate3(pMemoryName, header_len, item_count, item_length, mode, 0);
+}
+
+libshm_media_handle_t
+LibShmMediaCreate3
+(
+    const char * pMemoryName
+    , uint32_t header_len
+    , uint32_t item_count
+    , uint32_t item_length
+    , mode_t mode
+    , uint32_t flags
+)
+{
+    return LibShmMediaCreate4(pMemoryName, header_len, item_count, item_length, mode, flags, LIBSHM_MEDIA_NUMA_NODE_NONE);
+}
+
+libshm_media_handle_t
+LibShmMediaCreate4
+(
+    const char * pMemoryName
+    , uint32_t header_len
+    , uint32_t item_count
+    , uint32_t item_length
+    , mode_t mode
+    , uint32_t flags
+    , int numa_node
+)
 {
     CLibShmMediaCtx             *pctx   = NULL;
     libshm_media_handle_t    h       = NULL;
@@ -3160,7 +3686,7 @@ LibShmMediaCreate2
         goto FAILED;
     }
 
-    if (pctx->CreateShmEntry(pMemoryName, header_len, item_count, item_length, mode) < 0) {
+    if (pctx->CreateShmEntry(pMemoryName, header_len, item_count, item_length, mode, flags, numa_node) < 0) {
         goto FAILED;
     }
 
@@ -3191,6 +3717,16 @@ LibShmMediaRemoveShmidFromSystem
     }
     return CLibShmMediaCtx::RemoveShm(pMemoryName);
 }
+
+int
+LibShmMediaProbeShm(const char * pMemoryName)
+{
+    if (!pMemoryName)
+    {
+        return -EINVAL;
+    }
+    return CLibShmMediaCtx::ProbeShm(pMemoryName);
+}
 #endif
 
 libshm_media_handle_t
@@ -3200,6 +3736,18 @@ LibShmMediaOpen
     , libshm_media_readcb_t cb
     , void *opaq
 )
+{
+    return LibShmMediaOpen2(pMemoryName, cb, opaq, 0);
+}
+
+libshm_media_handle_t
+LibShmMediaOpen2
+(
+    const char * pMemoryName
+    , libshm_media_readcb_t cb
+    , void *opaq
+    , uint32_t flags
+)
 {
     CLibShmMediaCtx             *pctx   = NULL;
     libshm_media_handle_t      h       = NULL;
@@ -3212,7 +3760,7 @@ LibShmMediaOpen
         goto FAILED;
     }
 
-    if (pctx->OpenShmEntry(pMemoryName, cb, opaq) < 0) {
+    if (pctx->OpenShmEntry(pMemoryName, cb, opaq, flags) < 0) {
         goto FAILED;
     }
 
@@ -3446,6 +3994,24 @@ int LibShmMediaIsCreator(libshm_media_handle_t h)
     return pctx->IsCreator() ? 1 : 0;
 }
 
+int LibShmMediaGetPageBacking(libshm_media_handle_t h)
+{
+    CLibShmMediaCtx    *pctx    = (CLibShmMediaCtx *)h;
+    return pctx->GetPageBacking();
+}
+
+int64_t LibShmMediaGetPrefaultTime(libshm_media_handle_t h)
+{
+    CLibShmMediaCtx    *pctx    = (CLibShmMediaCtx *)h;
+    return pctx->GetPrefaultTime();
+}
+
+int LibShmMediaGetNumaNode(libshm_media_handle_t h)
+{
+    CLibShmMediaCtx    *pctx    = (CLibShmMediaCtx *)h;
+    return pctx->GetNumaNode();
+}
+
 /**
  *  Parameter:
  *      timeout : currently, it was no use
@@ -3489,6 +4055,33 @@ int LibShmMediaSendDataWithFrequency1000(
     return pctx->SendDataWithFrequency1000(pmh, pmi);
 }
 
+int LibShmMediaSetCopyMode(libshm_media_handle_t h, int mode)
+{
+    CLibShmMediaCtx    *pctx    = (CLibShmMediaCtx *)h;
+
+    if (!pctx)
+    {
+        return -EINVAL;
+    }
+
+    return pctx->SetCopyMode(mode);
+}
+
+int LibShmMediaSetHandleLogLevel(libshm_media_handle_t h, int level)
+{
+    CLibShmMediaCtx    *pctx    = (CLibShmMediaCtx *)h;
+
+    if (!pctx || !pctx->GetShmObj()
+        || (level != LIBSHM_MEDIA_LOG_LEVEL_DEFAULT
+            && (level < LIBSHM_MEDIA_LOG_LEVEL_INFO || level > LIBSHM_MEDIA_LOG_LEVEL_NONE)))
+    {
+        return -EINVAL;
+    }
+
+    pctx->GetShmObj()->SetLogLevel(level);
+    return 0;
+}
+
 int LibShmMediaPollReadHead(
       libshm_media_handle_t         h
       , libshm_media_head_param_t   *pmh
@@ -3526,6 +4119,18 @@ int LibShmMediaPollReadDataV2(
     return pctx->PollReadData(pmh, pmi, pext, timeout);
 }
 
+int LibShmMediaPollReadDataBatch(
+    libshm_media_handle_t         h
+    , libshm_media_head_param_t   *pmh
+    , libshm_media_item_param_t   *pmi
+    , int                         max
+    , unsigned int                timeout
+    )
+{
+    CLibShmMediaCtx    *pctx    = (CLibShmMediaCtx *)h;
+    return pctx->PollReadDataBatch(pmh, pmi, max, timeout);
+}
+
 int LibShmMediaReadData(
       libshm_media_handle_t         h
       , libshm_media_head_param_t   *pmh
@@ -3555,11 +4160,46 @@ void LibShmMediaReadIndexStep(
     return;
 }
 
-static int(*_gfnLibshmmedia)(int , const char *, va_list ap) = NULL;
+int LibShmMediaValidateRead(
+    libshm_media_handle_t         h
+    , const libshm_media_item_param_t *pmi
+)
+{
+    CLibShmMediaCtx    *pctx = (CLibShmMediaCtx *)h;
+
+    if (!pctx || !pmi)
+    {
+        return -EINVAL;
+    }
+
+    return pctx->ValidateRead(pmi);
+}
+
+int LibShmMediaSetReadPrefetch(
+    libshm_media_handle_t         h
+    , unsigned int                depth
+    , unsigned int                bytes
+)
+{
+    CLibShmMediaCtx    *pctx = (CLibShmMediaCtx *)h;
+
+    if (!pctx)
+    {
+        return -EINVAL;
+    }
+
+    return pctx->SetReadPrefetch(depth, bytes);
+}
+
+typedef int(*libshmmedia_va_log_cb_t)(int , const char *, va_list ap);
+
+/* libshmmedia_va_log_cb_t, swapped by LibShmMediaSetLogCallback while the drainer of TvuLog is in it. */
+static uint64_t _gfnLibshmmedia = 0;
 static int _fncallback(int level, const char *fmt, ...)
 {
     int ret = 0;
-    if (!_gfnLibshmmedia)
+    libshmmedia_va_log_cb_t cb = (libshmmedia_va_log_cb_t)(uintptr_t)_libshm_atomic_load_acquire_u64(&_gfnLibshmmedia);
+    if (!cb)
     {
         return 0;
     }
@@ -3567,15 +4207,24 @@ static int _fncallback(int level, const char *fmt, ...)
     va_list ap;
     va_start(ap, fmt);
     {
-        ret = _gfnLibshmmedia(level, fmt, ap);
+        ret = cb(level, fmt, ap);
     }
     va_end(ap);
     return ret;
 }
 
+static void _swapLibshmmediaCallback(void *opaq)
+{
+    _libshm_atomic_store_release_u64(&_gfnLibshmmedia, (uint64_t)(uintptr_t)opaq);
+}
+
 void LibShmMediaSetLogCallback(int(*cb)(int , const char *, va_list ap))
 {
-    _gfnLibshmmedia = cb;
+    /**
+     *  the records queued go to the callback they were logged for, and the
+     *  drainer is not in the old one once it returns.
+     */
+    tvushm::Log::Synchronize(_swapLibshmmediaCallback, (void *)(uintptr_t)cb);
     libsharememory_set_log_cabllback_internal_v2(cb);
     LibShmMediaProtoSetLogCbInternalV2(cb);
 
@@ -3583,6 +4232,68 @@ void LibShmMediaSetLogCallback(int(*cb)(int , const char *, va_list ap))
     tvushm::Log::SetLogTag("vishm");
 }
 
+int LibShmMediaSetLogLevel(int level)
+{
+    if (level < LIBSHM_MEDIA_LOG_LEVEL_INFO || level > LIBSHM_MEDIA_LOG_LEVEL_NONE)
+    {
+        return -EINVAL;
+    }
+
+    _libshm_atomic_store_relaxed_u32(&g_libshmLogLevel, (uint32_t)level);
+    return 0;
+}
+
+void LibShmMediaSetLogAsync(int enable)
+{
+    tvushm::Log::SetAsync(enable != 0);
+}
+
+int LibShmMediaFlushLogs(void)
+{
+    return tvushm::Log::Flush();
+}
+
+uint64_t LibShmMediaGetDroppedLogs(void)
+{
+    return tvushm::Log::GetDroppedCount();
+}
+
+int LibShmMediaTraceEnable(int enable)
+{
+#if defined(LIBSHM_ENABLE_TRACE)
+    tvushm::TraceSetEnabled(enable != 0);
+    return 0;
+#else
+    (void)enable;
+    return -ENOTSUP;
+#endif
+}
+
+int LibShmMediaTraceDump(const char *path)
+{
+#if defined(LIBSHM_ENABLE_TRACE)
+    if (!path)
+    {
+        return -EINVAL;
+    }
+
+    FILE *fp = fopen(path, "w");
+    if (!fp)
+    {
+        int ret = -errno;
+        DEBUG_ERROR("open trace file %s failed, errno %d\n", path, -ret);
+        return ret;
+    }
+
+    int ret = tvushm::TraceDumpChromeJson(fp);
+    fclose(fp);
+    return ret;
+#else
+    (void)path;
+    return -ENOTSUP;
+#endif
+}
+
 void LibShmMediaSetLogCb(int(*cb)(int , const char *, ...))
 {
     libsharememory_set_log_cabllback_internal(cb);
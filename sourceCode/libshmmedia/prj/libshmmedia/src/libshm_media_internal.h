@@ -32,6 +32,8 @@
 #include "libshm_media_raw_data_opt.h"
 #include "libshm_media_audio_track_channel_proto_internal.h"
 #include "libshm_media_item_info.h"
+#include "libshm_memcpy_internal.h"
+#include "libshm_trace_internal.h"
 #include <malloc.h>
 #include <assert.h>
 #include <vector>
@@ -51,6 +53,10 @@ public:
         m_pOpaq         = NULL;
         m_fnReadCb      = NULL;
         m_i64LastSendSysTime = 0;
+        m_uPrefetchDepth = 0;
+        m_uPrefetchBytes = 0;
+        m_uPrefetchedIndex = 0;
+        m_fnCopy        = NULL;
         //_itemIndex = 0;
     }
 
@@ -122,17 +128,35 @@ public:
 
     int PollSendable(unsigned int timeout)
     {
+        LIBSHM_TRACE_SCOPE(poll_sendable);
         CTvuBaseShareMemory    *pshm           = (CTvuBaseShareMemory *)m_pShmObj;
-        if (CheckCloseFlag()) {
-            const char      *pShmName       = pshm->GetName();
-            DEBUG_INFO("share memory[%s] server close flag, shoule destroy shm object at once\n", pShmName);
-            return -1;
+        int64_t         t1              = _libshm_get_sys_ms64();
+        int             ret             = -1;
+
+        while (1)
+        {
+            if (CheckCloseFlag()) {
+                const char      *pShmName       = pshm->GetName();
+                DEBUG_INFO("share memory[%s] server close flag, shoule destroy shm object at once\n", pShmName);
+                return -1;
+            }
+
+            ret = pshm->Sendable();
+
+            /* only a lossless writer waits, for the slowest reader releasing an item. */
+            int64_t now = _libshm_get_sys_ms64();
+            if (ret != 0 || timeout <= 0 || now >= t1 + timeout)
+                break;
+
+            pshm->WaitForRelease((unsigned int)(t1 + timeout - now));
         }
-        return pshm->Sendable();
+
+        return ret;
     }
 
     int PollReadable(unsigned int timeout)
     {
+        LIBSHM_TRACE_SCOPE(poll_readable);
         CTvuBaseShareMemory    *pshm           = (CTvuBaseShareMemory *)m_pShmObj;
         int64_t         t1              = _libshm_get_sys_ms64();
         int64_t         t2              = 0;
@@ -140,6 +164,7 @@ public:
 
         while (1)
         {
+            uint32_t wakeupSeq = pshm->GetWakeupSeq();
             bool bClosed = CheckCloseFlag();
             ret = pshm->Readable(bClosed);
 
@@ -163,9 +188,10 @@ public:
                 break;
             }
 
-            _libshm_common_msleep(1);
+            pshm->WaitForWrite(wakeupSeq, (unsigned int)(t1 + timeout - t2));
         }
 
+        LIBSHM_TRACE_ARG(poll_readable, ret);
         return ret;
     }
 
@@ -191,6 +217,22 @@ public:
         return pshm->IsCreator();
     }
 
+    int64_t GetPrefaultTime()
+    {
+        return m_pShmObj->GetPrefaultTime();
+    }
+
+    int GetNumaNode()
+    {
+        return m_pShmObj->GetNumaNode();
+    }
+
+    int GetPageBacking()
+    {
+        return m_pShmObj->GetPageBacking() == SHM_PAGE_BACKING_HUGETLBFS
+            ? LIBSHM_MEDIA_PAGE_BACKING_HUGETLBFS : LIBSHM_MEDIA_PAGE_BACKING_NORMAL;
+    }
+
     bool bHasReaders(unsigned int timeout = 100)
     {
         return m_pShmObj->HasReaders(timeout);
@@ -198,11 +240,14 @@ public:
 
     int CreateShmEntry(const char * pMemoryName, uint32_t header_len, uint32_t item_count, uint32_t item_length );
     int CreateShmEntry(const char * pMemoryName, uint32_t header_len, uint32_t item_count, uint32_t item_length, mode_t mode);
+    int CreateShmEntry(const char * pMemoryName, uint32_t header_len, uint32_t item_count, uint32_t item_length, mode_t mode, uint32_t flags);
+    int CreateShmEntry(const char * pMemoryName, uint32_t header_len, uint32_t item_count, uint32_t item_length, mode_t mode, uint32_t flags, int numa_node);
     int OpenShmEntry(const char * pMemoryName, libshm_media_readcb_t cb, void *opaq);
+    int OpenShmEntry(const char * pMemoryName, libshm_media_readcb_t cb, void *opaq, uint32_t flags);
     void SetCloseFlag(bool bclose);
     bool CheckCloseFlag();
     uint8_t *GetItemDataAddr(uint32_t index);
-    inline int FinishWrite();
+    inline int FinishWrite(uint32_t bytes);
 
 #ifdef _LIBSHMMEDIA_PROTOCOL_APIS_DONE
     int SendHead(const libshm_media_head_param_t *pmh);
@@ -216,6 +261,10 @@ public:
                                      , libshm_media_item_param_t   *pmi
                                      , libshmmedia_extend_data_info_t *pext
                                      , unsigned int timeout);
+    int PollReadDataBatch(libshm_media_head_param_t *pmh
+                          , libshm_media_item_param_t   *pmi
+                          , int max
+                          , unsigned int timeout);
     int PollReadDateWithTvutimestamp(libshm_media_head_param_t *pmh, libshm_media_item_param_t   *pmi
                                      , libshmmedia_extend_data_info_t *pext
                                      , bool *bFoundTvutimestamp
@@ -239,6 +288,8 @@ public:
 #endif
     int FinishRead();
     uint32_t SetReadIndex(char type, int64_t pts);
+    int SetReadPrefetch(uint32_t depth, uint32_t bytes);
+    int SetCopyMode(int mode);
 private:
     class ResultRecorder
     {
@@ -281,6 +332,29 @@ private:
     int _readOutItemInfor(uint32_t rindex, ResultRecorder &rec);
     int _readOutFirstItemInfor(ResultRecorder &rec);
 
+    /**
+     * the item node of the last matching, searching of the next frame
+     * starts from it rather than bisecting the whole ring again.
+     **/
+    class SearchHint
+    {
+    public:
+        bool        valid_;
+        uint32_t    itemIdx_;
+        SearchHint()
+        {
+            valid_ = false;
+            itemIdx_ = 0;
+        }
+    };
+
+    /**
+     * item nodes are cached by item index, which counts the laps of the
+     * ring too. a node is used only while the writer has not got back to
+     * its slot.
+     **/
+    bool _isItemNodeCached(const tvushm::ItemInfo &item, uint32_t rindex);
+
     /**
     * return the reading status.
     **/
@@ -323,8 +397,24 @@ public:
                                  , FnHasGottenTimeVal_t fnHasGotTime
                                  , FnTimestampValMinus_t fnMinus
                                  , const char *module
+                                 , SearchHint &hint
                                  );
 
+    /**
+     * walk at most LIBSHM_MEDIA_SEARCH_HINT_STEPS items forward from the last matching.
+     * return true when the first item not less than the value was found,
+     * false means bisecting is needed.
+     **/
+    bool _searchNearHint(const SearchHint &hint
+                         , const uint64_t &value
+                         , uint32_t rindex
+                         , uint32_t windex
+                         , ResultRecorder &matchingItem
+                         , FnCmpFetchingItem_t fnCmp
+                         , FnHasGottenTimeVal_t fnHasGotTime
+                         );
+    void _saveSearchHint(SearchHint &hint, uint32_t itemIdx);
+
     bool SearchTheFirstMatchingItemWithTvutimestamp(
         const uint64_t &tvutimestamp
         , ResultRecorder &matchingItem
@@ -333,8 +423,27 @@ public:
         const uint64_t &pts
         , ResultRecorder &matchingItem
         );
+
+    /**
+     * the item node of @rindex from the cache of item nodes.
+     **/
+    const tvushm::ItemInfo &GetItemInfor(uint32_t rindex)
+    {
+        return _readOutItemInfor(rindex);
+    }
+
+    CTvuBaseShareMemory *GetShmObj()
+    {
+        return m_pShmObj;
+    }
+    /* the logs of the methods follow the log level of the shm. */
+    int _libshmLogLevelOverride() const
+    {
+        return m_pShmObj ? m_pShmObj->GetLogLevel() : LIBSHM_LOG_LEVEL_DEFAULT;
+    }
 #if defined(TVU_LINUX)
     static int RemoveShm(const char *pshmname);
+    static int ProbeShm(const char *pshmname);
 #endif
 
     int PollReadRawData(libshmmedia_raw_head_param_t   *pmh, libshmmedia_raw_data_param_t   *pmi, unsigned int timeout);
@@ -344,7 +453,14 @@ public:
 
     int ApplyItemBuffer(const libshm_media_item_param_t *pmi, libshm_media_item_addr_layout_t *pLayout);
     int CommitItemBuffer(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmi);
+    int ValidateRead(const libshm_media_item_param_t *pmi);
+    int GetReaders(libshm_media_reader_info_t *readers, int max);
+    int GetStats(libshm_media_stats_t *pstats);
+    /* head of the newest written item, the read index and read time stay, 0 nothing written yet. */
+    int PeekLatestHead(libshm_media_head_param_t *pmh);
     private:
+        void _prefetchAhead();
+        void _countReadLatency(const libshm_media_item_param_t *pmi);
         int _sendV4Data(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmi, uint8_t *pItemAddr, uint32_t item_size);
     private:
         uint32_t                    m_uVersion;
@@ -356,6 +472,12 @@ public:
         libshm_media_readcb_t       m_fnReadCb;
         int64_t                     m_i64LastSendSysTime;
         std::vector<tvushm::ItemInfo>_itemNodes; // this is thread safe for it would be read at one APIs.
+        SearchHint                  m_oTvutimestampHint;
+        SearchHint                  m_oPtsHint;
+        uint32_t                    m_uPrefetchDepth;
+        uint32_t                    m_uPrefetchBytes;
+        uint32_t                    m_uPrefetchedIndex;  // items before it had been prefetched.
+        tvushm::MemcpyFunc_t        m_fnCopy;   // payload copy of SendData, NULL for memcpy.
 };
 
 #endif
@@ -25,6 +25,7 @@
 #include <stdbool.h>
 #include <string.h>
 #include <memory>
+#include <functional>
 
 namespace tvushm {
 
@@ -11,6 +11,7 @@
  *  limitations under the License.
  *********************************************************/
 
+#include <errno.h>
 #include "libshm_media_raw_data_opt.h"
 #include "libshm_media_internal.h"
 #include "libshm_media_protocol_internal.h"
@@ -75,6 +76,64 @@ int LibShmMediaHasReader(libshm_media_handle_t h, unsigned int timeout)
     return ret;
 }
 
+int LibShmMediaGetReaders(libshm_media_handle_t h, libshm_media_reader_info_t *readers, int max)
+{
+    CLibShmMediaCtx    *pctx    = (CLibShmMediaCtx *)h;
+    if (!pctx || !readers || max < 0)
+    {
+        return -EINVAL;
+    }
+    return pctx->GetReaders(readers, max);
+}
+
+int LibShmMediaGetStats(libshm_media_handle_t h, libshm_media_stats_t *pstats)
+{
+    CLibShmMediaCtx    *pctx    = (CLibShmMediaCtx *)h;
+    if (!pctx || !pstats)
+    {
+        return -EINVAL;
+    }
+    return pctx->GetStats(pstats);
+}
+
+int LibShmMediaPeekLatestHead(libshm_media_handle_t h, libshm_media_head_param_t *pmh)
+{
+    CLibShmMediaCtx    *pctx    = (CLibShmMediaCtx *)h;
+    if (!pctx || !pmh)
+    {
+        return -EINVAL;
+    }
+    return pctx->PeekLatestHead(pmh);
+}
+
+int LibShmMediaGetSlowestReader(libshm_media_handle_t h, libshm_media_reader_info_t *preader)
+{
+    CLibShmMediaCtx    *pctx    = (CLibShmMediaCtx *)h;
+    if (!pctx || !preader)
+    {
+        return -EINVAL;
+    }
+
+    libshm_media_reader_info_t readers[SHM_READER_TABLE_SLOTS];
+    int n = pctx->GetReaders(readers, SHM_READER_TABLE_SLOTS);
+    if (n <= 0)
+    {
+        return 0;
+    }
+
+    int slowest = 0;
+    for (int i = 1; i < n; i++)
+    {
+        if (readers[i].u_lag_items > readers[slowest].u_lag_items
+            || (readers[i].u_lag_items == readers[slowest].u_lag_items && readers[i].u_lag_ms > readers[slowest].u_lag_ms))
+        {
+            slowest = i;
+        }
+    }
+    *preader = readers[slowest];
+    return 1;
+}
+
 int LibShmMediaItemApplyBuffer(
     libshm_media_handle_t h
     , const libshm_media_item_param_t *pmi
@@ -0,0 +1,529 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+/******************************************************
+ *  Description:
+ *      synchronized reading of several shms by tvutimestamp.
+ *      every source keeps a cursor which only moves forward with the target,
+ *      so one polling usually checks one item of each source. the sources
+ *      still waiting sleep on one futex_waitv of all their wakeup words.
+******************************************************/
+
+#include "libshm_media_sync_group_internal.h"
+#include "libshm_time_internal.h"
+#include "libshm_tvu_timestamp.h"
+#include <errno.h>
+#include <inttypes.h>
+
+/* the searching keys of the vi ring index for seeking a cursor. */
+struct _SyncSeeking
+{
+    uint64_t    target;
+    int64_t     lowest;
+};
+
+static int _sync_item_index_cmp(void *ctx, const shm_item_index_entry_t *pentry)
+{
+    const struct _SyncSeeking *ps = (const struct _SyncSeeking *)ctx;
+    if (!LibshmutilTvutimestampValid(pentry->tvutimestamp))
+    {
+        /* stepped over, as the walking does. */
+        return -1;
+    }
+    return LibshmutilTvutimestampMinusWithMS(pentry->tvutimestamp, ps->target) < ps->lowest ? -1 : 1;
+}
+
+CLibShmMediaSyncGroup::CLibShmMediaSyncGroup(uint32_t tolerance_ms)
+{
+    m_uToleranceMs  = tolerance_ms;
+    m_u64Target     = TVU_TIMECODE_INVALID_VALUE;
+    m_nSources      = 0;
+}
+
+CLibShmMediaSyncGroup::~CLibShmMediaSyncGroup()
+{
+    m_nSources      = 0;
+}
+
+int CLibShmMediaSyncGroup::AddSource(libshm_media_handle_t h, bool bVi)
+{
+    if (!h)
+    {
+        return -EINVAL;
+    }
+
+    if (m_nSources >= LIBSHM_MEDIA_SYNC_GROUP_MAX_SOURCES)
+    {
+        return -ENOSPC;
+    }
+
+    Source &src = m_aSources[m_nSources];
+    src.bVi_ = bVi;
+    if (bVi)
+    {
+        CTvuVariableItemRingShmCtx *pctx = (CTvuVariableItemRingShmCtx *)h;
+        if (!pctx->GetShmObj()->HasItemIndex())
+        {
+            DEBUG_WARN_CR("vi shm[%s] was created without the item index, it could not be synchronized."
+                , pctx->GetName());
+            return -ENOTSUP;
+        }
+        src.pViCtx_ = pctx;
+        src.pCtx_ = NULL;
+        src.cursor_ = pctx->GetRIndex();
+    }
+    else
+    {
+        CLibShmMediaCtx *pctx = (CLibShmMediaCtx *)h;
+        src.pCtx_ = pctx;
+        src.pViCtx_ = NULL;
+        src.cursor_ = pctx->GetRIndex();
+    }
+
+    return m_nSources++;
+}
+
+int CLibShmMediaSyncGroup::SetTarget(uint64_t tvutimestamp)
+{
+    if (!LibshmutilTvutimestampValid(tvutimestamp))
+    {
+        return -EINVAL;
+    }
+    m_u64Target = tvutimestamp;
+    return 0;
+}
+
+int CLibShmMediaSyncGroup::_keyAtCursor(Source &src, uint64_t *ptvutimestamp)
+{
+    if (src.bVi_)
+    {
+        CTvuVariableItemBaseShm *pshm = src.pViCtx_->GetShmObj();
+        shm_item_index_entry_t entry;
+        uint64_t windex = pshm->GetWriteIndex();
+        uint64_t oldest = 0;
+
+        if (src.cursor_ == windex)
+        {
+            return 0;
+        }
+
+        /* the positions wrap, an old cursor may have the tag of a new item. */
+        if (pshm->IndexStepsBetween(src.cursor_, windex) > pshm->GetItemIndexWindow(&oldest)
+            || !pshm->ReadItemIndex(src.cursor_, &entry))
+        {
+            return -1;
+        }
+        *ptvutimestamp = entry.tvutimestamp;
+        return 1;
+    }
+
+    uint32_t windex = src.pCtx_->GetWIndex();
+    uint32_t cursor = (uint32_t)src.cursor_;
+
+    if (cursor == windex)
+    {
+        return 0;
+    }
+
+    if ((uint32_t)(windex - cursor) > src.pCtx_->GetItemCounts())
+    {
+        return -1;
+    }
+
+    const tvushm::ItemInfo &item = src.pCtx_->GetItemInfor(cursor);
+    *ptvutimestamp = item.HasGottenTvutimestamp(cursor) ? item.GetTvutimestamp() : TVU_TIMECODE_INVALID_VALUE;
+    return 1;
+}
+
+void CLibShmMediaSyncGroup::_stepCursor(Source &src)
+{
+    if (src.bVi_)
+    {
+        src.cursor_ = src.pViCtx_->GetShmObj()->NextIndexStep(src.cursor_);
+    }
+    else
+    {
+        src.cursor_ = (uint32_t)(src.cursor_ + 1);
+    }
+}
+
+void CLibShmMediaSyncGroup::_seekCursor(Source &src, int64_t lowest)
+{
+    if (src.bVi_)
+    {
+        CTvuVariableItemBaseShm *pshm = src.pViCtx_->GetShmObj();
+        struct _SyncSeeking obj;
+        shm_item_index_entry_t entry;
+        uint64_t pos = 0;
+
+        obj.target = m_u64Target;
+        obj.lowest = lowest;
+        if (pshm->SearchItemIndex(&obj, _sync_item_index_cmp, &pos, &entry))
+        {
+            src.cursor_ = pos;
+            return;
+        }
+
+        /* all items are before the target, or even the oldest one is not. */
+        if (pshm->GetItemIndexWindow(&pos)
+            && pshm->ReadItemIndex(pos, &entry)
+            && _sync_item_index_cmp(&obj, &entry) > 0)
+        {
+            src.cursor_ = pos;
+            return;
+        }
+        src.cursor_ = pshm->GetWriteIndex();
+        return;
+    }
+
+    uint32_t windex = src.pCtx_->GetWIndex();
+    uint32_t counts = src.pCtx_->GetItemCounts();
+    uint32_t left = (uint32_t)src.cursor_;
+    uint32_t right = windex;
+
+    if ((uint32_t)(windex - left) > counts - 1)
+    {
+        /* the slot of windex - counts is the one being written. */
+        left = windex < counts - 1 ? 0 : windex - (counts - 1);
+    }
+
+    /* first one not before the lowest in [left, right). */
+    while (left != right)
+    {
+        uint32_t mid = left + (right - left) / 2;
+        const tvushm::ItemInfo &item = src.pCtx_->GetItemInfor(mid);
+
+        if (!item.HasGottenTvutimestamp(mid)
+            || LibshmutilTvutimestampMinusWithMS(item.GetTvutimestamp(), m_u64Target) < lowest)
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid;
+        }
+    }
+    src.cursor_ = left;
+}
+
+int CLibShmMediaSyncGroup::_readAtCursor(Source &src, libshm_media_sync_frame_t *frame)
+{
+    int ret = 0;
+
+    if (src.bVi_)
+    {
+        shm_item_index_entry_t entry;
+        if (!src.pViCtx_->GetShmObj()->ReadItemIndex(src.cursor_, &entry))
+        {
+            return 0;
+        }
+        ret = src.pViCtx_->ReadItemAt(src.cursor_, &entry, &frame->o_head, &frame->o_item);
+    }
+    else
+    {
+        uint32_t cursor = (uint32_t)src.cursor_;
+        const tvushm::ItemInfo &item = src.pCtx_->GetItemInfor(cursor);
+        if (!item.IsReadingSuccess(cursor))
+        {
+            return 0;
+        }
+        frame->o_head = item.curHead_;
+        frame->o_item = item.curItem_;
+        ret = item.GetReadingRet();
+    }
+
+    if (ret > 0)
+    {
+        _stepCursor(src);
+        _syncReadIndex(src);
+    }
+    return ret;
+}
+
+void CLibShmMediaSyncGroup::_syncReadIndex(Source &src)
+{
+    if (src.bVi_)
+    {
+        src.pViCtx_->SeekReadIndex(src.cursor_);
+    }
+    else
+    {
+        src.pCtx_->SetRIndex((uint32_t)src.cursor_);
+    }
+}
+
+/**
+ * walk forward from the cursor, bisecting only when the cursor fell out of the
+ * ring or the target jumped over many items.
+ **/
+int CLibShmMediaSyncGroup::_checkSource(Source &src, libshm_media_sync_frame_t *frame, int64_t deadline)
+{
+    const int64_t tolerance = (int64_t)m_uToleranceMs;
+    int steps = 0;
+    int seeks = 0;
+
+    while (1)
+    {
+        uint64_t tvutimestamp = TVU_TIMECODE_INVALID_VALUE;
+        int ret = _keyAtCursor(src, &tvutimestamp);
+
+        if (ret < 0 || (ret > 0 && steps >= LIBSHM_MEDIA_SYNC_WALK_STEPS && !seeks))
+        {
+            if (seeks++ == 2)
+            {
+                /* the writer keeps overwriting what was found. */
+                break;
+            }
+            _seekCursor(src, -tolerance);
+            continue;
+        }
+
+        if (ret == 0)
+        {
+            break;
+        }
+
+        if (!LibshmutilTvutimestampValid(tvutimestamp))
+        {
+            _stepCursor(src);
+            steps++;
+            continue;
+        }
+
+        int64_t offset = LibshmutilTvutimestampMinusWithMS(tvutimestamp, m_u64Target);
+        frame->u64_tvutimestamp = tvutimestamp;
+        frame->i64_offset_ms = offset;
+
+        if (offset < -tolerance)
+        {
+            src.lastTvutimestamp_ = tvutimestamp;
+            _stepCursor(src);
+            steps++;
+            continue;
+        }
+
+        if (offset > tolerance)
+        {
+            _syncReadIndex(src);
+            return LIBSHM_MEDIA_SYNC_STATUS_MISSING;
+        }
+
+        if (_readAtCursor(src, frame) <= 0)
+        {
+            /**
+             * the payload wraps before the index slots do, the index of a vi item
+             * outlives its payload. step over it, the next ones are newer.
+             */
+            _stepCursor(src);
+            if (seeks++ == 2 || _libshm_get_sys_ms64() > deadline)
+            {
+                break;
+            }
+            continue;
+        }
+        src.lastTvutimestamp_ = tvutimestamp;
+        return LIBSHM_MEDIA_SYNC_STATUS_MATCHED;
+    }
+
+    _syncReadIndex(src);
+    if (LibshmutilTvutimestampValid(src.lastTvutimestamp_))
+    {
+        /* the target is before what the source has gone past. */
+        int64_t offset = LibshmutilTvutimestampMinusWithMS(src.lastTvutimestamp_, m_u64Target);
+        frame->u64_tvutimestamp = src.lastTvutimestamp_;
+        frame->i64_offset_ms = offset;
+        if (offset > tolerance)
+        {
+            return LIBSHM_MEDIA_SYNC_STATUS_MISSING;
+        }
+    }
+    return LIBSHM_MEDIA_SYNC_STATUS_LATE;
+}
+
+int CLibShmMediaSyncGroup::PollFrames(libshm_media_sync_frame_t *frames, int max, unsigned int timeout)
+{
+    bool    aResolved[LIBSHM_MEDIA_SYNC_GROUP_MAX_SOURCES];
+    int     matched = 0;
+    int     nPending = 0;
+    int64_t t1 = _libshm_get_sys_ms64();
+
+    if (!frames || max < m_nSources || !LibshmutilTvutimestampValid(m_u64Target))
+    {
+        return -EINVAL;
+    }
+
+    for (int i = 0; i < m_nSources; i++)
+    {
+        libshm_media_sync_frame_t &frame = frames[i];
+        frame.i_status = LIBSHM_MEDIA_SYNC_STATUS_LATE;
+        frame.i_reserved = 0;
+        frame.u64_tvutimestamp = TVU_TIMECODE_INVALID_VALUE;
+        frame.i64_offset_ms = 0;
+        LibShmMediaHeadParamInit(&frame.o_head, sizeof(frame.o_head));
+        LibShmMediaItemParamInit(&frame.o_item, sizeof(frame.o_item));
+        aResolved[i] = false;
+    }
+
+    while (1)
+    {
+        CTvuBaseShareMemory *aShms[LIBSHM_MEDIA_SYNC_GROUP_MAX_SOURCES];
+        uint32_t aSeqs[LIBSHM_MEDIA_SYNC_GROUP_MAX_SOURCES];
+        int     nWaiting = 0;
+
+        nPending = 0;
+
+        for (int i = 0; i < m_nSources; i++)
+        {
+            Source &src = m_aSources[i];
+            CTvuBaseShareMemory *pshm = src.bVi_ ? NULL : src.pCtx_->GetShmObj();
+            uint32_t seq = 0;
+
+            if (aResolved[i])
+            {
+                continue;
+            }
+
+            /* sampled before checking, a write after it breaks the sleeping. */
+            if (pshm && pshm->IsWakeupSupported())
+            {
+                seq = pshm->GetWakeupSeq();
+            }
+            else
+            {
+                pshm = NULL;
+            }
+
+            frames[i].i_status = _checkSource(src, &frames[i], t1 + timeout);
+            if (frames[i].i_status != LIBSHM_MEDIA_SYNC_STATUS_LATE)
+            {
+                aResolved[i] = true;
+                matched += (frames[i].i_status == LIBSHM_MEDIA_SYNC_STATUS_MATCHED) ? 1 : 0;
+                continue;
+            }
+
+            nPending++;
+            if (pshm)
+            {
+                aShms[nWaiting] = pshm;
+                aSeqs[nWaiting] = seq;
+                nWaiting++;
+            }
+        }
+
+        int64_t left = t1 + timeout - _libshm_get_sys_ms64();
+        if (!nPending || left <= 0)
+        {
+            break;
+        }
+
+        if (nWaiting != nPending)
+        {
+            /* the vi rings could only be polled. */
+            left = 1;
+        }
+
+        if (nWaiting)
+        {
+            CTvuBaseShareMemory::WaitForWriteAny(aShms, aSeqs, nWaiting, (unsigned int)left);
+        }
+        else
+        {
+            _libshm_common_msleep(1);
+        }
+    }
+
+    if (nPending)
+    {
+        /* timeout, the target stays to be polled again. */
+        return matched;
+    }
+
+    uint64_t next = LibshmutilTvutimestampMerge(
+        LibshmutilTvutimestampGetIndexValue(m_u64Target) + 1
+        , LibshmutilTvutimestampGetFpsValue(m_u64Target));
+    if (LibshmutilTvutimestampValid(next))
+    {
+        m_u64Target = next;
+    }
+
+    return matched;
+}
+
+libshm_media_sync_group_handle_t LibShmMediaSyncGroupCreate(uint32_t tolerance_ms)
+{
+    CLibShmMediaSyncGroup *pgrp = new CLibShmMediaSyncGroup(tolerance_ms);
+    return (libshm_media_sync_group_handle_t)pgrp;
+}
+
+void LibShmMediaSyncGroupDestroy(libshm_media_sync_group_handle_t g)
+{
+    CLibShmMediaSyncGroup *pgrp = (CLibShmMediaSyncGroup *)g;
+    if (pgrp)
+    {
+        delete pgrp;
+    }
+}
+
+int LibShmMediaSyncGroupAddSource(libshm_media_sync_group_handle_t g, libshm_media_handle_t h)
+{
+    CLibShmMediaSyncGroup *pgrp = (CLibShmMediaSyncGroup *)g;
+    if (!pgrp)
+    {
+        return -EINVAL;
+    }
+    return pgrp->AddSource(h, false);
+}
+
+int LibShmMediaSyncGroupAddViSource(libshm_media_sync_group_handle_t g, libshm_media_handle_t h)
+{
+    CLibShmMediaSyncGroup *pgrp = (CLibShmMediaSyncGroup *)g;
+    if (!pgrp)
+    {
+        return -EINVAL;
+    }
+    return pgrp->AddSource(h, true);
+}
+
+int LibShmMediaSyncGroupSetTarget(libshm_media_sync_group_handle_t g, uint64_t tvutimestamp)
+{
+    CLibShmMediaSyncGroup *pgrp = (CLibShmMediaSyncGroup *)g;
+    if (!pgrp)
+    {
+        return -EINVAL;
+    }
+    return pgrp->SetTarget(tvutimestamp);
+}
+
+uint64_t LibShmMediaSyncGroupGetTarget(libshm_media_sync_group_handle_t g)
+{
+    CLibShmMediaSyncGroup *pgrp = (CLibShmMediaSyncGroup *)g;
+    if (!pgrp)
+    {
+        return TVU_TIMECODE_INVALID_VALUE;
+    }
+    return pgrp->GetTarget();
+}
+
+int LibShmMediaSyncGroupPollFrames(
+    libshm_media_sync_group_handle_t g
+    , libshm_media_sync_frame_t *frames
+    , int max
+    , unsigned int timeout
+)
+{
+    CLibShmMediaSyncGroup *pgrp = (CLibShmMediaSyncGroup *)g;
+    if (!pgrp)
+    {
+        return -EINVAL;
+    }
+    return pgrp->PollFrames(frames, max, timeout);
+}
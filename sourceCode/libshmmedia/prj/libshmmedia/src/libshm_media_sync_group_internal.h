@@ -0,0 +1,90 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+/******************************************************************
+ *  Description:
+ *      synchronized reading group internal head files
+ *
+*******************************************************************/
+
+#ifndef _LIB_MEDIASHM_SYNC_GROUP_INTERNAL_H
+#define _LIB_MEDIASHM_SYNC_GROUP_INTERNAL_H
+
+#include <stdint.h>
+#include "libshm_media_sync_group.h"
+#include "libshm_media_internal.h"
+#include "libshm_media_variable_item_internal.h"
+#include "libshm_tvu_timestamp.h"
+
+/* items walked from the cursor of a source before falling back to bisecting. */
+#define LIBSHM_MEDIA_SYNC_WALK_STEPS    8
+
+class CLibShmMediaSyncGroup
+{
+public:
+    CLibShmMediaSyncGroup(uint32_t tolerance_ms);
+    ~CLibShmMediaSyncGroup();
+
+    int AddSource(libshm_media_handle_t h, bool bVi);
+    int SetTarget(uint64_t tvutimestamp);
+    uint64_t GetTarget()
+    {
+        return m_u64Target;
+    }
+    int PollFrames(libshm_media_sync_frame_t *frames, int max, unsigned int timeout);
+
+private:
+    /**
+     * the searching state of one source, the cursor is the next item to
+     * check, the item index of the constant ring or the position of the
+     * variable ring. it only moves forward with the target.
+     **/
+    class Source
+    {
+    public:
+        bool                        bVi_;
+        CLibShmMediaCtx             *pCtx_;
+        CTvuVariableItemRingShmCtx  *pViCtx_;
+        uint64_t                    cursor_;
+        uint64_t                    lastTvutimestamp_;  // of the last item the cursor went past.
+        Source()
+        {
+            bVi_ = false;
+            pCtx_ = NULL;
+            pViCtx_ = NULL;
+            cursor_ = 0;
+            lastTvutimestamp_ = TVU_TIMECODE_INVALID_VALUE;
+        }
+    };
+
+    /**
+     * 1  : the tvutimestamp of the cursor item, TVU_TIMECODE_INVALID_VALUE when it has none.
+     * 0  : the cursor is on the writing index.
+     * <0 : the cursor item was overwritten.
+     **/
+    int _keyAtCursor(Source &src, uint64_t *ptvutimestamp);
+    void _stepCursor(Source &src);
+    /* move the cursor to the first item not before @lowest ms of the target. */
+    void _seekCursor(Source &src, int64_t lowest);
+    /* read out the cursor item and step over it, <=0 when it was overwritten. */
+    int _readAtCursor(Source &src, libshm_media_sync_frame_t *frame);
+    void _syncReadIndex(Source &src);
+    /* @deadline, the ms of _libshm_get_sys_ms64 to give up searching by. */
+    int _checkSource(Source &src, libshm_media_sync_frame_t *frame, int64_t deadline);
+
+    uint32_t                m_uToleranceMs;
+    uint64_t                m_u64Target;
+    int                     m_nSources;
+    Source                  m_aSources[LIBSHM_MEDIA_SYNC_GROUP_MAX_SOURCES];
+};
+
+#endif
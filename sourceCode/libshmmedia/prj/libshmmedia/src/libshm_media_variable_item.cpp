@@ -25,6 +25,7 @@
 #include "libshm_media_protocol_internal.h"
 #include "libshm_media_key_value_proto_internal.h"
 #include "libshm_time_internal.h"
+#include "libshm_tvu_timestamp.h"
 #include <stddef.h>
 #include <errno.h>
 #include <assert.h>
@@ -129,6 +130,31 @@ int CTvuVariableItemRingShmCtx::CreateShmEntry(
     , const uint64_t total_size
     , mode_t mode
 )
+{
+    return CreateShmEntry(pMemoryName, _header_len, item_count, total_size, mode, 0);
+}
+
+int CTvuVariableItemRingShmCtx::CreateShmEntry(
+    const char * pMemoryName
+    , const uint32_t _header_len
+    , const uint32_t item_count
+    , const uint64_t total_size
+    , mode_t mode
+    , uint32_t flags
+)
+{
+    return CreateShmEntry(pMemoryName, _header_len, item_count, total_size, mode, flags, LIBSHM_MEDIA_NUMA_NODE_NONE);
+}
+
+int CTvuVariableItemRingShmCtx::CreateShmEntry(
+    const char * pMemoryName
+    , const uint32_t _header_len
+    , const uint32_t item_count
+    , const uint64_t total_size
+    , mode_t mode
+    , uint32_t flags
+    , int numa_node
+)
 {
     CTvuVariableItemBaseShm    *pshm   = NULL;
     uint32_t        ver     = 0;
@@ -166,6 +192,25 @@ int CTvuVariableItemRingShmCtx::CreateShmEntry(
     }
     header_len = _LISHMMEDIA_MEM_ALIGN(header_len, 16);/* multiple by 16 */
 
+    pshm->SetHugePage((flags & LIBSHM_MEDIA_CREATE_FLAG_HUGEPAGE) ? true : false);
+    pshm->SetPrefault((flags & LIBSHM_MEDIA_CREATE_FLAG_PREFAULT) ? true : false
+        , (flags & LIBSHM_MEDIA_CREATE_FLAG_MLOCK) ? true : false);
+    pshm->SetNumaNode(numa_node);
+    pshm->SetLossless((flags & LIBSHM_MEDIA_CREATE_FLAG_LOSSLESS) ? true : false);
+    pshm->SetItemIndex((flags & LIBSHM_MEDIA_CREATE_FLAG_ITEM_INDEX) ? true : false);
+    if (flags & LIBSHM_MEDIA_CREATE_FLAG_ALIGN_2M)
+    {
+        pshm->SetPayloadAlignment(2 * 1024 * 1024);
+    }
+    else if (flags & LIBSHM_MEDIA_CREATE_FLAG_ALIGN_4K)
+    {
+        pshm->SetPayloadAlignment(4096);
+    }
+    else if (flags & LIBSHM_MEDIA_CREATE_FLAG_ALIGN_64)
+    {
+        pshm->SetPayloadAlignment(64);
+    }
+
     if (!pshm->CreateOrOpen(pMemoryName, header_len, item_count, shm_total_size, mode))
     {
         DEBUG_ERROR("vi shm creating failed.name=>%s, head len=>%d, "
@@ -211,6 +256,7 @@ int CTvuVariableItemRingShmCtx::CreateShmEntry(
 
     m_uVersion      = ver;
     m_pShmObj       = pshm;
+    m_uVideoAlign   = (uint32_t)pshm->GetPayloadAlignment();
     return  0;
 
 FAILED:
@@ -226,6 +272,11 @@ FAILED:
 }
 
 int CTvuVariableItemRingShmCtx::OpenShmEntry(const char * pMemoryName, libshm_media_readcb_t cb, void *opaq)
+{
+    return OpenShmEntry(pMemoryName, cb, opaq, 0);
+}
+
+int CTvuVariableItemRingShmCtx::OpenShmEntry(const char * pMemoryName, libshm_media_readcb_t cb, void *opaq, uint32_t flags)
 {
     CTvuVariableItemBaseShm    *pshm   = NULL;
     uint32_t        ver     = 0;
@@ -238,6 +289,10 @@ int CTvuVariableItemRingShmCtx::OpenShmEntry(const char * pMemoryName, libshm_me
         goto FAILED;
     }
 
+    pshm->SetPrefault((flags & LIBSHM_MEDIA_OPEN_FLAG_PREFAULT) ? true : false
+        , (flags & LIBSHM_MEDIA_OPEN_FLAG_MLOCK) ? true : false);
+    pshm->SetMonitor((flags & LIBSHM_MEDIA_OPEN_FLAG_MONITOR) ? true : false);
+
     if (!pshm->Open(pMemoryName))
     {
         DEBUG_ERROR("sharemeory[name=>%s] open failed\n", pMemoryName);
@@ -264,7 +319,7 @@ FAILED:
 
 void CTvuVariableItemRingShmCtx::SetCloseFlag(bool bclose)
 {
-    if (!m_pShmObj)
+    if (!m_pShmObj || m_pShmObj->IsMonitor())
         return;
     libshmmediapro::setCloseFlag(m_pShmObj->GetHeader(), bclose);
     return;
@@ -499,6 +554,11 @@ int CTvuVariableItemRingShmCtx::_sendV3Data(const libshm_media_head_param_t *pmh
         return 0;
     }
 
+    if (m_pShmObj->IsWriteBlocked(size))
+    {
+        return -EAGAIN;
+    }
+
     pItemAddr = m_pShmObj->GetWriteItemAddr(size);
 
     if (!pItemAddr)
@@ -650,6 +710,7 @@ int CTvuVariableItemRingShmCtx::_sendV3Data(const libshm_media_head_param_t *pmh
 
 int CTvuVariableItemRingShmCtx::_sendV4Data(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmiv)
 {
+    LIBSHM_TRACE_SCOPE(vi_send_v4_data);
     const libshm_media_item_param_v1_t *pmi = (const libshm_media_item_param_v1_t *)pmiv;
     int         item_head_len = 0;
     uint8_t     *pItemAddr = NULL;
@@ -660,7 +721,10 @@ int CTvuVariableItemRingShmCtx::_sendV4Data(const libshm_media_head_param_t *pmh
     tvushm::BufferController_t tmpBuf;
     int  nout = 0;
     const uint8_t* pout = NULL;
-    tvushm::keyValueProtoAppendToBuffer(tmpBuf, hChannel);
+    {
+        LIBSHM_TRACE_SCOPE(vi_channel_layout_proto);
+        tvushm::keyValueProtoAppendToBuffer(tmpBuf, hChannel);
+    }
     pout = tmpBuf.GetOrigPtr();
     nout = tmpBuf.GetBufLength();
     libshm_media_item_param_internal_t rii;
@@ -668,6 +732,8 @@ int CTvuVariableItemRingShmCtx::_sendV4Data(const libshm_media_head_param_t *pmh
         memset(&rii, 0, sizeof(rii));
         rii.nKeyValueSize_ = nout;
         rii.pKeyValuePtr_ = pout;
+        rii.fnCopy_ = m_fnCopy;
+        rii.nVideoAlign_ = m_uVideoAlign;
     }
 
     item_head_len   = sizeof(shm_media_item_info_v4_t);
@@ -689,7 +755,13 @@ int CTvuVariableItemRingShmCtx::_sendV4Data(const libshm_media_head_param_t *pmh
         return 0;
     }
 
-    size += libshmmediapro::preRequireItemHeadLength(LIBSHM_MEDIA_HEAD_VERSION_V4);
+    size += libshmmediapro::preRequireItemHeadLength(LIBSHM_MEDIA_HEAD_VERSION_V4)
+        + libshmmediapro::preRequireVideoAlignLength(m_uVideoAlign);
+
+    if (m_pShmObj->IsWriteBlocked(size))
+    {
+        return -EAGAIN;
+    }
 
     pItemAddr = m_pShmObj->GetWriteItemAddr(size);
 
@@ -710,6 +782,13 @@ int CTvuVariableItemRingShmCtx::_sendV4Data(const libshm_media_head_param_t *pmh
     }
 
     w_len = _writeV4Buffer(pmh, pmiv, rii, pItemAddr);
+    if (w_len <= 0)
+    {
+        /* the space applied is not committed, readers never see it. */
+        DEBUG_ERROR("shm[%s] write item failed, ret:%d\n", m_pShmObj->GetName(), w_len);
+        return w_len < 0 ? w_len : -EINVAL;
+    }
+    _updateItemIndex(0, pmiv);
 
     bool bcommit = m_pShmObj->FinishWrite((const void *)pItemAddr, size);
 
@@ -718,9 +797,153 @@ int CTvuVariableItemRingShmCtx::_sendV4Data(const libshm_media_head_param_t *pmh
     return ret;
 }
 
+/**
+ *  all the items are encoded into one reserved space, and published by one
+ *  index update, readers see all of them or none.
+ */
+int CTvuVariableItemRingShmCtx::_sendV4DataBatch(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmiv, int counts)
+{
+    size_t      sizes[LIBVISHM_MEDIA_BATCH_MAX];
+    size_t      total = 0;
+    uint8_t     *pItemAddr = NULL;
+
+    const libshmmedia_audio_channel_layout_object_t *hChannel = libshmmediapro::_headParamGetChannelLayout(*pmh);
+    tvushm::BufferController_t tmpBuf;
+    int  nout = 0;
+    const uint8_t* pout = NULL;
+    tvushm::keyValueProtoAppendToBuffer(tmpBuf, hChannel);
+    pout = tmpBuf.GetOrigPtr();
+    nout = tmpBuf.GetBufLength();
+    libshm_media_item_param_internal_t rii;
+    {
+        memset(&rii, 0, sizeof(rii));
+        rii.nKeyValueSize_ = nout;
+        rii.pKeyValuePtr_ = pout;
+        rii.fnCopy_ = m_fnCopy;
+        rii.nVideoAlign_ = m_uVideoAlign;
+    }
+
+    for (int i = 0; i < counts; i++)
+    {
+        const libshm_media_item_param_v1_t *pmi = (const libshm_media_item_param_v1_t *)(pmiv + i);
+        int size = pmi->i_vLen + pmi->i_aLen + pmi->i_sLen + pmi->i_CCLen + pmi->i_timeCode + pmi->i_userDataLen + nout;
+
+        if (size <= 0)
+        {
+            DEBUG_ERROR("shm[%s] batch item %d require size %d invalid\n"
+                , m_pShmObj->GetName(), i, size);
+            return -EINVAL;
+        }
+
+        sizes[i] = size + libshmmediapro::preRequireItemHeadLength(LIBSHM_MEDIA_HEAD_VERSION_V4)
+            + libshmmediapro::preRequireVideoAlignLength(m_uVideoAlign);
+        total += (i + 1 < counts) ? CTvuVariableItemBaseShm::GetBatchItemSpan(sizes[i]) : sizes[i];
+    }
+
+    if (m_pShmObj->IsWriteBlocked(total, counts))
+    {
+        return -EAGAIN;
+    }
+
+    pItemAddr = m_pShmObj->GetWriteItemsAddr(total, counts);
+
+    if (!pItemAddr)
+    {
+        DEBUG_ERROR("shm[%s] require batch {counts[%d], size[%u]} failed, can not write\n"
+            , m_pShmObj->GetName(), counts, (unsigned int)total);
+        return 0;
+    }
+
+    size_t offset = 0;
+    for (int i = 0; i < counts; i++)
+    {
+        int w_len = _writeV4Buffer(pmh, pmiv + i, rii, pItemAddr + offset);
+        if (w_len <= 0)
+        {
+            /* none of the batch is committed, readers never see it. */
+            DEBUG_ERROR("shm[%s] write batch item %d failed, ret:%d\n", m_pShmObj->GetName(), i, w_len);
+            return w_len < 0 ? w_len : -EINVAL;
+        }
+        _updateItemIndex(i, pmiv + i);
+        offset += CTvuVariableItemBaseShm::GetBatchItemSpan(sizes[i]);
+    }
+
+    bool bcommit = m_pShmObj->FinishWriteBatch((const void *)pItemAddr, sizes, counts);
+
+    return bcommit ? counts : 0;
+}
+
+int CTvuVariableItemRingShmCtx::SetCopyMode(int mode)
+{
+    switch (mode)
+    {
+    case LIBSHM_MEDIA_COPY_MODE_DEFAULT:
+        m_fnCopy = NULL;
+        break;
+    case LIBSHM_MEDIA_COPY_MODE_STREAMING:
+        m_fnCopy = tvushm::MemcpyStreaming;
+        break;
+    default:
+        DEBUG_ERROR("copy mode %d invalid\n", mode);
+        return -EINVAL;
+    }
+    return 0;
+}
+
+int CTvuVariableItemRingShmCtx::Acquire(libshm_media_head_param_t *pmh, libshm_media_item_param_t *pmi, int *please)
+{
+    if (!pmh || !pmi || !please)
+    {
+        return -EINVAL;
+    }
+
+    if (!m_pShmObj->HasLeases())
+    {
+        DEBUG_WARN("vi shm %s was created without leases\n", m_pShmObj->GetName());
+        return -ENOTSUP;
+    }
+
+    if (m_pShmObj->IsMonitor())
+    {
+        return -EPERM;
+    }
+
+    int ret = PollReadDataWithoutIndexStep(pmh, pmi, 0);
+    if (ret <= 0)
+    {
+        return ret;
+    }
+
+    int lease = m_pShmObj->AcquireLease(pmi->u_read_index);
+    if (lease < 0)
+    {
+        DEBUG_WARN("vi shm %s lease of item %" PRIu64 " failed %d\n", m_pShmObj->GetName(), pmi->u_read_index, lease);
+        if (lease == -ENOSPC)
+        {
+            //left unread for the next acquiring;
+            m_pShmObj->SeekReadIndex(pmi->u_read_index);
+        }
+        return lease;
+    }
+
+    *please = lease;
+    return ret;
+}
+
+int CTvuVariableItemRingShmCtx::Release(int lease)
+{
+    return m_pShmObj->ReleaseLease(lease);
+}
+
+int CTvuVariableItemRingShmCtx::CheckLease(int lease)
+{
+    return m_pShmObj->CheckLease(lease);
+}
+
 int CTvuVariableItemRingShmCtx::_writeV4Buffer(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmi
                                                , const libshm_media_item_param_internal_t &rii, uint8_t *pItemAddr)
 {
+    LIBSHM_TRACE_SCOPE(vi_write_item_v4);
     return libshmmediapro::writeItemBufferV4(pmh, pmi, rii, pItemAddr);
 }
 
@@ -739,18 +962,37 @@ uint8_t *CTvuVariableItemRingShmCtx::_applyV4Buffer(unsigned int nlen)
     return pItemAddr;
 }
 
-bool CTvuVariableItemRingShmCtx::_commitV4Buffer(uint8_t *pItemAddr, unsigned int nlen)
+bool CTvuVariableItemRingShmCtx::_commitV4Buffer(uint8_t *pItemAddr, unsigned int nlen, uint64_t tvutimestamp, uint64_t pts)
 {
     int size = nlen;
 
     size += libshmmediapro::preRequireItemHeadLength(LIBSHM_MEDIA_HEAD_VERSION_V4);
 
+    if (m_pShmObj->HasItemIndex())
+    {
+        /* the user encoded the item, the keys are the user's, it is not parsed back. */
+        m_pShmObj->UpdateItemIndex(0, tvutimestamp, pts);
+    }
+
     return m_pShmObj->FinishWrite((const void *)pItemAddr, size);
 }
 
 int CTvuVariableItemRingShmCtx::SendData(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmi)
 {
+    LIBSHM_TRACE_SCOPE(vi_send_data);
     int         w_len       = 0;
+    int         nplanes     = libshmmediapro::checkItemVideoPlanes(pmi);
+
+    if (nplanes < 0)
+    {
+        return nplanes;
+    }
+
+    if (nplanes > 0 && m_uVersion != LIBSHM_MEDIA_HEAD_VERSION_V4)
+    {
+        DEBUG_ERROR("shm[%s] version %u, video planes need V4\n", m_pShmObj->GetName(), m_uVersion);
+        return -ENOTSUP;
+    }
 
     SendHead(pmh);
 
@@ -777,6 +1019,67 @@ int CTvuVariableItemRingShmCtx::SendData(const libshm_media_head_param_t *pmh, c
     return w_len;
 }
 
+int CTvuVariableItemRingShmCtx::SendDataBatch(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmi, int counts)
+{
+    int         w_len       = 0;
+
+    if (counts == 0)
+    {
+        return 0;
+    }
+
+    if (!pmh || !pmi || counts < 0 || counts > LIBVISHM_MEDIA_BATCH_MAX)
+    {
+        DEBUG_ERROR("invalid batch parameters, counts:%d", counts);
+        return -EINVAL;
+    }
+
+    for (int i = 0; i < counts; i++)
+    {
+        int nplanes = libshmmediapro::checkItemVideoPlanes(pmi + i);
+        if (nplanes < 0)
+        {
+            return nplanes;
+        }
+        if (nplanes > 0 && m_uVersion != LIBSHM_MEDIA_HEAD_VERSION_V4)
+        {
+            DEBUG_ERROR("shm[%s] version %u, video planes need V4\n", m_pShmObj->GetName(), m_uVersion);
+            return -ENOTSUP;
+        }
+    }
+
+    SendHead(pmh);
+
+    switch (m_uVersion)
+    {
+    case LIBSHM_MEDIA_HEAD_VERSION_V3:
+        {
+            /* old layout, item by item. */
+            for (; w_len < counts; w_len++)
+            {
+                if (_sendV3Data(pmh, pmi + w_len) <= 0)
+                {
+                    break;
+                }
+            }
+        }
+        break;
+    case LIBSHM_MEDIA_HEAD_VERSION_V4:
+        {
+            w_len = _sendV4DataBatch(pmh, pmi, counts);
+        }
+        break;
+    default:
+        {
+            w_len   = -1;
+            DEBUG_ERROR("unsupport version %d\n", m_uVersion);
+        }
+        break;
+    }
+
+    return w_len;
+}
+
 int CTvuVariableItemRingShmCtx::SendDataWithFrequency1000(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmi)
 {
 #if !defined(TVU_WINDOWS)
@@ -799,6 +1102,7 @@ int CTvuVariableItemRingShmCtx::SendDataWithFrequency1000(const libshm_media_hea
 
 uint8_t *CTvuVariableItemRingShmCtx::applyBuffer(unsigned int nlen)
 {
+    LIBSHM_TRACE_SCOPE(vi_apply_buffer);
     uint8_t *buf = NULL;
 
     switch (m_uVersion)
@@ -823,8 +1127,9 @@ uint8_t *CTvuVariableItemRingShmCtx::applyBuffer(unsigned int nlen)
     return buf;
 }
 
-bool CTvuVariableItemRingShmCtx::commitBuffer(uint8_t *pItemAddr, unsigned int size)
+bool CTvuVariableItemRingShmCtx::commitBuffer(uint8_t *pItemAddr, unsigned int size, uint64_t tvutimestamp, uint64_t pts)
 {
+    LIBSHM_TRACE_SCOPE(vi_commit_buffer);
     bool bret = false;
 
     switch (m_uVersion)
@@ -836,7 +1141,7 @@ bool CTvuVariableItemRingShmCtx::commitBuffer(uint8_t *pItemAddr, unsigned int s
         break;
     case LIBSHM_MEDIA_HEAD_VERSION_V4:
         {
-            bret = _commitV4Buffer(pItemAddr, size);
+            bret = _commitV4Buffer(pItemAddr, size, tvutimestamp, pts);
         }
         break;
     default:
@@ -876,6 +1181,7 @@ int CTvuVariableItemRingShmCtx::PollReadRawData(libshmmedia_raw_head_param_t *pm
 
 uint8_t *CTvuVariableItemRingShmCtx::applyRawData(size_t len)
 {
+    LIBSHM_TRACE_SCOPE(vi_apply_raw_data);
     if (!IsCreator())
     {
         return NULL;
@@ -886,6 +1192,7 @@ uint8_t *CTvuVariableItemRingShmCtx::applyRawData(size_t len)
 
 int CTvuVariableItemRingShmCtx::commitRawData(const uint8_t *buf, size_t s)
 {
+    LIBSHM_TRACE_SCOPE(vi_commit_raw_data);
     bool b = m_pShmObj->FinishWrite((const void *)buf, s);
     return b?s:0;
 }
@@ -957,7 +1264,7 @@ int CTvuVariableItemRingShmCtx::PollReadHead(libshm_media_head_param_t *pmh, uin
     uint8_t         *pItemAddr = NULL;
     libshm_media_item_param_t   oip;
     {
-        memset((void*)&oip, 0, sizeof(libshm_media_item_param_t));
+        LibShmMediaItemParamInit(&oip, sizeof(oip));
     }
     libshm_media_head_param_t   ohp;
     {
@@ -985,16 +1292,31 @@ int CTvuVariableItemRingShmCtx::PollReadHead(libshm_media_head_param_t *pmh, uin
     return ret;
 }
 
+int CTvuVariableItemRingShmCtx::PeekLatestHead(libshm_media_head_param_t *pmh)
+{
+    size_t          itemsize = 0;
+    uint8_t         *pItemAddr = m_pShmObj->PeekLatestItemAddr(&itemsize);
+
+    if (!pItemAddr || !itemsize)
+    {
+        return 0;
+    }
+
+    unsigned int item_len = libshmmediapro::getBufferLenFromItemBuffer(pItemAddr, m_uVersion);
+    return libshmmediapro::readHeadFromItemBuffer(pmh, pItemAddr, item_len);
+}
+
 #ifdef _LIBSHMMEDIA_PROTOCOL_APIS_DONE
 
 int CTvuVariableItemRingShmCtx::PollReadDataWithoutIndexStep(libshm_media_head_param_t *pmh, libshm_media_item_param_t   *pmi, uint32_t timeout)
 {
+    LIBSHM_TRACE_SCOPE(vi_poll_read_data);
     size_t         itemsize = 0;
     uint8_t     *pItemAddr = NULL;
     int         r_len       = -1;
     libshm_media_item_param_t   oip;
     {
-        memset((void*)&oip, 0, sizeof(libshm_media_item_param_t));
+        LibShmMediaItemParamInit(&oip, sizeof(oip));
     }
     libshm_media_head_param_t   ohp;
     {
@@ -1017,29 +1339,109 @@ int CTvuVariableItemRingShmCtx::PollReadDataWithoutIndexStep(libshm_media_head_p
         return 0;
     }
 
-    unsigned int buffer_len = libshmmediapro::getBufferLenFromItemBuffer(pItemAddr, m_uVersion);
+    {
+        LIBSHM_TRACE_SCOPE(vi_read_item_buffer);
+        unsigned int buffer_len = libshmmediapro::getBufferLenFromItemBuffer(pItemAddr, m_uVersion);
 
-    r_len = libshmmediapro::readDataFromItemBuffer(&ohp, &oip, pItemAddr, buffer_len);
+        r_len = libshmmediapro::readDataFromItemBuffer(&ohp, &oip, pItemAddr, buffer_len);
+        LIBSHM_TRACE_ARG(vi_read_item_buffer, r_len);
+    }
 
     if (r_len > 0)
     {
         oip.u_read_index = read_index;
+        {
+            LIBSHM_TRACE_SCOPE(vi_head_compare);
+            if (_media_head_cmp(pmh, &ohp))
+            {
+                *pmh    = ohp;
+                //return -1;
+            }
+        }
+
+        libshmmediapro::_itemParamLowCopy(*pmi, oip);
+        if (m_fnReadCb) {
+            ret   = m_fnReadCb(m_pOpaq, &oip);
+            if (ret < 0) {
+                DEBUG_ERROR("read callback return %d invalid", ret);
+            }
+        }
+    }
+
+    return r_len;
+}
+
+/**
+ *  all ready items are read out of the ring under one readable check,
+ *  the ring publishes the reader cursor once for them.
+ */
+int CTvuVariableItemRingShmCtx::PollReadDataBatch(libshm_media_head_param_t *pmh, libshm_media_item_param_t   *pmi, int max, uint32_t timeout)
+{
+    uint8_t     *pItemAddrs[LIBVISHM_MEDIA_BATCH_MAX];
+    size_t      itemsizes[LIBVISHM_MEDIA_BATCH_MAX];
+    libshm_media_head_param_t   ohp;
+    uint64_t    read_index = 0;
+    int         n = 0;
+
+    if (!pmh || !pmi || max <= 0)
+    {
+        DEBUG_ERROR("invalid batch parameters, max:%d", max);
+        return -EINVAL;
+    }
+
+    if (max > LIBVISHM_MEDIA_BATCH_MAX)
+    {
+        max = LIBVISHM_MEDIA_BATCH_MAX;
+    }
+
+    int         ret     = PollReadable(timeout);
+
+    if (ret <= 0) {
+        return ret;
+    }
+
+    read_index = m_pShmObj->GetReadIndex();
+    int counts = m_pShmObj->GetReadItemAddrBatch(pItemAddrs, itemsizes, max);
+
+    for (int i = 0; i < counts; i++)
+    {
+        uint8_t     *pItemAddr = pItemAddrs[i];
+        libshm_media_item_param_t   oip;
+
+        if (!pItemAddr || !itemsizes[i])
+        {
+            continue;
+        }
+
+        LibShmMediaItemParamInit(&oip, sizeof(oip));
+        memset((void*)&ohp, 0, sizeof(libshm_media_head_param_t));
+
+        unsigned int buffer_len = libshmmediapro::getBufferLenFromItemBuffer(pItemAddr, m_uVersion);
+        int r_len = libshmmediapro::readDataFromItemBuffer(&ohp, &oip, pItemAddr, buffer_len);
+
+        if (r_len <= 0)
+        {
+            DEBUG_WARN("parse batch item failed, ret:%d\n", r_len);
+            continue;
+        }
+
+        oip.u_read_index = read_index + i;
         if (_media_head_cmp(pmh, &ohp))
         {
             *pmh    = ohp;
-            //return -1;
         }
 
-        *pmi = oip;
+        libshmmediapro::_itemParamLowCopy(pmi[n], oip);
         if (m_fnReadCb) {
             ret   = m_fnReadCb(m_pOpaq, &oip);
             if (ret < 0) {
                 DEBUG_ERROR("read callback return %d invalid", ret);
             }
         }
+        n++;
     }
 
-    return r_len;
+    return n;
 }
 
 #else
@@ -1207,7 +1609,7 @@ int CTvuVariableItemRingShmCtx::PollReadDataWithoutIndexStep(libshm_media_head_p
     int         r_len       = -1;
     libshm_media_item_param_t   oip;
     {
-        memset((void*)&oip, 0, sizeof(libshm_media_item_param_t));
+        LibShmMediaItemParamInit(&oip, sizeof(oip));
     }
     libshm_media_head_param_t   ohp;
     {
@@ -1261,7 +1663,7 @@ int CTvuVariableItemRingShmCtx::PollReadDataWithoutIndexStep(libshm_media_head_p
         break;
     }
 
-    *pmi    = oip;
+    libshmmediapro::_itemParamLowCopy(*pmi, oip);
     return r_len;
 }
 
@@ -1291,7 +1693,7 @@ int CTvuVariableItemRingShmCtx::IsTheSearchingItem(const void *buf, size_t nbuf,
     int         r_len       = -1;
     libshm_media_item_param_t   oip;
     {
-        memset((void*)&oip, 0, sizeof(libshm_media_item_param_t));
+        LibShmMediaItemParamInit(&oip, sizeof(oip));
     }
     libshm_media_head_param_t   ohp;
     {
@@ -1344,8 +1746,185 @@ static int _item_valid_checking(void *ctx, const void *buf, size_t n, uint64_t p
     return ret;
 }
 
+void CTvuVariableItemRingShmCtx::_getItemIndexKeys(const libshm_media_item_param_t *pmi, uint64_t *ptvutimestamp, uint64_t *ppts)
+{
+    libshmmedia_extend_data_info_t ext;
+
+    *ppts = LibShmMediaItemParamGetPts((libshm_media_item_param_t *)pmi, 0);
+    *ptvutimestamp = TVU_TIMECODE_INVALID_VALUE;
+
+    if (pmi->p_userData && pmi->i_userDataLen > 0)
+    {
+        memset((void *)&ext, 0, sizeof(ext));
+        if (LibShmMeidaParseExtendData(&ext, pmi->p_userData, pmi->i_userDataLen, pmi->i_userDataType) >= 0
+            && ext.bGotTvutimestamp)
+        {
+            *ptvutimestamp = ext.u64Tvutimestamp;
+        }
+    }
+}
+
+void CTvuVariableItemRingShmCtx::_updateItemIndex(size_t nth, const libshm_media_item_param_t *pmi)
+{
+    uint64_t tvutimestamp = 0;
+    uint64_t pts = 0;
+
+    if (!m_pShmObj->HasItemIndex())
+    {
+        return;
+    }
+
+    _getItemIndexKeys(pmi, &tvutimestamp, &pts);
+    m_pShmObj->UpdateItemIndex(nth, tvutimestamp, pts);
+}
+
+struct _ItemIndexSearching
+{
+    uint64_t value;
+};
+
+static int _item_index_tvutimestamp_cmp(void *ctx, const shm_item_index_entry_t *pentry)
+{
+    const struct _ItemIndexSearching *ps = (const struct _ItemIndexSearching *)ctx;
+    if (pentry->tvutimestamp == SHM_ITEM_INDEX_KEY_NONE)
+    {
+        return CTvuVariableItemBaseShm::kItemIndexCmpNoKey;
+    }
+    return LibshmutilTvutimestampCompare(pentry->tvutimestamp, ps->value);
+}
+
+static int _item_index_pts_cmp(void *ctx, const shm_item_index_entry_t *pentry)
+{
+    const struct _ItemIndexSearching *ps = (const struct _ItemIndexSearching *)ctx;
+    if (pentry->pts == SHM_ITEM_INDEX_KEY_NONE)
+    {
+        return CTvuVariableItemBaseShm::kItemIndexCmpNoKey;
+    }
+    return pentry->pts < ps->value ? -1 : (pentry->pts > ps->value ? 1 : 0);
+}
+
+int CTvuVariableItemRingShmCtx::ReadItemAt(
+    uint64_t pos
+    , const shm_item_index_entry_t *pentry
+    , libshm_media_head_param_t *pmh
+    , libshm_media_item_param_t *pmi
+)
+{
+    size_t   itemsize = 0;
+    unsigned int buffer_len = 0;
+    uint8_t  *pItemAddr = NULL;
+    int      r_len = 0;
+    libshm_media_head_param_t   ohp;
+    libshm_media_item_param_t   oip;
+    uint64_t tvutimestamp = 0;
+    uint64_t pts = 0;
+
+    pItemAddr = m_pShmObj->GetItemAddrByPos(pos, &itemsize);
+    if (!pItemAddr || !itemsize)
+    {
+        return 0;
+    }
+
+    memset((void*)&ohp, 0, sizeof(ohp));
+    LibShmMediaItemParamInit(&oip, sizeof(oip));
+    buffer_len = libshmmediapro::getBufferLenFromItemBuffer(pItemAddr, m_uVersion);
+    if (buffer_len <= itemsize)
+    {
+        r_len = libshmmediapro::readDataFromItemBuffer(&ohp, &oip, pItemAddr, buffer_len);
+    }
+    if (r_len > 0)
+    {
+        _getItemIndexKeys(&oip, &tvutimestamp, &pts);
+    }
+
+    if (r_len <= 0 || tvutimestamp != pentry->tvutimestamp || pts != pentry->pts)
+    {
+        return 0;
+    }
+
+    oip.u_read_index = pos;
+    if (pmh)
+    {
+        *pmh = ohp;
+    }
+    if (pmi)
+    {
+        libshmmediapro::_itemParamLowCopy(*pmi, oip);
+    }
+    return r_len;
+}
+
+/**
+ *  the index points out the item, it is read and its keys are checked again,
+ *  the payload of an old item could have been overwritten by the newer ones.
+ */
+int CTvuVariableItemRingShmCtx::_searchItemWithIndex(
+    char type
+    , uint64_t value
+    , libshm_media_head_param_t *pmh
+    , libshm_media_item_param_t *pmi
+)
+{
+    LIBSHM_TRACE_SCOPE(vi_search_item_index);
+    struct _ItemIndexSearching obj;
+    tvu_variableitem_base_shm_item_index_cmp_fn_t fn = (type == 't') ? _item_index_tvutimestamp_cmp : _item_index_pts_cmp;
+    uint64_t pos = 0;
+    shm_item_index_entry_t entry;
+    int      r_len = 0;
+    int64_t  beginTime = _libshm_get_sys_us64();
+
+    if (!m_pShmObj->HasItemIndex())
+    {
+        DEBUG_WARN("vi shm[%s] was created without the item index\n", m_pShmObj->GetName());
+        return -ENOTSUP;
+    }
+
+    obj.value = value;
+    if (!m_pShmObj->SearchItemIndex(&obj, fn, &pos, &entry))
+    {
+        DEBUG_WARN("vi shm[%s] did not find the item of %c 0x%" PRIx64 "\n", m_pShmObj->GetName(), type, value);
+        m_pShmObj->SeekReadIndex2WriteIndex();
+        return 0;
+    }
+
+    r_len = ReadItemAt(pos, &entry, pmh, pmi);
+    if (r_len <= 0)
+    {
+        DEBUG_WARN("vi shm[%s] item %" PRIu64 " of %c 0x%" PRIx64 " was overwritten\n"
+            , m_pShmObj->GetName(), pos, type, value);
+        m_pShmObj->SeekReadIndex2WriteIndex();
+        return 0;
+    }
+
+    m_pShmObj->SeekReadIndex(pos);
+
+    DEBUG_INFO("vi shm[%s] found item %" PRIu64 " of %c 0x%" PRIx64 ", tm:%" PRId64 "us\n"
+        , m_pShmObj->GetName(), pos, type, value, _libshm_get_sys_us64() - beginTime);
+    return r_len;
+}
+
+int CTvuVariableItemRingShmCtx::SearchItemWithTvutimestamp(uint64_t tvutimestamp, libshm_media_head_param_t *pmh, libshm_media_item_param_t *pmi)
+{
+    if (!LibshmutilTvutimestampValid(tvutimestamp))
+    {
+        DEBUG_WARN("vi shm[%s] invalid tvutimestamp input 0x%" PRIx64 "\n", m_pShmObj->GetName(), tvutimestamp);
+        return -EINVAL;
+    }
+    return _searchItemWithIndex('t', tvutimestamp, pmh, pmi);
+}
+
+int CTvuVariableItemRingShmCtx::SearchItemWithPts(uint64_t pts, libshm_media_head_param_t *pmh, libshm_media_item_param_t *pmi)
+{
+    if (pts == SHM_ITEM_INDEX_KEY_NONE)
+    {
+        return -EINVAL;
+    }
+    return _searchItemWithIndex('p', pts, pmh, pmi);
+}
+
 bool CTvuVariableItemRingShmCtx::SearchItems(void *user, libshmmedia_item_checking_fn_t ch)
 {
+    LIBSHM_TRACE_SCOPE(vi_search_items);
     tvu_variableitem_base_shm_item_valid_determine_fn_t fn = _item_valid_checking;
     struct _LocalCallBackContext obj;
     {
@@ -1421,6 +2000,35 @@ LibViShmMediaCreate2
     , uint64_t total_size
     , mode_t mode
 )
+{
+    return LibViShmMediaCreate3(pMemoryName, header_len, item_count, total_size, mode, 0);
+}
+
+libshm_media_handle_t
+LibViShmMediaCreate3
+(
+    const char * pMemoryName
+    , uint32_t header_len
+    , uint32_t item_count
+    , uint64_t total_size
+    , mode_t mode
+    , uint32_t flags
+)
+{
+    return LibViShmMediaCreate4(pMemoryName, header_len, item_count, total_size, mode, flags, LIBSHM_MEDIA_NUMA_NODE_NONE);
+}
+
+libshm_media_handle_t
+LibViShmMediaCreate4
+(
+    const char * pMemoryName
+    , uint32_t header_len
+    , uint32_t item_count
+    , uint64_t total_size
+    , mode_t mode
+    , uint32_t flags
+    , int numa_node
+)
 {
     CTvuVariableItemRingShmCtx             *pctx   = NULL;
     libshm_media_handle_t    h       = NULL;
@@ -1433,7 +2041,7 @@ LibViShmMediaCreate2
         goto FAILED;
     }
 
-    if (pctx->CreateShmEntry(pMemoryName, header_len, item_count, total_size, mode) < 0) {
+    if (pctx->CreateShmEntry(pMemoryName, header_len, item_count, total_size, mode, flags, numa_node) < 0) {
         goto FAILED;
     }
 
@@ -1471,6 +2079,18 @@ LibViShmMediaOpen
     , libshm_media_readcb_t cb
     , void *opaq
 )
+{
+    return LibViShmMediaOpen2(pMemoryName, cb, opaq, 0);
+}
+
+libshm_media_handle_t
+LibViShmMediaOpen2
+(
+    const char * pMemoryName
+    , libshm_media_readcb_t cb
+    , void *opaq
+    , uint32_t flags
+)
 {
     CTvuVariableItemRingShmCtx             *pctx   = NULL;
     libshm_media_handle_t      h       = NULL;
@@ -1483,7 +2103,7 @@ LibViShmMediaOpen
         goto FAILED;
     }
 
-    if (pctx->OpenShmEntry(pMemoryName, cb, opaq) < 0) {
+    if (pctx->OpenShmEntry(pMemoryName, cb, opaq, flags) < 0) {
         goto FAILED;
     }
 
@@ -1634,6 +2254,30 @@ int LibViShmMediaIsCreator(libshm_media_handle_t h)
     return pctx->IsCreator() ? 1 : 0;
 }
 
+int LibViShmMediaGetPageBacking(libshm_media_handle_t h)
+{
+    CTvuVariableItemRingShmCtx    *pctx    = (CTvuVariableItemRingShmCtx *)h;
+    return pctx->GetPageBacking();
+}
+
+int64_t LibViShmMediaGetPrefaultTime(libshm_media_handle_t h)
+{
+    CTvuVariableItemRingShmCtx    *pctx    = (CTvuVariableItemRingShmCtx *)h;
+    return pctx->GetPrefaultTime();
+}
+
+int LibViShmMediaGetNumaNode(libshm_media_handle_t h)
+{
+    CTvuVariableItemRingShmCtx    *pctx    = (CTvuVariableItemRingShmCtx *)h;
+    return pctx->GetNumaNode();
+}
+
+uint32_t LibViShmMediaGetPayloadAlignment(libshm_media_handle_t h)
+{
+    CTvuVariableItemRingShmCtx    *pctx    = (CTvuVariableItemRingShmCtx *)h;
+    return pctx->GetPayloadAlignment();
+}
+
 /**
  *  Parameter:
  *      timeout : currently, it was no use
@@ -1717,6 +2361,97 @@ int LibViShmMediaReadDataWithoutIndexStep(
     return pctx->PollReadDataWithoutIndexStep(pmh, pmi, 0);
 }
 
+int LibViShmMediaSendDataBatch(
+      libshm_media_handle_t h
+      , const libshm_media_head_param_t *pmh
+      , const libshm_media_item_param_t *pmi
+      , int counts
+)
+{
+    CTvuVariableItemRingShmCtx    *pctx    = (CTvuVariableItemRingShmCtx *)h;
+    return pctx->SendDataBatch(pmh, pmi, counts);
+}
+
+int LibViShmMediaAcquire(
+    libshm_media_handle_t         h
+    , libshm_media_head_param_t   *pmh
+    , libshm_media_item_param_t   *pmi
+    , int                         *please
+)
+{
+    CTvuVariableItemRingShmCtx    *pctx    = (CTvuVariableItemRingShmCtx *)h;
+
+    if (!pctx)
+    {
+        return -EINVAL;
+    }
+
+    return pctx->Acquire(pmh, pmi, please);
+}
+
+int LibViShmMediaCheckLease(libshm_media_handle_t h, int lease)
+{
+    CTvuVariableItemRingShmCtx    *pctx    = (CTvuVariableItemRingShmCtx *)h;
+
+    if (!pctx)
+    {
+        return -EINVAL;
+    }
+
+    return pctx->CheckLease(lease);
+}
+
+int LibViShmMediaRelease(libshm_media_handle_t h, int lease)
+{
+    CTvuVariableItemRingShmCtx    *pctx    = (CTvuVariableItemRingShmCtx *)h;
+
+    if (!pctx)
+    {
+        return -EINVAL;
+    }
+
+    return pctx->Release(lease);
+}
+
+int LibViShmMediaSetCopyMode(libshm_media_handle_t h, int mode)
+{
+    CTvuVariableItemRingShmCtx    *pctx    = (CTvuVariableItemRingShmCtx *)h;
+
+    if (!pctx)
+    {
+        return -EINVAL;
+    }
+
+    return pctx->SetCopyMode(mode);
+}
+
+int LibViShmMediaSetHandleLogLevel(libshm_media_handle_t h, int level)
+{
+    CTvuVariableItemRingShmCtx    *pctx    = (CTvuVariableItemRingShmCtx *)h;
+
+    if (!pctx || !pctx->GetShmObj()
+        || (level != LIBSHM_MEDIA_LOG_LEVEL_DEFAULT
+            && (level < LIBSHM_MEDIA_LOG_LEVEL_INFO || level > LIBSHM_MEDIA_LOG_LEVEL_NONE)))
+    {
+        return -EINVAL;
+    }
+
+    pctx->GetShmObj()->SetLogLevel(level);
+    return 0;
+}
+
+int LibViShmMediaPollReadDataBatch(
+    libshm_media_handle_t         h
+    , libshm_media_head_param_t   *pmh
+    , libshm_media_item_param_t   *pmi
+    , int                         max
+    , uint32_t                    timeout
+)
+{
+    CTvuVariableItemRingShmCtx    *pctx    = (CTvuVariableItemRingShmCtx *)h;
+    return pctx->PollReadDataBatch(pmh, pmi, max, timeout);
+}
+
 void LibViShmMediaReadIndexStep(
     libshm_media_handle_t         h
 )
@@ -1737,6 +2472,36 @@ int LibViShmMediaSearchItems(
     return bget?1:0;
 }
 
+int LibViShmMediaSearchItemWithTvutimestamp(
+      libshm_media_handle_t        h
+      , uint64_t tvutimestamp
+      , libshm_media_head_param_t   *pmh
+      , libshm_media_item_param_t   *pmi
+)
+{
+    CTvuVariableItemRingShmCtx    *pctx = (CTvuVariableItemRingShmCtx *)h;
+    if (!pctx)
+    {
+        return -EINVAL;
+    }
+    return pctx->SearchItemWithTvutimestamp(tvutimestamp, pmh, pmi);
+}
+
+int LibViShmMediaSearchItemWithPts(
+      libshm_media_handle_t        h
+      , uint64_t pts
+      , libshm_media_head_param_t   *pmh
+      , libshm_media_item_param_t   *pmi
+)
+{
+    CTvuVariableItemRingShmCtx    *pctx = (CTvuVariableItemRingShmCtx *)h;
+    if (!pctx)
+    {
+        return -EINVAL;
+    }
+    return pctx->SearchItemWithPts(pts, pmh, pmi);
+}
+
 uint8_t* LibViShmMediaItemApplyBuffer(
       libshm_media_handle_t h
     , unsigned int  nlen
@@ -1762,7 +2527,26 @@ int LibViShmMediaItemCommitBuffer(
     CTvuVariableItemRingShmCtx    *pctx = (CTvuVariableItemRingShmCtx *)h;
     if (pctx && pctx->IsCreator())
     {
-        bool b = pctx->commitBuffer(pItemAddr, nlen);
+        bool b = pctx->commitBuffer(pItemAddr, nlen, SHM_ITEM_INDEX_KEY_NONE, SHM_ITEM_INDEX_KEY_NONE);
+        ret = b?0:-1;
+    }
+
+    return ret;
+}
+
+int LibViShmMediaItemCommitBuffer2(
+    libshm_media_handle_t h,
+    uint8_t *pItemAddr,
+    unsigned int nlen,
+    uint64_t tvutimestamp,
+    uint64_t pts
+)
+{
+    int  ret = -1;
+    CTvuVariableItemRingShmCtx    *pctx = (CTvuVariableItemRingShmCtx *)h;
+    if (pctx && pctx->IsCreator())
+    {
+        bool b = pctx->commitBuffer(pItemAddr, nlen, tvutimestamp, pts);
         ret = b?0:-1;
     }
 
@@ -32,11 +32,16 @@
 #include "libshm_media_protocol.h"
 #include "libshm_media_variable_item.h"
 #include "libshm_media_protocol_internal.h"
+#include "libshm_memcpy_internal.h"
+#include "libshm_trace_internal.h"
 
 #if _TVU_VIARIABLE_SHM_FEATURE_ENABLE
 
 #define _LIBSHMMEDIA_PROTOCOL_APIS_DONE 1
 
+/* max item counts of one batch reading or writing call. */
+#define LIBVISHM_MEDIA_BATCH_MAX        64
+
 class CTvuVariableItemRingShmCtx
 {
 private:
@@ -47,6 +52,8 @@ private:
     void                        *m_pOpaq;
     libshm_media_readcb_t       m_fnReadCb;
     int64_t                     m_i64LastSendSysTime;
+    tvushm::MemcpyFunc_t        m_fnCopy;   // payload copy of SendData, NULL for memcpy.
+    uint32_t                    m_uVideoAlign; // the payload alignment of the creator, the video data starts at it.
 public:
     CTvuVariableItemRingShmCtx()
     {
@@ -57,6 +64,8 @@ public:
         m_pOpaq         = NULL;
         m_fnReadCb      = NULL;
         m_i64LastSendSysTime = 0;
+        m_fnCopy        = NULL;
+        m_uVideoAlign   = 0;
     }
 
     ~CTvuVariableItemRingShmCtx()
@@ -103,17 +112,35 @@ public:
 
     int PollSendable(uint32_t timeout)
     {
+        LIBSHM_TRACE_SCOPE(vi_poll_sendable);
         CTvuVariableItemBaseShm    *pshm           = (CTvuVariableItemBaseShm *)m_pShmObj;
-        if (CheckCloseFlag()) {
-            const char      *pShmName       = pshm->GetName();
-            DEBUG_INFO("share memory[%s] server close flag, shoule destroy shm object at once\n", pShmName);
-            return -1;
+        int64_t         t1              = _libshm_get_sys_ms64();
+        int             ret             = -1;
+
+        while (1)
+        {
+            if (CheckCloseFlag()) {
+                const char      *pShmName       = pshm->GetName();
+                DEBUG_INFO("share memory[%s] server close flag, shoule destroy shm object at once\n", pShmName);
+                return -1;
+            }
+
+            ret = pshm->Sendable();
+
+            /* only a lossless writer waits, for the slowest reader releasing the ring. */
+            int64_t now = _libshm_get_sys_ms64();
+            if (ret != 0 || timeout <= 0 || now >= t1 + timeout)
+                break;
+
+            pshm->WaitForRelease((unsigned int)(t1 + timeout - now));
         }
-        return pshm->Sendable();
+
+        return ret;
     }
 
     int PollReadable(uint32_t timeout)
     {
+        LIBSHM_TRACE_SCOPE(vi_poll_readable);
         CTvuVariableItemBaseShm    *pshm           = (CTvuVariableItemBaseShm *)m_pShmObj;
         int64_t         t1              = _libshm_get_sys_ms64();
         int64_t         t2              = 0;
@@ -146,6 +173,7 @@ public:
             _libshm_common_msleep(1);
         }
 
+        LIBSHM_TRACE_ARG(vi_poll_readable, ret);
         return ret;
     }
 
@@ -166,6 +194,27 @@ public:
         return pshm->IsCreator();
     }
 
+    int64_t GetPrefaultTime()
+    {
+        return m_pShmObj->GetPrefaultTime();
+    }
+
+    int GetNumaNode()
+    {
+        return m_pShmObj->GetNumaNode();
+    }
+
+    uint32_t GetPayloadAlignment()
+    {
+        return (uint32_t)m_pShmObj->GetPayloadAlignment();
+    }
+
+    int GetPageBacking()
+    {
+        return m_pShmObj->GetPageBacking() == SHM_PAGE_BACKING_HUGETLBFS
+            ? LIBSHM_MEDIA_PAGE_BACKING_HUGETLBFS : LIBSHM_MEDIA_PAGE_BACKING_NORMAL;
+    }
+
     bool bHasReaders(unsigned int timeout = 100)
     {
         return m_pShmObj->HasReaders(timeout);
@@ -173,22 +222,33 @@ public:
 
     int CreateShmEntry(const char * pMemoryName, const uint32_t header_len, const uint32_t item_count, const uint64_t item_length);
     int CreateShmEntry(const char * pMemoryName, const uint32_t header_len, const uint32_t item_count, const uint64_t item_length, mode_t mode);
+    int CreateShmEntry(const char * pMemoryName, const uint32_t header_len, const uint32_t item_count, const uint64_t item_length, mode_t mode, uint32_t flags);
+    int CreateShmEntry(const char * pMemoryName, const uint32_t header_len, const uint32_t item_count, const uint64_t item_length, mode_t mode, uint32_t flags, int numa_node);
     int OpenShmEntry(const char * pMemoryName, libshm_media_readcb_t cb, void *opaq);
+    int OpenShmEntry(const char * pMemoryName, libshm_media_readcb_t cb, void *opaq, uint32_t flags);
     void SetCloseFlag(bool bclose);
     bool CheckCloseFlag();
     uint8_t *GetItemDataAddr(uint32_t index);
     int SendHead(const libshm_media_head_param_t *pmh);
     int SendData(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmi);
     int SendDataWithFrequency1000(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmi);
+    int SendDataBatch(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmi, int counts);
     int PollReadHead(libshm_media_head_param_t *pmh, uint32_t timeout);
+    /* head of the newest written item, the read index and read time stay, 0 nothing written yet. */
+    int PeekLatestHead(libshm_media_head_param_t *pmh);
+    uint64_t GetWrittenSince(uint64_t *pwindex, uint64_t *pbytes)
+    {
+        return m_pShmObj->GetWrittenSince(pwindex, pbytes);
+    }
     int PollReadData(libshm_media_head_param_t *pmh, libshm_media_item_param_t   *pmi, uint32_t timeout);
     int PollReadDataWithoutIndexStep(libshm_media_head_param_t *pmh, libshm_media_item_param_t   *pmi, uint32_t timeout);
+    int PollReadDataBatch(libshm_media_head_param_t *pmh, libshm_media_item_param_t   *pmi, int max, uint32_t timeout);
     int ReadIndexStep();
     void SeekReadIndexToWriteIndex();
     void SeekReadIndexToZero();
     void SeekReadIndex(uint64_t rindex);
     uint8_t *applyBuffer(unsigned int size);
-    bool commitBuffer(uint8_t *pItemAddr, unsigned int size);
+    bool commitBuffer(uint8_t *pItemAddr, unsigned int size, uint64_t tvutimestamp, uint64_t pts);
 
 public: /* raw data apis */
     int PollReadRawData(libshmmedia_raw_head_param_t   *pmh, libshmmedia_raw_data_param_t   *pmi, unsigned int timeout);
@@ -197,21 +257,58 @@ public: /* raw data apis */
 
 public:
     bool SearchItems(void *, libshmmedia_item_checking_fn_t fn);
+    /**
+     *  binary search of the item index for the first item not before the wanted key.
+     *  >0 : found, the read length, the reading index is on the item.
+     *  0  : not found, the reading index is on the writing index.
+     *  <0 : -EINVAL invalid key, -ENOTSUP the ring has no item index.
+    **/
+    int  SearchItemWithTvutimestamp(uint64_t tvutimestamp, libshm_media_head_param_t *pmh, libshm_media_item_param_t *pmi);
+    int  SearchItemWithPts(uint64_t pts, libshm_media_head_param_t *pmh, libshm_media_item_param_t *pmi);
     /**
      *  <0 : invalid data
      *  0  : not the searched item
      *  >0 : the searched item.
     **/
     int  IsTheSearchingItem(const void *buf, size_t nbuf, uint64_t pos, void *user, libshmmedia_item_checking_fn_t fn);
+    /**
+     *  read the item at @pos, which the item index entry @pentry points out.
+     *  the keys are checked again, the payload could have been overwritten.
+     *  >0 : the read length.
+     *  0  : the item was overwritten.
+    **/
+    int  ReadItemAt(uint64_t pos, const shm_item_index_entry_t *pentry, libshm_media_head_param_t *pmh, libshm_media_item_param_t *pmi);
+    CTvuVariableItemBaseShm *GetShmObj()
+    {
+        return m_pShmObj;
+    }
+    /* the logs of the methods follow the log level of the shm. */
+    int _libshmLogLevelOverride() const
+    {
+        return m_pShmObj ? m_pShmObj->GetLogLevel() : LIBSHM_LOG_LEVEL_DEFAULT;
+    }
+    int  SetCopyMode(int mode);
+    /**
+     *  read the next item as PollReadDataWithoutIndexStep, and lease it by @please.
+     *  return as PollReadDataWithoutIndexStep, or the errors of AcquireLease, the read
+     *  index is not stepped then.
+    **/
+    int  Acquire(libshm_media_head_param_t *pmh, libshm_media_item_param_t *pmi, int *please);
+    int  Release(int lease);
+    int  CheckLease(int lease);
 public:
     static int RemoveShm(const char *pshmname);
 private:
         int _sendV3Data(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmi);
         int _sendV4Data(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmi);
+        int _sendV4DataBatch(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmi, int counts);
         uint8_t *_applyV4Buffer(unsigned int size);
-        bool _commitV4Buffer(uint8_t *pItemAddr, unsigned int size);
+        bool _commitV4Buffer(uint8_t *pItemAddr, unsigned int size, uint64_t tvutimestamp, uint64_t pts);
         int _writeV4Buffer(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmi
                            , const libshm_media_item_param_internal_t &rii, uint8_t *pItemAddr);
+        void _getItemIndexKeys(const libshm_media_item_param_t *pmi, uint64_t *ptvutimestamp, uint64_t *ppts);
+        void _updateItemIndex(size_t nth, const libshm_media_item_param_t *pmi);
+        int _searchItemWithIndex(char type, uint64_t value, libshm_media_head_param_t *pmh, libshm_media_item_param_t *pmi);
 #ifndef _LIBSHMMEDIA_PROTOCOL_APIS_DONE
         int _readV3Data(libshm_media_item_param_t   *pmi, const uint8_t *pItemAddr);
         int _readV4Data(libshm_media_item_param_t   *pmi, const uint8_t *pItemAddr);
@@ -76,3 +76,23 @@ int LibViShmMediaHasReader(libshm_media_handle_t h, unsigned int timeout)
     CTvuVariableItemRingShmCtx    *pctx    = (CTvuVariableItemRingShmCtx *)h;
     return pctx->bHasReaders(timeout);
 }
+
+int LibViShmMediaPeekLatestHead(libshm_media_handle_t h, libshm_media_head_param_t *pmh)
+{
+    CTvuVariableItemRingShmCtx    *pctx    = (CTvuVariableItemRingShmCtx *)h;
+    if (!pctx || !pmh)
+    {
+        return -EINVAL;
+    }
+    return pctx->PeekLatestHead(pmh);
+}
+
+uint64_t LibViShmMediaGetWrittenSince(libshm_media_handle_t h, uint64_t *pwindex, uint64_t *pbytes)
+{
+    CTvuVariableItemRingShmCtx    *pctx    = (CTvuVariableItemRingShmCtx *)h;
+    if (!pctx || !pwindex)
+    {
+        return 0;
+    }
+    return pctx->GetWrittenSince(pwindex, pbytes);
+}
@@ -0,0 +1,414 @@
+/*******************************************************************************************
+ *  Description:
+ *      shmmedia_top, shows the live rates of the share memories of libshmmedia.
+ *      it walks /dev/shm, or watches the named ones, opens every ring by
+ *      LIBSHM_MEDIA_OPEN_FLAG_MONITOR and only peeks at it, no reader's read index
+ *      moves, no reader slot nor lossless cursor is taken, the writers never wait for it.
+ *  CopyRight:
+ *      TVU.
+*******************************************************************************************/
+#include "libshm_media.h"
+#include "libshm_media_raw_data_opt.h"
+#include "libshm_media_variable_item.h"
+#include "libshmmedia_variableitem_rawdata.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <signal.h>
+#include <dirent.h>
+#include <getopt.h>
+#include <sys/time.h>
+#include <string>
+#include <vector>
+
+#define SHMMEDIA_TOP_SHM_DIR        "/dev/shm"
+#define SHMMEDIA_TOP_ALIVE_MS       1000
+
+static int g_exit       = 0;
+static int g_verbose    = 0;
+
+typedef struct {
+    std::string             name;
+    int                     type;
+    libshm_media_handle_t   h;
+    bool                    bStats;
+    uint64_t                frames;     // fixed ring, the last frames_written or write index.
+    uint64_t                bytes;      // fixed ring, the last bytes_written.
+    uint64_t                windex;     // variable ring, the write index counted from.
+} shmmedia_top_ring_t;
+
+static inline
+int64_t _get_sys_ms64()
+{
+    struct timeval  tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+static
+int _quiet_log(int level, const char *fmt, va_list ap)
+{
+    if (!g_verbose || level != 'e')
+    {
+        return 0;
+    }
+    return vfprintf(stderr, fmt, ap);
+}
+
+static
+void handle_sig(int sig)
+{
+    (void)sig;
+    g_exit  = 1;
+}
+
+static
+void _close_ring(shmmedia_top_ring_t &r)
+{
+    if (!r.h)
+    {
+        return;
+    }
+
+    if (r.type == LIBSHM_MEDIA_SHM_TYPE_FIXED)
+    {
+        LibShmMediaDestroy(r.h);
+    }
+    else
+    {
+        LibViShmMediaDestroy(r.h);
+    }
+    r.h = NULL;
+}
+
+static
+bool _open_ring(shmmedia_top_ring_t &r)
+{
+    r.type = LibShmMediaProbeShm(r.name.c_str());
+
+    if (r.type == LIBSHM_MEDIA_SHM_TYPE_FIXED)
+    {
+        r.h = LibShmMediaOpen2(r.name.c_str(), NULL, NULL, LIBSHM_MEDIA_OPEN_FLAG_MONITOR);
+        if (r.h)
+        {
+            libshm_media_stats_t stats;
+            r.bStats = LibShmMediaGetStats(r.h, &stats) >= 0;
+            r.frames = r.bStats ? stats.u_frames_written : LibShmMediaGetWriteIndex(r.h);
+            r.bytes  = r.bStats ? stats.u_bytes_written : 0;
+        }
+    }
+    else if (r.type == LIBSHM_MEDIA_SHM_TYPE_VARIABLE)
+    {
+        r.h = LibViShmMediaOpen2(r.name.c_str(), NULL, NULL, LIBSHM_MEDIA_OPEN_FLAG_MONITOR);
+        if (r.h)
+        {
+            r.windex = LibViShmMediaGetWriteIndex(r.h);
+        }
+    }
+
+    return r.h != NULL;
+}
+
+/* walk the share memory directory, open the new rings, drop the ones removed. */
+static
+void _scan_rings(std::vector<shmmedia_top_ring_t> &rings)
+{
+    DIR *dir = opendir(SHMMEDIA_TOP_SHM_DIR);
+    if (!dir)
+    {
+        return;
+    }
+
+    std::vector<std::string> names;
+    struct dirent *ent = NULL;
+    while ((ent = readdir(dir)) != NULL)
+    {
+        if (ent->d_name[0] != '.')
+        {
+            names.push_back(ent->d_name);
+        }
+    }
+    closedir(dir);
+
+    for (size_t i = 0; i < rings.size(); )
+    {
+        bool bFound = false;
+        for (size_t n = 0; n < names.size() && !bFound; n++)
+        {
+            bFound = names[n] == rings[i].name;
+        }
+
+        if (bFound)
+        {
+            i++;
+            continue;
+        }
+        _close_ring(rings[i]);
+        rings.erase(rings.begin() + i);
+    }
+
+    for (size_t n = 0; n < names.size(); n++)
+    {
+        bool bKnown = false;
+        for (size_t i = 0; i < rings.size() && !bKnown; i++)
+        {
+            bKnown = rings[i].name == names[n];
+        }
+
+        if (bKnown)
+        {
+            continue;
+        }
+
+        shmmedia_top_ring_t r;
+        r.h      = NULL;
+        r.type   = LIBSHM_MEDIA_SHM_TYPE_NONE;
+        r.name   = names[n];
+        r.bStats = false;
+        r.frames = 0;
+        r.bytes  = 0;
+        r.windex = 0;
+        if (_open_ring(r))
+        {
+            rings.push_back(r);
+        }
+    }
+}
+
+static
+const char *_fourcc(uint32_t fourcc, char s[16])
+{
+    const uint8_t *p = (const uint8_t *)&fourcc;
+
+    if (!fourcc)
+    {
+        snprintf(s, 16, "-");
+        return s;
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (p[i] < 0x20 || p[i] > 0x7e)
+        {
+            snprintf(s, 16, "0x%08x", fourcc);
+            return s;
+        }
+    }
+    snprintf(s, 16, "%c%c%c%c", p[0], p[1], p[2], p[3]);
+    return s;
+}
+
+static
+void _show_ring(shmmedia_top_ring_t &r, int64_t elapsed)
+{
+    uint64_t    frames      = 0;
+    uint64_t    bytes       = 0;
+    bool        bBytes      = true;
+    bool        bClosed     = false;
+    int         readers     = -1;
+    char        fill[16]    = "-";
+    char        lag[32]     = "-";
+    char        vfourcc[16];
+    char        afourcc[16];
+    libshm_media_head_param_t   head;
+    int         bHead       = 0;
+    int         bReading    = 0;
+
+    memset(&head, 0, sizeof(head));
+
+    if (r.type == LIBSHM_MEDIA_SHM_TYPE_FIXED)
+    {
+        libshm_media_stats_t stats;
+        if (r.bStats && LibShmMediaGetStats(r.h, &stats) >= 0)
+        {
+            frames  = stats.u_frames_written - r.frames;
+            bytes   = stats.u_bytes_written - r.bytes;
+            r.frames = stats.u_frames_written;
+            r.bytes  = stats.u_bytes_written;
+        }
+        else
+        {
+            uint32_t windex = LibShmMediaGetWriteIndex(r.h);
+            frames  = (uint32_t)(windex - (uint32_t)r.frames);
+            r.frames = windex;
+            bBytes  = false;
+        }
+
+        libshm_media_reader_info_t slowest;
+        libshm_media_reader_info_t list[LIBSHM_MEDIA_STATS_READERS_MAX];
+        readers = LibShmMediaGetReaders(r.h, list, LIBSHM_MEDIA_STATS_READERS_MAX);
+        if (LibShmMediaGetSlowestReader(r.h, &slowest) > 0)
+        {
+            unsigned int counts = LibShmMediaGetItemCounts(r.h);
+            snprintf(fill, sizeof(fill), "%u%%", counts ? slowest.u_lag_items * 100 / counts : 0);
+            snprintf(lag, sizeof(lag), "%u/%llums", slowest.u_lag_items, (unsigned long long)slowest.u_lag_ms);
+        }
+
+        bClosed  = LibShmMediaCheckCloseflag(r.h) != 0;
+        bReading = LibShmMediaHasReader(r.h, SHMMEDIA_TOP_ALIVE_MS);
+        bHead    = LibShmMediaPeekLatestHead(r.h, &head) > 0;
+    }
+    else
+    {
+        frames   = LibViShmMediaGetWrittenSince(r.h, &r.windex, &bytes);
+        bClosed  = LibViShmMediaCheckCloseflag(r.h) != 0;
+        bReading = LibViShmMediaHasReader(r.h, SHMMEDIA_TOP_ALIVE_MS);
+        bHead    = LibViShmMediaPeekLatestHead(r.h, &head) > 0;
+    }
+
+    double fps  = elapsed > 0 ? frames * 1000.0 / elapsed : 0;
+    double mbps = elapsed > 0 ? bytes * 8.0 / 1000.0 / elapsed : 0;
+    const char *writer = bClosed ? "closed" : (frames ? "live" : "idle");
+
+    printf("%-24.24s %-4s %-6s %7.1f ", r.name.c_str()
+           , r.type == LIBSHM_MEDIA_SHM_TYPE_FIXED ? "fix" : "var", writer, fps);
+    if (bBytes)
+    {
+        printf("%8.2f ", mbps);
+    }
+    else
+    {
+        printf("%8s ", "-");
+    }
+
+    printf("%5s %-4s ", fill, bReading ? "yes" : "no");
+    if (readers >= 0)
+    {
+        printf("%3d ", readers);
+    }
+    else
+    {
+        printf("%3s ", "-");
+    }
+    printf("%-14s ", lag);
+
+    if (bHead)
+    {
+        char res[32];
+        snprintf(res, sizeof(res), "%dx%d", head.i_dstw, head.i_dsth);
+        printf("%-10s %-10s %-10s %6d\n", head.i_dstw ? res : "-"
+               , _fourcc(head.u_videofourcc, vfourcc), _fourcc(head.u_audiofourcc, afourcc), head.i_samplerate);
+    }
+    else
+    {
+        printf("%-10s %-10s %-10s %6s\n", "-", "-", "-", "-");
+    }
+}
+
+static
+void _usage(const char *exe)
+{
+    printf("Help:\n"
+        "    %s [-i<interval ms>] [-c<refresh counts>] [-v] [shmname ...]\n"
+        "    without shmname, every share memory of %s is watched.\n"
+        , exe, SHMMEDIA_TOP_SHM_DIR
+    );
+}
+
+int main(int argc, char *argv[])
+{
+    int interval = 1000;
+    int counts = -1;
+    int ch = '?';
+
+    while ((ch = getopt(argc, argv, "i:c:vh")) != -1)
+    {
+        switch(ch)
+        {
+            case 'i':
+            {
+                interval = atoi(optarg);
+            }
+            break;
+            case 'c':
+            {
+                counts = atoi(optarg);
+            }
+            break;
+            case 'v':
+            {
+                g_verbose = 1;
+            }
+            break;
+            default:
+            {
+                _usage(argv[0]);
+                return 0;
+            }
+        }
+    }
+
+    if (interval <= 0)
+    {
+        interval = 1000;
+    }
+
+    LibShmMediaSetLogCallback(_quiet_log);
+    signal(SIGINT, handle_sig);
+    signal(SIGTERM, handle_sig);
+
+    std::vector<shmmedia_top_ring_t> rings;
+    bool bScan = optind >= argc;
+
+    for (int i = optind; i < argc; i++)
+    {
+        shmmedia_top_ring_t r;
+        r.h      = NULL;
+        r.type   = LIBSHM_MEDIA_SHM_TYPE_NONE;
+        r.name   = argv[i];
+        r.bStats = false;
+        r.frames = 0;
+        r.bytes  = 0;
+        r.windex = 0;
+        if (!_open_ring(r))
+        {
+            fprintf(stderr, "%s is not a share memory of libshmmedia, ret %d\n", argv[i], r.type);
+            continue;
+        }
+        rings.push_back(r);
+    }
+
+    if (bScan)
+    {
+        _scan_rings(rings);
+    }
+
+    int64_t last = _get_sys_ms64();
+    while (!g_exit && counts != 0)
+    {
+        usleep(interval * 1000);
+        if (g_exit)
+        {
+            break;
+        }
+
+        int64_t now = _get_sys_ms64();
+        printf("%-24s %-4s %-6s %7s %8s %5s %-4s %3s %-14s %-10s %-10s %-10s %6s\n"
+               , "NAME", "TYPE", "WRITER", "FPS", "MBIT/S", "FILL", "READ", "RDS", "LAG(ITEMS/MS)"
+               , "RES", "VFOURCC", "AFOURCC", "SRATE");
+        for (size_t i = 0; i < rings.size(); i++)
+        {
+            _show_ring(rings[i], now - last);
+        }
+        printf("\n");
+        fflush(stdout);
+        last = now;
+
+        if (bScan)
+        {
+            _scan_rings(rings);
+        }
+        if (counts > 0)
+        {
+            counts--;
+        }
+    }
+
+    for (size_t i = 0; i < rings.size(); i++)
+    {
+        _close_ring(rings[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,377 @@
+// Benchmarks of the LibShm media apis, built into the opt-in unitTestBench binary
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sched.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+#if defined(TVU_LINUX)
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
+#endif
+
+extern "C" {
+#include "libshm_media.h"
+}
+
+static std::string make_shm_name()
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "/gtest_libshm_media_%d_%u", (int)getpid(), (unsigned)rand());
+    return std::string(buf);
+}
+
+static void InitMediaHeadParam(libshm_media_head_param_t* head_param) {
+    memset(head_param, 0, sizeof(libshm_media_head_param_t));
+    head_param->i_dstw = 1920;
+    head_param->i_dsth = 1080;
+    head_param->u_videofourcc = 0x31637661;  // avc1
+    head_param->i_duration = 1;
+    head_param->i_scale = 30;
+    head_param->u_audiofourcc = 0x6169766f;  // ovia
+    head_param->i_channels = 2;
+    head_param->i_depth = 16;
+    head_param->i_samplerate = 48000;
+}
+
+static void InitMediaItemParam(libshm_media_item_param_t* item_param, int64_t pts, uint64_t timestamp,uint8_t aExtBuff[256]) {
+    memset(item_param, 0, sizeof(libshm_media_item_param_t));
+    item_param->i64_vpts = pts;
+    item_param->i64_apts = pts + 100;
+    item_param->i64_spts = pts + 200;
+    
+    // Simulate timestamp data in user data section
+#if 1
+        uint32_t iExtBuffSize = 0;
+        uint64_t tvutimestamp = timestamp;
+
+
+        libshmmedia_extend_data_info_t myExt;
+        {
+            memset(&myExt, 0, sizeof (myExt));
+        }
+
+        {
+            myExt.bGotTvutimestamp = true;
+            myExt.u64Tvutimestamp = tvutimestamp;
+        }
+
+        int iExtBuffSizeBeforeAlloc = LibShmMediaEstimateExtendDataSize(&myExt);
+        iExtBuffSize = LibShmMediaWriteExtendData(aExtBuff, iExtBuffSizeBeforeAlloc, &myExt);
+
+        item_param->i_userDataType = LIBSHM_MEDIA_TYPE_TVU_EXTEND_DATA_V2;
+        item_param->p_userData = aExtBuff;
+        item_param->i_userDataLen = iExtBuffSize;
+#endif
+
+}
+
+static uint64_t searched_item_tvutimestamp(uint32_t i)
+{
+    return (static_cast<uint64_t>(1) << 56) | (1000 + i * 10);
+}
+
+static void send_searched_items(libshm_media_handle_t h, uint32_t from, uint32_t n)
+{
+    libshm_media_head_param_t head;
+    InitMediaHeadParam(&head);
+    uint8_t vdata[64];
+    memset(vdata, 0x3C, sizeof(vdata));
+    for (uint32_t i = from; i < from + n; i++)
+    {
+        uint8_t aExtBuff[256] = {0};
+        libshm_media_item_param_t item;
+        InitMediaItemParam(&item, i, searched_item_tvutimestamp(i), aExtBuff);
+        item.p_vData = vdata;
+        item.i_vLen = sizeof(vdata);
+        ASSERT_GT(LibShmMediaSendData(h, &head, &item), 0);
+    }
+}
+
+#if defined(TVU_LINUX)
+// fill the cpu set from /sys/devices/system/node/nodeN/cpulist, like "0-3,8-11"
+static bool numa_node_cpus(int node, cpu_set_t *set)
+{
+    char path[128];
+    char buf[1024];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        return false;
+    }
+    bool ok = fgets(buf, sizeof(buf), fp) != NULL;
+    fclose(fp);
+
+    CPU_ZERO(set);
+    for (char *p = buf; ok && *p && *p != '\n'; ) {
+        char *end = NULL;
+        long lo = strtol(p, &end, 10);
+        long hi = lo;
+        if (*end == '-') {
+            hi = strtol(end + 1, &end, 10);
+        }
+        for (long c = lo; c <= hi; c++) {
+            CPU_SET((int)c, set);
+        }
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return ok && CPU_COUNT(set) > 0;
+}
+
+// read the whole ring kLaps times pinned to the node's cpus, return MB/s.
+// item data addresses are only exposed to the creator, read through its mapping.
+static double read_bandwidth_on_node(libshm_media_handle_t h, int node)
+{
+    const int kLaps = 20;
+    cpu_set_t set;
+    if (!numa_node_cpus(node, &set) || sched_setaffinity(0, sizeof(set), &set) != 0) {
+        return 0;
+    }
+
+    // the item length covers the item head too, read the first half of the data
+    unsigned int counts = LibShmMediaGetItemCounts(h);
+    unsigned int len = LibShmMediaGetItemLength(h) / 2;
+    struct timespec t0, t1;
+    volatile uint64_t sink = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int lap = 0; lap < kLaps; lap++) {
+        for (unsigned int i = 0; i < counts; i++) {
+            const uint64_t *p = (const uint64_t *)LibShmMediaGetItemDataAddr(h, i);
+            uint64_t sum = 0;
+            for (unsigned int k = 0; k < len / sizeof(uint64_t); k++) {
+                sum += p[k];
+            }
+            sink += sum;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    (void)sink;
+
+    double sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    return (double)kLaps * counts * len / (1024.0 * 1024.0) / sec;
+}
+
+// Benchmark a reader on the ring's node against a reader on a remote node
+TEST(LibShmMediaBasic, Benchmark_NumaLocalVsRemoteRead)
+{
+    std::string name = make_shm_name();
+    libshm_media_handle_t h = LibShmMediaCreate4(name.c_str(), 1024, 16, 1024 * 1024
+                                                 , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_PREFAULT, 0);
+    ASSERT_NE(h, (libshm_media_handle_t)NULL);
+    libshm_media_handle_t r = LibShmMediaOpen(name.c_str(), NULL, NULL);
+    ASSERT_NE(r, (libshm_media_handle_t)NULL);
+
+    int node = LibShmMediaGetNumaNode(r);
+    int remote = LIBSHM_MEDIA_NUMA_NODE_NONE;
+    cpu_set_t set;
+    for (int n = 0; n < 64; n++) {
+        if (n != node && numa_node_cpus(n, &set)) {
+            remote = n;
+            break;
+        }
+    }
+
+    cpu_set_t saved;
+    sched_getaffinity(0, sizeof(saved), &saved);
+    if (node != LIBSHM_MEDIA_NUMA_NODE_NONE) {
+        double local = read_bandwidth_on_node(h, node);
+        if (remote != LIBSHM_MEDIA_NUMA_NODE_NONE) {
+            printf("[ BENCH    ] numa read: node%d local %.0f MB/s, node%d remote %.0f MB/s\n"
+                   , node, local, remote, read_bandwidth_on_node(h, remote));
+        } else {
+            printf("[ BENCH    ] numa read: node%d local %.0f MB/s, single node host, no remote\n"
+                   , node, local);
+        }
+    }
+    sched_setaffinity(0, sizeof(saved), &saved);
+
+    LibShmMediaDestroy(r);
+    LibShmMediaDestroy(h);
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+}
+#endif
+
+static double now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Benchmark frame by frame lookups against lookups in random order, which
+// bisect the ring every time
+TEST(LibShmMediaBasic, Benchmark_SearchAdvancingVsRandomTvutimestamp)
+{
+    std::string name = make_shm_name();
+    const uint32_t counts = 4096;
+    const int rounds = 8;
+    libshm_media_handle_t hW = LibShmMediaCreate(name.c_str(), 1024, counts, 1024);
+    ASSERT_NE(hW, (libshm_media_handle_t)NULL);
+    libshm_media_handle_t hR = LibShmMediaOpen(name.c_str(), NULL, NULL);
+    ASSERT_NE(hR, (libshm_media_handle_t)NULL);
+
+    send_searched_items(hW, 0, counts - 1);
+    LibShmMediaSeekReadIndex(hR, 0);
+
+    libshm_media_item_param_t ritem;
+    std::vector<uint32_t> order(counts - 1);
+    for (uint32_t i = 0; i < counts - 1; i++)
+    {
+        order[i] = i;
+        ASSERT_TRUE(LibShmMediaSearchItemWithTvutimestamp(hR, searched_item_tvutimestamp(i), &ritem));
+    }
+
+    double t0 = now_us();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (uint32_t i = 0; i < counts - 1; i++)
+        {
+            ASSERT_TRUE(LibShmMediaSearchItemWithTvutimestamp(hR, searched_item_tvutimestamp(i), &ritem));
+        }
+    }
+    double advancing = (now_us() - t0) / (rounds * (counts - 1));
+
+    srand(1);
+    for (uint32_t i = counts - 2; i > 0; i--)
+    {
+        std::swap(order[i], order[rand() % (i + 1)]);
+    }
+    t0 = now_us();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (uint32_t i = 0; i < counts - 1; i++)
+        {
+            ASSERT_TRUE(LibShmMediaSearchItemWithTvutimestamp(hR, searched_item_tvutimestamp(order[i]), &ritem));
+        }
+    }
+    double random = (now_us() - t0) / (rounds * (counts - 1));
+
+    printf("[ BENCH    ] search over %u items: advancing %.2f us/lookup, random %.2f us/lookup\n"
+           , counts - 1, advancing, random);
+
+    LibShmMediaDestroy(hR);
+    LibShmMediaDestroy(hW);
+#if defined(TVU_LINUX)
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+#endif
+}
+
+#if defined(TVU_LINUX)
+static int open_cache_miss_counter()
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// the reader consumes the first part of every 4K UYVY sized item, the ring is
+// evicted from the cache before each lap as a live writer's data would be
+static void read_items_cold(libshm_media_handle_t hW, libshm_media_handle_t hR, int fd
+                            , int laps, double *pus, long long *pmisses)
+{
+    const uint32_t ilen = 3840 * 2160 * 2;
+    const uint32_t consumed = 512 * 1024;
+    std::vector<uint8_t> vdata(ilen, 0x3C);
+    std::vector<uint8_t> evict(64 * 1024 * 1024, 1);
+    libshm_media_head_param_t head;
+    InitMediaHeadParam(&head);
+
+    *pus = 0;
+    *pmisses = 0;
+    for (int lap = 0; lap < laps; lap++)
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            libshm_media_item_param_t item;
+            memset(&item, 0, sizeof(item));
+            item.p_vData = vdata.data();
+            item.i_vLen = ilen;
+            item.i64_vpts = i;
+            ASSERT_GT(LibShmMediaSendData(hW, &head, &item), 0);
+        }
+        volatile uint64_t sink = 0;
+        for (size_t off = 0; off < evict.size(); off += 64)
+        {
+            evict[off]++;
+        }
+
+        long long misses = 0;
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        double t0 = now_us();
+        libshm_media_head_param_t rhead;
+        libshm_media_item_param_t ritem;
+        while (LibShmMediaReadData(hR, &rhead, &ritem) > 0)
+        {
+            const uint64_t *p = (const uint64_t *)ritem.p_vData;
+            uint64_t sum = 0;
+            for (uint32_t k = 0; k < consumed / sizeof(uint64_t); k++)
+            {
+                sum += p[k];
+            }
+            sink += sum;
+        }
+        *pus += now_us() - t0;
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &misses, sizeof(misses)) == sizeof(misses))
+            {
+                *pmisses += misses;
+            }
+        }
+    }
+}
+
+// Benchmark the cold read path of 4K UYVY items with and without prefetching
+TEST(LibShmMediaBasic, Benchmark_ReadPrefetch)
+{
+    std::string name = make_shm_name();
+    const int laps = 4;
+    libshm_media_handle_t hW = LibShmMediaCreate(name.c_str(), 1024, 8, 3840 * 2160 * 2 + 4096);
+    ASSERT_NE(hW, (libshm_media_handle_t)NULL);
+    libshm_media_handle_t hR = LibShmMediaOpen(name.c_str(), NULL, NULL);
+    ASSERT_NE(hR, (libshm_media_handle_t)NULL);
+
+    int fd = open_cache_miss_counter();
+    double us = 0, usPrefetch = 0;
+    long long misses = 0, missesPrefetch = 0;
+
+    LibShmMediaSeekReadIndexToWriteIndex(hR);
+    read_items_cold(hW, hR, fd, laps, &us, &misses);
+    ASSERT_EQ(LibShmMediaSetReadPrefetch(hR, 2, 512 * 1024), 0);
+    read_items_cold(hW, hR, fd, laps, &usPrefetch, &missesPrefetch);
+
+    if (fd >= 0)
+    {
+        printf("[ BENCH    ] cold reading %d items: %.0f us, %lld cache misses; prefetch depth 2: %.0f us, %lld cache misses\n"
+               , laps * 6, us, misses, usPrefetch, missesPrefetch);
+        close(fd);
+    }
+    else
+    {
+        printf("[ BENCH    ] cold reading %d items: %.0f us; prefetch depth 2: %.0f us (no perf counters: %s)\n"
+               , laps * 6, us, usPrefetch, strerror(errno));
+    }
+
+    LibShmMediaDestroy(hR);
+    LibShmMediaDestroy(hW);
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+}
+#endif
@@ -0,0 +1,169 @@
+/**
+ * @file bench_libshm_media_variable_item.cpp
+ * @brief Benchmarks of libshm_media_variable_item.cpp, built into the opt-in unitTestBench binary
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <chrono>
+#include "libshm_media_variable_item.h"
+
+class LibViShmMediaTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        creatorHandle_ = nullptr;
+        readerHandle_ = nullptr;
+        // Clean up any leftover shared memory
+        LibViShmMediaRemoveShmFromSystem(kTestShmName);
+    }
+
+    void TearDown() override {
+        if (readerHandle_) {
+            LibViShmMediaDestroy(readerHandle_);
+            readerHandle_ = nullptr;
+        }
+        if (creatorHandle_) {
+            LibViShmMediaDestroy(creatorHandle_);
+            creatorHandle_ = nullptr;
+        }
+        // Clean up test shared memory
+        LibViShmMediaRemoveShmFromSystem(kTestShmName);
+    }
+
+    static constexpr const char* kTestShmName = "test_vi_shm";
+    static constexpr uint32_t kTestHeaderLen = 1024;
+    static constexpr uint32_t kTestItemCount = 10;
+    static constexpr uint64_t kTestTotalSize = 1024 * 1024;  // 1MB
+
+    libshm_media_handle_t creatorHandle_;
+    libshm_media_handle_t readerHandle_;
+};
+
+// Out-of-class definitions for static constexpr members (required for ODR-use in C++11/14)
+constexpr const char* LibViShmMediaTest::kTestShmName;
+constexpr uint32_t LibViShmMediaTest::kTestHeaderLen;
+constexpr uint32_t LibViShmMediaTest::kTestItemCount;
+constexpr uint64_t LibViShmMediaTest::kTestTotalSize;
+
+// video item of pts @pts, tagged with @tvutimestamp in the extended data
+static void FillIndexedItem(libshm_media_item_param_t *item, uint8_t *vdata, uint8_t extBuff[64]
+                            , int64_t pts, uint64_t tvutimestamp) {
+    libshmmedia_extend_data_info_t ext;
+    memset(&ext, 0, sizeof(ext));
+    ext.bGotTvutimestamp = true;
+    ext.u64Tvutimestamp = tvutimestamp;
+
+    memset(item, 0, sizeof(*item));
+    item->p_vData = vdata;
+    item->i_vLen = 32;
+    item->i64_vpts = pts;
+    item->i_userDataType = LIBSHM_MEDIA_TYPE_TVU_EXTEND_DATA_V2;
+    item->p_userData = extBuff;
+    item->i_userDataLen = LibShmMediaWriteExtendData(extBuff, LibShmMediaEstimateExtendDataSize(&ext), &ext);
+}
+
+static void FillIndexedHead(libshm_media_head_param_t *head) {
+    memset(head, 0, sizeof(*head));
+    head->i_dstw = 1920;
+    head->i_dsth = 1080;
+    head->u_videofourcc = 0x31637661;  // avc1
+    head->i_duration = 1;
+    head->i_scale = 30;
+}
+
+static uint64_t IndexedItemTvutimestamp(int i) {
+    return (static_cast<uint64_t>(1) << 56) | (uint64_t)(1000 + i * 10);
+}
+
+static int _match_tvutimestamp(void *user, const libshm_media_head_param_t *, const libshm_media_item_param_t *pmi) {
+    libshmmedia_extend_data_info_t ext;
+    memset(&ext, 0, sizeof(ext));
+    LibShmMeidaParseExtendDataV2(&ext, pmi->p_userData, pmi->i_userDataLen);
+    return ext.bGotTvutimestamp && ext.u64Tvutimestamp == *(const uint64_t *)user;
+}
+
+// Benchmark the indexed search against walking the whole ring
+TEST_F(LibViShmMediaTest, Benchmark_SearchItemIndexVsWholeItems) {
+    const int kItemCount = 20000;
+    const int kLookups = 20;
+    creatorHandle_ = LibViShmMediaCreate3(kTestShmName, kTestHeaderLen, kItemCount, 16 * 1024 * 1024
+                                          , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_ITEM_INDEX);
+    ASSERT_NE(creatorHandle_, nullptr);
+
+    readerHandle_ = LibViShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    libshm_media_head_param_t writeHead;
+    FillIndexedHead(&writeHead);
+    uint8_t vdata[32];
+    uint8_t extBuff[64];
+    memset(vdata, 0x5a, sizeof(vdata));
+
+    for (int i = 0; i < kItemCount; ++i) {
+        libshm_media_item_param_t item;
+        FillIndexedItem(&item, vdata, extBuff, i * 100, IndexedItemTvutimestamp(i));
+        ASSERT_GT(LibViShmMediaSendData(creatorHandle_, &writeHead, &item), 0);
+    }
+
+    libshm_media_item_param_t readItem;
+    // the oldest items, the worst case of walking back from the writing index
+    uint64_t wanted = IndexedItemTvutimestamp(100);
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLookups; ++i) {
+        ASSERT_EQ(LibViShmMediaSearchItems(readerHandle_, &wanted, _match_tvutimestamp), 1);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLookups; ++i) {
+        ASSERT_GT(LibViShmMediaSearchItemWithTvutimestamp(readerHandle_, wanted, nullptr, &readItem), 0);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    EXPECT_EQ(readItem.i64_vpts, 10000);
+
+    double wholeUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / kLookups;
+    double indexUs = std::chrono::duration<double, std::micro>(t2 - t1).count() / kLookups;
+    printf("[ BENCH    ] search over %d items: whole items %.1f us/lookup, item index %.1f us/lookup\n"
+           , kItemCount, wholeUs, indexUs);
+}
+
+// Benchmark batch write against the per-item path, many tiny items per video frame
+TEST_F(LibViShmMediaTest, Benchmark_SendDataBatchVsPerItem) {
+    creatorHandle_ = LibViShmMediaCreate(kTestShmName, kTestHeaderLen, 1024, 4 * 1024 * 1024);
+    ASSERT_NE(creatorHandle_, nullptr);
+
+    const int kFrames = 2000;
+    const int kItemsPerFrame = 16;
+    uint8_t payload[128];
+    memset(payload, 0x5a, sizeof(payload));
+
+    libshm_media_head_param_t writeHead;
+    libshm_media_item_param_t writeItems[kItemsPerFrame];
+    memset(&writeHead, 0, sizeof(writeHead));
+    memset(writeItems, 0, sizeof(writeItems));
+    for (int i = 0; i < kItemsPerFrame; ++i) {
+        writeItems[i].p_userData = payload;
+        writeItems[i].i_userDataLen = sizeof(payload);
+        writeItems[i].i_userDataType = LIBSHM_MEDIA_TYPE_TVULIVE_DATA;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int f = 0; f < kFrames; ++f) {
+        for (int i = 0; i < kItemsPerFrame; ++i) {
+            ASSERT_GT(LibViShmMediaSendData(creatorHandle_, &writeHead, &writeItems[i]), 0);
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int f = 0; f < kFrames; ++f) {
+        ASSERT_EQ(LibViShmMediaSendDataBatch(creatorHandle_, &writeHead, writeItems, kItemsPerFrame), kItemsPerFrame);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    const double items = (double)kFrames * kItemsPerFrame;
+    double perItemNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / items;
+    double batchNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / items;
+    printf("[ BENCH    ] %d x %d items of %d bytes: per-item %.1f ns/item, batch %.1f ns/item\n"
+           , kFrames, kItemsPerFrame, (int)sizeof(payload), perItemNs, batchNs);
+}
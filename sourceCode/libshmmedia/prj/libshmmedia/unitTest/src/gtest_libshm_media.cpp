@@ -2,6 +2,11 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <time.h>
 
 extern "C" {
 #include "libshm_media.h"
@@ -78,6 +83,165 @@ TEST(LibShmMediaBasic, SendDataNoPayload)
 #endif
 }
 
+static int send_marked_item(libshm_media_handle_t h, uint8_t mark)
+{
+    libshm_media_head_param_t head;
+    libshm_media_item_param_t item;
+    uint8_t data[64];
+
+    memset(&head, 0, sizeof(head));
+    memset(&item, 0, sizeof(item));
+    memset(data, mark, sizeof(data));
+    item.p_userData = data;
+    item.i_userDataLen = sizeof(data);
+    item.i_userDataType = LIBSHM_MEDIA_TYPE_TVULIVE_DATA;
+    return LibShmMediaSendData(h, &head, &item);
+}
+
+TEST(LibShmMediaBasic, PollReadDataBatch)
+{
+    std::string name = make_shm_name();
+    libshm_media_handle_t h = LibShmMediaCreate3(name.c_str(), 1024, 8, 4096
+                                                 , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_LOSSLESS);
+    ASSERT_NE(h, (libshm_media_handle_t)NULL);
+    libshm_media_handle_t r = LibShmMediaOpen(name.c_str(), NULL, NULL);
+    ASSERT_NE(r, (libshm_media_handle_t)NULL);
+
+    for (int i = 0; i < 5; i++) {
+        ASSERT_GT(send_marked_item(h, 0x20 + i), 0);
+    }
+
+    libshm_media_head_param_t head;
+    libshm_media_item_param_t items[8];
+    memset(&head, 0, sizeof(head));
+
+    EXPECT_EQ(LibShmMediaPollReadDataBatch(r, &head, items, 0, 0), -EINVAL);
+    int n = LibShmMediaPollReadDataBatch(r, &head, items, 8, 100);
+    ASSERT_EQ(n, 5);
+    for (int i = 0; i < n; i++) {
+        EXPECT_EQ(items[i].i_userDataLen, 64);
+        EXPECT_EQ(items[i].p_userData[0], 0x20 + i);
+    }
+    EXPECT_EQ(LibShmMediaGetReadIndex(r), 5u);
+    EXPECT_EQ(LibShmMediaPollReadDataBatch(r, &head, items, 8, 0), 0);
+
+    // lossless writer keeps the whole batch, not only its last item
+    int written = 0;
+    while (LibShmMediaPollSendable(h, 0) > 0) {
+        ASSERT_GT(send_marked_item(h, 0x40 + written), 0);
+        written++;
+    }
+    EXPECT_EQ(written, 3);
+    for (int i = 0; i < n; i++) {
+        EXPECT_EQ(items[i].p_userData[0], 0x20 + i);
+    }
+
+    LibShmMediaDestroy(r);
+    LibShmMediaDestroy(h);
+#if defined(TVU_LINUX)
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+#endif
+}
+
+#if defined(TVU_LINUX)
+TEST(LibShmMediaBasic, HugePageFallsBackToNormalPages)
+{
+    // /tmp is not a hugetlbfs mount, the creator must fall back to normal pages
+    setenv("LIBSHMMEDIA_HUGETLBFS_DIR", "/tmp", 1);
+    std::string name = make_shm_name();
+    libshm_media_handle_t h = LibShmMediaCreate3(name.c_str(), 1024, 8, 4096
+                                                 , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_HUGEPAGE);
+    unsetenv("LIBSHMMEDIA_HUGETLBFS_DIR");
+    ASSERT_NE(h, (libshm_media_handle_t)NULL);
+    EXPECT_EQ(LibShmMediaGetPageBacking(h), LIBSHM_MEDIA_PAGE_BACKING_NORMAL);
+
+    libshm_media_handle_t r = LibShmMediaOpen(name.c_str(), NULL, NULL);
+    ASSERT_NE(r, (libshm_media_handle_t)NULL);
+    EXPECT_EQ(LibShmMediaGetPageBacking(r), LIBSHM_MEDIA_PAGE_BACKING_NORMAL);
+
+    ASSERT_GT(send_marked_item(h, 0x5a), 0);
+    libshm_media_head_param_t head;
+    libshm_media_item_param_t item;
+    memset(&head, 0, sizeof(head));
+    memset(&item, 0, sizeof(item));
+    ASSERT_GT(LibShmMediaPollReadData(r, &head, &item, 100), 0);
+    EXPECT_EQ(item.p_userData[0], 0x5a);
+
+    LibShmMediaDestroy(r);
+    LibShmMediaDestroy(h);
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+}
+#endif
+
+#if defined(TVU_LINUX)
+// touch every item data byte of the ring, return the minor page faults it took
+static long touch_all_items(libshm_media_handle_t h)
+{
+    struct rusage before, after;
+    unsigned int counts = LibShmMediaGetItemCounts(h);
+    unsigned int len = LibShmMediaGetItemLength(h) / 2;
+
+    getrusage(RUSAGE_SELF, &before);
+    for (unsigned int i = 0; i < counts; i++) {
+        memset(LibShmMediaGetItemDataAddr(h, i), 0x11, len);
+    }
+    getrusage(RUSAGE_SELF, &after);
+    return after.ru_minflt - before.ru_minflt;
+}
+
+TEST(LibShmMediaBasic, PrefaultRemovesFirstLapPageFaults)
+{
+    std::string name = make_shm_name();
+    libshm_media_handle_t h = LibShmMediaCreate3(name.c_str(), 1024, 32, 256 * 1024
+                                                 , S_IRUSR | S_IWUSR, 0);
+    ASSERT_NE(h, (libshm_media_handle_t)NULL);
+    EXPECT_EQ(LibShmMediaGetPrefaultTime(h), 0);
+    long coldFaults = touch_all_items(h);
+    LibShmMediaDestroy(h);
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+
+    name = make_shm_name();
+    h = LibShmMediaCreate3(name.c_str(), 1024, 32, 256 * 1024
+                           , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_PREFAULT);
+    ASSERT_NE(h, (libshm_media_handle_t)NULL);
+    EXPECT_GT(LibShmMediaGetPrefaultTime(h), 0);
+    long warmFaults = touch_all_items(h);
+    EXPECT_LT(warmFaults * 4, coldFaults);
+
+    libshm_media_handle_t r = LibShmMediaOpen2(name.c_str(), NULL, NULL, LIBSHM_MEDIA_OPEN_FLAG_PREFAULT);
+    ASSERT_NE(r, (libshm_media_handle_t)NULL);
+    EXPECT_GT(LibShmMediaGetPrefaultTime(r), 0);
+
+    LibShmMediaDestroy(r);
+    LibShmMediaDestroy(h);
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+}
+
+TEST(LibShmMediaBasic, NumaNodeRecordedForReaders)
+{
+    std::string name = make_shm_name();
+    libshm_media_handle_t h = LibShmMediaCreate4(name.c_str(), 1024, 8, 4096
+                                                 , S_IRUSR | S_IWUSR, 0, 0);
+    ASSERT_NE(h, (libshm_media_handle_t)NULL);
+    EXPECT_EQ(LibShmMediaGetNumaNode(h), 0);
+
+    libshm_media_handle_t r = LibShmMediaOpen(name.c_str(), NULL, NULL);
+    ASSERT_NE(r, (libshm_media_handle_t)NULL);
+    EXPECT_EQ(LibShmMediaGetNumaNode(r), 0);
+    LibShmMediaDestroy(r);
+    LibShmMediaDestroy(h);
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+
+    // a node that does not exist leaves the ring unplaced, creation still succeeds
+    name = make_shm_name();
+    h = LibShmMediaCreate4(name.c_str(), 1024, 8, 4096, S_IRUSR | S_IWUSR, 0, 4000);
+    ASSERT_NE(h, (libshm_media_handle_t)NULL);
+    EXPECT_EQ(LibShmMediaGetNumaNode(h), LIBSHM_MEDIA_NUMA_NODE_NONE);
+    LibShmMediaDestroy(h);
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+}
+#endif
+
 #include <gtest/gtest.h>
 #include <memory>
 #include "libshm_media.h"  // Main API header file
@@ -1316,3 +1480,472 @@ TEST_F(LibShmMediaReadItemWithTvutimestampTest, TimestampBoundaryConditions) {
         EXPECT_TRUE(found) << "Maximum timestamp item should be found";
     }
 }
+
+TEST(LibShmMediaBasic, ValidateReadDetectsOverwrite)
+{
+    std::string name = make_shm_name();
+    const uint32_t counts = 4;
+    libshm_media_handle_t hW = LibShmMediaCreate(name.c_str(), 1024, counts, 4096);
+    ASSERT_NE(hW, (libshm_media_handle_t)NULL);
+    libshm_media_handle_t hR = LibShmMediaOpen(name.c_str(), NULL, NULL);
+    ASSERT_NE(hR, (libshm_media_handle_t)NULL);
+
+    libshm_media_head_param_t head;
+    InitMediaHeadParam(&head);
+    uint8_t vdata[256];
+    memset(vdata, 0x5A, sizeof(vdata));
+    libshm_media_item_param_t item;
+    memset(&item, 0, sizeof(item));
+    item.p_vData = vdata;
+    item.i_vLen = sizeof(vdata);
+
+    ASSERT_GT(LibShmMediaSendData(hW, &head, &item), 0);
+
+    libshm_media_head_param_t rhead;
+    LibShmMediaHeadParamInit(&rhead, sizeof(rhead));
+    libshm_media_item_param_t ritem;
+    LibShmMediaItemParamInit(&ritem, sizeof(ritem));
+    ASSERT_GT(LibShmMediaPollReadData(hR, &rhead, &ritem, 100), 0);
+    ASSERT_NE(ritem.p_vData, (const uint8_t *)NULL);
+    EXPECT_EQ(LibShmMediaValidateRead(hR, &ritem), 1);
+
+    // writer laps the reader, the zero-copy slot is reused
+    for (uint32_t i = 0; i < counts; i++)
+    {
+        item.i64_vpts = i + 1;
+        ASSERT_GT(LibShmMediaSendData(hW, &head, &item), 0);
+    }
+    EXPECT_EQ(LibShmMediaValidateRead(hR, &ritem), 0);
+
+    EXPECT_LT(LibShmMediaValidateRead(hR, NULL), 0);
+    EXPECT_LT(LibShmMediaValidateRead(NULL, &ritem), 0);
+
+    LibShmMediaDestroy(hR);
+    LibShmMediaDestroy(hW);
+#if defined(TVU_LINUX)
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+#endif
+}
+
+static uint64_t searched_item_tvutimestamp(uint32_t i)
+{
+    return (static_cast<uint64_t>(1) << 56) | (1000 + i * 10);
+}
+
+static void send_searched_items(libshm_media_handle_t h, uint32_t from, uint32_t n)
+{
+    libshm_media_head_param_t head;
+    InitMediaHeadParam(&head);
+    uint8_t vdata[64];
+    memset(vdata, 0x3C, sizeof(vdata));
+    for (uint32_t i = from; i < from + n; i++)
+    {
+        uint8_t aExtBuff[256] = {0};
+        libshm_media_item_param_t item;
+        InitMediaItemParam(&item, i, searched_item_tvutimestamp(i), aExtBuff);
+        item.p_vData = vdata;
+        item.i_vLen = sizeof(vdata);
+        ASSERT_GT(LibShmMediaSendData(h, &head, &item), 0);
+    }
+}
+
+static uint64_t read_item_with_tvutimestamp(libshm_media_handle_t h, uint64_t tvutimestamp, bool *found)
+{
+    libshm_media_head_param_t rhead;
+    libshm_media_item_param_t ritem;
+    libshmmedia_extend_data_info_t oext;
+    memset(&oext, 0, sizeof(oext));
+    bool foundPts = false;
+    *found = false;
+    if (LibShmMediaReadItemWithTvutimestampV2(h, tvutimestamp, 0, (uint64_t)-1
+        , found, &foundPts, &rhead, &ritem, &oext) <= 0)
+    {
+        return 0;
+    }
+    return oext.u64Tvutimestamp;
+}
+
+// Frame by frame searching walks forward from the last matching, the results
+// must be the same as bisecting, also after the writer lapped the ring
+TEST(LibShmMediaBasic, ReadItemWithTvutimestamp_FollowsAdvancingTarget)
+{
+    std::string name = make_shm_name();
+    const uint32_t counts = 64;
+    libshm_media_handle_t hW = LibShmMediaCreate(name.c_str(), 1024, counts, 4096);
+    ASSERT_NE(hW, (libshm_media_handle_t)NULL);
+    libshm_media_handle_t hR = LibShmMediaOpen(name.c_str(), NULL, NULL);
+    ASSERT_NE(hR, (libshm_media_handle_t)NULL);
+
+    send_searched_items(hW, 0, 48);
+    LibShmMediaSeekReadIndex(hR, 0);
+
+    bool found = false;
+    for (uint32_t i = 1; i < 48; i += 3)
+    {
+        EXPECT_EQ(read_item_with_tvutimestamp(hR, searched_item_tvutimestamp(i), &found)
+                  , searched_item_tvutimestamp(i));
+        EXPECT_TRUE(found);
+    }
+
+    // between two items, the later one is the matching
+    LibShmMediaSeekReadIndex(hR, 10);
+    EXPECT_EQ(read_item_with_tvutimestamp(hR, searched_item_tvutimestamp(20) + 5, &found)
+              , searched_item_tvutimestamp(21));
+    EXPECT_TRUE(found);
+
+    // jump far ahead of the hint
+    EXPECT_EQ(read_item_with_tvutimestamp(hR, searched_item_tvutimestamp(45), &found)
+              , searched_item_tvutimestamp(45));
+    EXPECT_TRUE(found);
+
+    // the writer overwrites the slots of the cached items
+    send_searched_items(hW, 48, 100);
+    LibShmMediaSeekReadIndex(hR, 148 - counts + 1);
+    for (uint32_t i = 90; i < 148; i += 2)
+    {
+        EXPECT_EQ(read_item_with_tvutimestamp(hR, searched_item_tvutimestamp(i), &found)
+                  , searched_item_tvutimestamp(i));
+        EXPECT_TRUE(found);
+    }
+
+    LibShmMediaDestroy(hR);
+    LibShmMediaDestroy(hW);
+#if defined(TVU_LINUX)
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+#endif
+}
+
+// Prefetching must not change what is read, and it follows the read index
+// after seeking
+TEST(LibShmMediaBasic, SetReadPrefetch_ReadsUnchanged)
+{
+    std::string name = make_shm_name();
+    libshm_media_handle_t hW = LibShmMediaCreate(name.c_str(), 1024, 16, 4096);
+    ASSERT_NE(hW, (libshm_media_handle_t)NULL);
+    libshm_media_handle_t hR = LibShmMediaOpen(name.c_str(), NULL, NULL);
+    ASSERT_NE(hR, (libshm_media_handle_t)NULL);
+
+    EXPECT_EQ(LibShmMediaSetReadPrefetch(NULL, 2, 0), -EINVAL);
+    EXPECT_EQ(LibShmMediaSetReadPrefetch(hR, LIBSHM_MEDIA_PREFETCH_MAX_DEPTH + 1, 0), -EINVAL);
+    EXPECT_EQ(LibShmMediaSetReadPrefetch(hR, 4, 1 << 30), 0);
+
+    send_searched_items(hW, 0, 40);
+    LibShmMediaSeekReadIndex(hR, 30);
+
+    libshm_media_head_param_t rhead;
+    libshm_media_item_param_t ritem;
+    for (int i = 30; i < 40; i++)
+    {
+        ASSERT_GT(LibShmMediaPollReadData(hR, &rhead, &ritem, 0), 0);
+        EXPECT_EQ(ritem.i64_vpts, i);
+        if (i == 33)
+        {
+            LibShmMediaSeekReadIndex(hR, 35);
+            i = 34;
+        }
+    }
+    EXPECT_EQ(LibShmMediaReadData(hR, &rhead, &ritem), 0);
+    EXPECT_EQ(LibShmMediaSetReadPrefetch(hR, 0, 0), 0);
+
+    LibShmMediaDestroy(hR);
+    LibShmMediaDestroy(hW);
+#if defined(TVU_LINUX)
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+#endif
+}
+
+TEST(LibShmMediaBasic, SetCopyMode_StreamingPayloadReadsBack)
+{
+    std::string name = make_shm_name();
+    const uint32_t vlen = 1920 * 1080 * 2 + 17;
+    const uint32_t alen = 4099;
+    libshm_media_handle_t hW = LibShmMediaCreate(name.c_str(), 1024, 4, vlen + alen + 4096);
+    ASSERT_NE(hW, (libshm_media_handle_t)NULL);
+    libshm_media_handle_t hR = LibShmMediaOpen(name.c_str(), NULL, NULL);
+    ASSERT_NE(hR, (libshm_media_handle_t)NULL);
+
+    EXPECT_EQ(LibShmMediaSetCopyMode(NULL, LIBSHM_MEDIA_COPY_MODE_STREAMING), -EINVAL);
+    EXPECT_EQ(LibShmMediaSetCopyMode(hW, 7), -EINVAL);
+    EXPECT_EQ(LibShmMediaSetCopyMode(hW, LIBSHM_MEDIA_COPY_MODE_STREAMING), 0);
+
+    std::vector<uint8_t> vdata(vlen);
+    std::vector<uint8_t> adata(alen);
+    for (uint32_t i = 0; i < vlen; i++)
+    {
+        vdata[i] = (uint8_t)(i * 7 + (i >> 11));
+    }
+    for (uint32_t i = 0; i < alen; i++)
+    {
+        adata[i] = (uint8_t)(i * 3);
+    }
+    libshm_media_head_param_t head;
+    InitMediaHeadParam(&head);
+
+    libshm_media_head_param_t rhead;
+    libshm_media_item_param_t ritem;
+    for (int i = 0; i < 6; i++)
+    {
+        if (i == 3)
+        {
+            EXPECT_EQ(LibShmMediaSetCopyMode(hW, LIBSHM_MEDIA_COPY_MODE_DEFAULT), 0);
+        }
+        libshm_media_item_param_t item;
+        memset(&item, 0, sizeof(item));
+        item.p_vData = vdata.data() + (i & 1);
+        item.i_vLen = vlen - 1;
+        item.p_aData = adata.data();
+        item.i_aLen = alen;
+        item.i64_vpts = i;
+        ASSERT_GT(LibShmMediaSendData(hW, &head, &item), 0);
+
+        ASSERT_GT(LibShmMediaReadData(hR, &rhead, &ritem), 0);
+        EXPECT_EQ(ritem.i64_vpts, i);
+        ASSERT_EQ(ritem.i_vLen, vlen - 1);
+        EXPECT_EQ(0, memcmp(ritem.p_vData, vdata.data() + (i & 1), vlen - 1));
+        ASSERT_EQ(ritem.i_aLen, alen);
+        EXPECT_EQ(0, memcmp(ritem.p_aData, adata.data(), alen));
+    }
+
+    LibShmMediaDestroy(hR);
+    LibShmMediaDestroy(hW);
+#if defined(TVU_LINUX)
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+#endif
+}
+
+static int g_copyModeLogs = 0;
+
+static int count_copy_mode_log(int level, const char *fmt, va_list ap)
+{
+    char slog[1024];
+    vsnprintf(slog, sizeof(slog), fmt, ap);
+    if (level == 'e' && strstr(slog, "copy mode 7 invalid"))
+    {
+        g_copyModeLogs++;
+    }
+    return 0;
+}
+
+TEST(LibShmMediaBasic, LogLevel_HandleOverridesGlobal)
+{
+    std::string name = make_shm_name();
+    libshm_media_handle_t hW = LibShmMediaCreate(name.c_str(), 1024, 4, 4096);
+    ASSERT_NE(hW, (libshm_media_handle_t)NULL);
+
+    EXPECT_EQ(LibShmMediaSetLogLevel(0), -EINVAL);
+    EXPECT_EQ(LibShmMediaSetLogLevel(LIBSHM_MEDIA_LOG_LEVEL_DEFAULT), -EINVAL);
+    EXPECT_EQ(LibShmMediaSetHandleLogLevel(NULL, LIBSHM_MEDIA_LOG_LEVEL_NONE), -EINVAL);
+    EXPECT_EQ(LibShmMediaSetHandleLogLevel(hW, LIBSHM_MEDIA_LOG_LEVEL_NONE + 1), -EINVAL);
+
+    LibShmMediaSetLogCallback(count_copy_mode_log);
+    g_copyModeLogs = 0;
+
+    /* the invalid copy mode logs an error from the methods of the handle. */
+    EXPECT_EQ(LibShmMediaSetHandleLogLevel(hW, LIBSHM_MEDIA_LOG_LEVEL_NONE), 0);
+    EXPECT_EQ(LibShmMediaSetCopyMode(hW, 7), -EINVAL);
+    EXPECT_EQ(g_copyModeLogs, 0);
+
+    EXPECT_EQ(LibShmMediaSetHandleLogLevel(hW, LIBSHM_MEDIA_LOG_LEVEL_DEFAULT), 0);
+    EXPECT_EQ(LibShmMediaSetCopyMode(hW, 7), -EINVAL);
+    EXPECT_EQ(g_copyModeLogs, 1);
+
+    EXPECT_EQ(LibShmMediaSetLogLevel(LIBSHM_MEDIA_LOG_LEVEL_NONE), 0);
+    EXPECT_EQ(LibShmMediaSetCopyMode(hW, 7), -EINVAL);
+    EXPECT_EQ(g_copyModeLogs, 1);
+
+    EXPECT_EQ(LibShmMediaSetHandleLogLevel(hW, LIBSHM_MEDIA_LOG_LEVEL_ERROR), 0);
+    EXPECT_EQ(LibShmMediaSetCopyMode(hW, 7), -EINVAL);
+    EXPECT_EQ(g_copyModeLogs, 2);
+
+    EXPECT_EQ(LibShmMediaSetLogLevel(LIBSHM_MEDIA_LOG_LEVEL_INFO), 0);
+    LibShmMediaSetLogCallback(NULL);
+
+    LibShmMediaDestroy(hW);
+#if defined(TVU_LINUX)
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+#endif
+}
+
+TEST(LibShmMediaBasic, SendData_VideoPlanesGathered)
+{
+    std::string name = make_shm_name();
+    const int w = 64, h = 16, stride = 96;
+    libshm_media_handle_t hW = LibShmMediaCreate(name.c_str(), 1024, 4, 16 * 1024);
+    ASSERT_NE(hW, (libshm_media_handle_t)NULL);
+    libshm_media_handle_t hR = LibShmMediaOpen(name.c_str(), NULL, NULL);
+    ASSERT_NE(hR, (libshm_media_handle_t)NULL);
+
+    // NV12, a padded luma DMA buffer and a contiguous chroma plane
+    std::vector<uint8_t> y(stride * h);
+    std::vector<uint8_t> uv(w * h / 2);
+    for (size_t i = 0; i < y.size(); i++)
+    {
+        y[i] = (i % stride) < (size_t)w ? (uint8_t)(i / stride + 1) : 0xEE;
+    }
+    for (size_t i = 0; i < uv.size(); i++)
+    {
+        uv[i] = (uint8_t)(0x80 + i);
+    }
+    libshm_media_video_plane_t planes[2];
+    memset(planes, 0, sizeof(planes));
+    planes[0].p_data = y.data();
+    planes[0].i_len = w * h;
+    planes[0].i_stride = stride;
+    planes[0].i_lineLen = w;
+    planes[1].p_data = uv.data();
+    planes[1].i_len = (int)uv.size();
+
+    libshm_media_head_param_t head;
+    InitMediaHeadParam(&head);
+    libshm_media_item_param_t item;
+    LibShmMediaItemParamInit(&item, sizeof(item));
+    item.p_vPlanes = planes;
+    item.i_vPlanes = 2;
+    item.i_vLen = w * h;
+    item.i64_vpts = 7;
+    EXPECT_EQ(LibShmMediaSendData(hW, &head, &item), -EINVAL);
+
+    item.i_vLen = w * h + (int)uv.size();
+    ASSERT_GT(LibShmMediaSendData(hW, &head, &item), 0);
+
+    libshm_media_head_param_t rhead;
+    libshm_media_item_param_t ritem;
+    LibShmMediaItemParamInit(&ritem, sizeof(ritem));
+    ASSERT_GT(LibShmMediaReadData(hR, &rhead, &ritem), 0);
+    EXPECT_EQ(ritem.i64_vpts, 7);
+    ASSERT_EQ(ritem.i_vLen, w * h + (int)uv.size());
+
+    // the plane table is made of the planes sent
+    libshm_media_plane_t rplanes[LIBSHM_MEDIA_VIDEO_PLANES_MAX];
+    ASSERT_EQ(LibShmMediaItemGetPlanes(&ritem, rplanes, LIBSHM_MEDIA_VIDEO_PLANES_MAX), 2);
+    EXPECT_EQ(rplanes[0].p_data, ritem.p_vData);
+    EXPECT_EQ(rplanes[0].u_stride, w);
+    EXPECT_EQ(rplanes[0].u_height, h);
+    EXPECT_EQ(rplanes[1].p_data, ritem.p_vData + w * h);
+    EXPECT_EQ(rplanes[1].u_stride, (uint32_t)uv.size());
+    EXPECT_EQ(rplanes[1].u_height, 1u);
+    for (int l = 0; l < h; l++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            ASSERT_EQ(ritem.p_vData[l * w + x], l + 1);
+        }
+    }
+    EXPECT_EQ(0, memcmp(ritem.p_vData + w * h, uv.data(), uv.size()));
+
+    LibShmMediaDestroy(hR);
+    LibShmMediaDestroy(hW);
+#if defined(TVU_LINUX)
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+#endif
+}
+
+TEST(LibShmMediaBasic, ItemGetPlanes_ReadsWriterPlaneTable)
+{
+    std::string name = make_shm_name();
+    // P010, 16 bits per sample, luma lines padded to 256 bytes
+    const uint32_t w = 96, h = 16, stride = 256;
+    const uint32_t vlen = stride * h + stride * h / 2;
+    libshm_media_handle_t hW = LibShmMediaCreate(name.c_str(), 1024, 4, vlen + 1024);
+    ASSERT_NE(hW, (libshm_media_handle_t)NULL);
+    libshm_media_handle_t hR = LibShmMediaOpen(name.c_str(), NULL, NULL);
+    ASSERT_NE(hR, (libshm_media_handle_t)NULL);
+
+    std::vector<uint8_t> vdata(vlen, 0x11);
+    memset(vdata.data() + stride * h, 0x22, stride * h / 2);
+    libshm_media_head_param_t head;
+    InitMediaHeadParam(&head);
+    head.i_dstw = w;
+    head.i_dsth = h;
+
+    libshm_media_item_param_t item;
+    LibShmMediaItemParamInit(&item, sizeof(item));
+    item.p_vData = vdata.data();
+    item.i_vLen = vlen;
+    item.i_vPlaneDescs = 2;
+    item.o_vPlaneDescs[0].u_offset = 0;
+    item.o_vPlaneDescs[0].u_stride = stride;
+    item.o_vPlaneDescs[0].u_height = h;
+    item.o_vPlaneDescs[1].u_offset = stride * h;
+    item.o_vPlaneDescs[1].u_stride = stride;
+    item.o_vPlaneDescs[1].u_height = h;
+    EXPECT_EQ(LibShmMediaSendData(hW, &head, &item), -EINVAL);
+
+    item.o_vPlaneDescs[1].u_height = h / 2;
+    ASSERT_GT(LibShmMediaSendData(hW, &head, &item), 0);
+    item.i_vPlaneDescs = 0;
+    ASSERT_GT(LibShmMediaSendData(hW, &head, &item), 0);
+
+    libshm_media_head_param_t rhead;
+    libshm_media_item_param_t ritem;
+    libshm_media_plane_t planes[LIBSHM_MEDIA_VIDEO_PLANES_MAX];
+    LibShmMediaItemParamInit(&ritem, sizeof(ritem));
+    ASSERT_GT(LibShmMediaReadData(hR, &rhead, &ritem), 0);
+    EXPECT_EQ(LibShmMediaItemGetPlanes(NULL, planes, LIBSHM_MEDIA_VIDEO_PLANES_MAX), -EINVAL);
+    EXPECT_EQ(LibShmMediaItemGetPlanes(&ritem, planes, 1), -ENOSPC);
+    ASSERT_EQ(LibShmMediaItemGetPlanes(&ritem, planes, LIBSHM_MEDIA_VIDEO_PLANES_MAX), 2);
+    EXPECT_EQ(planes[0].p_data, ritem.p_vData);
+    EXPECT_EQ(planes[0].u_stride, stride);
+    EXPECT_EQ(planes[0].u_height, h);
+    EXPECT_EQ(planes[1].p_data, ritem.p_vData + stride * h);
+    EXPECT_EQ(planes[1].u_height, h / 2);
+    EXPECT_EQ(planes[0].p_data[0], 0x11);
+    EXPECT_EQ(planes[1].p_data[stride * (h / 2) - 1], 0x22);
+
+    ASSERT_GT(LibShmMediaReadData(hR, &rhead, &ritem), 0);
+    EXPECT_EQ(LibShmMediaItemGetPlanes(&ritem, planes, LIBSHM_MEDIA_VIDEO_PLANES_MAX), 0);
+
+    LibShmMediaDestroy(hR);
+    LibShmMediaDestroy(hW);
+#if defined(TVU_LINUX)
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+#endif
+}
+
+TEST(LibShmMediaBasic, ReadData_V1ItemParamNotOverrun)
+{
+    std::string name = make_shm_name();
+    libshm_media_handle_t hW = LibShmMediaCreate(name.c_str(), 1024, 4, 4096);
+    ASSERT_NE(hW, (libshm_media_handle_t)NULL);
+    libshm_media_handle_t hR = LibShmMediaOpen(name.c_str(), NULL, NULL);
+    ASSERT_NE(hR, (libshm_media_handle_t)NULL);
+
+    uint8_t vdata[256];
+    memset(vdata, 0x33, sizeof(vdata));
+    libshm_media_head_param_t head;
+    InitMediaHeadParam(&head);
+    libshm_media_item_param_t item;
+    LibShmMediaItemParamInit(&item, sizeof(item));
+    item.p_vData = vdata;
+    item.i_vLen = sizeof(vdata);
+    item.i64_vpts = 9;
+    item.i_vPlaneDescs = 1;
+    item.o_vPlaneDescs[0].u_stride = 16;
+    item.o_vPlaneDescs[0].u_height = 16;
+    ASSERT_GT(LibShmMediaSendData(hW, &head, &item), 0);
+
+    // a caller built against the V1 structure, the bytes after it are not its own
+    union
+    {
+        libshm_media_item_param_t   v2;
+        uint8_t                     raw[sizeof(libshm_media_item_param_t)];
+    } ritem;
+    memset(ritem.raw, 0xcd, sizeof(ritem.raw));
+    LibShmMediaItemParamInit(&ritem.v2, sizeof(libshm_media_item_param_v1_t));
+
+    libshm_media_head_param_t rhead;
+    ASSERT_GT(LibShmMediaReadData(hR, &rhead, &ritem.v2), 0);
+    EXPECT_EQ(ritem.v2.i64_vpts, 9);
+    EXPECT_EQ(ritem.v2.u_reservePrivate, sizeof(libshm_media_item_param_v1_t));
+    for (size_t i = sizeof(libshm_media_item_param_v1_t); i < sizeof(ritem.raw); i++)
+    {
+        ASSERT_EQ(ritem.raw[i], 0xcd) << "offset " << i;
+    }
+
+    LibShmMediaDestroy(hR);
+    LibShmMediaDestroy(hW);
+#if defined(TVU_LINUX)
+    LibShmMediaRemoveShmidFromSystem(name.c_str());
+#endif
+}
+
@@ -17,6 +17,12 @@
 
 #include <gtest/gtest.h>
 #include <cstring>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "libshmmedia.h"
 #include "libshm_media_raw_data_opt.h"
 
@@ -187,6 +193,295 @@ TEST_F(LibShmMediaRawDataOptTest, HasReader_WithReader) {
     SUCCEED();
 }
 
+// Test LibShmMediaGetReaders / LibShmMediaGetSlowestReader
+TEST_F(LibShmMediaRawDataOptTest, GetReaders_ReportsLag) {
+    creatorHandle_ = LibShmMediaCreate(kTestShmName, kTestHeaderLen, kTestItemLen, kTestItemCount);
+    ASSERT_NE(creatorHandle_, nullptr);
+
+    libshm_media_reader_info_t readers[4];
+    EXPECT_EQ(LibShmMediaGetReaders(creatorHandle_, readers, 4), 0);
+    EXPECT_EQ(LibShmMediaGetSlowestReader(creatorHandle_, &readers[0]), 0);
+
+    readerHandle_ = LibShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+    libshm_media_handle_t idleReader = LibShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(idleReader, nullptr);
+
+    const int kWrites = 3;
+    for (int i = 0; i < kWrites; ++i) {
+        uint8_t* buffer = LibShmMediaRawDataApply(creatorHandle_, 256);
+        ASSERT_NE(buffer, nullptr);
+        for (size_t k = 0; k < 256; ++k) {
+            buffer[k] = static_cast<uint8_t>(k & 0xFF);
+        }
+        ASSERT_GT(LibShmMediaRawDataCommit(creatorHandle_, buffer, 256), 0);
+    }
+
+    libshmmedia_raw_head_param_t readHead;
+    libshmmedia_raw_data_param_t readData;
+    for (int i = 0; i < kWrites; ++i) {
+        memset(&readHead, 0, sizeof(readHead));
+        memset(&readData, 0, sizeof(readData));
+        ASSERT_GT(LibShmMediaRawDataRead(readerHandle_, &readHead, &readData, 100), 0);
+    }
+    // nothing left, marks the reader caught up
+    EXPECT_EQ(LibShmMediaRawDataRead(readerHandle_, &readHead, &readData, 0), 0);
+
+    ASSERT_EQ(LibShmMediaGetReaders(creatorHandle_, readers, 4), 2);
+    uint32_t lags[2] = { readers[0].u_lag_items, readers[1].u_lag_items };
+    EXPECT_EQ(std::min(lags[0], lags[1]), 0u);
+    EXPECT_EQ(std::max(lags[0], lags[1]), (uint32_t)kWrites);
+    EXPECT_EQ(readers[0].u_pid, (uint32_t)getpid());
+
+    libshm_media_reader_info_t slowest;
+    ASSERT_EQ(LibShmMediaGetSlowestReader(creatorHandle_, &slowest), 1);
+    EXPECT_EQ(slowest.u_lag_items, (uint32_t)kWrites);
+    EXPECT_EQ(slowest.u_read_index, LibShmMediaGetWriteIndex(creatorHandle_) - kWrites);
+
+    // destroying a reader frees its slot
+    LibShmMediaDestroy(idleReader);
+    ASSERT_EQ(LibShmMediaGetReaders(creatorHandle_, readers, 4), 1);
+    EXPECT_EQ(readers[0].u_lag_items, 0u);
+
+    EXPECT_LT(LibShmMediaGetReaders(creatorHandle_, nullptr, 4), 0);
+    EXPECT_LT(LibShmMediaGetSlowestReader(nullptr, &slowest), 0);
+}
+
+// Lossless writer waits for the slowest registered reader
+TEST_F(LibShmMediaRawDataOptTest, Lossless_WriterBlocksOnSlowestReader) {
+    const uint32_t kItems = 4;
+    creatorHandle_ = LibShmMediaCreate3(kTestShmName, kTestHeaderLen, kItems, kTestItemLen
+                                        , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_LOSSLESS);
+    ASSERT_NE(creatorHandle_, nullptr);
+    readerHandle_ = LibShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    // one slot stays for the item the reader could still reference
+    int written = 0;
+    for (uint32_t i = 0; i < kItems; ++i) {
+        uint8_t* buffer = LibShmMediaRawDataApply(creatorHandle_, 256);
+        if (!buffer) {
+            break;
+        }
+        memset(buffer, 0x10 + i, 256);
+        ASSERT_GT(LibShmMediaRawDataCommit(creatorHandle_, buffer, 256), 0);
+        written++;
+    }
+    EXPECT_EQ(written, (int)kItems - 1);
+    EXPECT_EQ(LibShmMediaPollSendable(creatorHandle_, 0), 0);
+    EXPECT_EQ(LibShmMediaPollSendable(creatorHandle_, 5), 0);
+
+    libshmmedia_raw_head_param_t readHead;
+    libshmmedia_raw_data_param_t readData;
+    memset(&readHead, 0, sizeof(readHead));
+    memset(&readData, 0, sizeof(readData));
+    ASSERT_GT(LibShmMediaRawDataRead(readerHandle_, &readHead, &readData, 100), 0);
+    EXPECT_GT(LibShmMediaPollSendable(creatorHandle_, 0), 0);
+
+    uint8_t* buffer = LibShmMediaRawDataApply(creatorHandle_, 256);
+    ASSERT_NE(buffer, nullptr);
+    memset(buffer, 0x10 + written, 256);
+    ASSERT_GT(LibShmMediaRawDataCommit(creatorHandle_, buffer, 256), 0);
+    EXPECT_EQ(LibShmMediaPollSendable(creatorHandle_, 0), 0);
+
+    // nothing was overwritten
+    for (int i = 1; i <= written; ++i) {
+        memset(&readData, 0, sizeof(readData));
+        ASSERT_GT(LibShmMediaRawDataRead(readerHandle_, &readHead, &readData, 100), 0);
+        ASSERT_NE(readData.pRawData_, nullptr);
+        EXPECT_EQ(readData.pRawData_[0], 0x10 + i);
+    }
+
+    // a closed reader no longer holds the writer
+    LibShmMediaDestroy(readerHandle_);
+    readerHandle_ = nullptr;
+    EXPECT_GT(LibShmMediaPollSendable(creatorHandle_, 0), 0);
+}
+
+// A lossless reader silent over the slot expiry loses its slot, its next read reports the loss
+TEST_F(LibShmMediaRawDataOptTest, Lossless_SilentReaderEvictedReportsLoss) {
+    const uint32_t kItems = 4;
+    creatorHandle_ = LibShmMediaCreate3(kTestShmName, kTestHeaderLen, kItems, kTestItemLen
+                                        , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_LOSSLESS);
+    ASSERT_NE(creatorHandle_, nullptr);
+    readerHandle_ = LibShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    for (uint32_t i = 0; i < kItems - 1; ++i) {
+        uint8_t* buffer = LibShmMediaRawDataApply(creatorHandle_, 256);
+        ASSERT_NE(buffer, nullptr);
+        memset(buffer, 0x10 + i, 256);
+        ASSERT_GT(LibShmMediaRawDataCommit(creatorHandle_, buffer, 256), 0);
+    }
+    EXPECT_EQ(LibShmMediaPollSendable(creatorHandle_, 0), 0);
+
+    libshmmedia_raw_head_param_t readHead;
+    libshmmedia_raw_data_param_t readData;
+    memset(&readHead, 0, sizeof(readHead));
+    memset(&readData, 0, sizeof(readData));
+    ASSERT_GT(LibShmMediaRawDataRead(readerHandle_, &readHead, &readData, 100), 0);
+
+    // the reader stalls on the item longer than the 3s expiry of its slot
+    std::this_thread::sleep_for(std::chrono::milliseconds(3500));
+    for (uint32_t i = 0; i < kItems; ++i) {
+        ASSERT_GT(LibShmMediaPollSendable(creatorHandle_, 0), 0);
+        uint8_t* buffer = LibShmMediaRawDataApply(creatorHandle_, 256);
+        ASSERT_NE(buffer, nullptr);
+        memset(buffer, 0x20 + i, 256);
+        ASSERT_GT(LibShmMediaRawDataCommit(creatorHandle_, buffer, 256), 0);
+    }
+
+    memset(&readData, 0, sizeof(readData));
+    EXPECT_EQ(LibShmMediaRawDataRead(readerHandle_, &readHead, &readData, 100), -EPIPE);
+
+    // registered again, it goes on reading and holds the writer again
+    libshm_media_reader_info_t readers[4];
+    EXPECT_EQ(LibShmMediaGetReaders(creatorHandle_, readers, 4), 1);
+    memset(&readData, 0, sizeof(readData));
+    EXPECT_GT(LibShmMediaRawDataRead(readerHandle_, &readHead, &readData, 100), 0);
+}
+
+// A blocked lossless writer polling for sendable is woken by the reader releasing an item
+TEST_F(LibShmMediaRawDataOptTest, Lossless_PollSendableWokenByRead) {
+    const uint32_t kItems = 4;
+    creatorHandle_ = LibShmMediaCreate3(kTestShmName, kTestHeaderLen, kItems, kTestItemLen
+                                        , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_LOSSLESS);
+    ASSERT_NE(creatorHandle_, nullptr);
+    readerHandle_ = LibShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    for (uint32_t i = 0; i + 1 < kItems; ++i) {
+        uint8_t* buffer = LibShmMediaRawDataApply(creatorHandle_, 256);
+        ASSERT_NE(buffer, nullptr);
+        memset(buffer, 0x10 + i, 256);
+        ASSERT_GT(LibShmMediaRawDataCommit(creatorHandle_, buffer, 256), 0);
+    }
+    ASSERT_EQ(LibShmMediaPollSendable(creatorHandle_, 0), 0);
+
+    int readRet = 0;
+    std::thread reader([&]() {
+        usleep(20 * 1000);
+        libshmmedia_raw_head_param_t readHead;
+        libshmmedia_raw_data_param_t readData;
+        memset(&readHead, 0, sizeof(readHead));
+        memset(&readData, 0, sizeof(readData));
+        readRet = LibShmMediaRawDataRead(readerHandle_, &readHead, &readData, 100);
+    });
+    EXPECT_GT(LibShmMediaPollSendable(creatorHandle_, 10 * 1000), 0);
+    reader.join();
+    EXPECT_GT(readRet, 0);
+}
+
+// Statistics counters of the writer and the registered readers
+TEST_F(LibShmMediaRawDataOptTest, GetStats_CountsWritesReadsAndLapping) {
+    const uint32_t kItems = 4;
+    creatorHandle_ = LibShmMediaCreate3(kTestShmName, kTestHeaderLen, kItems, kTestItemLen
+                                        , S_IRUSR | S_IWUSR, 0);
+    ASSERT_NE(creatorHandle_, nullptr);
+    readerHandle_ = LibShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    uint8_t frame[32 * 8];
+    memset(frame, 0x3c, sizeof(frame));
+    libshm_media_head_param_t head;
+    libshm_media_item_param_t item;
+    memset(&head, 0, sizeof(head));
+    memset(&item, 0, sizeof(item));
+    head.i_dstw = 32;
+    head.i_dsth = 8;
+    head.i_duration = 1;
+    head.i_scale = 25;
+    item.p_vData = frame;
+    item.i_vLen = sizeof(frame);
+
+    libshm_media_stats_t stats;
+    ASSERT_EQ(LibShmMediaGetStats(creatorHandle_, &stats), 1);
+    EXPECT_EQ(stats.u_frames_written, 0u);
+    EXPECT_EQ(stats.readers[0].u_frames_read, 0u);
+
+    ASSERT_GT(LibShmMediaSendData(creatorHandle_, &head, &item), 0);
+    item.i_vLen = 16;
+    ASSERT_GT(LibShmMediaSendData(creatorHandle_, &head, &item), 0);
+
+    libshm_media_head_param_t readHead;
+    libshm_media_item_param_t readItem;
+    memset(&readHead, 0, sizeof(readHead));
+    ASSERT_GT(LibShmMediaPollReadData(readerHandle_, &readHead, &readItem, 100), 0);
+    ASSERT_GT(LibShmMediaPollReadData(readerHandle_, &readHead, &readItem, 100), 0);
+
+    // the reader scrapes the writer's counters too
+    ASSERT_EQ(LibShmMediaGetStats(readerHandle_, &stats), 1);
+    EXPECT_EQ(stats.u_frames_written, 2u);
+    EXPECT_GE(stats.u_bytes_written, sizeof(frame) + 16);
+    EXPECT_GE(stats.u_max_item_size, sizeof(frame));
+    EXPECT_LT(stats.u_max_item_size, stats.u_bytes_written);
+    EXPECT_EQ(stats.readers[0].u_pid, (uint32_t)getpid());
+    EXPECT_EQ(stats.readers[0].u_frames_read, 2u);
+    EXPECT_EQ(stats.readers[0].u_frames_dropped, 0u);
+    uint64_t latencies = 0;
+    for (int b = 0; b < LIBSHM_MEDIA_STATS_LATENCY_BUCKETS; ++b) {
+        latencies += stats.readers[0].u_latency_ms[b];
+    }
+    EXPECT_EQ(latencies, 2u);
+
+    // the writer laps the reader twice, which jumps forward by whole laps
+    for (uint32_t i = 0; i < 2 * kItems + 1; ++i) {
+        ASSERT_GT(LibShmMediaSendData(creatorHandle_, &head, &item), 0);
+    }
+    ASSERT_GT(LibShmMediaPollReadData(readerHandle_, &readHead, &readItem, 100), 0);
+    ASSERT_EQ(LibShmMediaGetStats(creatorHandle_, &stats), 1);
+    EXPECT_EQ(stats.u_frames_written, 3u + 2 * kItems);
+    EXPECT_EQ(stats.readers[0].u_overruns, 1u);
+    EXPECT_EQ(stats.readers[0].u_frames_dropped, (uint64_t)(2 * kItems));
+    EXPECT_EQ(stats.readers[0].u_frames_read, 3u);
+
+    EXPECT_EQ(LibShmMediaGetStats(creatorHandle_, nullptr), -EINVAL);
+}
+
+// A monitor handle peeks at the ring without registering or reading
+TEST_F(LibShmMediaRawDataOptTest, Monitor_PeeksWithoutHoldingTheWriter) {
+    const uint32_t kItems = 4;
+    EXPECT_EQ(LibShmMediaProbeShm(kTestShmName), -ENOENT);
+    creatorHandle_ = LibShmMediaCreate3(kTestShmName, kTestHeaderLen, kItems, kTestItemLen
+                                        , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_LOSSLESS);
+    ASSERT_NE(creatorHandle_, nullptr);
+    EXPECT_EQ(LibShmMediaProbeShm(kTestShmName), LIBSHM_MEDIA_SHM_TYPE_FIXED);
+    readerHandle_ = LibShmMediaOpen2(kTestShmName, nullptr, nullptr, LIBSHM_MEDIA_OPEN_FLAG_MONITOR);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    libshm_media_reader_info_t readers[4];
+    EXPECT_EQ(LibShmMediaGetReaders(creatorHandle_, readers, 4), 0);
+    libshm_media_head_param_t peek;
+    memset(&peek, 0, sizeof(peek));
+    EXPECT_EQ(LibShmMediaPeekLatestHead(readerHandle_, &peek), 0);
+
+    uint8_t frame[64 * 16];
+    memset(frame, 0x5a, sizeof(frame));
+    libshm_media_head_param_t head;
+    libshm_media_item_param_t item;
+    memset(&head, 0, sizeof(head));
+    memset(&item, 0, sizeof(item));
+    head.i_duration = 1;
+    head.i_scale = 25;
+    item.p_vData = frame;
+    item.i_vLen = sizeof(frame);
+
+    // the lossless writer does not keep a slot for the monitor
+    for (uint32_t i = 0; i < 2 * kItems; ++i) {
+        head.i_dstw = (i == 2 * kItems - 1) ? 64 : 32;
+        head.i_dsth = (i == 2 * kItems - 1) ? 16 : 8;
+        ASSERT_GT(LibShmMediaSendData(creatorHandle_, &head, &item), 0);
+    }
+
+    ASSERT_GT(LibShmMediaPeekLatestHead(readerHandle_, &peek), 0);
+    EXPECT_EQ(peek.i_dstw, 64);
+    EXPECT_EQ(peek.i_dsth, 16);
+    EXPECT_EQ(LibShmMediaGetReadIndex(readerHandle_), 0u);
+    EXPECT_EQ(LibShmMediaHasReader(creatorHandle_, 1000), 0);
+    EXPECT_EQ(LibShmMediaCheckCloseflag(readerHandle_), 0);
+    EXPECT_EQ(LibShmMediaPeekLatestHead(readerHandle_, nullptr), -EINVAL);
+}
+
 // Test LibShmMediaItemApplyBuffer
 TEST_F(LibShmMediaRawDataOptTest, ItemApplyBuffer_ValidParams) {
     creatorHandle_ = LibShmMediaCreate(kTestShmName, kTestHeaderLen, kTestItemLen, kTestItemCount);
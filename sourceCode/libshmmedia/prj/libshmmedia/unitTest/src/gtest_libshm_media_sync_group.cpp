@@ -0,0 +1,315 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+/**
+ * @file gtest_libshm_media_sync_group.cpp
+ * @brief Unit tests for libshm_media_sync_group.cpp
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+#include "libshm_media_sync_group.h"
+#include "libshm_tvu_timestamp.h"
+
+static const uint64_t kSyncBaseIndex = 100000;
+
+// frame @i at 25 fps, 40 ms one frame
+static uint64_t SyncFrameTvutimestamp(int i) {
+    return LibshmutilTvutimestampMerge(kSyncBaseIndex + i, TVU_FPS_KEY_25);
+}
+
+// the same frame in milli-seconds, @jitter ms later
+static uint64_t SyncFrameMsTvutimestamp(int i, int jitter) {
+    return LibshmutilTvutimestampMerge((kSyncBaseIndex + i) * 40 + jitter, TVU_FPS_KEY_MILLISEC);
+}
+
+class LibShmMediaSyncGroupTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        group_ = nullptr;
+        nFixed_ = 0;
+        nVi_ = 0;
+    }
+
+    void TearDown() override {
+        if (group_) {
+            LibShmMediaSyncGroupDestroy(group_);
+        }
+        for (int i = 0; i < nFixed_; ++i) {
+            LibShmMediaDestroy(fixedReaders_[i]);
+            LibShmMediaDestroy(fixedWriters_[i]);
+            LibShmMediaRemoveShmidFromSystem(fixedNames_[i].c_str());
+        }
+        for (int i = 0; i < nVi_; ++i) {
+            LibViShmMediaDestroy(viReaders_[i]);
+            LibViShmMediaDestroy(viWriters_[i]);
+            LibViShmMediaRemoveShmFromSystem(viNames_[i].c_str());
+        }
+    }
+
+    // create one constant ring, return its index of fixedWriters_/fixedReaders_
+    int AddFixedRing(uint32_t counts) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "/gtest_sync_group_%d_%d", (int)getpid(), nFixed_);
+        fixedNames_[nFixed_] = buf;
+        LibShmMediaRemoveShmidFromSystem(buf);
+        fixedWriters_[nFixed_] = LibShmMediaCreate(buf, 1024, counts, 4096);
+        fixedReaders_[nFixed_] = LibShmMediaOpen(buf, NULL, NULL);
+        EXPECT_NE(fixedWriters_[nFixed_], nullptr);
+        EXPECT_NE(fixedReaders_[nFixed_], nullptr);
+        return nFixed_++;
+    }
+
+    int AddViRing(uint32_t counts) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "gtest_sync_group_vi_%d_%d", (int)getpid(), nVi_);
+        viNames_[nVi_] = buf;
+        LibViShmMediaRemoveShmFromSystem(buf);
+        viWriters_[nVi_] = LibViShmMediaCreate3(buf, 1024, counts, 1024 * 1024
+                                                , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_ITEM_INDEX);
+        viReaders_[nVi_] = LibViShmMediaOpen(buf, NULL, NULL);
+        EXPECT_NE(viWriters_[nVi_], nullptr);
+        EXPECT_NE(viReaders_[nVi_], nullptr);
+        return nVi_++;
+    }
+
+    // item of pts @pts tagged with @tvutimestamp, @vlen bytes of video
+    static void SendItem(libshm_media_handle_t h, bool bVi, int64_t pts, uint64_t tvutimestamp, size_t vlen = 32) {
+        libshm_media_head_param_t head;
+        libshm_media_item_param_t item;
+        libshmmedia_extend_data_info_t ext;
+        uint8_t extBuff[64];
+        std::vector<uint8_t> vdata(vlen, 0x5a);
+
+        memset(&head, 0, sizeof(head));
+        head.i_dstw = 1920;
+        head.i_dsth = 1080;
+        head.u_videofourcc = 0x31637661;  // avc1
+        head.i_duration = 1;
+        head.i_scale = 25;
+
+        memset(&ext, 0, sizeof(ext));
+        ext.bGotTvutimestamp = true;
+        ext.u64Tvutimestamp = tvutimestamp;
+
+        memset(&item, 0, sizeof(item));
+        item.p_vData = vdata.data();
+        item.i_vLen = (int)vdata.size();
+        item.i64_vpts = pts;
+        item.i_userDataType = LIBSHM_MEDIA_TYPE_TVU_EXTEND_DATA_V2;
+        item.p_userData = extBuff;
+        item.i_userDataLen = LibShmMediaWriteExtendData(extBuff, LibShmMediaEstimateExtendDataSize(&ext), &ext);
+
+        if (bVi) {
+            ASSERT_GT(LibViShmMediaSendData(h, &head, &item), 0);
+        } else {
+            ASSERT_GT(LibShmMediaSendData(h, &head, &item), 0);
+        }
+    }
+
+    libshm_media_sync_group_handle_t group_;
+    int nFixed_;
+    int nVi_;
+    std::string fixedNames_[4];
+    libshm_media_handle_t fixedWriters_[4];
+    libshm_media_handle_t fixedReaders_[4];
+    std::string viNames_[4];
+    libshm_media_handle_t viWriters_[4];
+    libshm_media_handle_t viReaders_[4];
+};
+
+// Test frame sets of rings in different timestamp units, frame by frame
+TEST_F(LibShmMediaSyncGroupTest, PollFrames_MatchesAcrossRings) {
+    int a = AddFixedRing(32);
+    int b = AddFixedRing(32);
+    int v = AddViRing(32);
+    for (int i = 0; i < 20; ++i) {
+        SendItem(fixedWriters_[a], false, i, SyncFrameTvutimestamp(i));
+        SendItem(fixedWriters_[b], false, i, SyncFrameMsTvutimestamp(i, 3));
+        SendItem(viWriters_[v], true, i, SyncFrameTvutimestamp(i));
+    }
+
+    group_ = LibShmMediaSyncGroupCreate(10);
+    ASSERT_NE(group_, nullptr);
+    ASSERT_EQ(LibShmMediaSyncGroupAddSource(group_, fixedReaders_[a]), 0);
+    ASSERT_EQ(LibShmMediaSyncGroupAddSource(group_, fixedReaders_[b]), 1);
+    ASSERT_EQ(LibShmMediaSyncGroupAddViSource(group_, viReaders_[v]), 2);
+    ASSERT_EQ(LibShmMediaSyncGroupSetTarget(group_, SyncFrameTvutimestamp(5)), 0);
+
+    libshm_media_sync_frame_t frames[3];
+    for (int i = 5; i < 20; ++i) {
+        ASSERT_EQ(LibShmMediaSyncGroupPollFrames(group_, frames, 3, 0), 3);
+        for (int s = 0; s < 3; ++s) {
+            EXPECT_EQ(frames[s].i_status, LIBSHM_MEDIA_SYNC_STATUS_MATCHED);
+            EXPECT_EQ(frames[s].o_item.i64_vpts, i);
+        }
+        EXPECT_EQ(frames[0].u64_tvutimestamp, SyncFrameTvutimestamp(i));
+        EXPECT_NEAR(frames[1].i64_offset_ms, 3, 1);
+        EXPECT_EQ(frames[2].i64_offset_ms, 0);
+    }
+    EXPECT_EQ(LibShmMediaSyncGroupGetTarget(group_), SyncFrameTvutimestamp(20));
+
+    // the handles were stepped over the matched items
+    EXPECT_EQ(LibShmMediaGetReadIndex(fixedReaders_[a]), 20u);
+    EXPECT_EQ(LibViShmMediaGetReadIndex(viReaders_[v]), LibViShmMediaGetWriteIndex(viReaders_[v]));
+}
+
+// Test a source which skipped frames, and a source which has not written yet
+TEST_F(LibShmMediaSyncGroupTest, PollFrames_MissingAndLate) {
+    int a = AddFixedRing(32);
+    int b = AddFixedRing(32);
+    for (int i = 0; i < 10; ++i) {
+        SendItem(fixedWriters_[a], false, i, SyncFrameTvutimestamp(i));
+        if (i != 5 && i != 6) {
+            SendItem(fixedWriters_[b], false, i, SyncFrameTvutimestamp(i));
+        }
+    }
+
+    group_ = LibShmMediaSyncGroupCreate(10);
+    ASSERT_EQ(LibShmMediaSyncGroupAddSource(group_, fixedReaders_[a]), 0);
+    ASSERT_EQ(LibShmMediaSyncGroupAddSource(group_, fixedReaders_[b]), 1);
+    ASSERT_EQ(LibShmMediaSyncGroupSetTarget(group_, SyncFrameTvutimestamp(5)), 0);
+
+    libshm_media_sync_frame_t frames[2];
+    EXPECT_EQ(LibShmMediaSyncGroupPollFrames(group_, frames, 2, 0), 1);
+    EXPECT_EQ(frames[0].i_status, LIBSHM_MEDIA_SYNC_STATUS_MATCHED);
+    EXPECT_EQ(frames[1].i_status, LIBSHM_MEDIA_SYNC_STATUS_MISSING);
+    EXPECT_EQ(frames[1].u64_tvutimestamp, SyncFrameTvutimestamp(7));
+    EXPECT_EQ(frames[1].i64_offset_ms, 80);
+
+    EXPECT_EQ(LibShmMediaSyncGroupPollFrames(group_, frames, 2, 0), 1);
+    EXPECT_EQ(frames[1].i_status, LIBSHM_MEDIA_SYNC_STATUS_MISSING);
+    for (int i = 7; i < 10; ++i) {
+        EXPECT_EQ(LibShmMediaSyncGroupPollFrames(group_, frames, 2, 0), 2);
+    }
+
+    // nothing of the target yet, non-block, the target stays
+    EXPECT_EQ(LibShmMediaSyncGroupPollFrames(group_, frames, 2, 0), 0);
+    EXPECT_EQ(frames[0].i_status, LIBSHM_MEDIA_SYNC_STATUS_LATE);
+    EXPECT_EQ(frames[1].i_status, LIBSHM_MEDIA_SYNC_STATUS_LATE);
+    EXPECT_EQ(LibShmMediaSyncGroupGetTarget(group_), SyncFrameTvutimestamp(10));
+
+    // one source writes while the group is waiting, the other stays late
+    std::thread writer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        SendItem(fixedWriters_[a], false, 10, SyncFrameTvutimestamp(10));
+    });
+    auto t1 = std::chrono::steady_clock::now();
+    EXPECT_EQ(LibShmMediaSyncGroupPollFrames(group_, frames, 2, 200), 1);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t1).count();
+    writer.join();
+    EXPECT_EQ(frames[0].i_status, LIBSHM_MEDIA_SYNC_STATUS_MATCHED);
+    EXPECT_EQ(frames[0].o_item.i64_vpts, 10);
+    EXPECT_EQ(frames[1].i_status, LIBSHM_MEDIA_SYNC_STATUS_LATE);
+    EXPECT_GE(ms, 190);
+    EXPECT_EQ(LibShmMediaSyncGroupGetTarget(group_), SyncFrameTvutimestamp(10));
+}
+
+// Test a vi source whose payloads were overwritten while their index slots were not
+TEST_F(LibShmMediaSyncGroupTest, PollFrames_ViPayloadOverwritten) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "gtest_sync_group_vi_%d_%d", (int)getpid(), nVi_);
+    viNames_[nVi_] = buf;
+    LibViShmMediaRemoveShmFromSystem(buf);
+    // payloads of 4 KB wrap far before the 256 index slots do
+    viWriters_[nVi_] = LibViShmMediaCreate3(buf, 1024, 256, 4096, S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_ITEM_INDEX);
+    viReaders_[nVi_] = LibViShmMediaOpen(buf, NULL, NULL);
+    ASSERT_NE(viWriters_[nVi_], nullptr);
+    ASSERT_NE(viReaders_[nVi_], nullptr);
+    int v = nVi_++;
+
+    group_ = LibShmMediaSyncGroupCreate(10);
+    ASSERT_EQ(LibShmMediaSyncGroupAddViSource(group_, viReaders_[v]), 0);
+    for (int i = 0; i < 100; ++i) {
+        SendItem(viWriters_[v], true, i, SyncFrameTvutimestamp(i), 4096);
+    }
+
+    libshm_media_sync_frame_t frames[1];
+    ASSERT_EQ(LibShmMediaSyncGroupSetTarget(group_, SyncFrameTvutimestamp(5)), 0);
+    EXPECT_EQ(LibShmMediaSyncGroupPollFrames(group_, frames, 1, 100), 0);
+    // the slot of 5 is still indexed but its payload is gone, stepped over as missing
+    EXPECT_EQ(frames[0].i_status, LIBSHM_MEDIA_SYNC_STATUS_MISSING);
+    EXPECT_EQ(LibShmMediaSyncGroupGetTarget(group_), SyncFrameTvutimestamp(6));
+
+    // the latest ones are still there
+    ASSERT_EQ(LibShmMediaSyncGroupSetTarget(group_, SyncFrameTvutimestamp(99)), 0);
+    EXPECT_EQ(LibShmMediaSyncGroupPollFrames(group_, frames, 1, 0), 1);
+    EXPECT_EQ(frames[0].o_item.i64_vpts, 99);
+}
+
+// Test the cursors fell out of the rings and a target jumping ahead
+TEST_F(LibShmMediaSyncGroupTest, PollFrames_SeeksAfterFallingBehind) {
+    int a = AddFixedRing(16);
+    int v = AddViRing(16);
+
+    group_ = LibShmMediaSyncGroupCreate(10);
+    ASSERT_EQ(LibShmMediaSyncGroupAddSource(group_, fixedReaders_[a]), 0);
+    ASSERT_EQ(LibShmMediaSyncGroupAddViSource(group_, viReaders_[v]), 1);
+
+    for (int i = 0; i < 20; ++i) {
+        SendItem(fixedWriters_[a], false, i, SyncFrameTvutimestamp(i));
+        SendItem(viWriters_[v], true, i, SyncFrameTvutimestamp(i));
+    }
+
+    libshm_media_sync_frame_t frames[2];
+    ASSERT_EQ(LibShmMediaSyncGroupSetTarget(group_, SyncFrameTvutimestamp(12)), 0);
+    EXPECT_EQ(LibShmMediaSyncGroupPollFrames(group_, frames, 2, 0), 2);
+    EXPECT_EQ(frames[0].o_item.i64_vpts, 12);
+    EXPECT_EQ(frames[1].o_item.i64_vpts, 12);
+
+    // the target between two frames, the items of the tolerance
+    ASSERT_EQ(LibShmMediaSyncGroupSetTarget(group_, LibshmutilTvutimestampMerge((kSyncBaseIndex + 19) * 40 - 8, TVU_FPS_KEY_MILLISEC)), 0);
+    EXPECT_EQ(LibShmMediaSyncGroupPollFrames(group_, frames, 2, 0), 2);
+    EXPECT_EQ(frames[0].o_item.i64_vpts, 19);
+    EXPECT_NEAR(frames[1].i64_offset_ms, 8, 1);
+
+    // before what the sources have gone past
+    ASSERT_EQ(LibShmMediaSyncGroupSetTarget(group_, SyncFrameTvutimestamp(2)), 0);
+    EXPECT_EQ(LibShmMediaSyncGroupPollFrames(group_, frames, 2, 0), 0);
+    EXPECT_EQ(frames[0].i_status, LIBSHM_MEDIA_SYNC_STATUS_MISSING);
+    EXPECT_EQ(frames[1].i_status, LIBSHM_MEDIA_SYNC_STATUS_MISSING);
+    EXPECT_EQ(frames[1].u64_tvutimestamp, SyncFrameTvutimestamp(19));
+}
+
+// Test invalid parameters
+TEST_F(LibShmMediaSyncGroupTest, InvalidParameters) {
+    int a = AddFixedRing(8);
+    libshm_media_sync_frame_t frames[2];
+
+    EXPECT_EQ(LibShmMediaSyncGroupAddSource(nullptr, fixedReaders_[a]), -EINVAL);
+    EXPECT_EQ(LibShmMediaSyncGroupSetTarget(nullptr, SyncFrameTvutimestamp(0)), -EINVAL);
+    EXPECT_EQ(LibShmMediaSyncGroupGetTarget(nullptr), (uint64_t)-1);
+    EXPECT_EQ(LibShmMediaSyncGroupPollFrames(nullptr, frames, 2, 0), -EINVAL);
+
+    group_ = LibShmMediaSyncGroupCreate(10);
+    ASSERT_NE(group_, nullptr);
+    EXPECT_EQ(LibShmMediaSyncGroupAddSource(group_, nullptr), -EINVAL);
+    EXPECT_EQ(LibShmMediaSyncGroupGetTarget(group_), (uint64_t)-1);
+    EXPECT_EQ(LibShmMediaSyncGroupSetTarget(group_, (uint64_t)-1), -EINVAL);
+
+    for (int i = 0; i < LIBSHM_MEDIA_SYNC_GROUP_MAX_SOURCES; ++i) {
+        ASSERT_EQ(LibShmMediaSyncGroupAddSource(group_, fixedReaders_[a]), i);
+    }
+    EXPECT_EQ(LibShmMediaSyncGroupAddSource(group_, fixedReaders_[a]), -ENOSPC);
+
+    // no target yet, and too few frames
+    EXPECT_EQ(LibShmMediaSyncGroupPollFrames(group_, frames, LIBSHM_MEDIA_SYNC_GROUP_MAX_SOURCES, 0), -EINVAL);
+    ASSERT_EQ(LibShmMediaSyncGroupSetTarget(group_, SyncFrameTvutimestamp(0)), 0);
+    EXPECT_EQ(LibShmMediaSyncGroupPollFrames(group_, frames, 2, 0), -EINVAL);
+}
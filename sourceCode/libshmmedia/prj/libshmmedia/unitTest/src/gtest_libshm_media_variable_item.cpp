@@ -17,9 +17,13 @@
 
 #include <gtest/gtest.h>
 #include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <sys/stat.h>
 #include <thread>
 #include <chrono>
 #include "libshm_media_variable_item.h"
+#include "libshmmedia_variableitem_rawdata.h"
 
 class LibViShmMediaTest : public ::testing::Test {
 protected:
@@ -521,3 +525,554 @@ TEST_F(LibViShmMediaTest, MultipleWritesThenReads) {
         }
     }
 }
+
+// Test batch read drains all ready items in one call
+TEST_F(LibViShmMediaTest, PollReadDataBatch_DrainsReadyItems) {
+    creatorHandle_ = LibViShmMediaCreate(kTestShmName, kTestHeaderLen, kTestItemCount, kTestTotalSize);
+    ASSERT_NE(creatorHandle_, nullptr);
+
+    readerHandle_ = LibViShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    const int numItems = 5;
+
+    for (int i = 0; i < numItems; ++i) {
+        libshm_media_head_param_t writeHead;
+        libshm_media_item_param_t writeItem;
+        memset(&writeHead, 0, sizeof(writeHead));
+        memset(&writeItem, 0, sizeof(writeItem));
+
+        uint8_t testData[64];
+        memset(testData, i, sizeof(testData));
+
+        writeItem.p_userData = testData;
+        writeItem.i_userDataLen = sizeof(testData);
+        writeItem.i_userDataType = LIBSHM_MEDIA_TYPE_TVULIVE_DATA;
+
+        ASSERT_GT(LibViShmMediaSendData(creatorHandle_, &writeHead, &writeItem), 0);
+    }
+
+    libshm_media_head_param_t readHead;
+    libshm_media_item_param_t readItems[8];
+    memset(&readHead, 0, sizeof(readHead));
+
+    EXPECT_EQ(LibViShmMediaPollReadDataBatch(readerHandle_, &readHead, readItems, 0, 0), -EINVAL);
+
+    int n = LibViShmMediaPollReadDataBatch(readerHandle_, &readHead, readItems, 3, 100);
+    ASSERT_EQ(n, 3);
+    n += LibViShmMediaPollReadDataBatch(readerHandle_, &readHead, readItems + n, 8 - n, 100);
+    ASSERT_EQ(n, numItems);
+
+    for (int i = 0; i < numItems; ++i) {
+        EXPECT_EQ(readItems[i].i_userDataLen, 64);
+        EXPECT_EQ(readItems[i].p_userData[0], static_cast<uint8_t>(i));
+    }
+
+    EXPECT_EQ(LibViShmMediaPollReadDataBatch(readerHandle_, &readHead, readItems, 8, 0), 0);
+}
+
+#if defined(TVU_LINUX)
+// Test hugepage creation falls back to normal pages without a hugetlbfs mount
+TEST_F(LibViShmMediaTest, Create3_HugePageFallsBackToNormalPages) {
+    setenv("LIBSHMMEDIA_HUGETLBFS_DIR", "/tmp", 1);
+    creatorHandle_ = LibViShmMediaCreate3(kTestShmName, kTestHeaderLen, kTestItemCount, kTestTotalSize
+                                          , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_HUGEPAGE);
+    unsetenv("LIBSHMMEDIA_HUGETLBFS_DIR");
+    ASSERT_NE(creatorHandle_, nullptr);
+    EXPECT_EQ(LibViShmMediaGetPageBacking(creatorHandle_), LIBSHM_MEDIA_PAGE_BACKING_NORMAL);
+
+    readerHandle_ = LibViShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+    EXPECT_EQ(LibViShmMediaGetPageBacking(readerHandle_), LIBSHM_MEDIA_PAGE_BACKING_NORMAL);
+
+    libshm_media_head_param_t writeHead;
+    libshm_media_item_param_t writeItem;
+    memset(&writeHead, 0, sizeof(writeHead));
+    memset(&writeItem, 0, sizeof(writeItem));
+    uint8_t testData[64];
+    memset(testData, 0x5a, sizeof(testData));
+    writeItem.p_userData = testData;
+    writeItem.i_userDataLen = sizeof(testData);
+    writeItem.i_userDataType = LIBSHM_MEDIA_TYPE_TVULIVE_DATA;
+    ASSERT_GT(LibViShmMediaSendData(creatorHandle_, &writeHead, &writeItem), 0);
+
+    libshm_media_head_param_t readHead;
+    libshm_media_item_param_t readItem;
+    memset(&readHead, 0, sizeof(readHead));
+    memset(&readItem, 0, sizeof(readItem));
+    ASSERT_GT(LibViShmMediaPollReadData(readerHandle_, &readHead, &readItem, 100), 0);
+    EXPECT_EQ(readItem.p_userData[0], 0x5a);
+}
+#endif
+
+// Test prefault flags warm up both the creator and the reader mapping
+TEST_F(LibViShmMediaTest, Create3_PrefaultReportsWarmupTime) {
+    creatorHandle_ = LibViShmMediaCreate3(kTestShmName, kTestHeaderLen, kTestItemCount, kTestTotalSize
+                                          , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_PREFAULT);
+    ASSERT_NE(creatorHandle_, nullptr);
+    EXPECT_GT(LibViShmMediaGetPrefaultTime(creatorHandle_), 0);
+
+    readerHandle_ = LibViShmMediaOpen2(kTestShmName, nullptr, nullptr, LIBSHM_MEDIA_OPEN_FLAG_PREFAULT);
+    ASSERT_NE(readerHandle_, nullptr);
+    EXPECT_GT(LibViShmMediaGetPrefaultTime(readerHandle_), 0);
+
+    libshm_media_handle_t plain = LibViShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(plain, nullptr);
+    EXPECT_EQ(LibViShmMediaGetPrefaultTime(plain), 0);
+    LibViShmMediaDestroy(plain);
+}
+
+#if defined(TVU_LINUX)
+// Test the NUMA node is recorded in the head and seen by the reader
+TEST_F(LibViShmMediaTest, Create4_NumaNodeRecordedForReaders) {
+    creatorHandle_ = LibViShmMediaCreate4(kTestShmName, kTestHeaderLen, kTestItemCount, kTestTotalSize
+                                          , S_IRUSR | S_IWUSR, 0, 0);
+    ASSERT_NE(creatorHandle_, nullptr);
+    EXPECT_EQ(LibViShmMediaGetNumaNode(creatorHandle_), 0);
+
+    readerHandle_ = LibViShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+    EXPECT_EQ(LibViShmMediaGetNumaNode(readerHandle_), 0);
+}
+#endif
+
+// video item of pts @pts, tagged with @tvutimestamp in the extended data
+static void FillIndexedItem(libshm_media_item_param_t *item, uint8_t *vdata, uint8_t extBuff[64]
+                            , int64_t pts, uint64_t tvutimestamp) {
+    libshmmedia_extend_data_info_t ext;
+    memset(&ext, 0, sizeof(ext));
+    ext.bGotTvutimestamp = true;
+    ext.u64Tvutimestamp = tvutimestamp;
+
+    memset(item, 0, sizeof(*item));
+    item->p_vData = vdata;
+    item->i_vLen = 32;
+    item->i64_vpts = pts;
+    item->i_userDataType = LIBSHM_MEDIA_TYPE_TVU_EXTEND_DATA_V2;
+    item->p_userData = extBuff;
+    item->i_userDataLen = LibShmMediaWriteExtendData(extBuff, LibShmMediaEstimateExtendDataSize(&ext), &ext);
+}
+
+static void FillIndexedHead(libshm_media_head_param_t *head) {
+    memset(head, 0, sizeof(*head));
+    head->i_dstw = 1920;
+    head->i_dsth = 1080;
+    head->u_videofourcc = 0x31637661;  // avc1
+    head->i_duration = 1;
+    head->i_scale = 30;
+}
+
+static uint64_t IndexedItemTvutimestamp(int i) {
+    return (static_cast<uint64_t>(1) << 56) | (uint64_t)(1000 + i * 10);
+}
+
+// Test tvutimestamp search by the item index, after the ring wrapped
+TEST_F(LibViShmMediaTest, SearchItemWithTvutimestamp_UsesItemIndex) {
+    const int kItemCount = 64;
+    const int kItems = 200;
+    creatorHandle_ = LibViShmMediaCreate3(kTestShmName, kTestHeaderLen, kItemCount, kTestTotalSize
+                                          , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_ITEM_INDEX);
+    ASSERT_NE(creatorHandle_, nullptr);
+
+    readerHandle_ = LibViShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    libshm_media_head_param_t writeHead;
+    FillIndexedHead(&writeHead);
+    uint8_t vdata[32];
+    uint8_t extBuff[64];
+    memset(vdata, 0x5a, sizeof(vdata));
+
+    for (int i = 0; i < kItems; ++i) {
+        libshm_media_item_param_t item;
+        FillIndexedItem(&item, vdata, extBuff, i * 100, IndexedItemTvutimestamp(i));
+        ASSERT_GT(LibViShmMediaSendData(creatorHandle_, &writeHead, &item), 0);
+    }
+
+    libshm_media_head_param_t readHead;
+    libshm_media_item_param_t readItem;
+    memset(&readHead, 0, sizeof(readHead));
+
+    // exact match, the reading index stays on the item
+    ASSERT_GT(LibViShmMediaSearchItemWithTvutimestamp(readerHandle_, IndexedItemTvutimestamp(180), &readHead, &readItem), 0);
+    EXPECT_EQ(readItem.i64_vpts, 18000);
+    ASSERT_GT(LibViShmMediaReadData(readerHandle_, &readHead, &readItem), 0);
+    EXPECT_EQ(readItem.i64_vpts, 18000);
+
+    // between two items, the later one
+    ASSERT_GT(LibViShmMediaSearchItemWithTvutimestamp(readerHandle_, IndexedItemTvutimestamp(170) + 5, nullptr, &readItem), 0);
+    EXPECT_EQ(readItem.i64_vpts, 17100);
+
+    // overwritten and not written yet
+    EXPECT_EQ(LibViShmMediaSearchItemWithTvutimestamp(readerHandle_, IndexedItemTvutimestamp(10), nullptr, &readItem), 0);
+    EXPECT_EQ(LibViShmMediaGetReadIndex(readerHandle_), LibViShmMediaGetWriteIndex(readerHandle_));
+    EXPECT_EQ(LibViShmMediaSearchItemWithTvutimestamp(readerHandle_, IndexedItemTvutimestamp(kItems), nullptr, &readItem), 0);
+
+    EXPECT_EQ(LibViShmMediaSearchItemWithTvutimestamp(readerHandle_, (uint64_t)-1, nullptr, &readItem), -EINVAL);
+    EXPECT_EQ(LibViShmMediaSearchItemWithTvutimestamp(nullptr, IndexedItemTvutimestamp(180), nullptr, &readItem), -EINVAL);
+}
+
+// Test pts search by the item index, with the items written by batches
+TEST_F(LibViShmMediaTest, SearchItemWithPts_UsesItemIndex) {
+    const int kItemCount = 64;
+    const int kBatch = 8;
+    creatorHandle_ = LibViShmMediaCreate3(kTestShmName, kTestHeaderLen, kItemCount, kTestTotalSize
+                                          , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_ITEM_INDEX);
+    ASSERT_NE(creatorHandle_, nullptr);
+
+    readerHandle_ = LibViShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    libshm_media_head_param_t writeHead;
+    FillIndexedHead(&writeHead);
+    uint8_t vdata[32];
+    uint8_t extBuff[kBatch][64];
+    memset(vdata, 0x5a, sizeof(vdata));
+
+    for (int b = 0; b < 20; ++b) {
+        libshm_media_item_param_t items[kBatch];
+        for (int i = 0; i < kBatch; ++i) {
+            int n = b * kBatch + i;
+            FillIndexedItem(&items[i], vdata, extBuff[i], n * 100, IndexedItemTvutimestamp(n));
+        }
+        ASSERT_EQ(LibViShmMediaSendDataBatch(creatorHandle_, &writeHead, items, kBatch), kBatch);
+    }
+
+    libshm_media_head_param_t readHead;
+    libshm_media_item_param_t readItem;
+    memset(&readHead, 0, sizeof(readHead));
+
+    ASSERT_GT(LibViShmMediaSearchItemWithPts(readerHandle_, 15000, &readHead, &readItem), 0);
+    EXPECT_EQ(readItem.i64_vpts, 15000);
+    ASSERT_GT(LibViShmMediaSearchItemWithPts(readerHandle_, 12050, &readHead, &readItem), 0);
+    EXPECT_EQ(readItem.i64_vpts, 12100);
+    EXPECT_EQ(LibViShmMediaSearchItemWithPts(readerHandle_, 100, &readHead, &readItem), 0);
+}
+
+// Test the item index is only kept when asked for at creating
+TEST_F(LibViShmMediaTest, SearchItemWithPts_WithoutItemIndexFlag) {
+    creatorHandle_ = LibViShmMediaCreate(kTestShmName, kTestHeaderLen, kTestItemCount, kTestTotalSize);
+    ASSERT_NE(creatorHandle_, nullptr);
+
+    readerHandle_ = LibViShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    libshm_media_head_param_t writeHead;
+    FillIndexedHead(&writeHead);
+    uint8_t vdata[32];
+    uint8_t extBuff[64];
+    memset(vdata, 0x5a, sizeof(vdata));
+
+    libshm_media_item_param_t item;
+    FillIndexedItem(&item, vdata, extBuff, 100, IndexedItemTvutimestamp(1));
+    ASSERT_GT(LibViShmMediaSendData(creatorHandle_, &writeHead, &item), 0);
+
+    libshm_media_item_param_t readItem;
+    EXPECT_EQ(LibViShmMediaSearchItemWithPts(readerHandle_, 100, nullptr, &readItem), -ENOTSUP);
+}
+
+// Test the keys committed with the applied buffer are searched, the item is not parsed back
+TEST_F(LibViShmMediaTest, ItemCommitBuffer2_RecordsKeys) {
+    creatorHandle_ = LibViShmMediaCreate3(kTestShmName, kTestHeaderLen, kTestItemCount, kTestTotalSize
+                                          , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_ITEM_INDEX);
+    ASSERT_NE(creatorHandle_, nullptr);
+
+    readerHandle_ = LibViShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    libshm_media_head_param_t writeHead;
+    FillIndexedHead(&writeHead);
+    uint8_t vdata[32];
+    uint8_t extBuff[64];
+    memset(vdata, 0x5a, sizeof(vdata));
+
+    for (int i = 0; i < 8; ++i) {
+        libshm_media_item_param_t item;
+        FillIndexedItem(&item, vdata, extBuff, i * 100, IndexedItemTvutimestamp(i));
+        unsigned int nlen = item.i_vLen + item.i_userDataLen;
+        uint8_t *buffer = LibViShmMediaItemApplyBuffer(creatorHandle_, nlen);
+        ASSERT_NE(buffer, nullptr);
+        ASSERT_GT(LibViShmMediaItemWriteBuffer(creatorHandle_, &writeHead, &item, buffer), 0);
+        ASSERT_EQ(LibViShmMediaItemCommitBuffer2(creatorHandle_, buffer, nlen, IndexedItemTvutimestamp(i), i * 100), 0);
+    }
+
+    libshm_media_item_param_t readItem;
+    ASSERT_GT(LibViShmMediaSearchItemWithTvutimestamp(readerHandle_, IndexedItemTvutimestamp(5), nullptr, &readItem), 0);
+    EXPECT_EQ(readItem.i64_vpts, 500);
+    ASSERT_GT(LibViShmMediaSearchItemWithPts(readerHandle_, 250, nullptr, &readItem), 0);
+    EXPECT_EQ(readItem.i64_vpts, 300);
+}
+
+// Test the video data of the sent items starts at the creating alignment, in batches too
+TEST_F(LibViShmMediaTest, SendData_VideoAlign4K) {
+    const int kBatch = 4;
+    creatorHandle_ = LibViShmMediaCreate3(kTestShmName, kTestHeaderLen, 32, kTestTotalSize
+                                          , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_ALIGN_4K);
+    ASSERT_NE(creatorHandle_, nullptr);
+
+    readerHandle_ = LibViShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    libshm_media_head_param_t writeHead;
+    FillIndexedHead(&writeHead);
+    uint8_t vdata[32];
+    uint8_t extBuff[kBatch][64];
+    memset(vdata, 0x5a, sizeof(vdata));
+
+    libshm_media_item_param_t items[kBatch];
+    for (int i = 0; i < kBatch; ++i) {
+        FillIndexedItem(&items[i], vdata, extBuff[i], i * 100, IndexedItemTvutimestamp(i));
+    }
+    ASSERT_GT(LibViShmMediaSendData(creatorHandle_, &writeHead, &items[0]), 0);
+    ASSERT_EQ(LibViShmMediaSendDataBatch(creatorHandle_, &writeHead, items, kBatch), kBatch);
+
+    libshm_media_head_param_t readHead;
+    libshm_media_item_param_t readItem;
+    for (int i = 0; i < 1 + kBatch; ++i) {
+        ASSERT_GT(LibViShmMediaReadData(readerHandle_, &readHead, &readItem), 0);
+        ASSERT_EQ(readItem.i_vLen, 32);
+        EXPECT_EQ(((uintptr_t)readItem.p_vData) % 4096, 0u);
+        EXPECT_EQ(memcmp(readItem.p_vData, vdata, sizeof(vdata)), 0);
+    }
+}
+
+// Test batch write publishes all items with one index update
+TEST_F(LibViShmMediaTest, SendDataBatch_PublishesAllItems) {
+    creatorHandle_ = LibViShmMediaCreate(kTestShmName, kTestHeaderLen, kTestItemCount, kTestTotalSize);
+    ASSERT_NE(creatorHandle_, nullptr);
+
+    readerHandle_ = LibViShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    const int numItems = 6;
+    uint8_t testData[numItems][48];
+    libshm_media_head_param_t writeHead;
+    libshm_media_item_param_t writeItems[numItems];
+    memset(&writeHead, 0, sizeof(writeHead));
+    memset(writeItems, 0, sizeof(writeItems));
+
+    for (int i = 0; i < numItems; ++i) {
+        // odd sizes, every item of the batch starts at its own aligned offset
+        memset(testData[i], 0x30 + i, sizeof(testData[i]));
+        writeItems[i].p_userData = testData[i];
+        writeItems[i].i_userDataLen = 33 + i;
+        writeItems[i].i_userDataType = LIBSHM_MEDIA_TYPE_TVULIVE_DATA;
+    }
+
+    EXPECT_EQ(LibViShmMediaSendDataBatch(creatorHandle_, &writeHead, writeItems, 0), 0);
+
+    // the head has no audio format, so the audio of the 3rd item fails, nothing is published
+    uint8_t audio[16] = {0};
+    libshm_media_item_param_t badItems[numItems];
+    memcpy(badItems, writeItems, sizeof(badItems));
+    badItems[2].p_aData = audio;
+    badItems[2].i_aLen = sizeof(audio);
+    uint64_t windex = LibViShmMediaGetWriteIndex(creatorHandle_);
+    EXPECT_EQ(LibViShmMediaSendDataBatch(creatorHandle_, &writeHead, badItems, numItems), -EINVAL);
+    EXPECT_EQ(LibViShmMediaGetWriteIndex(creatorHandle_), windex);
+    EXPECT_EQ(LibViShmMediaSendData(creatorHandle_, &writeHead, &badItems[2]), -EINVAL);
+    EXPECT_EQ(LibViShmMediaGetWriteIndex(creatorHandle_), windex);
+
+    ASSERT_EQ(LibViShmMediaSendDataBatch(creatorHandle_, &writeHead, writeItems, numItems), numItems);
+    EXPECT_EQ(LibViShmMediaGetWriteIndex(creatorHandle_), windex + numItems);
+
+    libshm_media_head_param_t readHead;
+    libshm_media_item_param_t readItems[numItems];
+    memset(&readHead, 0, sizeof(readHead));
+
+    ASSERT_EQ(LibViShmMediaPollReadDataBatch(readerHandle_, &readHead, readItems, numItems, 100), numItems);
+    for (int i = 0; i < numItems; ++i) {
+        EXPECT_EQ(readItems[i].i_userDataLen, 33 + i);
+        EXPECT_EQ(readItems[i].p_userData[0], 0x30 + i);
+        EXPECT_EQ(readItems[i].p_userData[32 + i], 0x30 + i);
+    }
+}
+
+TEST_F(LibViShmMediaTest, SendData_VideoPlanesGathered) {
+    creatorHandle_ = LibViShmMediaCreate(kTestShmName, kTestHeaderLen, kTestItemCount, kTestTotalSize);
+    ASSERT_NE(creatorHandle_, nullptr);
+
+    readerHandle_ = LibViShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    // I420 planes in separate buffers
+    uint8_t yPlane[32 * 8], uPlane[16 * 4], vPlane[16 * 4];
+    memset(yPlane, 0x10, sizeof(yPlane));
+    memset(uPlane, 0x20, sizeof(uPlane));
+    memset(vPlane, 0x30, sizeof(vPlane));
+    libshm_media_video_plane_t planes[3];
+    memset(planes, 0, sizeof(planes));
+    planes[0].p_data = yPlane;
+    planes[0].i_len = sizeof(yPlane);
+    planes[1].p_data = uPlane;
+    planes[1].i_len = sizeof(uPlane);
+    planes[2].p_data = vPlane;
+    planes[2].i_len = sizeof(vPlane);
+
+    libshm_media_head_param_t writeHead;
+    memset(&writeHead, 0, sizeof(writeHead));
+    writeHead.i_dstw = 32;
+    writeHead.i_dsth = 8;
+    writeHead.i_duration = 1;
+    writeHead.i_scale = 25;
+
+    libshm_media_item_param_t writeItems[2];
+    for (int i = 0; i < 2; ++i) {
+        LibShmMediaItemParamInit(&writeItems[i], sizeof(writeItems[i]));
+        writeItems[i].p_vPlanes = planes;
+        writeItems[i].i_vPlanes = 3;
+        writeItems[i].i_vLen = sizeof(yPlane) + sizeof(uPlane) + sizeof(vPlane);
+        writeItems[i].i64_vpts = i;
+    }
+
+    ASSERT_GT(LibViShmMediaSendData(creatorHandle_, &writeHead, &writeItems[0]), 0);
+    ASSERT_EQ(LibViShmMediaSendDataBatch(creatorHandle_, &writeHead, writeItems, 2), 2);
+
+    libshm_media_head_param_t readHead;
+    libshm_media_item_param_t readItem;
+    memset(&readHead, 0, sizeof(readHead));
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_GT(LibViShmMediaReadData(readerHandle_, &readHead, &readItem), 0);
+        ASSERT_EQ(readItem.i_vLen, (int)(sizeof(yPlane) + sizeof(uPlane) + sizeof(vPlane)));
+        EXPECT_EQ(readItem.p_vData[0], 0x10);
+        EXPECT_EQ(readItem.p_vData[sizeof(yPlane) - 1], 0x10);
+        EXPECT_EQ(readItem.p_vData[sizeof(yPlane)], 0x20);
+        EXPECT_EQ(readItem.p_vData[sizeof(yPlane) + sizeof(uPlane)], 0x30);
+        EXPECT_EQ(readItem.p_vData[readItem.i_vLen - 1], 0x30);
+    }
+
+    planes[1].p_data = nullptr;
+    EXPECT_EQ(LibViShmMediaSendData(creatorHandle_, &writeHead, &writeItems[0]), -EINVAL);
+}
+
+static int sendMarkedItem(libshm_media_handle_t h, uint8_t mark)
+{
+    uint8_t data[64];
+    libshm_media_head_param_t head;
+    libshm_media_item_param_t item;
+    memset(&head, 0, sizeof(head));
+    memset(&item, 0, sizeof(item));
+    memset(data, mark, sizeof(data));
+    item.p_userData = data;
+    item.i_userDataLen = sizeof(data);
+    item.i_userDataType = LIBSHM_MEDIA_TYPE_TVULIVE_DATA;
+    return LibViShmMediaSendData(h, &head, &item);
+}
+
+// Lossless writer waits on the leased item after the reader has read on
+TEST_F(LibViShmMediaTest, Acquire_LosslessWriterWaitsOnLease) {
+    creatorHandle_ = LibViShmMediaCreate3(kTestShmName, kTestHeaderLen, kTestItemCount, 64 * 1024
+                                          , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_LOSSLESS);
+    ASSERT_NE(creatorHandle_, nullptr);
+    readerHandle_ = LibViShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    ASSERT_GT(sendMarkedItem(creatorHandle_, 0x11), 0);
+    ASSERT_GT(sendMarkedItem(creatorHandle_, 0x12), 0);
+
+    libshm_media_head_param_t head;
+    libshm_media_item_param_t leased;
+    libshm_media_item_param_t item;
+    int lease = -1;
+    memset(&head, 0, sizeof(head));
+    EXPECT_EQ(LibViShmMediaAcquire(readerHandle_, &head, &leased, nullptr), -EINVAL);
+    ASSERT_GT(LibViShmMediaAcquire(readerHandle_, &head, &leased, &lease), 0);
+    ASSERT_GE(lease, 0);
+    EXPECT_EQ(leased.p_userData[0], 0x11);
+
+    // the reader cursor moves on, only the lease holds the first item
+    ASSERT_GT(LibViShmMediaReadData(readerHandle_, &head, &item), 0);
+    int written = 0;
+    int ret = 0;
+    while (written < 100 && (ret = sendMarkedItem(creatorHandle_, 0x40)) > 0) {
+        written++;
+        ASSERT_GT(LibViShmMediaReadData(readerHandle_, &head, &item), 0);
+    }
+    EXPECT_EQ(ret, -EAGAIN);
+    EXPECT_LT(written, (int)kTestItemCount);
+    EXPECT_EQ(leased.p_userData[0], 0x11);
+    EXPECT_EQ(leased.p_userData[63], 0x11);
+    EXPECT_EQ(LibViShmMediaCheckLease(readerHandle_, lease), 0);
+
+    EXPECT_EQ(LibViShmMediaRelease(readerHandle_, lease), 0);
+    EXPECT_EQ(LibViShmMediaRelease(readerHandle_, lease), -EINVAL);
+    EXPECT_GT(sendMarkedItem(creatorHandle_, 0x41), 0);
+}
+
+// Lossy writer goes on over the leased item and breaks the lease
+TEST_F(LibViShmMediaTest, Acquire_LossyWriterBreaksLease) {
+    creatorHandle_ = LibViShmMediaCreate3(kTestShmName, kTestHeaderLen, kTestItemCount, 64 * 1024
+                                          , S_IRUSR | S_IWUSR, 0);
+    ASSERT_NE(creatorHandle_, nullptr);
+    readerHandle_ = LibViShmMediaOpen(kTestShmName, nullptr, nullptr);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    libshm_media_head_param_t head;
+    libshm_media_item_param_t leased;
+    int lease = -1;
+    memset(&head, 0, sizeof(head));
+    EXPECT_EQ(LibViShmMediaAcquire(readerHandle_, &head, &leased, &lease), 0);
+
+    ASSERT_GT(sendMarkedItem(creatorHandle_, 0x21), 0);
+    ASSERT_GT(LibViShmMediaAcquire(readerHandle_, &head, &leased, &lease), 0);
+    EXPECT_EQ(LibViShmMediaCheckLease(readerHandle_, lease), 0);
+
+    for (uint32_t i = 0; i < 2 * kTestItemCount; ++i) {
+        ASSERT_GT(sendMarkedItem(creatorHandle_, 0x50), 0);
+    }
+    EXPECT_EQ(LibViShmMediaCheckLease(readerHandle_, lease), -EPIPE);
+    EXPECT_EQ(LibViShmMediaRelease(readerHandle_, lease), -EPIPE);
+    EXPECT_EQ(LibViShmMediaCheckLease(readerHandle_, lease), -EINVAL);
+    EXPECT_EQ(LibViShmMediaCheckLease(nullptr, 0), -EINVAL);
+}
+
+// A monitor handle claims no lossless cursor, it counts and peeks at the items only
+TEST_F(LibViShmMediaTest, Monitor_CountsAndPeeksWithoutHoldingTheWriter) {
+    creatorHandle_ = LibViShmMediaCreate3(kTestShmName, kTestHeaderLen, kTestItemCount, 64 * 1024
+                                          , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_LOSSLESS);
+    ASSERT_NE(creatorHandle_, nullptr);
+    EXPECT_EQ(LibShmMediaProbeShm(kTestShmName), LIBSHM_MEDIA_SHM_TYPE_VARIABLE);
+    readerHandle_ = LibViShmMediaOpen2(kTestShmName, nullptr, nullptr, LIBSHM_MEDIA_OPEN_FLAG_MONITOR);
+    ASSERT_NE(readerHandle_, nullptr);
+
+    libshm_media_head_param_t peek;
+    memset(&peek, 0, sizeof(peek));
+    EXPECT_EQ(LibViShmMediaPeekLatestHead(readerHandle_, &peek), 0);
+
+    uint64_t windex = LibViShmMediaGetWriteIndex(readerHandle_);
+    uint64_t bytes = 0;
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_GT(sendMarkedItem(creatorHandle_, 0x60), 0);
+    }
+    EXPECT_EQ(LibViShmMediaGetWrittenSince(readerHandle_, &windex, &bytes), 5u);
+    EXPECT_GE(bytes, 5u * 64);
+    EXPECT_EQ(LibViShmMediaGetWrittenSince(readerHandle_, &windex, nullptr), 0u);
+
+    // the lossless writer laps the ring, the items before the last ring are not counted
+    for (uint32_t i = 0; i < kTestItemCount + 2; ++i) {
+        ASSERT_GT(sendMarkedItem(creatorHandle_, 0x61), 0);
+    }
+    EXPECT_EQ(LibViShmMediaGetWrittenSince(readerHandle_, &windex, nullptr), (uint64_t)kTestItemCount);
+
+    uint8_t data[64];
+    libshm_media_head_param_t head;
+    libshm_media_item_param_t item;
+    memset(&head, 0, sizeof(head));
+    memset(&item, 0, sizeof(item));
+    memset(data, 0x62, sizeof(data));
+    head.i_dstw = 1920;
+    head.i_dsth = 1080;
+    head.u_videofourcc = 0x32315659;
+    head.i_duration = 1;
+    head.i_scale = 25;
+    item.p_vData = data;
+    item.i_vLen = sizeof(data);
+    ASSERT_GT(LibViShmMediaSendData(creatorHandle_, &head, &item), 0);
+
+    ASSERT_GT(LibViShmMediaPeekLatestHead(readerHandle_, &peek), 0);
+    EXPECT_EQ(peek.i_dstw, 1920);
+    EXPECT_EQ(peek.i_dsth, 1080);
+    EXPECT_EQ(peek.u_videofourcc, 0x32315659u);
+    EXPECT_EQ(LibViShmMediaHasReader(creatorHandle_, 1000), 0);
+    EXPECT_EQ(LibViShmMediaPeekLatestHead(readerHandle_, nullptr), -EINVAL);
+}
@@ -17,6 +17,7 @@
 
 #include <gtest/gtest.h>
 #include <cstring>
+#include <sys/stat.h>
 #include "libshmmedia_variableitem_rawdata.h"
 #include "libshm_media_variable_item.h"
 
@@ -99,6 +100,22 @@ TEST_F(LibViShmMediaRawDataTest, RawDataCommit_ValidHandle) {
     EXPECT_GT(ret, 0);
 }
 
+// Test raw data buffers start at the creating alignment
+TEST_F(LibViShmMediaRawDataTest, RawDataApply_Align64) {
+    handle_ = LibViShmMediaCreate3(kTestShmName, kTestHeaderLen, kTestItemCount, kTestTotalSize
+                                   , S_IRUSR | S_IWUSR, LIBSHM_MEDIA_CREATE_FLAG_ALIGN_64);
+    ASSERT_NE(handle_, nullptr);
+    EXPECT_EQ(LibViShmMediaGetPayloadAlignment(handle_), 64u);
+
+    for (size_t len = 1; len < 400; len += 37) {
+        uint8_t* buffer = LibViShmMediaRawDataApply(handle_, len);
+        ASSERT_NE(buffer, nullptr);
+        EXPECT_EQ(((uintptr_t)buffer) % 64, 0u);
+        memset(buffer, 0xAB, len);
+        EXPECT_GT(LibViShmMediaRawDataCommit(handle_, buffer, len), 0);
+    }
+}
+
 // Test LibViShmMediaRawHeadWrite with null data
 TEST_F(LibViShmMediaRawDataTest, RawHeadWrite_NullData) {
     handle_ = LibViShmMediaCreate(kTestShmName, kTestHeaderLen, kTestItemCount, kTestTotalSize);
@@ -171,7 +171,98 @@ typedef struct SLibShmMediaItemParamV0
     libshm_media_process_handle_t       h_media_process;
 }libshm_media_item_param_v1_t;
 
-typedef libshm_media_item_param_v1_t libshm_media_item_param_t;
+#define LIBSHM_MEDIA_VIDEO_PLANES_MAX   4
+
+/**
+ *  one video plane of the scatter-gather sending, the planes are written
+ *  one after another into the item's video data.
+ *  a plane with line padding, such as a DMA buffer, is repacked by
+ *  i_stride and i_lineLen, its lines are written without the padding.
+**/
+typedef struct SLibShmMediaVideoPlane
+{
+    const uint8_t   *p_data;
+    int             i_len;      // bytes of the plane in the item.
+    int             i_stride;   // bytes between the source lines, 0 for a contiguous plane.
+    int             i_lineLen;  // bytes of a line in the item, used when i_stride is not 0, i_len is a multiple of it.
+}libshm_media_video_plane_t;
+
+/**
+ *  one plane of the video data in the item, stored by the writer for readers.
+**/
+typedef struct SLibShmMediaPlaneDesc
+{
+    uint32_t        u_offset;   // from the start of the video data.
+    uint32_t        u_stride;   // bytes of a line.
+    uint32_t        u_height;   // lines of the plane.
+}libshm_media_plane_desc_t;
+
+/**
+ *  one plane of a read item, from LibShmMediaItemGetPlanes.
+**/
+typedef struct SLibShmMediaPlane
+{
+    const uint8_t   *p_data;
+    uint32_t        u_stride;
+    uint32_t        u_height;
+}libshm_media_plane_t;
+
+typedef struct SLibShmMediaItemParamV2
+{
+    uint32_t    u_reservePrivate; // reserve for internal
+    int         i_totalLen;
+    const uint8_t   *p_vData;
+    int         i_vLen;
+    int64_t     i64_vpts;
+    int64_t     i64_vdts;
+    int64_t     i64_vct;
+    const uint8_t    *p_aData;
+    int         i_aLen;
+    int64_t     i64_apts;
+    int64_t     i64_adts;
+    int64_t     i64_act;
+    const uint8_t     *p_sData;
+    int         i_sLen;
+    int64_t     i64_spts;
+    int64_t     i64_sdts;
+    int64_t     i64_sct;
+    const uint8_t    *p_CCData;
+    int         i_CCLen;
+    const uint8_t    *p_timeCode;
+    int         i_timeCode;
+    uint32_t    u_frameType;
+    uint32_t    u_picType;
+    const uint8_t    *p_userData; /* user self definition */
+    int         i_userDataLen;
+    int64_t     i64_userDataCT;/* data's create time */
+    int         i_userDataType;
+    uint32_t    i_interlaceFlag;
+    uint32_t    u_copied_flags;
+    uint32_t    u_read_index;
+    void                                *p_opaq;
+    libshm_media_process_handle_t       h_media_process;
+    /**
+     *  For writer, the video data is gathered from p_vPlanes instead of p_vData
+     *  while i_vPlanes is in (0, LIBSHM_MEDIA_VIDEO_PLANES_MAX], i_vLen must be the
+     *  sum of the planes' i_len. Only for V4 shm, and the object must be
+     *  initialized by LibShmMediaItemParamInit with the V2 structure size.
+     *  For reader, they are not set, the video data is p_vData.
+    **/
+    const libshm_media_video_plane_t    *p_vPlanes;
+    int                                 i_vPlanes;
+    /**
+     *  the plane table of the video data, up to LIBSHM_MEDIA_VIDEO_PLANES_MAX.
+     *  For writer, optional, stored in the item, i_vPlaneDescs is 0 for none,
+     *  then the table of p_vPlanes is stored, a plane of no i_lineLen as one line.
+     *  For reader, set by reading when the object was initialized by LibShmMediaItemParamInit
+     *  with the V2 structure size, LibShmMediaItemGetPlanes turns it to plane pointers.
+     *  A reading fills only the fields of the structure size the object was initialized with.
+    **/
+    libshm_media_plane_desc_t           o_vPlaneDescs[LIBSHM_MEDIA_VIDEO_PLANES_MAX];
+    int                                 i_vPlaneDescs;
+}libshm_media_item_param_v2_t;
+
+typedef libshm_media_item_param_v2_t libshm_media_item_param_t;
 
 typedef struct SLibShmMediaItemAddrLayout
 {
@@ -268,7 +359,8 @@ unsigned int LibShmMediaProtoGetHeadVersion(const uint8_t *headBuf);
  *      used to read out the item buffer layout.
  *  Parameters:
  *      @pmh[OUT]    : some head parameters.
- *      @pmi[OUT]    : item parameters.
+ *      @pmi[OUT]    : item parameters, the plane table is set only when it was initialized
+ *                     by LibShmMediaItemParamInit with the V2 structure size.
  *      @pItemAddr[IN]  : item address point.
  *      @nItem[IN]  : pItemAddr total buffer sizes.
  *  Reutrn:
@@ -407,6 +499,23 @@ void LibShmMediaItemParamRelease(libshm_media_item_param_t *p);
  */
 uint64_t LibShmMediaItemParamGetPts(libshm_media_item_param_t *p, const char type);
 
+/**
+ *  Functionality:
+ *      used to get the video planes of a read item, from the plane table the writer stored,
+ *      so the reader need not compute the offsets and strides from the fourcc.
+ *  Parameters:
+ *      @p[IN]          : item param object point, from reading.
+ *      @planes[OUT]    : plane array, pointers into p_vData.
+ *      @maxPlanes[IN]  : size of @planes.
+ *  Reutrn:
+ *      >0      : the planes count.
+ *      0       : the writer stored no plane table.
+ *      -EINVAL : invalid parameters, or a plane out of the video data.
+ *      -ENOSPC : @maxPlanes is less than the planes count.
+ */
+_LIBSHMMEDIA_PROTO_DLL_
+int LibShmMediaItemGetPlanes(const libshm_media_item_param_t *p, libshm_media_plane_t *planes, int maxPlanes);
+
 
 /**
  *  Functionality:
@@ -275,6 +275,58 @@ namespace libshmmediapro {
         return len;
     }
 
+    static inline uint64_t *_itemGenerationAddr(const uint8_t *pItemAddr)
+    {
+        return (uint64_t *)(pItemAddr + offsetof(shm_media_item_info_v4_subv2_t, _generation));
+    }
+
+    bool itemHasGeneration(const uint8_t *pItemAddr)
+    {
+        const shm_media_item_info_v4_subv0_t *pi4 = (const shm_media_item_info_v4_subv0_t *)pItemAddr;
+
+        if (!pItemAddr)
+        {
+            return false;
+        }
+
+        return LIBSHMMEDIA_ITEM_READ_SHM_U8(pi4->_item_version) == kLibShmMediaItemVerV4
+            && LIBSHMMEDIA_ITEM_READ_SHM_U32(pi4->_head_len) >= sizeof(shm_media_item_info_v4_subv2_t);
+    }
+
+    void invalidateItemGeneration(uint8_t *pItemAddr)
+    {
+        if (!itemHasGeneration(pItemAddr))
+        {
+            return;
+        }
+
+        /* the zero stamp must be visible before any payload byte of the new frame. */
+        __atomic_store_n(_itemGenerationAddr(pItemAddr), 0, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+
+    void publishItemGeneration(uint8_t *pItemAddr, uint64_t gen)
+    {
+        if (!itemHasGeneration(pItemAddr))
+        {
+            return;
+        }
+
+        __atomic_store_n(_itemGenerationAddr(pItemAddr), LIBSHMMEDIA_ITEM_WRITE_SHM_U64(gen), __ATOMIC_RELEASE);
+    }
+
+    uint64_t loadItemGeneration(const uint8_t *pItemAddr)
+    {
+        if (!itemHasGeneration(pItemAddr))
+        {
+            return 0;
+        }
+
+        /* payload reading of the caller must be done before the stamp checking. */
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        return LIBSHMMEDIA_ITEM_READ_SHM_U64(__atomic_load_n(_itemGenerationAddr(pItemAddr), __ATOMIC_RELAXED));
+    }
+
     #define V4_ITEM_ALIGN_SIZE  32
 
     int preRequireItemHeadLength(uint32_t v)
@@ -882,6 +934,28 @@ namespace libshmmediapro {
             pmi->i_vLen = videolen;
         }
 
+        /* only a V2 object has the plane table. */
+        bool bPlaneDescs = pmiv->u_reservePrivate >= sizeof(libshm_media_item_param_v2_t);
+        if (bPlaneDescs)
+        {
+            pmiv->i_vPlaneDescs = 0;
+        }
+        if (bPlaneDescs && videolen > 0 && item_head_len >= (int)sizeof(shm_media_item_info_v4_subv3_t))
+        {
+            const shm_media_item_info_v4_subv3_t *pi43 = (const shm_media_item_info_v4_subv3_t *)pItemAddr;
+            uint32_t n = LIBSHMMEDIA_ITEM_READ_SHM_U32(pi43->_plane_count);
+            if (n <= LIBSHM_MEDIA_VIDEO_PLANES_MAX)
+            {
+                for (uint32_t i = 0; i < n; i++)
+                {
+                    pmiv->o_vPlaneDescs[i].u_offset = LIBSHMMEDIA_ITEM_READ_SHM_U32(pi43->_planes[i].offset);
+                    pmiv->o_vPlaneDescs[i].u_stride = LIBSHMMEDIA_ITEM_READ_SHM_U32(pi43->_planes[i].stride);
+                    pmiv->o_vPlaneDescs[i].u_height = LIBSHMMEDIA_ITEM_READ_SHM_U32(pi43->_planes[i].height);
+                }
+                pmiv->i_vPlaneDescs = (int)n;
+            }
+        }
+
         pmi->i64_vpts = LIBSHMMEDIA_ITEM_READ_SHM_U64(pi3->videopts);
         pmi->i64_vdts = LIBSHMMEDIA_ITEM_READ_SHM_U64(pi3->videodts);
         pmi->i64_vct = LIBSHMMEDIA_ITEM_READ_SHM_U64(pi3->videoct);
@@ -955,7 +1029,14 @@ namespace libshmmediapro {
 //        bool        bIgnUserData = ignore_flag & 0x08;
 
         item_w_offset   += libshmmediapro::getItemHeadLengthV4();
-        _offset = libshmmediapro::getAlignOffset(pItemAddr, item_w_offset);
+        if (rii.nVideoAlign_ > 16)
+        {
+            _offset = libshmmediapro::getAlignOffset(pItemAddr, item_w_offset, rii.nVideoAlign_);
+        }
+        else
+        {
+            _offset = libshmmediapro::getAlignOffset(pItemAddr, item_w_offset);
+        }
 
         item_w_offset = _offset;
 
@@ -1186,6 +1267,80 @@ namespace libshmmediapro {
     #define INVALID_AUDIO_SAMPLERATE(s) (s < 8000)
     #define INVALID_AUDIO_CHANNEL_LAYOUT(c) (c==0)
 
+    static inline void _copyPayload(const libshm_media_item_param_internal_t &rii, void *dst, const void *src, size_t len)
+    {
+        if (rii.fnCopy_)
+        {
+            rii.fnCopy_(dst, src, len);
+        }
+        else
+        {
+            memcpy(dst, src, len);
+        }
+    }
+
+    /**
+     *  the table was checked by checkItemVideoPlanes, the head is zeroed, so no table means count 0.
+     *  without a table of the writer, the scatter-gather planes make it, they are written
+     *  one after another, a plane of no line length is one line.
+     */
+    static void _writeItemPlaneTable(const libshm_media_item_param_t *pmi, uint8_t *pItemAddr)
+    {
+        shm_media_item_info_v4_subv3_t *pi43 = (shm_media_item_info_v4_subv3_t *)pItemAddr;
+        int n = _itemParamGetPlaneDescs(*pmi);
+        const libshm_media_video_plane_t *planes = NULL;
+
+        if (n > 0)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                pi43->_planes[i].offset = LIBSHMMEDIA_ITEM_WRITE_SHM_U32(pmi->o_vPlaneDescs[i].u_offset);
+                pi43->_planes[i].stride = LIBSHMMEDIA_ITEM_WRITE_SHM_U32(pmi->o_vPlaneDescs[i].u_stride);
+                pi43->_planes[i].height = LIBSHMMEDIA_ITEM_WRITE_SHM_U32(pmi->o_vPlaneDescs[i].u_height);
+            }
+        }
+        else if ((n = _itemParamGetVideoPlanes(*pmi, &planes)) > 0)
+        {
+            uint32_t offset = 0;
+            for (int i = 0; i < n; i++)
+            {
+                const libshm_media_video_plane_t &pl = planes[i];
+                bool lined = pl.i_lineLen > 0 && (pl.i_len % pl.i_lineLen) == 0;
+                uint32_t lineLen = lined ? (uint32_t)pl.i_lineLen : (uint32_t)pl.i_len;
+
+                pi43->_planes[i].offset = LIBSHMMEDIA_ITEM_WRITE_SHM_U32(offset);
+                pi43->_planes[i].stride = LIBSHMMEDIA_ITEM_WRITE_SHM_U32(lineLen);
+                pi43->_planes[i].height = LIBSHMMEDIA_ITEM_WRITE_SHM_U32((uint32_t)pl.i_len / lineLen);
+                offset += (uint32_t)pl.i_len;
+            }
+        }
+        pi43->_plane_count = LIBSHMMEDIA_ITEM_WRITE_SHM_U32(n);
+    }
+
+    /* the planes were checked by checkItemVideoPlanes. */
+    static void _copyVideoPlanes(const libshm_media_item_param_internal_t &rii, uint8_t *dst
+                                 , const libshm_media_video_plane_t *planes, int n)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            const libshm_media_video_plane_t &pl = planes[i];
+            if (pl.i_stride == 0 || pl.i_stride == pl.i_lineLen)
+            {
+                _copyPayload(rii, dst, pl.p_data, pl.i_len);
+            }
+            else
+            {
+                const uint8_t *src = pl.p_data;
+                for (int l = 0; l < pl.i_len / pl.i_lineLen; l++)
+                {
+                    memcpy(dst + l * pl.i_lineLen, src, pl.i_lineLen);
+                    src += pl.i_stride;
+                }
+            }
+            dst += pl.i_len;
+        }
+    }
+
     int writeItemBufferV4(const libshm_media_head_param_t *pmh, const libshm_media_item_param_t *pmiv, const libshm_media_item_param_internal_t &rii, uint8_t *pItemAddr)
     {
         const libshm_media_item_param_v1_t *pmi = (const libshm_media_item_param_v1_t *)pmiv;
@@ -1261,8 +1416,14 @@ namespace libshmmediapro {
                 if (olayout.p_vData)
                 {
                     pi3->videolen = LIBSHMMEDIA_ITEM_WRITE_SHM_U32(pmi->i_vLen);
-                    if (bvc && pmi->p_vData) {
-                        memcpy((void *)olayout.p_vData, pmi->p_vData, pmi->i_vLen);
+                    _writeItemPlaneTable(pmiv, pItemAddr);
+                    const libshm_media_video_plane_t *planes = NULL;
+                    int nplanes = _itemParamGetVideoPlanes(*pmiv, &planes);
+                    if (bvc && nplanes > 0) {
+                        _copyVideoPlanes(rii, olayout.p_vData, planes, nplanes);
+                    }
+                    else if (bvc && pmi->p_vData) {
+                        _copyPayload(rii, (void *)olayout.p_vData, pmi->p_vData, pmi->i_vLen);
                     }
                 }
             }
@@ -1292,7 +1453,7 @@ namespace libshmmediapro {
                 {
                     pi3->audiolen = LIBSHMMEDIA_ITEM_WRITE_SHM_U32(pmi->i_aLen);
                     if (bac && pmi->p_aData) {
-                        memcpy((void *)olayout.p_aData, pmi->p_aData, pmi->i_aLen);
+                        _copyPayload(rii, (void *)olayout.p_aData, pmi->p_aData, pmi->i_aLen);
                     }
 
                     if (pmi->h_media_process)
@@ -1485,6 +1646,133 @@ namespace libshmmediapro {
         return NULL;
     }
 
+    uint32_t _itemParamGetStructSize(const libshm_media_item_param_t &p)
+    {
+        uint32_t strutSize = p.u_reservePrivate;
+
+        if (strutSize >= sizeof(libshm_media_item_param_v2_t))
+        {
+            strutSize = sizeof(libshm_media_item_param_v2_t);
+        }
+        else
+        {
+            strutSize = sizeof(libshm_media_item_param_v1_t);
+        }
+        return strutSize;
+    }
+
+    void _itemParamLowCopy(libshm_media_item_param_t &dst, const libshm_media_item_param_t &src)
+    {
+        uint32_t strutSize = TVUUTIL_MIN(_itemParamGetStructSize(dst), _itemParamGetStructSize(src));
+        uint32_t reservePrivate = dst.u_reservePrivate;
+        if (strutSize >= sizeof(libshm_media_item_param_v2_t))
+        {
+            libshm_media_item_param_v2_t *pdst = (libshm_media_item_param_v2_t *)&dst;
+            const libshm_media_item_param_v2_t *psrc = (const libshm_media_item_param_v2_t *)&src;
+            *pdst = *psrc;
+        }
+        else
+        {
+            libshm_media_item_param_v1_t *pdst = (libshm_media_item_param_v1_t *)&dst;
+            const libshm_media_item_param_v1_t *psrc = (const libshm_media_item_param_v1_t *)&src;
+            *pdst = *psrc;
+        }
+        dst.u_reservePrivate = reservePrivate;
+        return;
+    }
+
+    int _itemParamGetVideoPlanes(const libshm_media_item_param_t &r, const libshm_media_video_plane_t **ppPlanes)
+    {
+        if (r.u_reservePrivate >= sizeof(libshm_media_item_param_v2_t) && r.i_vPlanes > 0 && r.p_vPlanes)
+        {
+            *ppPlanes = r.p_vPlanes;
+            return r.i_vPlanes;
+        }
+        *ppPlanes = NULL;
+        return 0;
+    }
+
+    int _itemParamGetPlaneDescs(const libshm_media_item_param_t &r)
+    {
+        if (r.u_reservePrivate >= sizeof(libshm_media_item_param_v2_t) && r.i_vPlaneDescs > 0)
+        {
+            return r.i_vPlaneDescs;
+        }
+        return 0;
+    }
+
+    static int _checkPlaneDescs(const libshm_media_plane_desc_t *descs, int n, int vlen)
+    {
+        if (n > LIBSHM_MEDIA_VIDEO_PLANES_MAX)
+        {
+            DEBUG_SHMMEDIA_PROTO_WARN("plane table %d over %d\n", n, LIBSHM_MEDIA_VIDEO_PLANES_MAX);
+            return -EINVAL;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            const libshm_media_plane_desc_t &d = descs[i];
+            if (!d.u_stride || !d.u_height
+                || (uint64_t)d.u_offset + (uint64_t)d.u_stride * d.u_height > (uint64_t)(vlen > 0 ? vlen : 0))
+            {
+                DEBUG_SHMMEDIA_PROTO_WARN("plane %d {offset %u, stride %u, height %u} out of video len %d\n"
+                    , i, d.u_offset, d.u_stride, d.u_height, vlen);
+                return -EINVAL;
+            }
+        }
+        return n;
+    }
+
+    int checkItemVideoPlanes(const libshm_media_item_param_t *pmi)
+    {
+        const libshm_media_video_plane_t *planes = NULL;
+        int n = _itemParamGetVideoPlanes(*pmi, &planes);
+        int ndescs = _itemParamGetPlaneDescs(*pmi);
+        int64_t total = 0;
+
+        if (ndescs > 0 && _checkPlaneDescs(pmi->o_vPlaneDescs, ndescs, pmi->i_vLen) < 0)
+        {
+            return -EINVAL;
+        }
+
+        if (n <= 0)
+        {
+            return ndescs;
+        }
+
+        if (n > LIBSHM_MEDIA_VIDEO_PLANES_MAX)
+        {
+            DEBUG_SHMMEDIA_PROTO_WARN("video planes %d over %d\n", n, LIBSHM_MEDIA_VIDEO_PLANES_MAX);
+            return -EINVAL;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            const libshm_media_video_plane_t &pl = planes[i];
+            if (!pl.p_data || pl.i_len <= 0 || pl.i_stride < 0)
+            {
+                DEBUG_SHMMEDIA_PROTO_WARN("video plane %d {data %p, len %d, stride %d} invalid\n"
+                    , i, pl.p_data, pl.i_len, pl.i_stride);
+                return -EINVAL;
+            }
+            if (pl.i_stride > 0
+                && (pl.i_lineLen <= 0 || pl.i_lineLen > pl.i_stride || pl.i_len % pl.i_lineLen))
+            {
+                DEBUG_SHMMEDIA_PROTO_WARN("video plane %d {len %d, stride %d, line %d} invalid\n"
+                    , i, pl.i_len, pl.i_stride, pl.i_lineLen);
+                return -EINVAL;
+            }
+            total += pl.i_len;
+        }
+
+        if (total != pmi->i_vLen)
+        {
+            DEBUG_SHMMEDIA_PROTO_WARN("video planes len %lld, but video len %d\n", (long long)total, pmi->i_vLen);
+            return -EINVAL;
+        }
+        return n;
+    }
+
 }
 
 uint32_t LibShmMediaProGetItemParamDataLen(const libshm_media_item_param_t *pvi)
@@ -1537,7 +1825,9 @@ int LibShmMediaProtoWriteItemBuffer(
         uint8_t *pItemAddr)
 {
     int ret = 0;
-    libshm_media_item_param_t omi = *pmi;
+    libshm_media_item_param_t omi;
+    LibShmMediaItemParamInit(&omi, sizeof(omi));
+    libshmmediapro::_itemParamLowCopy(omi, *pmi);
     omi.u_copied_flags = 0xFFFFFFFF;
     ret = libshmmediapro::writeItemBuffer(pmh, &omi, pItemAddr, LIBSHM_MEDIA_ITEM_CURRENT_VERSION);
     return ret;
@@ -1579,9 +1869,9 @@ int LibShmMediaItemParamInit(libshm_media_item_param_t *p, uint32_t structSize)
         return -1;
     }
 
-    if (structSize >= sizeof(libshm_media_item_param_v1_t))
+    if (structSize >= sizeof(libshm_media_item_param_v2_t))
     {
-        structSize = sizeof(libshm_media_item_param_v1_t);
+        structSize = sizeof(libshm_media_item_param_v2_t);
     }
     else
     {
@@ -1601,6 +1891,38 @@ void LibShmMediaItemParamRelease(libshm_media_item_param_t *p)
     return;
 }
 
+int LibShmMediaItemGetPlanes(const libshm_media_item_param_t *p, libshm_media_plane_t *planes, int maxPlanes)
+{
+    if (!p || !planes || maxPlanes <= 0)
+    {
+        return -EINVAL;
+    }
+
+    int n = libshmmediapro::_itemParamGetPlaneDescs(*p);
+    if (n <= 0 || !p->p_vData)
+    {
+        return 0;
+    }
+
+    if (libshmmediapro::_checkPlaneDescs(p->o_vPlaneDescs, n, p->i_vLen) < 0)
+    {
+        return -EINVAL;
+    }
+
+    if (n > maxPlanes)
+    {
+        return -ENOSPC;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        planes[i].p_data = p->p_vData + p->o_vPlaneDescs[i].u_offset;
+        planes[i].u_stride = p->o_vPlaneDescs[i].u_stride;
+        planes[i].u_height = p->o_vPlaneDescs[i].u_height;
+    }
+    return n;
+}
+
 uint64_t LibShmMediaItemParamGetPts(libshm_media_item_param_t *p, const char type)
 {
     if (!p)
@@ -63,6 +63,10 @@ typedef struct {
 
     uint32_t nKeyValueSize_;
     const uint8_t *pKeyValuePtr_;
+    /* copy of the video/audio payloads, memcpy when NULL. */
+    void *(*fnCopy_)(void *dst, const void *src, size_t len);
+    /* the address alignment of the video data, 0 for the default 16 bytes. */
+    uint32_t nVideoAlign_;
 
 }libshm_media_item_param_internal_t;
 
@@ -76,6 +80,21 @@ static inline uint32_t getAlignOffset(uint8_t *pstart, uint32_t offset)
     return (p_algin_start - pstart);
 }
 
+/* as getAlignOffset, at a multiple of @align, a power of 2. */
+static inline uint32_t getAlignOffset(uint8_t *pstart, uint32_t offset, uint32_t align)
+{
+
+    uint8_t *p_algin_start = (uint8_t *)_LISHMMEDIA_MEM_ALIGN((uintptr_t)(pstart + offset), (uintptr_t)align);
+
+    return (p_algin_start - pstart);
+}
+
+/* the item bytes more than preRequireItemHeadLength, for the video data aligned at @align. */
+static inline uint32_t preRequireVideoAlignLength(uint32_t align)
+{
+    return align > 16 ? align : 0;
+}
+
 static inline uint32_t getItemParamDataLen(const libshm_media_item_param_t *pmiv)
 {
     const libshm_media_item_param_v1_t *pvi = (const libshm_media_item_param_v1_t *)pmiv;
@@ -121,11 +140,30 @@ unsigned int getShmMediaHeadVersion(const uint8_t *headBuf);
 
 uint32_t getItemHeadLengthV4();
 
+/* item generation stamp, seqlock for zero-copy reading, only V4 item which head covers the stamp. */
+bool itemHasGeneration(const uint8_t *pItemAddr);
+void invalidateItemGeneration(uint8_t *pItemAddr);
+void publishItemGeneration(uint8_t *pItemAddr, uint64_t gen);
+uint64_t loadItemGeneration(const uint8_t *pItemAddr);
+
 uint32_t _headParamGetStructSize(const libshm_media_head_param_t &p);
 uint32_t _headParamGetMinStructSize(const libshm_media_head_param_t &p1, const libshm_media_head_param_t &p2);
 void _headParamLowCopy(libshm_media_head_param_t &dst, const libshm_media_head_param_t &src);
 int _headParamLowCompare(const libshm_media_head_param_t &dst, const libshm_media_head_param_t &src);
 const libshmmedia_audio_channel_layout_object_t *_headParamGetChannelLayout(const libshm_media_head_param_t &r);
+
+uint32_t _itemParamGetStructSize(const libshm_media_item_param_t &p);
+/* copies the fields both structures have, dst keeps its u_reservePrivate. */
+void _itemParamLowCopy(libshm_media_item_param_t &dst, const libshm_media_item_param_t &src);
+/* video planes of a V2 item param, return the planes count, 0 for none. */
+int _itemParamGetVideoPlanes(const libshm_media_item_param_t &r, const libshm_media_video_plane_t **ppPlanes);
+/* plane table count of a V2 item param, 0 for none. */
+int _itemParamGetPlaneDescs(const libshm_media_item_param_t &r);
+/**
+ *  return >0 when the item has video planes or a plane table, which need a V4 shm, 0 for none,
+ *  -EINVAL for invalid planes, a video length not of them, or a plane table out of the video data.
+**/
+int checkItemVideoPlanes(const libshm_media_item_param_t *pmi);
 }
 
 
@@ -15,51 +15,46 @@
 
 #include "libshm_media_protocol_log.h"
 #include "libshm_time_internal.h"
+#include "libshm_log_internal.h"
 #include <stdarg.h>
 #include <ctype.h>
 
 #define _LIBSHMMEDIA_PROTO_COMMON_LOG(level, fmt, ...)        \
     do {\
+        if (_libshm_log_level_of(level) < LIBSHM_LOG_COMPILE_LEVEL \
+            || !_libshm_log_level_enabled(_libshm_log_level_of(level), _libshmLogLevelOverride())) { \
+            break; \
+        } \
         LibShmMediaProtoLogPrintInternal(level, "@[%s,%d] %c- " fmt \
         , __FUNCTION__, __LINE__, toupper(char(level)), ##__VA_ARGS__);\
     } while (0)
 
 
+/**
+ *  prints the first @maxIntervalCount logs of the site in each @seconds,
+ *  see libshm_log_internal.h for the filtering ahead of it.
+ */
 #define _LIBSHMMEDIA_PROTO_HEARTBEAT_MULTIPLE_LOG(seconds,maxIntervalCount,level,fmt, ...) \
     do \
     {\
-        uint64_t _tvu_now = _libshm_get_sys_ms64();; \
-        bool boutLog = false; \
-        static uint64_t _tvu_lastTime_##__LINE__ = 0;\
-        static uint32_t _tvu_counts_##__LINE__ = 0;\
-        static uint64_t _tvu_lastLastTime##__LINE__ = 0; \
-        if (!_tvu_lastLastTime##__LINE__) {\
-            _tvu_lastLastTime##__LINE__ = _tvu_now; \
-        } \
-        _tvu_counts_##__LINE__++;\
-        bool b_internal_time_out = _tvu_now>=_tvu_lastTime_##__LINE__+(seconds*(int64_t)1000) || _tvu_now<_tvu_lastTime_##__LINE__; \
-        uint32_t _tvu_count_copy = _tvu_counts_##__LINE__; \
-        if (b_internal_time_out) { \
-            if (_tvu_lastTime_##__LINE__ != 0) { \
-                _tvu_lastLastTime##__LINE__ = _tvu_lastTime_##__LINE__;\
-            } \
-            _tvu_lastTime_##__LINE__=_tvu_now; \
-            _tvu_counts_##__LINE__ = 0;\
-            boutLog = true; \
-        }  else if (_tvu_counts_##__LINE__ < maxIntervalCount) {\
-           boutLog = true;\
+        if (_libshm_log_level_of(level) < LIBSHM_LOG_COMPILE_LEVEL \
+            || !_libshm_log_level_enabled(_libshm_log_level_of(level), _libshmLogLevelOverride())) { \
+            break; \
         } \
-        if (boutLog) {\
+        static libshm_log_site_t _tvu_site; \
+        uint64_t _tvu_now = _libshm_get_sys_ms64_coarse(); \
+        uint32_t _tvu_count_copy = 0; \
+        uint64_t _tvu_interval = 0; \
+        bool b_internal_time_out = false; \
+        if (_libshm_log_site_hit(&_tvu_site, _tvu_now, seconds, maxIntervalCount \
+            , &_tvu_count_copy, &_tvu_interval, &b_internal_time_out)) {\
             char stime[50] = {0};\
             LibShmMediaProtoLogPrintInternal(level, "@[%s,%ld][%" PRIu64 ",%u%s%s] %c-" fmt \
             , __FUNCTION__, __LINE__\
             , _tvu_now, _tvu_count_copy, b_internal_time_out?"/":"@" \
-            , _libshmmediaInternalMilliSec2Str(_tvu_now-_tvu_lastLastTime##__LINE__, stime, sizeof(stime))\
+            , _libshmmediaInternalMilliSec2Str(_tvu_interval, stime, sizeof(stime))\
             , toupper(char(level)) \
             , ##__VA_ARGS__);\
-            if (b_internal_time_out) {\
-                _tvu_lastLastTime##__LINE__ = _tvu_lastTime_##__LINE__;\
-            } \
         } \
     } while (0)
 
@@ -221,7 +221,35 @@ typedef struct SLibshmMediaItemInfoV4Subv1v0 {
     uint32_t                        _key_value_area_len;
 }shm_media_item_info_v4_subv1v0_t;
 
-typedef shm_media_item_info_v4_subv1_t shm_media_item_info_v4_t;
+/**
+ *  _generation is the seqlock stamp of the item, (write index + 1) when committed,
+ *  0 while the writer is refilling the item. reader use it to check whether the
+ *  zero-copy frame had been overwritten. valid only when _head_len covers it.
+**/
+typedef struct SLibshmMediaItemInfoV4Subv2 {
+    shm_media_item_info_v4_subv1_t  _v41;
+    uint64_t                        _generation;
+    uint8_t                         _reserver[8];
+}shm_media_item_info_v4_subv2_t;
+
+typedef struct SLibshmMediaItemPlaneInfo {
+    uint32_t                        offset; // from the video data
+    uint32_t                        stride;
+    uint32_t                        height;
+}shm_media_item_plane_info_t;
+
+/**
+ *  _plane_count planes of the video data, 0 when the writer did not describe them.
+ *  valid only when _head_len covers it.
+**/
+typedef struct SLibshmMediaItemInfoV4Subv3 {
+    shm_media_item_info_v4_subv2_t  _v42;
+    uint32_t                        _plane_count;
+    shm_media_item_plane_info_t     _planes[LIBSHM_MEDIA_VIDEO_PLANES_MAX];
+    uint8_t                         _reserver[4];
+}shm_media_item_info_v4_subv3_t;
+
+typedef shm_media_item_info_v4_subv3_t shm_media_item_info_v4_t;
 
 #pragma pack(pop)
 
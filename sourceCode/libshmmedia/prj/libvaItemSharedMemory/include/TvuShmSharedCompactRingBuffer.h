@@ -37,8 +37,48 @@ namespace tvushm
         ~SharedCompactRingBuffer(void);
 
         bool Open(const char*name);
+        /**
+         *  @readOnly, a monitor maps the ring for reading only, it can not register a
+         *  reader or acquire a lease then.
+        **/
+        bool Open(const char*name,bool readOnly);
+        /**
+         *  tells the named shm is a ring of this class by its control data, not opening it,
+         *  the first @size bytes of its fixed user data are read into @fixedData.
+         *  return 1 it is, 0 not, or the fixed user data is shorter, -errno when it could not be read.
+        **/
+        static int Probe(const char*name,void*fixedData,size_t size);
         bool Create(const char*name,uint64_t fixedUserDataSize,uint64_t payloadBufferSize,uint64_t maxItemsNum);
         bool Create(const char*name,uint64_t fixedUserDataSize,uint64_t payloadBufferSize,uint64_t maxItemsNum,mode_t mode);
+        /**
+         *  hugePage: map a new shm from the hugetlbfs mount, falls back to normal pages.
+         *  IsHugePage tells the backing really mapped, also for the readers.
+        **/
+        bool Create(const char*name,uint64_t fixedUserDataSize,uint64_t payloadBufferSize,uint64_t maxItemsNum,mode_t mode,bool hugePage);
+        /**
+         *  payloadAlignment: every item Apply returns starts at a multiple of it from the
+         *  shm start, a power of 2 from sizeof(uint64) up to MaxPayloadAlignment, 0 for
+         *  sizeof(uint64). it is kept in the control data, writers reopening the shm use it.
+         *  the address is aligned as well up to the page size of the mapping.
+         *  batch items after the first one are placed by BatchItemSpan still.
+        **/
+        bool Create(const char*name,uint64_t fixedUserDataSize,uint64_t payloadBufferSize,uint64_t maxItemsNum,mode_t mode,bool hugePage,size_t payloadAlignment);
+        /**
+         *  lossless: see IsLossless, set before the ring is handed to the readers,
+         *  an existing shm takes it as well, false when its control data has no cursors.
+        **/
+        bool Create(const char*name,uint64_t fixedUserDataSize,uint64_t payloadBufferSize,uint64_t maxItemsNum,mode_t mode,bool hugePage,size_t payloadAlignment,bool lossless);
+        size_t GetPayloadAlignment()const;
+        enum { MaxPayloadAlignment=2*1024*1024 };
+        //reader cursors and leases keep an item index in 31 bits, so maxItemsNum*2 fits them;
+        enum { MaxItemsNum=0x3FFFFFFF };
+        bool IsHugePage()const;
+        /**
+         *  warm up the mapping, see SharedMemory::Prefault/Lock.
+        **/
+        int Prefault(bool forWriting);
+        int Lock();
+        int BindNuma(int node);
 
         bool GetInfo(uint64_t* fixedUserDataSizePtr=NULL,uint64_t* payloadBufferSizePtr=NULL,uint64_t* maxItemsNumPtr=NULL);
 
@@ -49,15 +89,39 @@ namespace tvushm
 
         void* Apply(size_t maxSize);
         bool Commit(const void*buffer,size_t size);
+        /**
+         *  batch writing, ApplyBatch reserves maxSize bytes for itemsNum items,
+         *  the items lay back to back, each one starts at BatchItemSpan() of the one before.
+         *  CommitBatch publishes all of them with one index update, readers see all or none.
+        **/
+        void* ApplyBatch(size_t maxSize,size_t itemsNum);
+        bool CommitBatch(const void*buffer,const size_t*sizes,size_t itemsNum);
+        static size_t BatchItemSpan(size_t size);
 
         void* Read(size_t *sizePtr);
         void* ReadNoStep(size_t *sizePtr);
+        /**
+         *  read at most maxCount consecutive items, return the count read out.
+         *  a lossless reader keeps holding from the first item of the batch.
+        **/
+        size_t ReadBatch(void**buffers,size_t*sizes,size_t maxCount);
         /**
          *  Read directly, but not check writing status
         **/
         void *ReadByPos(size_t *sizePtr, uint64_t pos);
+        /**
+         *  peek at the written items, no read index moves and no reader cursor is held.
+         *  PeekLatest return the newest item and its position, NULL when none written yet.
+         *  PeekSize gets the size of the item at @position, false when it is not in the ring.
+        **/
+        void *PeekLatest(size_t *sizePtr, uint64_t *positionPtr);
+        bool PeekSize(uint64_t position, size_t *sizePtr)const;
         uint64_t NextIndexStep(uint64_t pos)const;
         uint64_t PreviousIndexStep(uint64_t pos)const;
+        /* steps back @steps positions at once, steps must not be over GetMaxItemNum(). */
+        uint64_t PreviousIndexStep(uint64_t pos,uint64_t steps)const;
+        /* positions stepped from @from to @to, the positions wrap. */
+        uint64_t IndexStepsBetween(uint64_t from,uint64_t to)const;
 
         void* GetFixedData(size_t *sizePtr);
 
@@ -68,6 +132,50 @@ namespace tvushm
         bool IsReadable(void);
 
         bool IsWriteable(void);
+        bool IsWriteable(size_t size);
+        bool IsWriteable(size_t size,size_t itemsNum);
+
+        /**
+         *  lossless: the writer never overwrites the items which the registered readers
+         *  still hold, Apply returns NULL then, IsWriteable(size) tells it before.
+         *  the creator selects it by Create, before the ring is handed to the readers,
+         *  SetLossless changes it for a writer which took an existing ring over by Open.
+         *  WaitWriteable sleeps until a reader moves its cursor or releases a lease,
+         *  or timeoutMs, return false at once when the ring can not be waited on, not
+         *  linux or created before the wait word, the caller polls then.
+         */
+        bool SetLossless(bool lossless);
+        bool IsLossless()const;
+        bool WaitWriteable(size_t size,size_t itemsNum,unsigned int timeoutMs);
+        /**
+         *  reader claims a cursor of the lossless ring, released by Close().
+         *  false when the ring is not lossless or all cursors are taken.
+         *  the reader refreshes the heartbeat of its cursor and leases by IsReadable and
+         *  reading, a cursor or lease silent over 3s is taken back by the writer or another
+         *  reader. CheckReaderEvicted return true once after the cursor was taken back, the
+         *  items after it may have been overwritten unread, the reader is registered again.
+         */
+        bool RegisterReader();
+        bool CheckReaderEvicted();
+
+        /**
+         *  lease, pins the item at @position while the reader still uses it after reading on,
+         *  the lease lives in a slot of the shm. a lossless writer does not write over a
+         *  leased item, a lossy one goes on and marks the lease broken.
+         *  AcquireLease return the lease, LeaseNoSlot when the ring has no free slot or was
+         *  created before leases, LeaseGone when the item is overwritten or being so.
+         *  CheckLease/ReleaseLease return LeaseIntact, LeaseBroken, or LeaseInvalid for a
+         *  lease this object does not hold, a lease taken back for its silence is broken.
+         *  Close() releases the leases left.
+         *  as the read index, the leases held are kept in this object unsynchronized, the
+         *  lease calls of one object must not run on several threads at the same time.
+         */
+        enum { LeaseGone=-2, LeaseNoSlot=-1 };
+        enum { LeaseInvalid=-1, LeaseIntact=0, LeaseBroken=1 };
+        bool HasLeases()const;
+        int AcquireLease(uint64_t position);
+        int CheckLease(int lease)const;
+        int ReleaseLease(int lease);
 
         uint64_t GetWriteIndex(void) const;
 
@@ -95,9 +203,30 @@ namespace tvushm
         void  _previousReadingIndex();
         void* _getControlInfo();
         uint64_t _getMaxItemIndex()const;
+        const void* _peekItem(uint64_t position,size_t *sizePtr)const;
+        size_t  _getPayloadAlignment()const;
         bool    _isValidShmData()const;
+        /* checks the control data for reading, the write index by @nextFreeItemIndex. */
+        bool    _loadReadableControl(uint64_t&nextFreeItemIndex)const;
+        /* reads the item at @position and steps the reading index, @position may be moved to the last filled item. */
+        void*   _readAt(uint64_t&position,uint64_t nextFreeItemIndex,size_t *sizePtr);
+        uint64_t _readerCursorEntryOf(uint64_t position)const;
+        void    _publishReaderCursor(uint64_t position);
+        void    _releaseReaderCursor();
+        void    _loseReaderCursor();
+        void    _refreshHeartbeats();
+        uint32_t* _releaseWord();
+        void    _wakeWriter();
+        void    _breakReachedLeases(size_t size,size_t itemsNum);
+        uint64_t _placeFreeOffset()const;
+        void    _releaseLeases();
     private:
         SharedMemory _sm;
         uint64_t _nextReadingIndex;
+        int _readerCursor;
+        uint64_t _readerCursorEntry; // the value this object last stored to its cursor
+        bool _readerEvicted;
+        uint32_t _leasesHeld; // slots held by this object, single-threaded as _nextReadingIndex
+        uint64_t _leaseEntries[16]; // the values of the leases held, by slot
     };
 }
@@ -68,22 +68,47 @@ namespace tvushm
 
 	public:
 		bool Open(const char*name);
+        /* @readOnly, map it for reading only, read permission on the shm is enough then. */
+        bool Open(const char*name,bool readOnly);
         bool Create(const char*name,uint64_t size,bool&isNew);
         bool Create(const char*name,uint64_t size,bool&isNew,mode_t mode);
+        /**
+         *  @hugePage, map a new shm from the hugetlbfs mount, falls back to normal
+         *  pages when it could not. the size is rounded up to whole huge pages.
+         */
+        bool Create(const char*name,uint64_t size,bool&isNew,mode_t mode,bool hugePage);
 		void Close();
 		void Destroy();
         unsigned char* GetBytes(void)const;
         size_t GetSize(void) const;
 		bool IsValid() const;
+        bool IsHugePage() const;
+        bool IsReadOnly() const;
+        /**
+         *  fault in every page of the mapping without changing the data, Lock mlocks it.
+         *  return 0 success, or the errno.
+         */
+        int Prefault(bool forWriting);
+        int Lock();
+        /* prefer the numa node for the pages of the mapping, return 0 success, or the errno. */
+        int BindNuma(int node);
+        /**
+         *  read @size bytes at @offset of the named shm into @buffer without mapping it,
+         *  its whole size by @totalSizePtr. return 0 success, or the errno.
+         */
+        static int ReadBytes(const char*name,uint64_t offset,void*buffer,size_t size,uint64_t*totalSizePtr);
 	private:
 #if defined(TVU_WINDOWS)
 		HANDLE _mapFileHandle;
 #elif defined(TVU_LINUX) || defined(TVU_MINI)
 		int _shmId;
+        unsigned char* _createHugePage(const char*name,uint64_t size,mode_t mode,int&shmId,uint64_t&mapSize);
 #endif
 		unsigned char* _bytes;
         uint64_t _size;
 		std::string _name;
 		bool _isOwner;
+        bool _isHugePage;
+        bool _isReadOnly;
 	};
 }
@@ -20,6 +20,9 @@ History: Tony Guo on Feb 11, 2014: Created
 */
 
 #include "TvuLog.h"
+#include "TvuLogSink.h"
+#include "libshm_log_internal.h"
+#include "libshm_atomic_internal.h"
 #include <stdio.h>
 
 namespace tvushm
@@ -54,7 +57,10 @@ namespace tvushm
         {
             return false;
         }
-        return true;
+        /* the level of LibShmMediaSetLogLevel, checked before the message is formatted. */
+        int libshmLevel = level <= ErrorLevel ? LIBSHM_LOG_LEVEL_ERROR
+            : (level == WarnLevel ? LIBSHM_LOG_LEVEL_WARN : LIBSHM_LOG_LEVEL_INFO);
+        return _libshm_log_level_enabled(libshmLevel, LIBSHM_LOG_LEVEL_DEFAULT);
     }
 
     bool Log::IsSystemEnabled(void)
@@ -104,10 +110,15 @@ namespace tvushm
             return;
         }
 
-        if (_dumpLogCallback)
+        DumpLogCallback cb = (DumpLogCallback)(uintptr_t)_libshm_atomic_load_acquire_u64(&_dumpLogCallback);
+        if (cb && _libshm_atomic_load_relaxed_u32(&_async))
+        {
+            LogSink::GetDefaultSink().Post(LevelMapInteger(level), tag, message);
+        }
+        else if (cb)
         {
             int iv = LevelMapInteger(level);
-            _dumpLogCallback(iv, "%s%s%s%s"
+            cb(iv, "%s%s%s%s"
                 , tag?"T[":""
                 , tag?tag:""
                 , tag?"]-":""
@@ -187,7 +198,40 @@ namespace tvushm
 
     void Log::SetLogCallback(Log::DumpLogCallback cb)
     {
-        Log::_dumpLogCallback = cb;
+        LogSink &sink = LogSink::GetDefaultSink();
+
+        /* the messages posted before go to the callback of then. */
+        sink.Drain();
+        sink.SetCallback(cb);
+        _libshm_atomic_store_release_u64(&Log::_dumpLogCallback, (uint64_t)(uintptr_t)cb);
+        if (cb)
+        {
+            sink.Start();
+        }
+    }
+
+    void Log::SetAsync(bool bAsync)
+    {
+        _libshm_atomic_store_relaxed_u32(&Log::_async, bAsync ? 1 : 0);
+        if (!bAsync)
+        {
+            Flush();
+        }
+    }
+
+    int Log::Flush(void)
+    {
+        return LogSink::GetDefaultSink().Drain();
+    }
+
+    void Log::Synchronize(void (*fn)(void *opaq), void *opaq)
+    {
+        LogSink::GetDefaultSink().Synchronize(fn, opaq);
+    }
+
+    uint64_t Log::GetDroppedCount(void)
+    {
+        return LogSink::GetDefaultSink().GetDroppedCount();
     }
 
     void Log::SetLogTag(const char *tag)
@@ -198,7 +242,8 @@ namespace tvushm
         }
     }
 
-    Log::DumpLogCallback Log::_dumpLogCallback;
+    uint64_t Log::_dumpLogCallback = 0;
     std::string Log::_logTag;
+    uint32_t Log::_async = 1;
 }
 
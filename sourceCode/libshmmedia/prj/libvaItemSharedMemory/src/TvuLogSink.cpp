@@ -0,0 +1,190 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+#include "TvuLogSink.h"
+#include "libshm_atomic_internal.h"
+#include <stdio.h>
+#include <new>
+#include <chrono>
+
+/* the drainer sleeps from 1 ms after a record up to this when idle. */
+#define LOG_SINK_IDLE_MS_MAX        100
+
+#define LOG_SINK_RECORD_MASK        (LogSink::QueueRecords - 1)
+
+namespace tvushm
+{
+    LogSink::LogSink(void)
+        : _records(new (std::nothrow) Record_t[QueueRecords])
+        , _enqueuePos(0)
+        , _dequeuePos(0)
+        , _callback(0)
+        , _dropped(0)
+        , _stop(false)
+    {
+        for (int i = 0; _records && i < QueueRecords; i++)
+        {
+            _records[i].seq = i;
+        }
+    }
+
+    LogSink::~LogSink(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_stateLock);
+            _stop = true;
+        }
+        _stateCond.notify_all();
+
+        if (_drainer.joinable())
+        {
+            _drainer.join();
+        }
+        Drain();
+
+        std::lock_guard<std::mutex> guard(_drainLock);
+        delete [] _records;
+        _records = NULL;
+    }
+
+    LogSink &LogSink::GetDefaultSink()
+    {
+        static LogSink defaultSink;
+        return defaultSink;
+    }
+
+    void LogSink::SetCallback(Callback cb)
+    {
+        _libshm_atomic_store_release_u64(&_callback, (uint64_t)(uintptr_t)cb);
+    }
+
+    void LogSink::Start(void)
+    {
+        std::lock_guard<std::mutex> lock(_stateLock);
+        if (!_stop && !_drainer.joinable())
+        {
+            _drainer = std::thread(&LogSink::_run, this);
+        }
+    }
+
+    /**
+     *  a record is claimed by moving _enqueuePos over it, only when its seq tells
+     *  the drainer is done with it, it is handed over by seq = pos + 1.
+     */
+    bool LogSink::Post(int level, const char *tag, const char *message)
+    {
+        Record_t *rec = NULL;
+        uint64_t pos = _libshm_atomic_load_relaxed_u64(&_enqueuePos);
+
+        while (_records)
+        {
+            rec = &_records[pos & LOG_SINK_RECORD_MASK];
+            int64_t dif = (int64_t)(_libshm_atomic_load_acquire_u64(&rec->seq) - pos);
+
+            if (dif == 0 && _libshm_atomic_cas_u64(&_enqueuePos, pos, pos + 1))
+            {
+                break;
+            }
+            if (dif < 0)
+            {
+                /* the drainer has not freed it yet, the queue is full. */
+                rec = NULL;
+                break;
+            }
+            pos = _libshm_atomic_load_relaxed_u64(&_enqueuePos);
+        }
+
+        if (!rec)
+        {
+            _libshm_atomic_inc_u32(&_dropped);
+            return false;
+        }
+
+        rec->level = level;
+        int len = snprintf(rec->text, RecordSize, "%s%s%s%s"
+            , tag ? "T[" : ""
+            , tag ? tag : ""
+            , tag ? "]-" : ""
+            , message ? message : "");
+        if (len >= RecordSize)
+        {
+            rec->text[RecordSize - 2] = '\n';
+        }
+        _libshm_atomic_store_release_u64(&rec->seq, pos + 1);
+        return true;
+    }
+
+    int LogSink::Drain(void)
+    {
+        std::lock_guard<std::mutex> guard(_drainLock);
+        return _drain();
+    }
+
+    void LogSink::Synchronize(void (*fn)(void *opaq), void *opaq)
+    {
+        std::lock_guard<std::mutex> guard(_drainLock);
+        _drain();
+        if (fn)
+        {
+            fn(opaq);
+        }
+    }
+
+    int LogSink::_drain(void)
+    {
+        Callback cb = (Callback)(uintptr_t)_libshm_atomic_load_acquire_u64(&_callback);
+        int counts = 0;
+
+        while (_records)
+        {
+            Record_t *rec = &_records[_dequeuePos & LOG_SINK_RECORD_MASK];
+            if (_libshm_atomic_load_acquire_u64(&rec->seq) != _dequeuePos + 1)
+            {
+                /* empty, or the next record is still being filled. */
+                break;
+            }
+
+            if (cb)
+            {
+                cb(rec->level, "%s", rec->text);
+            }
+            _libshm_atomic_store_release_u64(&rec->seq, _dequeuePos + QueueRecords);
+            _dequeuePos++;
+            counts++;
+        }
+        return counts;
+    }
+
+    uint64_t LogSink::GetDroppedCount(void)
+    {
+        return _libshm_atomic_load_relaxed_u32(&_dropped);
+    }
+
+    void LogSink::_run(void)
+    {
+        int idleMs = 1;
+        std::unique_lock<std::mutex> lock(_stateLock);
+
+        while (!_stop)
+        {
+            lock.unlock();
+            int counts = Drain();
+            lock.lock();
+
+            idleMs = counts ? 1 : (idleMs * 2 < LOG_SINK_IDLE_MS_MAX ? idleMs * 2 : LOG_SINK_IDLE_MS_MAX);
+            if (!_stop)
+            {
+                _stateCond.wait_for(lock, std::chrono::milliseconds(idleMs));
+            }
+        }
+    }
+}
@@ -38,6 +38,9 @@ History: Tony Guo on Oct 4, 2016: Created
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include "libshm_hugepage_internal.h"
+#include "libshm_prefault_internal.h"
+#include "libshm_numa_internal.h"
 #endif
 #include <sys/types.h>
 
@@ -58,6 +61,8 @@ namespace tvushm
         _bytes=NULL;
         _size=0;
         _isOwner=false;
+        _isHugePage=false;
+        _isReadOnly=false;
 
 #if defined(TVU_WINDOWS)
         _mapFileHandle=INVALID_HANDLE_VALUE;
@@ -79,12 +84,18 @@ namespace tvushm
         }
     }
 
+    bool SharedMemory::Open(const char*name)
+    {
+        return Open(name,false);
+    }
+
 #if defined(TVU_WINDOWS)
 
-    bool SharedMemory::Open(const char*name)
+    bool SharedMemory::Open(const char*name,bool readOnly)
     {
+        DWORD access=readOnly?FILE_MAP_READ:FILE_MAP_ALL_ACCESS;
         HANDLE mapFileHandle=OpenFileMappingA(
-            FILE_MAP_ALL_ACCESS,
+            access,
             FALSE,
             name);
         if (mapFileHandle==NULL)
@@ -97,7 +108,7 @@ namespace tvushm
         }
 
         LPVOID bufferPtr= MapViewOfFile(mapFileHandle,
-            FILE_MAP_ALL_ACCESS,
+            access,
             0,
             0,
             0);
@@ -124,6 +135,7 @@ namespace tvushm
         _size=0;
         _name=(name);
         _isOwner=false;
+        _isReadOnly=readOnly;
         return true;
     }
 
@@ -214,6 +226,7 @@ namespace tvushm
             CloseHandle(_mapFileHandle);
             _mapFileHandle=INVALID_HANDLE_VALUE;
         }
+        _isReadOnly=false;
     }
 
     void SharedMemory::Destroy(void)
@@ -226,9 +239,36 @@ namespace tvushm
         return _bytes!=NULL && _mapFileHandle!=INVALID_HANDLE_VALUE;
     }
 
+    int SharedMemory::Prefault(bool forWriting)
+    {
+        TVU_UNREFERENCED(forWriting);
+        return ENOSYS;
+    }
+
+    int SharedMemory::Lock()
+    {
+        return ENOSYS;
+    }
+
+    int SharedMemory::BindNuma(int node)
+    {
+        TVU_UNREFERENCED(node);
+        return ENOSYS;
+    }
+
+    int SharedMemory::ReadBytes(const char*name,uint64_t offset,void*buffer,size_t size,uint64_t*totalSizePtr)
+    {
+        TVU_UNREFERENCED(name);
+        TVU_UNREFERENCED(offset);
+        TVU_UNREFERENCED(buffer);
+        TVU_UNREFERENCED(size);
+        TVU_UNREFERENCED(totalSizePtr);
+        return ENOSYS;
+    }
+
 #elif defined(TVU_LINUX) || defined(TVU_MINI)
 
-    bool SharedMemory::Open(const char*name)
+    bool SharedMemory::Open(const char*name,bool readOnly)
     {
         if (_shmId!=-1 || _bytes!=NULL)
         {
@@ -236,8 +276,21 @@ namespace tvushm
         }
 
         //try open;
-        int shmId=shm_open(    name, O_RDWR,
+        int oflag=readOnly?O_RDONLY:O_RDWR;
+        int shmId=shm_open(    name, oflag,
             S_IRUSR | S_IWUSR);
+        bool isHugePage=false;
+
+        if (shmId == -1 && errno == ENOENT)
+        {
+            //the creator could map it from the hugetlbfs mount;
+            shmId=_libshm_hugetlbfs_open(name, oflag, S_IRUSR | S_IWUSR);
+            isHugePage=(shmId != -1);
+            if (shmId == -1)
+            {
+                errno=ENOENT;
+            }
+        }
 
         if (shmId == -1)
         {
@@ -266,7 +319,7 @@ namespace tvushm
 
         size_t existingSize= shmStat.st_size;
 
-        byte*bytes= static_cast<byte*>(mmap(NULL, existingSize, PROT_READ | PROT_WRITE, MAP_SHARED, shmId, 0));
+        byte*bytes= static_cast<byte*>(mmap(NULL, existingSize, readOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, shmId, 0));
         if (bytes==MAP_FAILED || bytes==NULL)
         {
             int errorCode=errno;
@@ -282,6 +335,7 @@ namespace tvushm
             << (name)
             << ", address: "<< (uintptr)bytes
             << ", existing size: "<< existingSize
+            << ", huge page: "<< isHugePage
             );
 
         _shmId=shmId;
@@ -289,6 +343,8 @@ namespace tvushm
         _size=existingSize;
         _name=name;
         _isOwner=false;
+        _isHugePage=isHugePage;
+        _isReadOnly=readOnly;
         return true;
     }
 
@@ -298,6 +354,67 @@ namespace tvushm
     }
 
     bool SharedMemory::Create(const char*name,uint64_t size,bool&isNew,mode_t mode)
+    {
+        return Create(name, size, isNew, mode, false);
+    }
+
+    /**
+     *  return NULL when hugepage is not available, the caller falls back to normal pages.
+     */
+    unsigned char* SharedMemory::_createHugePage(const char*name,uint64_t size,mode_t mode,int&shmId,uint64_t&mapSize)
+    {
+        size_t pageSize=_libshm_hugetlbfs_page_size();
+        if (!pageSize)
+        {
+            TVU_HEARTBEAT_MULTIPLE_WARN(1,10,Log::GetDefaultLog(), Formatter("no hugetlbfs mount, uses normal pages. dir: ")
+                << _libshm_hugetlbfs_dir()
+                << ", name: "
+                << (name)
+                );
+            return NULL;
+        }
+
+        int fd=_libshm_hugetlbfs_open(name, O_CREAT | O_RDWR, mode);
+        if (fd == -1)
+        {
+            int errorCode=errno;
+            TVU_HEARTBEAT_MULTIPLE_WARN(1,10,Log::GetDefaultLog(), Formatter("hugetlbfs open failed, uses normal pages. name: ")
+                << (name)
+                << ", error: "
+                << FormatErrno(errorCode)
+                );
+            return NULL;
+        }
+
+        //hugetlbfs only maps whole huge pages, mmap fails when the pool is too small;
+        uint64_t alignedSize=_libshm_hugepage_align((size_t)size, pageSize);
+        void*bytes=MAP_FAILED;
+        if (ftruncate(fd, (off_t)alignedSize) == 0)
+        {
+            bytes=mmap(NULL, (size_t)alignedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+
+        if (bytes==MAP_FAILED || bytes==NULL)
+        {
+            int errorCode=errno;
+            TVU_HEARTBEAT_MULTIPLE_WARN(1,10,Log::GetDefaultLog(), Formatter("hugetlbfs map failed, uses normal pages. name: ")
+                << (name)
+                << ", size: "
+                << alignedSize
+                << ", error: "
+                << FormatErrno(errorCode)
+                );
+            close(fd);
+            _libshm_hugetlbfs_unlink(name);
+            return NULL;
+        }
+
+        shmId=fd;
+        mapSize=alignedSize;
+        return static_cast<unsigned char*>(bytes);
+    }
+
+    bool SharedMemory::Create(const char*name,uint64_t size,bool&isNew,mode_t mode,bool hugePage)
     {
         if (_shmId!=-1 || _bytes!=NULL)
         {
@@ -307,6 +424,38 @@ namespace tvushm
         //try open;
         int shmId=shm_open(    name, O_RDWR,
             mode);
+        bool isHugePage=false;
+
+        if (shmId == -1)
+        {
+            shmId=_libshm_hugetlbfs_open(name, O_RDWR, mode);
+            isHugePage=(shmId != -1);
+        }
+
+        if (shmId == -1 && hugePage)
+        {
+            uint64_t mapSize=0;
+            byte*bytes=_createHugePage(name, size, mode, shmId, mapSize);
+            if (bytes!=NULL)
+            {
+                isNew=true;
+
+                TVU_HEARTBEAT_MULTIPLE_DEBUG(1,10, Log::GetDefaultLog(), Formatter("shared memory created on huge pages. id: ")
+                    << shmId
+                    << ", name: "
+                    << (name)
+                    << ", address: "<< (uintptr)bytes
+                    << ", size: "    << mapSize
+                    );
+                _shmId=shmId;
+                _bytes=bytes;
+                _size=mapSize;
+                _name=name;
+                _isOwner=isNew;
+                _isHugePage=true;
+                return true;
+            }
+        }
 
         if (shmId == -1)
         {
@@ -360,6 +509,7 @@ namespace tvushm
             _size=size;
             _name=name;
             _isOwner=isNew;
+            _isHugePage=false;
             return true;
         }
         else
@@ -407,6 +557,7 @@ namespace tvushm
             _size=existingSize;
             _name=name;
             _isOwner=isNew;
+            _isHugePage=isHugePage;
             return true;
         }
     }
@@ -424,6 +575,8 @@ namespace tvushm
             close(_shmId);
             _shmId=-1;
         }
+        _isHugePage=false;
+        _isReadOnly=false;
     }
 
     void SharedMemory::Destroy(void)
@@ -436,21 +589,100 @@ namespace tvushm
         }
         if (_shmId!=-1)
         {
-            shm_unlink(_name.c_str());
+            if (_isHugePage)
+            {
+                _libshm_hugetlbfs_unlink(_name.c_str());
+            }
+            else
+            {
+                shm_unlink(_name.c_str());
+            }
             close(_shmId);
             _shmId=-1;
             _isOwner=false;
         }
+        _isHugePage=false;
     }
 
     bool SharedMemory::IsValid() const
     {
         return _bytes!=NULL && _shmId!=-1;
     }
+
+    int SharedMemory::Prefault(bool forWriting)
+    {
+        if (_bytes==NULL)
+        {
+            return EINVAL;
+        }
+        //a read-only mapping can not be faulted in for writing;
+        return _libshm_prefault(_bytes, (size_t)_size, forWriting && !_isReadOnly);
+    }
+
+    int SharedMemory::Lock()
+    {
+        if (_bytes==NULL)
+        {
+            return EINVAL;
+        }
+        return _libshm_mlock(_bytes, (size_t)_size);
+    }
+
+    int SharedMemory::BindNuma(int node)
+    {
+        if (_bytes==NULL)
+        {
+            return EINVAL;
+        }
+        return _libshm_numa_bind(_bytes, (size_t)_size, node);
+    }
+
+    int SharedMemory::ReadBytes(const char*name,uint64_t offset,void*buffer,size_t size,uint64_t*totalSizePtr)
+    {
+        if (name==NULL || buffer==NULL)
+        {
+            return EINVAL;
+        }
+
+        int shmId=shm_open(name, O_RDONLY, 0);
+        if (shmId == -1 && errno == ENOENT)
+        {
+            shmId=_libshm_hugetlbfs_open(name, O_RDONLY, 0);
+            if (shmId == -1)
+            {
+                errno=ENOENT;
+            }
+        }
+
+        if (shmId == -1)
+        {
+            return errno;
+        }
+
+        int errorCode=0;
+        struct stat shmStat;
+        MemUtils::Initialize(shmStat);
+
+        if (fstat(shmId,&shmStat)==-1)
+        {
+            errorCode=errno;
+        }
+        else if (pread(shmId,buffer,size,(off_t)offset)!=(ssize_t)size)
+        {
+            errorCode=ENODATA;
+        }
+        else if (totalSizePtr)
+        {
+            *totalSizePtr=(uint64_t)shmStat.st_size;
+        }
+        close(shmId);
+        return errorCode;
+    }
 #else
-    bool SharedMemory::Open(const char*name)
+    bool SharedMemory::Open(const char*name,bool readOnly)
     {
         TVU_UNREFERENCED(name);
+        TVU_UNREFERENCED(readOnly);
         return false;
     }
 
@@ -473,6 +705,33 @@ namespace tvushm
     {
         return false;
     }
+
+    int SharedMemory::Prefault(bool forWriting)
+    {
+        TVU_UNREFERENCED(forWriting);
+        return ENOSYS;
+    }
+
+    int SharedMemory::Lock()
+    {
+        return ENOSYS;
+    }
+
+    int SharedMemory::BindNuma(int node)
+    {
+        TVU_UNREFERENCED(node);
+        return ENOSYS;
+    }
+
+    int SharedMemory::ReadBytes(const char*name,uint64_t offset,void*buffer,size_t size,uint64_t*totalSizePtr)
+    {
+        TVU_UNREFERENCED(name);
+        TVU_UNREFERENCED(offset);
+        TVU_UNREFERENCED(buffer);
+        TVU_UNREFERENCED(size);
+        TVU_UNREFERENCED(totalSizePtr);
+        return ENOSYS;
+    }
 #endif
 
     unsigned char* SharedMemory::GetBytes(void) const
@@ -485,5 +744,15 @@ namespace tvushm
         return (size_t)_size;
     }
 
+    bool SharedMemory::IsHugePage(void) const
+    {
+        return _isHugePage;
+    }
+
+    bool SharedMemory::IsReadOnly(void) const
+    {
+        return _isReadOnly;
+    }
+
 
 }
@@ -29,8 +29,19 @@ Modifiers: Tony Guo (tonyguo@tvunetworks.com)
 #include "TvuTimeUtils.h"
 #include "TvuFormatUtils.h"
 #include "TvuCommonDefines.h"
+#include "libshm_atomic_internal.h"
+#include "libshm_wait_word_internal.h"
+#include "libshm_liveness_internal.h"
+#include "libshm_time_internal.h"
 #include <string.h>
 #include <algorithm>
+#include <errno.h>
+#if defined(TVU_LINUX)
+#include <signal.h>
+#include <unistd.h>
+#elif defined(TVU_WINDOWS)
+#include <windows.h>
+#endif
 
 //WARNINGS: DON'T CHANGE BELOW LINE OF MAGIC CODE
 #define TVU_SHARED_COMPACT_RING_BUFFER_MAGIC_CODE        "TVUCRB@20200518"
@@ -68,7 +79,7 @@ namespace tvushm
         {
             //flag 0~7: for creator/writer
             byte inactiveFlag:1; //need to close and reopen;
-            byte reservedFlag1:1;
+            byte losslessFlag:1; //writer never overwrites the items readerCursors hold;
             byte reservedFlag2:1;
             byte reservedFlag3:1;
             byte reservedFlag4:1;
@@ -134,17 +145,39 @@ namespace tvushm
             byte reservedFlag61:1;
             byte reservedFlag62:1;
             byte reservedFlag63:1;
-            uint64 reserved1;
-            uint64 reserved2;
-            uint64 reserved3;
-            uint64 reserved4;
-            uint64 reserved5;
-            uint64 reserved6;
-            uint64 reserved7;
+            //lossless readers, 0 free, or (pid << 32 | the oldest item index the reader still holds);
+            uint64 readerCursors[6];
+            //payload items start at multiples of it, 0 by the creators before it, means sizeof(uint64);
+            uint64 payloadAlignment;
+        };
+
+        struct ControlDataV3:ControlDataV2
+        {
+            //the bytes and items the writer applied but not committed yet, 0 when none,
+            //lease acquiring checks them against the new lease;
+            uint64 applyingSize;
+            uint64 applyingItemsNum;
+            //leases, 0 free, or (pid << 32 | LeaseBrokenBit | the leased item index);
+            uint64 leases[16];
+        };
+
+        struct ControlDataV4:ControlDataV3
+        {
+            //wait word, lossless readers wake the blocked writer by it after releasing items;
+            uint32 releaseWord;
+            uint32 reserved;
+        };
+
+        struct ControlDataV5:ControlDataV4
+        {
+            //ms, refreshed by the owners of readerCursors/leases, a slot silent too long
+            //could be reclaimed, see libshm_liveness_internal.h;
+            uint64 readerHeartbeats[6];
+            uint64 leaseHeartbeats[16];
         };
 
         typedef struct ControlDataV1 MinimumControlData;
-        typedef struct ControlDataV2 MaximumControlData;
+        typedef struct ControlDataV5 MaximumControlData;
 
         struct IndexItemV1
         {
@@ -160,12 +193,122 @@ namespace tvushm
         {
             InactiveControlMask=0x1
         };
+
+        enum
+        {
+            MaxReaderCursors=sizeof(((ControlDataV2*)0)->readerCursors)/sizeof(uint64),
+            MaxLeases=sizeof(((ControlDataV3*)0)->leases)/sizeof(uint64)
+        };
+
+        //a lease keeps the item index below the broken bit, Create bounds maxItemIndex to fit it;
+        enum
+        {
+            LeaseBrokenBit=0x80000000u,
+            LeasePositionMask=0x7FFFFFFFu
+        };
+
+        enum
+        {
+            //the readers gone without releasing never wake the writer, it re-checks in time;
+            ReleaseWaitMaxMs=100
+        };
     };
 #pragma pack(pop)
 
+    static inline uint32 _currentProcessId()
+    {
+#if defined(TVU_WINDOWS)
+        return (uint32)GetCurrentProcessId();
+#else
+        return (uint32)getpid();
+#endif
+    }
+
+    //the heartbeats of the reader cursors and leases, NULL for the rings created before them;
+    static inline uint64* _readerHeartbeat(SharedCompactRingBufferImpl::MaximumControlData&controlData,int i)
+    {
+        return controlData.controlDataSize>=sizeof(SharedCompactRingBufferImpl::ControlDataV5)
+            ?&controlData.readerHeartbeats[i]:NULL;
+    }
+
+    static inline uint64* _leaseHeartbeat(SharedCompactRingBufferImpl::MaximumControlData&controlData,int i)
+    {
+        return controlData.controlDataSize>=sizeof(SharedCompactRingBufferImpl::ControlDataV5)
+            ?&controlData.leaseHeartbeats[i]:NULL;
+    }
+
+    //the same rule as the reader slots of the fixed ring, the heartbeat decides, the pid is only a hint;
+    static inline bool _isSlotExpired(uint64 entry,const uint64*heartbeat,uint64 now)
+    {
+        return _libshm_slot_expired((uint32)(entry>>32),heartbeat,now);
+    }
+
+    static inline void _fullFence()
+    {
+#if defined(TVU_WINDOWS) && !defined(TVU_MINGW)
+        MemoryBarrier();
+#else
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+    }
+
+    //whether the next write of size bytes/itemsNum items from the free offset reaches the item at position;
+    static bool _writeReachesPosition(const byte*smBytes,
+        const SharedCompactRingBufferImpl::MaximumControlData&controlData,
+        uint64 position,uint64 freeItemPayloadOffset,size_t size,size_t itemsNum)
+    {
+        uint64 maxItemIndex=controlData.maxItemIndex;
+        uint64 maxItemsNum=controlData.maxItemsNum;
+        uint64 nextFreeItemIndex=controlData.nextFreeItemIndex;
+        uint64 payloadBegin=controlData.payloadDataOffset;
+        uint64 payloadEnd=controlData.payloadDataOffset+controlData.payloadDataSize;
+
+        if (position>=maxItemIndex)
+        {
+            return false;
+        }
+
+        uint64 held=(nextFreeItemIndex+maxItemIndex-position)%maxItemIndex;
+        if (held==0 || held>maxItemsNum)
+        {
+            //not written yet, or lapped already;
+            return false;
+        }
+
+        if (held+itemsNum>maxItemsNum)
+        {
+            //one of the next index items is the one at position;
+            return true;
+        }
+
+        const SharedCompactRingBufferImpl::IndexItem&heldItem=
+            *reinterpret_cast<const SharedCompactRingBufferImpl::IndexItem*>(smBytes+
+            controlData.indexDataOffset+
+            controlData.indexItemSize*(position%maxItemsNum));
+
+        if (heldItem.index!=position)
+        {
+            return false;
+        }
+
+        //held payload is [heldItem.offset, freeItemPayloadOffset), wrapped when offset >= free offset;
+        uint64 heldOffset=heldItem.offset;
+        if (heldOffset>=freeItemPayloadOffset)
+        {
+            return freeItemPayloadOffset+size>heldOffset;
+        }
+        return freeItemPayloadOffset+size>=payloadEnd && payloadBegin+size>heldOffset;
+    }
+
     SharedCompactRingBuffer::SharedCompactRingBuffer(void)
     {
         _nextReadingIndex=(uint64)(-1);
+        _readerCursor=-1;
+        _readerCursorEntry=0;
+        _readerEvicted=false;
+        _leasesHeld=0;
+        (void)sizeof(char[(sizeof(_leaseEntries)/sizeof(_leaseEntries[0])==SharedCompactRingBufferImpl::MaxLeases)?1:-1]);
+        memset(_leaseEntries,0,sizeof(_leaseEntries));
     }
 
     SharedCompactRingBuffer::~SharedCompactRingBuffer(void)
@@ -174,7 +317,12 @@ namespace tvushm
 
     bool SharedCompactRingBuffer::Open(const char*name)
     {
-        if (!_sm.Open(name))
+        return Open(name,false);
+    }
+
+    bool SharedCompactRingBuffer::Open(const char*name,bool readOnly)
+    {
+        if (!_sm.Open(name,readOnly))
         {
             return false;
         }
@@ -188,14 +336,53 @@ namespace tvushm
         return true;
     }
 
+    int SharedCompactRingBuffer::Probe(const char*name,void*fixedData,size_t size)
+    {
+        SharedCompactRingBufferImpl::MinimumControlData controlData;
+        uint64_t totalSize=0;
+
+        int errorCode=SharedMemory::ReadBytes(name,0,&controlData,sizeof(controlData),&totalSize);
+        if (errorCode==ENODATA)
+        {
+            //shorter than the control data;
+            return 0;
+        }
+        if (errorCode!=0)
+        {
+            return -errorCode;
+        }
+
+        const char magicCode[]=TVU_SHARED_COMPACT_RING_BUFFER_MAGIC_CODE;
+        if (memcmp(controlData.magicCode, magicCode, std::min(sizeof(magicCode),sizeof(controlData.magicCode))) ||
+            controlData.totalSharedMemorySize!=totalSize ||
+            controlData.fixedUserDataSize<size)
+        {
+            return 0;
+        }
+
+        if (size>0)
+        {
+            errorCode=SharedMemory::ReadBytes(name,controlData.fixedUserDataOffset,fixedData,size,NULL);
+            if (errorCode!=0)
+            {
+                return errorCode==ENODATA ? 0 : -errorCode;
+            }
+        }
+        return 1;
+    }
+
     void SharedCompactRingBuffer::Close()
     {
+        _releaseLeases();
+        _releaseReaderCursor();
         _sm.Close();
         _nextReadingIndex=(uint64)(-1);
     }
 
     void SharedCompactRingBuffer::Destroy()
     {
+        _releaseLeases();
+        _releaseReaderCursor();
         _sm.Destroy();
         _nextReadingIndex=(uint64)(-1);
     }
@@ -206,14 +393,66 @@ namespace tvushm
     }
 
     bool SharedCompactRingBuffer::Create(const char*name,uint64_t fixedUserDataSize,uint64_t payloadBufferSize,uint64_t maxItemsNum,mode_t mode)
+    {
+        return Create(name, fixedUserDataSize, payloadBufferSize, maxItemsNum, mode, false);
+    }
+
+    bool SharedCompactRingBuffer::IsHugePage()const
+    {
+        return _sm.IsHugePage();
+    }
+
+    int SharedCompactRingBuffer::Prefault(bool forWriting)
+    {
+        return _sm.Prefault(forWriting);
+    }
+
+    int SharedCompactRingBuffer::Lock()
+    {
+        return _sm.Lock();
+    }
+
+    int SharedCompactRingBuffer::BindNuma(int node)
+    {
+        return _sm.BindNuma(node);
+    }
+
+    bool SharedCompactRingBuffer::Create(const char*name,uint64_t fixedUserDataSize,uint64_t payloadBufferSize,uint64_t maxItemsNum,mode_t mode,bool hugePage)
+    {
+        return Create(name, fixedUserDataSize, payloadBufferSize, maxItemsNum, mode, hugePage, 0);
+    }
+
+    bool SharedCompactRingBuffer::Create(const char*name,uint64_t fixedUserDataSize,uint64_t payloadBufferSize,uint64_t maxItemsNum,mode_t mode,bool hugePage,size_t payloadAlignment)
+    {
+        return Create(name, fixedUserDataSize, payloadBufferSize, maxItemsNum, mode, hugePage, payloadAlignment, false);
+    }
+
+    bool SharedCompactRingBuffer::Create(const char*name,uint64_t fixedUserDataSize,uint64_t payloadBufferSize,uint64_t maxItemsNum,mode_t mode,bool hugePage,size_t payloadAlignment,bool lossless)
     {
         //estimate required shared memory size.
-        if (maxItemsNum<=1 || payloadBufferSize==0)
+        if (maxItemsNum<=1 || maxItemsNum>MaxItemsNum || payloadBufferSize==0)
         {
             //bad parameter;
             return false;
         }
 
+        if (payloadAlignment==0)
+        {
+            payloadAlignment=sizeof(uint64);
+        }
+
+        if (payloadAlignment<sizeof(uint64) || payloadAlignment>MaxPayloadAlignment
+            || (payloadAlignment&(payloadAlignment-1))!=0)
+        {
+            TVU_TAGGED_HEARTBEAT_WARN(
+                        "virsmw",1,Log::GetDefaultLog(),
+                        Formatter("create shm, invalid payload alignment.")
+                        <<"name:"<<name
+                        <<"alignment:"<<payloadAlignment
+                        );
+            return false;
+        }
+
         size_t alignment=sizeof(uint64);
         size_t controlDataSize=sizeof(SharedCompactRingBufferImpl::MaximumControlData);
         size_t alignedControlDataSize=controlDataSize;
@@ -242,13 +481,17 @@ namespace tvushm
             alignedIndexDataSize+=alignment-(alignedIndexDataSize % alignment);
         }
 
-        uint64 expectedSharedMemorySize=controlDataSize+
-            alignedFixedUserDataSize+
-            alignedIndexDataSize+
-            payloadBufferSize;
+        //the payload area starts aligned, then Apply only needs to round up the offsets;
+        uint64 payloadDataOffset=alignedControlDataSize+alignedFixedUserDataSize+alignedIndexDataSize;
+        if ((payloadDataOffset % payloadAlignment)!=0)
+        {
+            payloadDataOffset+=payloadAlignment-(payloadDataOffset % payloadAlignment);
+        }
+
+        uint64 expectedSharedMemorySize=payloadDataOffset+payloadBufferSize;
 
         bool isNew=false;
-        if (!_sm.Create(name,expectedSharedMemorySize,isNew,mode))
+        if (!_sm.Create(name,expectedSharedMemorySize,isNew,mode,hugePage))
         {
             //failed to create shared memory;
             TVU_TAGGED_HEARTBEAT_WARN(
@@ -264,6 +507,11 @@ namespace tvushm
         {
             //initialize control area;
             size_t shmSize = _sm.GetSize();
+            if (_sm.IsHugePage() && shmSize > expectedSharedMemorySize)
+            {
+                //rounded up to whole huge pages, the tail is not used;
+                expectedSharedMemorySize = shmSize;
+            }
             if (expectedSharedMemorySize != shmSize)
             {
                 TVU_TAGGED_HEARTBEAT_WARN(
@@ -294,10 +542,12 @@ namespace tvushm
             controlData.indexItemSize=alignedIndexItemSize;
             controlData.actualIndexItemSize=indexItemSize;
 
-            controlData.payloadDataOffset=alignedControlDataSize+alignedFixedUserDataSize+alignedIndexDataSize;
+            controlData.payloadDataOffset=payloadDataOffset;
             controlData.payloadDataSize=payloadBufferSize;
+            controlData.payloadAlignment=payloadAlignment;
             controlData.maxItemsNum=maxItemsNum;
             controlData.maxItemIndex=maxItemsNum*2;
+            controlData.losslessFlag=lossless?1:0;
 
             if (!_isValidShmData())
             {
@@ -325,6 +575,16 @@ namespace tvushm
             size_t shmSize = _sm.GetSize();
             const SharedCompactRingBufferImpl::MaximumControlData& controlData=
                 *reinterpret_cast<const SharedCompactRingBufferImpl::MaximumControlData*>(_sm.GetBytes());
+            if (!SetLossless(lossless))
+            {
+                TVU_TAGGED_HEARTBEAT_WARN(
+                            "virsmw",1,Log::GetDefaultLog(),
+                            Formatter("create shm existing, no reader cursors for lossless. ")
+                            <<"name:"<<name
+                            );
+                _sm.Close();
+                return false;
+            }
             if (shmSize < expectedSharedMemorySize
                     || controlData.maxItemsNum < maxItemsNum
                     || controlData.payloadDataSize < payloadBufferSize
@@ -451,7 +711,18 @@ namespace tvushm
 
     void* SharedCompactRingBuffer::Apply(size_t maxSize)
     {
-        if (maxSize==0)
+        return ApplyBatch(maxSize,1);
+    }
+
+    size_t SharedCompactRingBuffer::BatchItemSpan(size_t size)
+    {
+        size_t alignment=sizeof(uint64);
+        return (size+alignment-1)/alignment*alignment;
+    }
+
+    void* SharedCompactRingBuffer::ApplyBatch(size_t maxSize,size_t itemsNum)
+    {
+        if (maxSize==0 || itemsNum==0)
         {
             return NULL;
         }
@@ -480,6 +751,12 @@ namespace tvushm
             return NULL;
         }
 
+        if (itemsNum>=controlData.maxItemsNum)
+        {
+            //the batch would overwrite its own index items;
+            return NULL;
+        }
+
         if (controlData.controlDataSize<sizeof(SharedCompactRingBufferImpl::MinimumControlData))
         {
             return NULL;
@@ -495,15 +772,21 @@ namespace tvushm
             return NULL;
         }
 
+        if (!IsWriteable(maxSize,itemsNum))
+        {
+            //lossless, the slowest reader still holds the space;
+            return NULL;
+        }
+
         uint64 freeItemPayloadOffset=controlData.nextFreeItemPayloadOffset;
 
-        //align to machine word;
+        //align to the payload alignment;
         if (freeItemPayloadOffset<controlData.payloadDataOffset)
         {
             freeItemPayloadOffset=controlData.payloadDataOffset;
         }
 
-        size_t alignment=sizeof(uint64);
+        size_t alignment=_getPayloadAlignment();
         if ((freeItemPayloadOffset %alignment)!=0)
         {
             freeItemPayloadOffset+=alignment-(freeItemPayloadOffset % alignment);
@@ -511,26 +794,41 @@ namespace tvushm
 
         if (freeItemPayloadOffset+maxSize>=controlData.payloadDataOffset+controlData.payloadDataSize)
         {
-            //LLL, clear the writing before.
-            if (controlData.payloadDataOffset+controlData.payloadDataSize > freeItemPayloadOffset)
-            {
-                memset(smBytes+freeItemPayloadOffset, 0, controlData.payloadDataOffset+controlData.payloadDataSize-freeItemPayloadOffset);
-            }
-            //unwind to first;
+            //unwind to first, the tail is left as it is. readers only reach the payload
+            //by the index items, the item indexed at payloadDataOffset after it marks the
+            //wrap, nothing ever points into the tail again until it is written over.
             freeItemPayloadOffset=controlData.payloadDataOffset;
         }
 
+        _breakReachedLeases(maxSize,itemsNum);
+
         byte*nextFreeBytes=smBytes+freeItemPayloadOffset;
         return nextFreeBytes;
     }
 
     bool SharedCompactRingBuffer::Commit(const void*buffer,size_t size)
     {
-        if (buffer==NULL || size==0)
+        return CommitBatch(buffer,&size,1);
+    }
+
+    bool SharedCompactRingBuffer::CommitBatch(const void*buffer,const size_t*sizes,size_t itemsNum)
+    {
+        if (buffer==NULL || sizes==NULL || itemsNum==0)
         {
             return false;
         }
 
+        //the items lay back to back from buffer, each starts at BatchItemSpan of the one before;
+        size_t size=0;
+        for (size_t i=0;i<itemsNum;i++)
+        {
+            if (sizes[i]==0)
+            {
+                return false;
+            }
+            size+=(i+1<itemsNum)?BatchItemSpan(sizes[i]):sizes[i];
+        }
+
         byte*smBytes=_sm.GetBytes();
         if (smBytes==NULL)
         {
@@ -555,6 +853,11 @@ namespace tvushm
             return false;
         }
 
+        if (itemsNum>=controlData.maxItemsNum)
+        {
+            return false;
+        }
+
         if (controlData.controlDataSize<sizeof(SharedCompactRingBufferImpl::MinimumControlData))
         {
             return false;
@@ -578,13 +881,13 @@ namespace tvushm
             freeItemIndex=0;
         }
 
-        //align to machine word;
+        //align to the payload alignment;
         if (freeItemPayloadOffset<controlData.payloadDataOffset)
         {
             freeItemPayloadOffset=controlData.payloadDataOffset;
         }
 
-        size_t alignment=sizeof(uint64);
+        size_t alignment=_getPayloadAlignment();
         if ((freeItemPayloadOffset % alignment)!=0)
         {
             freeItemPayloadOffset+=alignment-(freeItemPayloadOffset % alignment);
@@ -614,22 +917,40 @@ namespace tvushm
             return false;
         }
 
-        uint64 nextFreeItemIndex=(freeItemIndex+1)%(controlData.maxItemIndex);
+        uint64 itemIndex=freeItemIndex;
+        uint64 itemOffset=bufferOffset;
+        for (size_t i=0;i<itemsNum;i++)
+        {
+            if (i>0)
+            {
+                itemOffset+=BatchItemSpan(sizes[i-1]);
+                itemIndex=(itemIndex+1)%(controlData.maxItemIndex);
+            }
 
-        SharedCompactRingBufferImpl::IndexItem&freeItem=
-            *reinterpret_cast<SharedCompactRingBufferImpl::IndexItem*>(smBytes+
-            controlData.indexDataOffset+
-            controlData.indexItemSize*(freeItemIndex%controlData.maxItemsNum));
+            SharedCompactRingBufferImpl::IndexItem&freeItem=
+                *reinterpret_cast<SharedCompactRingBufferImpl::IndexItem*>(smBytes+
+                controlData.indexDataOffset+
+                controlData.indexItemSize*(itemIndex%controlData.maxItemsNum));
 
-        freeItem.offset=bufferOffset;
-        freeItem.size=size;
-        freeItem.index=freeItemIndex;
-        freeItem.checksum=freeItemIndex+bufferOffset+size;
-        //update the index;
+            freeItem.offset=itemOffset;
+            freeItem.size=sizes[i];
+            freeItem.index=itemIndex;
+            freeItem.checksum=itemIndex+itemOffset+sizes[i];
+        }
+
+        uint64 nextFreeItemIndex=(itemIndex+1)%(controlData.maxItemIndex);
+        //update the index once for the whole batch, the index items and the checksum
+        //first, then both indices, the write index last, readers acquire it first;
         controlData.nextFreeItemPayloadOffset=bufferOffset+size;
-        controlData.lastFilledItemIndex=freeItemIndex;
-        controlData.itemIndexChecksum=nextFreeItemIndex+freeItemIndex;
-        controlData.nextFreeItemIndex=nextFreeItemIndex;
+        _libshm_atomic_store_release_u64(&controlData.itemIndexChecksum,nextFreeItemIndex+itemIndex);
+        _libshm_atomic_store_release_u64(&controlData.lastFilledItemIndex,itemIndex);
+        _libshm_atomic_store_release_u64(&controlData.nextFreeItemIndex,nextFreeItemIndex);
+        if (controlData.controlDataSize>=sizeof(SharedCompactRingBufferImpl::ControlDataV3))
+        {
+            SharedCompactRingBufferImpl::MaximumControlData&controlDataV3=
+                *reinterpret_cast<SharedCompactRingBufferImpl::MaximumControlData*>(smBytes);
+            _libshm_atomic_store_release_u64(&controlDataV3.applyingSize,0);
+        }
         return true;
     }
 
@@ -640,73 +961,133 @@ namespace tvushm
             return NULL;
         }
 
+        uint64 nextFreeItemIndex=0;
+        if (!_loadReadableControl(nextFreeItemIndex))
+        {
+            return NULL;
+        }
+
+        uint64 position=_nextReadingIndex;
+        void*buffer=_readAt(position,nextFreeItemIndex,sizePtr);
+        if (buffer!=NULL)
+        {
+            _publishReaderCursor(position);
+        }
+        return buffer;
+    }
+
+    size_t SharedCompactRingBuffer::ReadBatch(void**buffers,size_t*sizes,size_t maxCount)
+    {
+        if (buffers==NULL || sizes==NULL || maxCount==0)
+        {
+            return 0;
+        }
+
+        //the control data is checked once, the cursor is published once for the batch;
+        uint64 nextFreeItemIndex=0;
+        if (!_loadReadableControl(nextFreeItemIndex))
+        {
+            return 0;
+        }
+
+        uint64 firstPosition=_nextReadingIndex;
+        size_t n=0;
+        while (n<maxCount)
+        {
+            uint64 position=_nextReadingIndex;
+            void*buffer=_readAt(position,nextFreeItemIndex,sizes+n);
+            if (buffer==NULL)
+            {
+                break;
+            }
+
+            if (n==0)
+            {
+                firstPosition=position;
+            }
+            buffers[n++]=buffer;
+        }
+
+        if (n>0)
+        {
+            //a lossless reader keeps holding from the first item of the batch;
+            _publishReaderCursor(firstPosition);
+        }
+        return n;
+    }
+
+    bool SharedCompactRingBuffer::_loadReadableControl(uint64_t&nextFreeItemIndex)const
+    {
         byte*smBytes=_sm.GetBytes();
         if (smBytes==NULL)
         {
-            return NULL;
+            return false;
         }
 
-        SharedCompactRingBufferImpl::MinimumControlData&controlData=
+        const SharedCompactRingBufferImpl::MinimumControlData&controlData=
             *reinterpret_cast<SharedCompactRingBufferImpl::MinimumControlData*>(smBytes);
 
         if (controlData.controlDataSize<sizeof(SharedCompactRingBufferImpl::MinimumControlData))
         {
-            return NULL;
+            return false;
         }
 
-        //if (controlData.controlDataSize>=sizeof(SharedCompactRingBufferImpl::ControlDataV2))
-        //{
-        //    SharedCompactRingBufferImpl::ControlDataV2&controlDataV2=
-        //        *reinterpret_cast<SharedCompactRingBufferImpl::ControlDataV2*>(smBytes);
-        //    controlDataV2.requestedFlag=1;
-        //}
-
         if (controlData.indexItemSize<controlData.actualIndexItemSize)
         {
-            return NULL;
+            return false;
         }
 
         if (controlData.actualIndexItemSize<sizeof(SharedCompactRingBufferImpl::IndexItemV1))
         {
-            return NULL;
+            return false;
         }
 
         if (controlData.maxItemsNum<=1)
         {
-            return NULL;
+            return false;
         }
 
         if (controlData.maxItemIndex<=1)
         {
-            return NULL;
+            return false;
         }
 
-        uint64 nextFreeItemIndex=controlData.nextFreeItemIndex;
-        uint64 lastFilledItemIndex=controlData.lastFilledItemIndex;
-        uint64 itemIndexChecksum=controlData.itemIndexChecksum;
+        uint64 nextFree=_libshm_atomic_load_acquire_u64(&controlData.nextFreeItemIndex);
+        uint64 lastFilledItemIndex=_libshm_atomic_load_acquire_u64(&controlData.lastFilledItemIndex);
+        uint64 itemIndexChecksum=_libshm_atomic_load_acquire_u64(&controlData.itemIndexChecksum);
 
-        if (nextFreeItemIndex==0 && lastFilledItemIndex==0)
+        if (nextFree==0 && lastFilledItemIndex==0)
         {
             //never enqueued.
-            return NULL;
+            return false;
         }
 
-        uint64 position=_nextReadingIndex;
-        if (itemIndexChecksum!=nextFreeItemIndex+lastFilledItemIndex)
+        if (itemIndexChecksum!=nextFree+lastFilledItemIndex)
         {
             TVU_TAGGED_HEARTBEAT_WARN("virsmw",1,Log::GetDefaultLog(),Formatter("unexpected control checksum. ")
-                <<"write index: "<<nextFreeItemIndex
+                <<"write index: "<<nextFree
                 <<", last written index: "<<lastFilledItemIndex
                 <<", unexpected checksum: "<<itemIndexChecksum
-                <<", expected checksum: "<<nextFreeItemIndex+lastFilledItemIndex
-                <<", next reading index:" << position
+                <<", expected checksum: "<<nextFree+lastFilledItemIndex
+                <<", next reading index:" << _nextReadingIndex
             ); /* control data was writing. */
-            return NULL;
+            return false;
         }
 
+        nextFreeItemIndex=nextFree;
+        return true;
+    }
+
+    void* SharedCompactRingBuffer::_readAt(uint64_t&position,uint64_t nextFreeItemIndex,size_t *sizePtr)
+    {
+        byte*smBytes=_sm.GetBytes();
+
+        const SharedCompactRingBufferImpl::MinimumControlData&controlData=
+            *reinterpret_cast<SharedCompactRingBufferImpl::MinimumControlData*>(smBytes);
+
         if (position>=controlData.maxItemIndex)
         {
-            position=lastFilledItemIndex;
+            position=_libshm_atomic_load_acquire_u64(&controlData.lastFilledItemIndex);
         }
         else if (position==nextFreeItemIndex)
         {
@@ -797,7 +1178,7 @@ namespace tvushm
 
         const SharedCompactRingBufferImpl::MinimumControlData&controlData=
             *reinterpret_cast<SharedCompactRingBufferImpl::MinimumControlData*>(smBytes);
-        uint64 nextFreeItemIndex=controlData.nextFreeItemIndex;
+        uint64 nextFreeItemIndex=_libshm_atomic_load_acquire_u64(&controlData.nextFreeItemIndex);
 
         SharedCompactRingBufferImpl::IndexItem&expectedItem=
             *reinterpret_cast<SharedCompactRingBufferImpl::IndexItem*>(smBytes+
@@ -862,19 +1243,82 @@ namespace tvushm
         return static_cast<void*>(buffer);
     }
 
-    uint64_t SharedCompactRingBuffer::NextIndexStep(uint64_t position)const
+    const void* SharedCompactRingBuffer::_peekItem(uint64_t position,size_t *sizePtr)const
     {
-        uint64 maxItemIndex = _getMaxItemIndex();
-        uint64 nextPosition=(position+1)%maxItemIndex;
-        return nextPosition;
-    }
+        const byte*smBytes=_sm.GetBytes();
 
-    uint64_t SharedCompactRingBuffer::PreviousIndexStep(uint64_t position)const
-    {
-        uint64 maxItemIndex = _getMaxItemIndex();
-        uint64 prePosition = 0;
-        if (position == 0)
-        {
+        const SharedCompactRingBufferImpl::MinimumControlData&controlData=
+            *reinterpret_cast<const SharedCompactRingBufferImpl::MinimumControlData*>(smBytes);
+
+        if (position>=controlData.maxItemIndex)
+        {
+            return NULL;
+        }
+
+        const SharedCompactRingBufferImpl::IndexItem&item=
+            *reinterpret_cast<const SharedCompactRingBufferImpl::IndexItem*>(smBytes+
+            controlData.indexDataOffset+
+            controlData.indexItemSize*(position%controlData.maxItemsNum));
+
+        uint64 index=item.index;
+        uint64 offset=item.offset;
+        uint64 size=item.size;
+        uint64 checksum=item.checksum;
+
+        //a slot not written yet, or written over, is not an error for peeking, no warning;
+        if (checksum!=(index+offset+size) || index!=position)
+        {
+            return NULL;
+        }
+
+        if (offset<controlData.payloadDataOffset ||
+            offset+size>controlData.totalSharedMemorySize)
+        {
+            return NULL;
+        }
+
+        *sizePtr=(size_t)size;
+        return smBytes+(size_t)offset;
+    }
+
+    void *SharedCompactRingBuffer::PeekLatest(size_t *sizePtr, uint64_t *positionPtr)
+    {
+        if (sizePtr==NULL || !IsValid())
+        {
+            return NULL;
+        }
+
+        uint64 position=PreviousIndexStep(GetWriteIndex());
+        void*buffer=const_cast<void*>(_peekItem(position,sizePtr));
+        if (buffer && positionPtr)
+        {
+            *positionPtr=position;
+        }
+        return buffer;
+    }
+
+    bool SharedCompactRingBuffer::PeekSize(uint64_t position, size_t *sizePtr)const
+    {
+        if (sizePtr==NULL || !IsValid())
+        {
+            return false;
+        }
+        return _peekItem(position,sizePtr)!=NULL;
+    }
+
+    uint64_t SharedCompactRingBuffer::NextIndexStep(uint64_t position)const
+    {
+        uint64 maxItemIndex = _getMaxItemIndex();
+        uint64 nextPosition=(position+1)%maxItemIndex;
+        return nextPosition;
+    }
+
+    uint64_t SharedCompactRingBuffer::PreviousIndexStep(uint64_t position)const
+    {
+        uint64 maxItemIndex = _getMaxItemIndex();
+        uint64 prePosition = 0;
+        if (position == 0)
+        {
             prePosition = maxItemIndex-1;
         }
         else
@@ -884,6 +1328,18 @@ namespace tvushm
         return prePosition;
     }
 
+    uint64_t SharedCompactRingBuffer::PreviousIndexStep(uint64_t position,uint64_t steps)const
+    {
+        uint64 maxItemIndex = _getMaxItemIndex();
+        return (position+maxItemIndex-steps%maxItemIndex)%maxItemIndex;
+    }
+
+    uint64_t SharedCompactRingBuffer::IndexStepsBetween(uint64_t from,uint64_t to)const
+    {
+        uint64 maxItemIndex = _getMaxItemIndex();
+        return (to+maxItemIndex-from%maxItemIndex)%maxItemIndex;
+    }
+
     void *SharedCompactRingBuffer::_getControlInfo()
     {
         byte*smBytes=_sm.GetBytes();
@@ -966,6 +1422,7 @@ namespace tvushm
         //0: first;
         //-1: last;
         _nextReadingIndex=nextReadingIndex;
+        _publishReaderCursor(nextReadingIndex);
         return true;
     }
 
@@ -985,7 +1442,7 @@ namespace tvushm
             return (uint64)(-1);
         }
 
-        return controlData.nextFreeItemIndex;
+        return _libshm_atomic_load_acquire_u64(&controlData.nextFreeItemIndex);
     }
 
     uint64_t SharedCompactRingBuffer::GetMaxItemNum()const
@@ -1045,6 +1502,36 @@ namespace tvushm
         return controlData.maxItemIndex;
     }
 
+    size_t SharedCompactRingBuffer::_getPayloadAlignment()const
+    {
+        const byte*smBytes=_sm.GetBytes();
+        if (smBytes==NULL)
+        {
+            return sizeof(uint64);
+        }
+
+        const SharedCompactRingBufferImpl::MaximumControlData&controlData=
+            *reinterpret_cast<const SharedCompactRingBufferImpl::MaximumControlData*>(smBytes);
+
+        if (controlData.controlDataSize<sizeof(SharedCompactRingBufferImpl::ControlDataV2))
+        {
+            return sizeof(uint64);
+        }
+
+        uint64 alignment=controlData.payloadAlignment;
+        if (alignment<sizeof(uint64) || alignment>MaxPayloadAlignment || (alignment&(alignment-1))!=0)
+        {
+            //created before the field, or dirty data;
+            return sizeof(uint64);
+        }
+        return (size_t)alignment;
+    }
+
+    size_t SharedCompactRingBuffer::GetPayloadAlignment()const
+    {
+        return _getPayloadAlignment();
+    }
+
     uint64_t SharedCompactRingBuffer::GetReadIndex(void) const
     {
         if (_nextReadingIndex==-1)
@@ -1191,6 +1678,8 @@ namespace tvushm
             return false;
         }
 
+        _refreshHeartbeats();
+
         SharedCompactRingBufferImpl::MinimumControlData&controlData=
             *reinterpret_cast<SharedCompactRingBufferImpl::MinimumControlData*>(smBytes);
 
@@ -1209,9 +1698,9 @@ namespace tvushm
             return false;
         }
 
-        uint64 itemIndexChecksum=controlData.itemIndexChecksum;
-        uint64 lastFilledItemIndex=controlData.lastFilledItemIndex;
-        uint64 nextFreeItemIndex=controlData.nextFreeItemIndex;
+        uint64 nextFreeItemIndex=_libshm_atomic_load_acquire_u64(&controlData.nextFreeItemIndex);
+        uint64 lastFilledItemIndex=_libshm_atomic_load_acquire_u64(&controlData.lastFilledItemIndex);
+        uint64 itemIndexChecksum=_libshm_atomic_load_acquire_u64(&controlData.itemIndexChecksum);
 
         if (nextFreeItemIndex==0 && lastFilledItemIndex==0)
         {
@@ -1272,6 +1761,548 @@ namespace tvushm
         return true;
     }
 
+    bool SharedCompactRingBuffer::IsWriteable(size_t size)
+    {
+        return IsWriteable(size,1);
+    }
+
+    bool SharedCompactRingBuffer::IsWriteable(size_t size,size_t itemsNum)
+    {
+        if (!IsLossless())
+        {
+            return true;
+        }
+
+        byte*smBytes=_sm.GetBytes();
+        SharedCompactRingBufferImpl::MaximumControlData&controlData=
+            *reinterpret_cast<SharedCompactRingBufferImpl::MaximumControlData*>(smBytes);
+
+        //same placement as Apply;
+        uint64 freeItemPayloadOffset=_placeFreeOffset();
+        uint64 now=_libshm_get_sys_ms64();
+
+        for (int i=0;i<SharedCompactRingBufferImpl::MaxReaderCursors;i++)
+        {
+            uint64 cursor=_libshm_atomic_load_acquire_u64(&controlData.readerCursors[i]);
+
+            //nothing held, or the reader was lapped before registering, does not block;
+            if (cursor==0 ||
+                !_writeReachesPosition(smBytes,controlData,cursor&0xFFFFFFFF,freeItemPayloadOffset,size,itemsNum))
+            {
+                continue;
+            }
+
+            //only a blocking reader is checked for being gone, its cursor is freed then;
+            if (_isSlotExpired(cursor,_readerHeartbeat(controlData,i),now))
+            {
+                _libshm_atomic_cas_u64(&controlData.readerCursors[i],cursor,0);
+                continue;
+            }
+            return false;
+        }
+
+        if (controlData.controlDataSize<sizeof(SharedCompactRingBufferImpl::ControlDataV3))
+        {
+            return true;
+        }
+
+        for (int i=0;i<SharedCompactRingBufferImpl::MaxLeases;i++)
+        {
+            uint64 lease=_libshm_atomic_load_acquire_u64(&controlData.leases[i]);
+            if (lease==0 || (lease&SharedCompactRingBufferImpl::LeaseBrokenBit) ||
+                !_writeReachesPosition(smBytes,controlData,lease&SharedCompactRingBufferImpl::LeasePositionMask,
+                    freeItemPayloadOffset,size,itemsNum))
+            {
+                continue;
+            }
+
+            //only a blocking lease is checked for its owner being gone, it is freed then;
+            if (_isSlotExpired(lease,_leaseHeartbeat(controlData,i),now))
+            {
+                _libshm_atomic_cas_u64(&controlData.leases[i],lease,0);
+                continue;
+            }
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     *  lossy writer, marks the leases the next write reaches as broken.
+     *  the applying range is published before the leases are checked, a reader
+     *  acquiring a lease at the same time checks it after publishing the lease,
+     *  so one of both sides sees the other.
+     */
+    void SharedCompactRingBuffer::_breakReachedLeases(size_t size,size_t itemsNum)
+    {
+        byte*smBytes=_sm.GetBytes();
+        SharedCompactRingBufferImpl::MaximumControlData&controlData=
+            *reinterpret_cast<SharedCompactRingBufferImpl::MaximumControlData*>(smBytes);
+
+        if (controlData.controlDataSize<sizeof(SharedCompactRingBufferImpl::ControlDataV3))
+        {
+            return;
+        }
+
+        _libshm_atomic_store_relaxed_u64(&controlData.applyingItemsNum,itemsNum);
+        _libshm_atomic_store_release_u64(&controlData.applyingSize,size);
+        _fullFence();
+
+        uint64 freeItemPayloadOffset=_placeFreeOffset();
+        uint64 now=_libshm_get_sys_ms64();
+        for (int i=0;i<SharedCompactRingBufferImpl::MaxLeases;i++)
+        {
+            uint64 lease=_libshm_atomic_load_acquire_u64(&controlData.leases[i]);
+            if (lease==0 || (lease&SharedCompactRingBufferImpl::LeaseBrokenBit) ||
+                !_writeReachesPosition(smBytes,controlData,lease&SharedCompactRingBufferImpl::LeasePositionMask,
+                    freeItemPayloadOffset,size,itemsNum))
+            {
+                continue;
+            }
+
+            //only a reached lease is checked for its owner being gone, it is freed instead of broken then;
+            if (_isSlotExpired(lease,_leaseHeartbeat(controlData,i),now))
+            {
+                _libshm_atomic_cas_u64(&controlData.leases[i],lease,0);
+                continue;
+            }
+            _libshm_atomic_cas_u64(&controlData.leases[i],lease,lease|SharedCompactRingBufferImpl::LeaseBrokenBit);
+        }
+    }
+
+    //the free payload offset the next Apply starts from, before the wrapping check;
+    uint64_t SharedCompactRingBuffer::_placeFreeOffset()const
+    {
+        const SharedCompactRingBufferImpl::MaximumControlData&controlData=
+            *reinterpret_cast<const SharedCompactRingBufferImpl::MaximumControlData*>(_sm.GetBytes());
+
+        uint64 freeItemPayloadOffset=controlData.nextFreeItemPayloadOffset;
+        if (freeItemPayloadOffset<controlData.payloadDataOffset)
+        {
+            freeItemPayloadOffset=controlData.payloadDataOffset;
+        }
+
+        size_t alignment=_getPayloadAlignment();
+        if ((freeItemPayloadOffset % alignment)!=0)
+        {
+            freeItemPayloadOffset+=alignment-(freeItemPayloadOffset % alignment);
+        }
+        return freeItemPayloadOffset;
+    }
+
+    bool SharedCompactRingBuffer::HasLeases()const
+    {
+        const byte*smBytes=_sm.GetBytes();
+        if (smBytes==NULL)
+        {
+            return false;
+        }
+
+        const SharedCompactRingBufferImpl::MinimumControlData&controlData=
+            *reinterpret_cast<const SharedCompactRingBufferImpl::MinimumControlData*>(smBytes);
+        return controlData.controlDataSize>=sizeof(SharedCompactRingBufferImpl::ControlDataV3);
+    }
+
+    int SharedCompactRingBuffer::AcquireLease(uint64_t position)
+    {
+        byte*smBytes=_sm.GetBytes();
+        if (smBytes==NULL || _sm.IsReadOnly())
+        {
+            return LeaseNoSlot;
+        }
+
+        SharedCompactRingBufferImpl::MaximumControlData&controlData=
+            *reinterpret_cast<SharedCompactRingBufferImpl::MaximumControlData*>(smBytes);
+
+        if (controlData.controlDataSize<sizeof(SharedCompactRingBufferImpl::ControlDataV3)
+            || position>=controlData.maxItemIndex)
+        {
+            return LeaseNoSlot;
+        }
+
+        uint64 entry=((uint64)_currentProcessId()<<32)|(position&SharedCompactRingBufferImpl::LeasePositionMask);
+        uint64 now=_libshm_get_sys_ms64();
+        int slot=-1;
+        //takes a free slot first, only when all are taken a slot of a gone owner is reclaimed;
+        for (int pass=0;pass<2 && slot<0;pass++)
+        {
+            for (int i=0;i<SharedCompactRingBufferImpl::MaxLeases && slot<0;i++)
+            {
+                uint64 lease=_libshm_atomic_load_acquire_u64(&controlData.leases[i]);
+                uint64*heartbeat=_leaseHeartbeat(controlData,i);
+                if (lease!=0 && (pass==0 || !_isSlotExpired(lease,heartbeat,now)))
+                {
+                    continue;
+                }
+
+                //the heartbeat goes first, the new entry must not look silent to the writer;
+                if (heartbeat!=NULL)
+                {
+                    _libshm_atomic_store_release_u64(heartbeat,now);
+                }
+                if (_libshm_atomic_cas_u64(&controlData.leases[i],lease,entry))
+                {
+                    slot=i;
+                }
+            }
+        }
+
+        if (slot<0)
+        {
+            TVU_TAGGED_HEARTBEAT_WARN(
+                        "virsmw",1,Log::GetDefaultLog(),
+                        Formatter("shm leases were full. ")
+                        <<"leases:"<<(int)SharedCompactRingBufferImpl::MaxLeases
+                        );
+            return LeaseNoSlot;
+        }
+
+        //pairs with the fence of _breakReachedLeases;
+        _fullFence();
+
+        uint64 nextFreeItemIndex=_libshm_atomic_load_acquire_u64(&controlData.nextFreeItemIndex);
+        uint64 held=(nextFreeItemIndex+controlData.maxItemIndex-position)%controlData.maxItemIndex;
+        bool gone=(held==0 || held>controlData.maxItemsNum);
+
+        uint64 applyingSize=_libshm_atomic_load_acquire_u64(&controlData.applyingSize);
+        if (!gone && applyingSize!=0)
+        {
+            size_t applyingItemsNum=(size_t)_libshm_atomic_load_relaxed_u64(&controlData.applyingItemsNum);
+            gone=_writeReachesPosition(smBytes,controlData,position,_placeFreeOffset(),(size_t)applyingSize,applyingItemsNum);
+        }
+
+        if (gone)
+        {
+            _libshm_atomic_cas_u64(&controlData.leases[slot],entry,0);
+            return LeaseGone;
+        }
+
+        _leasesHeld|=(1u<<slot);
+        _leaseEntries[slot]=entry;
+        return slot;
+    }
+
+    int SharedCompactRingBuffer::CheckLease(int lease)const
+    {
+        if (lease<0 || lease>=SharedCompactRingBufferImpl::MaxLeases || !(_leasesHeld&(1u<<lease)))
+        {
+            return LeaseInvalid;
+        }
+
+        const SharedCompactRingBufferImpl::MaximumControlData&controlData=
+            *reinterpret_cast<const SharedCompactRingBufferImpl::MaximumControlData*>(_sm.GetBytes());
+        uint64 entry=_libshm_atomic_load_acquire_u64(&controlData.leases[lease]);
+        //a lease silent too long was taken back, its item may be overwritten as well;
+        if ((entry&~(uint64)SharedCompactRingBufferImpl::LeaseBrokenBit)!=_leaseEntries[lease])
+        {
+            return LeaseBroken;
+        }
+        return (entry&SharedCompactRingBufferImpl::LeaseBrokenBit)?LeaseBroken:LeaseIntact;
+    }
+
+    int SharedCompactRingBuffer::ReleaseLease(int lease)
+    {
+        int state=CheckLease(lease);
+        if (state==LeaseInvalid)
+        {
+            return state;
+        }
+
+        SharedCompactRingBufferImpl::MaximumControlData&controlData=
+            *reinterpret_cast<SharedCompactRingBufferImpl::MaximumControlData*>(_sm.GetBytes());
+        //only freed while still owned, a slot taken back could be another reader's by now;
+        uint64 entry=_leaseEntries[lease];
+        if (!_libshm_atomic_cas_u64(&controlData.leases[lease],entry,0))
+        {
+            _libshm_atomic_cas_u64(&controlData.leases[lease],entry|SharedCompactRingBufferImpl::LeaseBrokenBit,0);
+        }
+        _leasesHeld&=~(1u<<lease);
+        _leaseEntries[lease]=0;
+        _wakeWriter();
+        return state;
+    }
+
+    void SharedCompactRingBuffer::_releaseLeases()
+    {
+        for (int i=0;_leasesHeld!=0 && i<SharedCompactRingBufferImpl::MaxLeases;i++)
+        {
+            if (_leasesHeld&(1u<<i))
+            {
+                ReleaseLease(i);
+            }
+        }
+        _leasesHeld=0;
+    }
+
+    bool SharedCompactRingBuffer::SetLossless(bool lossless)
+    {
+        byte*smBytes=_sm.GetBytes();
+        if (smBytes==NULL)
+        {
+            return false;
+        }
+
+        SharedCompactRingBufferImpl::MaximumControlData&controlData=
+            *reinterpret_cast<SharedCompactRingBufferImpl::MaximumControlData*>(smBytes);
+
+        if (controlData.controlDataSize<sizeof(SharedCompactRingBufferImpl::ControlDataV2))
+        {
+            //old control data has no reader cursors;
+            return !lossless;
+        }
+
+        controlData.losslessFlag=lossless?1:0;
+        return true;
+    }
+
+    bool SharedCompactRingBuffer::IsLossless()const
+    {
+        const byte*smBytes=_sm.GetBytes();
+        if (smBytes==NULL)
+        {
+            return false;
+        }
+
+        const SharedCompactRingBufferImpl::MaximumControlData&controlData=
+            *reinterpret_cast<const SharedCompactRingBufferImpl::MaximumControlData*>(smBytes);
+
+        if (controlData.controlDataSize<sizeof(SharedCompactRingBufferImpl::ControlDataV2))
+        {
+            return false;
+        }
+
+        return controlData.losslessFlag!=0;
+    }
+
+    bool SharedCompactRingBuffer::RegisterReader()
+    {
+        if (_readerCursor>=0)
+        {
+            return true;
+        }
+
+        if (!IsLossless() || _sm.IsReadOnly())
+        {
+            return false;
+        }
+
+        SharedCompactRingBufferImpl::MaximumControlData&controlData=
+            *reinterpret_cast<SharedCompactRingBufferImpl::MaximumControlData*>(_sm.GetBytes());
+        uint64 entry=_readerCursorEntryOf(_nextReadingIndex);
+        uint64 now=_libshm_get_sys_ms64();
+
+        for (int i=0;i<SharedCompactRingBufferImpl::MaxReaderCursors;i++)
+        {
+            uint64 cursor=_libshm_atomic_load_acquire_u64(&controlData.readerCursors[i]);
+            uint64*heartbeat=_readerHeartbeat(controlData,i);
+            if (cursor!=0 && !_isSlotExpired(cursor,heartbeat,now))
+            {
+                continue;
+            }
+
+            //the heartbeat goes first, the new cursor must not look silent to the writer;
+            if (heartbeat!=NULL)
+            {
+                _libshm_atomic_store_release_u64(heartbeat,now);
+            }
+            if (_libshm_atomic_cas_u64(&controlData.readerCursors[i],cursor,entry))
+            {
+                _readerCursor=i;
+                _readerCursorEntry=entry;
+                _wakeWriter();
+                return true;
+            }
+        }
+
+        TVU_TAGGED_HEARTBEAT_WARN(
+                    "virsmw",1,Log::GetDefaultLog(),
+                    Formatter("lossless reader cursors were full. ")
+                    <<"cursors:"<<(int)SharedCompactRingBufferImpl::MaxReaderCursors
+                    );
+        return false;
+    }
+
+    uint64_t SharedCompactRingBuffer::_readerCursorEntryOf(uint64_t position)const
+    {
+        const SharedCompactRingBufferImpl::MaximumControlData&controlData=
+            *reinterpret_cast<const SharedCompactRingBufferImpl::MaximumControlData*>(_sm.GetBytes());
+
+        if (position>=controlData.maxItemIndex)
+        {
+            //the reader starts from the last filled item;
+            position=_libshm_atomic_load_acquire_u64(&controlData.lastFilledItemIndex);
+        }
+        return ((uint64)_currentProcessId()<<32)|(position&0xFFFFFFFF);
+    }
+
+    void SharedCompactRingBuffer::_publishReaderCursor(uint64_t position)
+    {
+        if (_readerCursor<0)
+        {
+            return;
+        }
+
+        byte*smBytes=_sm.GetBytes();
+        if (smBytes==NULL)
+        {
+            return;
+        }
+
+        SharedCompactRingBufferImpl::MaximumControlData&controlData=
+            *reinterpret_cast<SharedCompactRingBufferImpl::MaximumControlData*>(smBytes);
+        uint64 entry=_readerCursorEntryOf(position);
+
+        //the cursor is only moved while still owned, a cursor silent too long could have been taken back;
+        //release, the writer may reuse the items before position at once;
+        if (!_libshm_atomic_cas_u64(&controlData.readerCursors[_readerCursor],_readerCursorEntry,entry))
+        {
+            _loseReaderCursor();
+            return;
+        }
+        _readerCursorEntry=entry;
+
+        uint64*heartbeat=_readerHeartbeat(controlData,_readerCursor);
+        if (heartbeat!=NULL)
+        {
+            _libshm_atomic_store_relaxed_u64(heartbeat,_libshm_get_sys_ms64());
+        }
+        _wakeWriter();
+    }
+
+    void SharedCompactRingBuffer::_releaseReaderCursor()
+    {
+        if (_readerCursor<0)
+        {
+            return;
+        }
+
+        byte*smBytes=_sm.GetBytes();
+        if (smBytes!=NULL)
+        {
+            SharedCompactRingBufferImpl::MaximumControlData&controlData=
+                *reinterpret_cast<SharedCompactRingBufferImpl::MaximumControlData*>(smBytes);
+            _libshm_atomic_cas_u64(&controlData.readerCursors[_readerCursor],_readerCursorEntry,0);
+            _wakeWriter();
+        }
+        _readerCursor=-1;
+        _readerCursorEntry=0;
+        _readerEvicted=false;
+    }
+
+    //the cursor was taken back, the writer may have overwritten the items after it unread;
+    void SharedCompactRingBuffer::_loseReaderCursor()
+    {
+        TVU_TAGGED_HEARTBEAT_WARN(
+                    "virsmw",1,Log::GetDefaultLog(),
+                    Formatter("lossless reader cursor was taken back. ")
+                    <<"cursor:"<<_readerCursor
+                    <<",read index:"<<_nextReadingIndex
+                    );
+        _readerCursor=-1;
+        _readerCursorEntry=0;
+        _readerEvicted=IsLossless();
+        RegisterReader();
+    }
+
+    bool SharedCompactRingBuffer::CheckReaderEvicted()
+    {
+        bool evicted=_readerEvicted;
+        _readerEvicted=false;
+        return evicted;
+    }
+
+    //the reader shows it is alive while polling as well, its cursor and leases do not expire then;
+    void SharedCompactRingBuffer::_refreshHeartbeats()
+    {
+        if (_readerCursor<0 && _leasesHeld==0)
+        {
+            return;
+        }
+
+        SharedCompactRingBufferImpl::MaximumControlData&controlData=
+            *reinterpret_cast<SharedCompactRingBufferImpl::MaximumControlData*>(_sm.GetBytes());
+
+        if (_readerCursor>=0
+            && _libshm_atomic_load_acquire_u64(&controlData.readerCursors[_readerCursor])!=_readerCursorEntry)
+        {
+            _loseReaderCursor();
+        }
+
+        if (controlData.controlDataSize<sizeof(SharedCompactRingBufferImpl::ControlDataV5))
+        {
+            return;
+        }
+
+        uint64 now=_libshm_get_sys_ms64();
+        if (_readerCursor>=0)
+        {
+            _libshm_atomic_store_relaxed_u64(&controlData.readerHeartbeats[_readerCursor],now);
+        }
+        for (int i=0;_leasesHeld!=0 && i<SharedCompactRingBufferImpl::MaxLeases;i++)
+        {
+            if ((_leasesHeld&(1u<<i))
+                && (_libshm_atomic_load_acquire_u64(&controlData.leases[i])&~(uint64)SharedCompactRingBufferImpl::LeaseBrokenBit)==_leaseEntries[i])
+            {
+                _libshm_atomic_store_relaxed_u64(&controlData.leaseHeartbeats[i],now);
+            }
+        }
+    }
+
+    uint32_t* SharedCompactRingBuffer::_releaseWord()
+    {
+#if defined(TVU_LINUX)
+        byte*smBytes=_sm.GetBytes();
+        if (smBytes==NULL)
+        {
+            return NULL;
+        }
+
+        SharedCompactRingBufferImpl::MaximumControlData&controlData=
+            *reinterpret_cast<SharedCompactRingBufferImpl::MaximumControlData*>(smBytes);
+        if (controlData.controlDataSize>=sizeof(SharedCompactRingBufferImpl::ControlDataV4))
+        {
+            return &controlData.releaseWord;
+        }
+#endif
+        return NULL;
+    }
+
+    //a reader released items, the writer is only woken when it sleeps on the word;
+    void SharedCompactRingBuffer::_wakeWriter()
+    {
+        uint32_t*word=_releaseWord();
+        if (word!=NULL)
+        {
+            _libshm_wait_word_wake_armed(word);
+        }
+    }
+
+    bool SharedCompactRingBuffer::WaitWriteable(size_t size,size_t itemsNum,unsigned int timeoutMs)
+    {
+        uint32_t*word=_releaseWord();
+        if (word==NULL)
+        {
+            return false;
+        }
+
+        timeoutMs=std::min(timeoutMs,(unsigned int)SharedCompactRingBufferImpl::ReleaseWaitMaxMs);
+
+        uint32_t seq=_libshm_wait_word_load(word);
+        uint32_t sleepval=0;
+        if (IsWriteable(size,itemsNum) || !_libshm_wait_word_arm(word,seq,&sleepval))
+        {
+            return true;
+        }
+
+        //a reader released after the first check, but saw no waiters bit;
+        if (!IsWriteable(size,itemsNum))
+        {
+            _libshm_wait_word_sleep(word,sleepval,timeoutMs);
+        }
+        return true;
+    }
+
     bool SharedCompactRingBuffer::GetInfo(
         uint64_t* fixedUserDataSizePtr,uint64_t* payloadBufferSizePtr,uint64_t* maxItemsNumPtr)
     {
@@ -25,7 +25,9 @@ History: Tony Guo on Feb 11, 2014: Created
 #undef Log
 #endif
 
+#include <stdint.h>
 #include <string>
+#include "libshm_log_internal.h"
 
 #define TVU_MAX_CACHED_LOG_LINES_NUM                    (100*1000)
 
@@ -71,12 +73,28 @@ namespace tvushm
         void VerboseLog(Level level,const std::string& message);
 
     protected:
-        static DumpLogCallback  _dumpLogCallback;
+        static uint64_t         _dumpLogCallback;   // DumpLogCallback, atomic.
         static std::string      _logTag;
+        static uint32_t         _async;             // atomic.
         static int LevelMapInteger(Level val);
     public:
         static void SetLogCallback(DumpLogCallback cb);
         static void SetLogTag(const char *tag);
+        /**
+         *  async, the default, posts the messages to the LogSink, its thread calls
+         *  the callback. sync calls it in the logging thread.
+         */
+        static void SetAsync(bool bAsync);
+        /* hands the messages posted to the callback now, return the count. */
+        static int Flush(void);
+        /**
+         *  hands the messages posted to the callback, then runs @fn while no message
+         *  is being handed to it, so a state of the callback @fn swaps is not used
+         *  by the drainer after it returns.
+         */
+        static void Synchronize(void (*fn)(void *opaq), void *opaq);
+        /* messages dropped for the sink full. */
+        static uint64_t GetDroppedCount(void);
     protected:
         void LogMessage(Level level,const char*tag,const char*message);
         void LogMessage(Level level,const char*message);
@@ -121,24 +139,23 @@ namespace tvushm
 #define TVU_LOG_RAW(log,message) TVU_LOG(log,tvu::tvushm::RawLevel,message)
 
 
+/**
+ *  prints the first @maxIntervalCount logs of the site in each @seconds, the
+ *  site is counted as the ones of libsharememory, see libshm_log_internal.h.
+ */
 #define _TVU_TAGGED_HEARTBEAT_MULTIPLE_LOG(tagName,seconds,maxIntervalCount,logName,level,message) \
     do \
     {\
-        tvushm::uint64 _tvu_now; \
-        tvushm::TimeUtils::GetCurrentTimeInUsec(&_tvu_now);\
-        bool boutLog = false; \
-        static tvushm::uint64 _tvu_lastTime_##__LINE__ = 0;\
-        static tvushm::uint64 _tvu_counts_##__LINE__ = 0;\
-        if (_tvu_now>=_tvu_lastTime_##__LINE__+TVU_SEC2USEC(seconds)) { \
-            boutLog = true; _tvu_lastTime_##__LINE__=_tvu_now; _tvu_counts_##__LINE__ = 0;\
-        }  else {\
-            if (_tvu_counts_##__LINE__ < maxIntervalCount) {\
-                boutLog = true;\
-            }\
+        if (!(logName).IsLevelEnabled(level)) { \
+            break; \
         } \
-        if (boutLog) {\
-            TVU_LOG(logName,level,message);\
-            _tvu_counts_##__LINE__++;\
+        static libshm_log_site_t _tvu_site; \
+        uint32_t _tvu_count_copy = 0; \
+        uint64_t _tvu_interval = 0; \
+        bool b_internal_time_out = false; \
+        if (_libshm_log_site_hit(&_tvu_site, _libshm_get_sys_ms64_coarse(), seconds, maxIntervalCount \
+            , &_tvu_count_copy, &_tvu_interval, &b_internal_time_out)) {\
+            TVU_DIRECT_LOG(logName,level,message);\
         } \
     } while (0)
 
@@ -0,0 +1,87 @@
+/*********************************************************
+ *  Copyright 2025 TVU Networks
+ *  Licensed under the Apache License, Version 2.0 (the “License”);
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an “AS IS” BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *********************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace tvushm
+{
+    /**
+     *  the asynchronous sink of Log. any thread posts a preformatted record into
+     *  a bounded lock-free queue, one drainer thread hands them to the callback.
+     *  a post never blocks, takes no lock and allocates nothing, a record finding
+     *  the queue full is dropped and counted, the media paths never wait for the
+     *  callback.
+     */
+    class LogSink
+    {
+    public:
+        typedef int (*Callback)(int level, const char *message, ...);
+
+        enum
+        {
+            RecordSize      = 1024,     // bytes of a record, a longer text is cut.
+            QueueRecords    = 256,      // records queued, a power of 2.
+        };
+
+    public:
+        LogSink(void);
+        /* stops the drainer, the records left are drained. */
+        ~LogSink(void);
+
+        static LogSink &GetDefaultSink();
+
+        /* the callback of the records drained, NULL drops them. */
+        void SetCallback(Callback cb);
+        /* starts the drainer thread, once. */
+        void Start(void);
+
+        /* "T[tag]-message" queued as a record of @level, false when dropped. */
+        bool Post(int level, const char *tag, const char *message);
+        /* hands the records posted to the callback in the calling thread, return the count. */
+        int Drain(void);
+        /* drains, then runs @fn with no record being handed to the callback. */
+        void Synchronize(void (*fn)(void *opaq), void *opaq);
+        /* records dropped for the queue full. */
+        uint64_t GetDroppedCount(void);
+
+    private:
+        typedef struct Record
+        {
+            uint64_t    seq;        // the position it is free for, +1 when filled.
+            int         level;
+            char        text[RecordSize];
+        } Record_t;
+
+        LogSink(const LogSink &);
+        LogSink &operator=(const LogSink &);
+
+        void _run(void);
+        int _drain(void);           // under _drainLock.
+
+        Record_t                *_records;
+        uint64_t                _enqueuePos;
+        uint64_t                _dequeuePos;   // under _drainLock.
+        uint64_t                _callback;
+        uint32_t                _dropped;
+        bool                    _stop;
+        std::mutex              _drainLock;
+        std::mutex              _stateLock;
+        std::condition_variable _stateCond;
+        std::thread             _drainer;
+    };
+}
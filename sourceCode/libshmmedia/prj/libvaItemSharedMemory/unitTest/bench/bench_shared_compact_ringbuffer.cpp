@@ -0,0 +1,83 @@
+// Benchmarks of SharedCompactRingBuffer, built into the opt-in unitTestBench binary
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#if defined(TVU_LINUX)
+#include <unistd.h>
+#endif
+
+#include "TvuShmSharedCompactRingBuffer.h"
+
+using namespace tvushm;
+
+static std::string make_shm_name()
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "/gtest_va_%d_%u", (int)getpid(), (unsigned)rand());
+    return std::string(buf);
+}
+
+#if defined(TVU_LINUX)
+// every Apply of itemSize wraps, return the median Apply time in ns and fill the histogram
+static double apply_wrap_latency(uint64_t payloadSize, size_t itemSize, int rounds, int hist[6])
+{
+    std::string name = make_shm_name();
+    SharedCompactRingBuffer w;
+    if (!w.Create(name.c_str(), 128, payloadSize, 8))
+    {
+        return -1;
+    }
+    w.Prefault(true);
+
+    std::vector<double> ns;
+    for (int i = 0; i < rounds; i++)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        void *dest = w.Apply(itemSize);
+        auto t1 = std::chrono::steady_clock::now();
+        if (!dest || !w.Commit(dest, itemSize))
+        {
+            w.Destroy();
+            return -1;
+        }
+
+        double d = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        ns.push_back(d);
+        // buckets: <1us, <10us, <100us, <1ms, <10ms, >=10ms
+        int b = 0;
+        for (double edge = 1000; b < 5 && d >= edge; edge *= 10)
+        {
+            b++;
+        }
+        hist[b]++;
+    }
+    w.Destroy();
+
+    std::sort(ns.begin(), ns.end());
+    return ns[ns.size() / 2];
+}
+
+TEST(SharedCompactRingBuffer, Benchmark_ApplyWrapLatencyIndependentOfTail)
+{
+    const uint64_t kPayload = 64 * 1024 * 1024;
+    const int kRounds = 40;
+    int smallHist[6] = {0};
+    int largeHist[6] = {0};
+
+    // items just under the payload leave a 64 KiB tail on every wrap, items just
+    // over half of it leave a 32 MiB tail.
+    double smallTail = apply_wrap_latency(kPayload, kPayload - 64 * 1024, kRounds, smallHist);
+    double largeTail = apply_wrap_latency(kPayload, kPayload / 2 + 64, kRounds, largeHist);
+    ASSERT_GT(smallTail, 0);
+    ASSERT_GT(largeTail, 0);
+
+    printf("[ BENCH    ] apply on wrap, median: 64K tail %.0f ns, 32M tail %.0f ns\n", smallTail, largeTail);
+    printf("[ BENCH    ] <1us/<10us/<100us/<1ms/<10ms/>=10ms 64K tail: %d/%d/%d/%d/%d/%d, 32M tail: %d/%d/%d/%d/%d/%d\n"
+           , smallHist[0], smallHist[1], smallHist[2], smallHist[3], smallHist[4], smallHist[5]
+           , largeHist[0], largeHist[1], largeHist[2], largeHist[3], largeHist[4], largeHist[5]);
+}
+#endif
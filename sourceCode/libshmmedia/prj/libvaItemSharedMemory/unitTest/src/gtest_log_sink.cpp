@@ -0,0 +1,148 @@
+// Unit tests for the asynchronous log sink
+#include <gtest/gtest.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TvuLogSink.h"
+
+using namespace tvushm;
+
+static std::mutex               g_sinkLock;
+static std::vector<std::string> g_sinkRecords;
+
+static int collect_record(int level, const char *fmt, ...)
+{
+    char text[LogSink::RecordSize + 16];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+
+    std::lock_guard<std::mutex> lock(g_sinkLock);
+    g_sinkRecords.push_back(std::string(1, (char)level) + text);
+    return 0;
+}
+
+static size_t collected_records()
+{
+    std::lock_guard<std::mutex> lock(g_sinkLock);
+    return g_sinkRecords.size();
+}
+
+TEST(LogSink, DropsWhenFullAndDrainsInOrder) {
+    LogSink sink;
+    g_sinkRecords.clear();
+    sink.SetCallback(collect_record);
+
+    const int extra = 10;
+    for (int i = 0; i < LogSink::QueueRecords + extra; i++)
+    {
+        char msg[32];
+        snprintf(msg, sizeof(msg), "m%d\n", i);
+        EXPECT_EQ(i < LogSink::QueueRecords, sink.Post('w', i & 1 ? "tag" : NULL, msg));
+    }
+    EXPECT_EQ((uint64_t)extra, sink.GetDroppedCount());
+
+    EXPECT_EQ(LogSink::QueueRecords, sink.Drain());
+    EXPECT_EQ(0, sink.Drain());
+    ASSERT_EQ((size_t)LogSink::QueueRecords, g_sinkRecords.size());
+    EXPECT_EQ("wm0\n", g_sinkRecords[0]);
+    EXPECT_EQ("wT[tag]-m1\n", g_sinkRecords[1]);
+    EXPECT_EQ("wT[tag]-m255\n", g_sinkRecords[255]);
+
+    /* the records drained are free again. */
+    EXPECT_TRUE(sink.Post('e', NULL, "again\n"));
+    EXPECT_EQ(1, sink.Drain());
+    EXPECT_EQ("eagain\n", g_sinkRecords.back());
+}
+
+TEST(LogSink, LongMessageIsCutWithNewline) {
+    LogSink sink;
+    g_sinkRecords.clear();
+    sink.SetCallback(collect_record);
+
+    std::string msg(LogSink::RecordSize * 2, 'x');
+    EXPECT_TRUE(sink.Post('i', NULL, msg.c_str()));
+    EXPECT_EQ(1, sink.Drain());
+    ASSERT_EQ(1u, g_sinkRecords.size());
+    EXPECT_EQ((size_t)LogSink::RecordSize, g_sinkRecords[0].size());
+    EXPECT_EQ('\n', g_sinkRecords[0].back());
+}
+
+TEST(LogSink, ProducersDrainedByTheThread) {
+    const int producers = 4;
+    const int records = 2000;
+    g_sinkRecords.clear();
+
+    {
+        LogSink sink;
+        sink.SetCallback(collect_record);
+        sink.Start();
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < producers; t++)
+        {
+            workers.push_back(std::thread([t, records, &sink]() {
+                for (int i = 0; i < records; i++)
+                {
+                    char msg[32];
+                    snprintf(msg, sizeof(msg), "%d:%d", t, i);
+                    sink.Post('i', NULL, msg);
+                }
+            }));
+        }
+        for (size_t t = 0; t < workers.size(); t++)
+        {
+            workers[t].join();
+        }
+
+        /* the sink drains the rest when it is destroyed. */
+        uint64_t dropped = sink.GetDroppedCount();
+        for (int i = 0; i < 200 && collected_records() + dropped < (size_t)(producers * records); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        EXPECT_EQ((size_t)(producers * records), collected_records() + dropped);
+    }
+
+    /* each producer's records come out in the order posted. */
+    std::vector<int> last(producers, -1);
+    for (size_t n = 0; n < g_sinkRecords.size(); n++)
+    {
+        int t = -1;
+        int i = -1;
+        ASSERT_EQ(2, sscanf(g_sinkRecords[n].c_str() + 1, "%d:%d", &t, &i));
+        ASSERT_GE(t, 0);
+        ASSERT_LT(t, producers);
+        EXPECT_GT(i, last[t]);
+        last[t] = i;
+    }
+}
+
+static void count_synchronized(void *opaq)
+{
+    /* the records posted before were all handed over. */
+    *(size_t *)opaq = collected_records();
+}
+
+TEST(LogSink, SynchronizeRunsAfterTheDrain) {
+    LogSink sink;
+    g_sinkRecords.clear();
+    sink.SetCallback(collect_record);
+    sink.Start();
+
+    for (int i = 0; i < 16; i++)
+    {
+        sink.Post('i', NULL, "m");
+    }
+    size_t seen = 0;
+    sink.Synchronize(count_synchronized, &seen);
+    EXPECT_EQ(16u, seen);
+}
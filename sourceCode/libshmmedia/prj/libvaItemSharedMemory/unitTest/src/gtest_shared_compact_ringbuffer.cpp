@@ -2,8 +2,20 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#if defined(TVU_LINUX)
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#endif
 
 #include "TvuShmSharedCompactRingBuffer.h"
+#include "gtest_stress_item.h"
 
 using namespace tvushm;
 
@@ -44,3 +56,372 @@ TEST(SharedCompactRingBuffer, CreateWriteReadDestroy)
     r.Close();
     r.Destroy();
 }
+
+TEST(SharedCompactRingBuffer, LosslessWriterWaitsForReader)
+{
+    std::string name = make_shm_name();
+    SharedCompactRingBuffer w;
+    ASSERT_TRUE(w.Create(name.c_str(), 128, 4096, 8, S_IRUSR | S_IWUSR, false, 0, true));
+    EXPECT_TRUE(w.IsLossless());
+
+    SharedCompactRingBuffer r;
+    ASSERT_TRUE(r.Open(name.c_str()));
+    r.SetReadIndex(r.GetWriteIndex());
+    ASSERT_TRUE(r.RegisterReader());
+
+    // four 1000 bytes items fill the payload, the fifth would wrap onto item 0
+    char item[1000];
+    for (int i = 0; i < 4; i++)
+    {
+        memset(item, 'a' + i, sizeof(item));
+        ASSERT_TRUE(w.Write(item, sizeof(item)));
+    }
+    EXPECT_FALSE(w.IsWriteable(sizeof(item)));
+    EXPECT_FALSE(w.Write(item, sizeof(item)));
+
+    // item 0 is still held while the reader uses it, released by the next read
+    size_t rlen = 0;
+    char *pdata = (char *)r.Read(&rlen);
+    ASSERT_NE(pdata, (char*)NULL);
+    EXPECT_EQ(pdata[0], 'a');
+    EXPECT_FALSE(w.IsWriteable(sizeof(item)));
+    pdata = (char *)r.Read(&rlen);
+    ASSERT_NE(pdata, (char*)NULL);
+    EXPECT_EQ(pdata[0], 'b');
+    EXPECT_TRUE(w.IsWriteable(sizeof(item)));
+
+    memset(item, 'e', sizeof(item));
+    ASSERT_TRUE(w.Write(item, sizeof(item)));
+    for (char c = 'c'; c <= 'e'; c++)
+    {
+        pdata = (char *)r.Read(&rlen);
+        ASSERT_NE(pdata, (char*)NULL);
+        EXPECT_EQ(rlen, sizeof(item));
+        EXPECT_EQ(pdata[0], c);
+        EXPECT_EQ(pdata[sizeof(item) - 1], c);
+    }
+
+    // the closed reader no longer holds anything
+    r.Close();
+    EXPECT_TRUE(w.IsWriteable(sizeof(item)));
+    w.Destroy();
+}
+
+TEST(SharedCompactRingBuffer, LosslessReadBatchHoldsFromFirstItem)
+{
+    std::string name = make_shm_name();
+    SharedCompactRingBuffer w;
+    ASSERT_TRUE(w.Create(name.c_str(), 128, 4096, 8, S_IRUSR | S_IWUSR, false, 0, true));
+
+    SharedCompactRingBuffer r;
+    ASSERT_TRUE(r.Open(name.c_str()));
+    r.SetReadIndex(r.GetWriteIndex());
+    ASSERT_TRUE(r.RegisterReader());
+
+    char item[1000];
+    for (int i = 0; i < 4; i++)
+    {
+        memset(item, 'a' + i, sizeof(item));
+        ASSERT_TRUE(w.Write(item, sizeof(item)));
+    }
+
+    void *buffers[8];
+    size_t sizes[8];
+    ASSERT_EQ(r.ReadBatch(buffers, sizes, 8), (size_t)4);
+    for (int i = 0; i < 4; i++)
+    {
+        EXPECT_EQ(sizes[i], sizeof(item));
+        EXPECT_EQ(((char *)buffers[i])[0], 'a' + i);
+    }
+    EXPECT_EQ(r.ReadBatch(buffers, sizes, 8), (size_t)0);
+
+    // the whole batch is still referenced, item 0 can not be written over
+    EXPECT_FALSE(w.IsWriteable(sizeof(item)));
+    r.Close();
+    EXPECT_TRUE(w.IsWriteable(sizeof(item)));
+    w.Destroy();
+}
+
+TEST(SharedCompactRingBuffer, LosslessWaitWriteableWokenByReader)
+{
+    std::string name = make_shm_name();
+    SharedCompactRingBuffer w;
+    ASSERT_TRUE(w.Create(name.c_str(), 128, 4096, 8, S_IRUSR | S_IWUSR, false, 0, true));
+
+    SharedCompactRingBuffer r;
+    ASSERT_TRUE(r.Open(name.c_str()));
+    r.SetReadIndex(r.GetWriteIndex());
+    ASSERT_TRUE(r.RegisterReader());
+
+    char item[1000];
+    memset(item, 'a', sizeof(item));
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(w.Write(item, sizeof(item)));
+    }
+    ASSERT_FALSE(w.IsWriteable(sizeof(item)));
+
+    std::thread reader([&]() {
+        usleep(20 * 1000);
+        size_t rlen = 0;
+        r.Read(&rlen);
+        r.Read(&rlen);
+    });
+#if defined(TVU_LINUX)
+    // a few bounded waits, the reader wakes the writer instead of the timeout
+    for (int i = 0; i < 100 && !w.IsWriteable(sizeof(item)); i++)
+    {
+        EXPECT_TRUE(w.WaitWriteable(sizeof(item), 1, 10 * 1000));
+    }
+#endif
+    reader.join();
+    EXPECT_TRUE(w.IsWriteable(sizeof(item)));
+
+    r.Close();
+    w.Destroy();
+}
+
+// cursors and leases expire by their heartbeat, a polling reader keeps them
+TEST(SharedCompactRingBuffer, LosslessCursorExpiresByHeartbeat)
+{
+    std::string name = make_shm_name();
+    SharedCompactRingBuffer w;
+    ASSERT_TRUE(w.Create(name.c_str(), 128, 4096, 8, S_IRUSR | S_IWUSR, false, 0, true));
+
+    SharedCompactRingBuffer r;
+    ASSERT_TRUE(r.Open(name.c_str()));
+    r.SetReadIndex(r.GetWriteIndex());
+    ASSERT_TRUE(r.RegisterReader());
+
+    char item[1000];
+    memset(item, 'a', sizeof(item));
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(w.Write(item, sizeof(item)));
+    }
+    size_t rlen = 0;
+    ASSERT_NE(r.Read(&rlen), (void *)NULL);
+    ASSERT_FALSE(w.IsWriteable(sizeof(item)));
+
+    // polling over the 3s expiry keeps the cursor
+    for (int i = 0; i < 35; i++)
+    {
+        r.IsReadable();
+        usleep(100 * 1000);
+    }
+    EXPECT_FALSE(w.IsWriteable(sizeof(item)));
+    EXPECT_FALSE(r.CheckReaderEvicted());
+
+    // silent over it, the writer takes the cursor back and goes on
+    usleep(3500 * 1000);
+    EXPECT_TRUE(w.IsWriteable(sizeof(item)));
+    ASSERT_TRUE(w.Write(item, sizeof(item)));
+
+    // the reader learns it once, and holds the writer again
+    EXPECT_TRUE(r.IsReadable());
+    EXPECT_TRUE(r.CheckReaderEvicted());
+    EXPECT_FALSE(r.CheckReaderEvicted());
+    EXPECT_FALSE(w.IsWriteable(sizeof(item)));
+
+    r.Close();
+    w.Destroy();
+}
+
+TEST(SharedCompactRingBuffer, LosslessLeaseExpiresByHeartbeat)
+{
+    std::string name = make_shm_name();
+    SharedCompactRingBuffer w;
+    ASSERT_TRUE(w.Create(name.c_str(), 128, 4096, 8, S_IRUSR | S_IWUSR, false, 0, true));
+    ASSERT_TRUE(w.HasLeases());
+
+    SharedCompactRingBuffer r;
+    ASSERT_TRUE(r.Open(name.c_str()));
+    r.SetReadIndex(r.GetWriteIndex());
+
+    char item[1000];
+    memset(item, 'a', sizeof(item));
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(w.Write(item, sizeof(item)));
+    }
+    uint64_t position = r.GetReadIndex();
+    int lease = r.AcquireLease(position);
+    ASSERT_GE(lease, 0);
+    EXPECT_FALSE(w.IsWriteable(sizeof(item)));
+
+    // the owner silent over the expiry, the lease does not pin the ring forever
+    usleep(3500 * 1000);
+    EXPECT_TRUE(w.IsWriteable(sizeof(item)));
+    EXPECT_EQ(r.CheckLease(lease), SharedCompactRingBuffer::LeaseBroken);
+    EXPECT_EQ(r.ReleaseLease(lease), SharedCompactRingBuffer::LeaseBroken);
+
+    r.Close();
+    w.Destroy();
+}
+
+TEST(SharedCompactRingBuffer, CreateBoundsMaxItemsNum)
+{
+    std::string name = make_shm_name();
+    SharedCompactRingBuffer w;
+    // the item indices would not fit the 31 bits of the reader cursors
+    EXPECT_FALSE(w.Create(name.c_str(), 128, 4096, (uint64_t)SharedCompactRingBuffer::MaxItemsNum + 1));
+}
+
+TEST(SharedCompactRingBuffer, PayloadAlignmentAppliesToEveryItem)
+{
+    std::string name = make_shm_name();
+    SharedCompactRingBuffer w;
+    EXPECT_FALSE(w.Create(name.c_str(), 128, 64 * 1024, 8, S_IRUSR | S_IWUSR, false, 100));
+    ASSERT_TRUE(w.Create(name.c_str(), 128, 64 * 1024, 8, S_IRUSR | S_IWUSR, false, 4096));
+    EXPECT_EQ(w.GetPayloadAlignment(), (size_t)4096);
+
+    SharedCompactRingBuffer r;
+    ASSERT_TRUE(r.Open(name.c_str()));
+    EXPECT_EQ(r.GetPayloadAlignment(), (size_t)4096);
+    r.SetReadIndex(r.GetWriteIndex());
+
+    // odd sizes over several laps, every item stays page aligned
+    char item[5000];
+    for (int i = 0; i < 40; i++)
+    {
+        size_t len = 1 + (size_t)(i * 977) % sizeof(item);
+        memset(item, 'a' + i % 26, len);
+        void *dest = w.Apply(len);
+        ASSERT_NE(dest, (void*)NULL);
+        EXPECT_EQ(((uintptr_t)dest) % 4096, (uintptr_t)0);
+        memcpy(dest, item, len);
+        ASSERT_TRUE(w.Commit(dest, len));
+
+        size_t rlen = 0;
+        char *pdata = (char *)r.Read(&rlen);
+        ASSERT_NE(pdata, (char*)NULL);
+        EXPECT_EQ(rlen, len);
+        EXPECT_EQ(pdata[len - 1], 'a' + i % 26);
+    }
+
+    r.Close();
+    w.Destroy();
+
+    // the default keeps the machine word alignment
+    ASSERT_TRUE(w.Create(name.c_str(), 128, 4096, 8));
+    EXPECT_EQ(w.GetPayloadAlignment(), sizeof(uint64_t));
+    w.Destroy();
+}
+
+// Apply on a wrap leaves the tail of the payload as it was, it does not zero it
+TEST(SharedCompactRingBuffer, ApplyWrapLeavesTailUntouched)
+{
+    std::string name = make_shm_name();
+    SharedCompactRingBuffer w;
+    ASSERT_TRUE(w.Create(name.c_str(), 128, 4096, 8));
+    size_t payload = (size_t)w.GetPayloadSize();
+
+    // a first item over the whole payload, its bytes are left in the later tail
+    size_t firstLen = payload - 96;
+    char *base = (char *)w.Apply(firstLen);
+    ASSERT_NE(base, (char*)NULL);
+    memset(base, 'd', firstLen);
+    ASSERT_TRUE(w.Commit(base, firstLen));
+
+    // three items of 3/8 of the payload, the first and the third wrap
+    size_t len = payload * 3 / 8;
+    char *dests[3];
+    for (int i = 0; i < 3; i++)
+    {
+        dests[i] = (char *)w.Apply(len);
+        ASSERT_NE(dests[i], (char*)NULL);
+        memset(dests[i], 'a' + i, len);
+        ASSERT_TRUE(w.Commit(dests[i], len));
+    }
+    ASSERT_EQ(dests[0], base);
+    ASSERT_EQ(dests[2], base);
+
+    for (size_t off = (size_t)(dests[1] - base) + len; off < firstLen; off++)
+    {
+        ASSERT_EQ(base[off], 'd') << "offset " << off;
+    }
+    w.Destroy();
+}
+
+#if defined(TVU_LINUX)
+TEST(SharedCompactRingBuffer, TwoProcessWriterReaderStress)
+{
+    const uint64_t kCount = 64;
+    const size_t kMaxItemLen = 1024;
+    const uint64_t kTotal = 200000;
+    std::string name = make_shm_name();
+
+    SharedCompactRingBuffer writer;
+    ASSERT_TRUE(writer.Create(name.c_str(), 128, kCount * kMaxItemLen * 2, kCount));
+
+    StressProgress *prog = (StressProgress *)mmap(NULL, sizeof(StressProgress), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE((void *)prog, MAP_FAILED);
+    memset(prog, 0, sizeof(StressProgress));
+
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0)
+    {
+        int code = 0;
+        SharedCompactRingBuffer reader;
+        if (!reader.Open(name.c_str()))
+            _exit(1);
+        reader.SetReadIndex(0);
+        __atomic_store_n(&prog->ready, 1, __ATOMIC_RELEASE);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        for (uint64_t seq = 0; seq < kTotal && code == 0; )
+        {
+            size_t len = 0;
+            const uint8_t *p = (const uint8_t *)reader.Read(&len);
+            if (!p)
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                    code = 4;
+                sched_yield();
+                continue;
+            }
+            code = stress_check(p, len, seq);
+            __atomic_store_n(&prog->consumed, ++seq, __ATOMIC_RELEASE);
+        }
+        reader.Close();
+        _exit(code);
+    }
+
+    while (!__atomic_load_n(&prog->ready, __ATOMIC_ACQUIRE))
+        sched_yield();
+
+    // the writer runs unthrottled unless it would lap the reader, so every item must arrive intact.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    bool timeout = false;
+    for (uint64_t seq = 0; seq < kTotal && !timeout; seq++)
+    {
+        while (seq - __atomic_load_n(&prog->consumed, __ATOMIC_ACQUIRE) >= kCount / 2)
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                timeout = true;
+                break;
+            }
+            sched_yield();
+        }
+        size_t len = stress_len(seq, kMaxItemLen);
+        uint8_t *p = (uint8_t *)writer.Apply(len);
+        ASSERT_NE(p, (uint8_t *)NULL);
+        stress_fill(p, seq, len);
+        ASSERT_TRUE(writer.Commit(p, len));
+    }
+    if (timeout)
+        kill(pid, SIGKILL);
+
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_FALSE(timeout);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    EXPECT_EQ(__atomic_load_n(&prog->consumed, __ATOMIC_ACQUIRE), kTotal);
+
+    munmap(prog, sizeof(StressProgress));
+    writer.Close();
+    writer.Destroy();
+}
+#endif